@@ -9,8 +9,13 @@ SOURCES += main.cpp \
     satellite/station/stationdialog.cpp \
     satellite/station/station.cpp \
     utils/plist.cpp \
+    utils/trace.cpp \
     satellite/kepler/tledialog.cpp \
     satellite/predict/Satellite.cpp \
+    satellite/predict/sgp4batch.cpp \
+    satellite/predict/passpool.cpp \
+    satellite/predict/passscheduler.cpp \
+    satellite/predict/passtimeline.cpp \
     settings.cpp \
     utils/utils.cpp \
     satellite/satutil.cpp \
@@ -19,12 +24,12 @@ SOURCES += main.cpp \
     satellite/trackthread.cpp \
     satellite/track/trackwidget.cpp \
     imagewidget.cpp \
+    imageview.cpp \
     satellite/active/activesatdialog.cpp \
     rig/rigdialog.cpp \
     rig/rig.cpp \
     decoder/block.cpp \
     decoder/mn1lrptblock.cpp \
-    decoder/ReedSolomon.cpp \
     decoder/lritblock.cpp \
     decoder/ljpeg/ljpegreader.cpp \
     decoder/ljpeg/ljpegdecompressor.cpp \
@@ -47,6 +52,22 @@ SOURCES += main.cpp \
     rig/jrkconfdialog.cpp \
     decoder/ahrptblock.cpp \
     decoder/cadu.cpp \
+    decoder/blockreader.cpp \
+    decoder/syncscanner.cpp \
+    decoder/synccorrelator.cpp \
+    decoder/rsdecoder.cpp \
+    decoder/cadustats.cpp \
+    decoder/frameindex.cpp \
+    decoder/imagestore.cpp \
+    decoder/linepool.cpp \
+    decoder/cadupipeline.cpp \
+    decoder/unpack10.cpp \
+    decoder/packetreassembler.cpp \
+    decoder/livedecoder.cpp \
+    decoder/linecompositor.cpp \
+    decoder/contrast.cpp \
+    decoder/colorscale.cpp \
+    decoder/vegetationlut.cpp \
     utils/azeldialog.cpp \
     tools/cadusplitterdialog.cpp \
     rig/monstrum.cpp \
@@ -68,8 +89,13 @@ HEADERS += mainwindow.h \
     satellite/station/stationdialog.h \
     satellite/station/station.h \
     utils/plist.h \
+    utils/trace.h \
     satellite/kepler/tledialog.h \
     satellite/predict/Satellite.h \
+    satellite/predict/sgp4batch.h \
+    satellite/predict/passpool.h \
+    satellite/predict/passscheduler.h \
+    satellite/predict/passtimeline.h \
     satellite/predict/satcalc.h \
     settings.h \
     utils/utils.h \
@@ -80,12 +106,12 @@ HEADERS += mainwindow.h \
     satellite/trackthread.h \
     satellite/track/trackwidget.h \
     imagewidget.h \
+    imageview.h \
     satellite/active/activesatdialog.h \
     rig/rigdialog.h \
     rig/rig.h \
     decoder/block.h \
     decoder/mn1lrptblock.h \
-    decoder/ReedSolomon.h \
     decoder/lritblock.h \
     decoder/ljpeg/ljpegdecompressor.h \
     decoder/ljpeg/ljpegcomponent.h \
@@ -109,6 +135,22 @@ HEADERS += mainwindow.h \
     rig/jrkconfdialog.h \
     decoder/ahrptblock.h \
     decoder/cadu.h \
+    decoder/blockreader.h \
+    decoder/syncscanner.h \
+    decoder/synccorrelator.h \
+    decoder/rsdecoder.h \
+    decoder/cadustats.h \
+    decoder/frameindex.h \
+    decoder/imagestore.h \
+    decoder/linepool.h \
+    decoder/cadupipeline.h \
+    decoder/unpack10.h \
+    decoder/packetreassembler.h \
+    decoder/livedecoder.h \
+    decoder/linecompositor.h \
+    decoder/contrast.h \
+    decoder/colorscale.h \
+    decoder/vegetationlut.h \
     utils/azeldialog.h \
     tools/cadusplitterdialog.h \
     rig/monstrum.h \
@@ -181,6 +223,16 @@ INCLUDEPATH += decoder \
 #DEFINES += DEBUG_GPS
 DEFINES += DEBUG_AHRPT
 
+# sync scanner and derandomizer use SSE2 by default, uncomment for the AVX2 path
+#QMAKE_CXXFLAGS += -mavx2
+# Reed Solomon syndromes and the 10 bit unpacker need SSSE3 (PSHUFB), implied by -mavx2
+#QMAKE_CXXFLAGS += -mssse3
+
+# hot path timers and counters, build with qmake CONFIG+=trace, see utils/trace.h
+trace {
+    DEFINES += POES_TRACE
+}
+
 # --------------------------------------------------------------------------------
 # Mr Linus Thorvalds (linux) settings
 # --------------------------------------------------------------------------------
@@ -197,10 +249,6 @@ unix {
     INCLUDEPATH += /usr/include
     LIBS += -lusb
 
-    # DSP and FEC Library, http://www.ka9q.net/code/fec/
-    # see conf/README-libfec.txt
-    #DEFINES += HAVE_LIBFEC
-    #LIBS += -L/usr/local/lib -lfec
     #DEFINES += DEBUG_RS
 }
 
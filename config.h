@@ -27,6 +27,7 @@
 #define PATH_CONF           "conf"
 #define PATH_TLE            "tle"
 #define PATH_TLE_ARC        "tle/archive"
+#define PATH_LUT            "conf/LUT"  // colour scales of NDVI and EVI
 
 // settings files
 #define FILE_SAT_INI        "satellites.ini"
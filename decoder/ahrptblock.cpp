@@ -20,12 +20,15 @@
 */
 
 //---------------------------------------------------------------------------
-#include <QImage>
 #include <QDateTime>
 #include <QDate>
 #include <stdlib.h>
 #include "ahrptblock.h"
 #include "block.h"
+#include "imagestore.h"
+#include "linepool.h"
+#include "unpack10.h"
+#include "trace.h"
 
 //---------------------------------------------------------------------------
 /*
@@ -51,6 +54,7 @@ const int AHRPT_NUM_CHANNELS = 5;
 const int AHRPT_SCAN_WIDTH   = 2048;   // 10 bit, one image scan
 const int AHRPT_SCAN_SIZE    = 10240;  // 10 bit, width * channels
 const int AHRPT_IMAGE_START  = 88;     // CCSDS bytes + 6 bits (20 + 68 bytes + 550 bits)
+const int AHRPT_IMAGE_SHIFT  = 6;      // bits, CH 1 starts 6 bits into the first image byte
 
 //---------------------------------------------------------------------------
 //#define DEBUG_FRAME
@@ -62,7 +66,9 @@ TAHRPT::TAHRPT(TBlock *_block)
   cadu = block->getCADU();
 
   scanLine = NULL;
-  fp = NULL;
+  last_apid = 0;
+  following = false;
+  reader = NULL;
 }
 
 //---------------------------------------------------------------------------
@@ -81,9 +87,9 @@ bool TAHRPT::init(void)
     if(scanLine == NULL)
         scanLine = (quint16 *) malloc(AHRPT_SCAN_SIZE << 1); // 20480 bytes
 
-    fp = block->getHandle();
+    reader = block->getReader();
 
-    if(!cadu->init(fp, AHRPT_CADU_SIZE - CADU_SYNC_SIZE)) // CCSDS size, 1020 bytes
+    if(!cadu->init(reader, AHRPT_CADU_SIZE - CADU_SYNC_SIZE)) // CCSDS size, 1020 bytes
         return false;
 
     block->setFrames(0);
@@ -98,7 +104,7 @@ bool TAHRPT::init(void)
 bool TAHRPT::check(int flags)
 {
     // check allocation and file pointer status
-    if(block == NULL || cadu == NULL || fp == NULL || scanLine == NULL)
+    if(block == NULL || cadu == NULL || reader == NULL || !reader->isOpen() || scanLine == NULL)
         return false;
 
     // check found stuff
@@ -113,76 +119,59 @@ bool TAHRPT::check(int flags)
 //---------------------------------------------------------------------------
 int TAHRPT::countFrames(void)
 {
+    TRACE_SCOPE("TAHRPT::countFrames");
+
     if(!check())
         return 0; // fatal error
 
-    return check(1) ? block->getFrames():count_AVHRR_HR_frames();
+    if(check(1) || block->fromIndex())
+        return block->getFrames();
+
+    return count_AVHRR_HR_frames();
 }
 
 //---------------------------------------------------------------------------
 long TAHRPT::count_AVHRR_HR_frames(void)
 {
-    quint16 hdr_ptr, apid;
-    quint8  vcid, find_vcid;
+    const TSourcePacket *packet;
     long    frames = 0;
-
-    find_vcid = 0x09; // MetOp
-    //find_vcid = 0x37; // FY3A -> guess
-    //find_vcid = 0x0d; // FY3A -> guess
+    int     fill;
 
 #ifdef DEBUG_AHRPT
-    long errors = 0;
-
     cadu->outfp = fopen("/home/poes-weather/Downloads/metop-a-derand.cadu", "wb");
 #endif
 
-    fseek(fp, 0, SEEK_SET);
+    reader->seek(0);
+    cadu->collect_stats(true);
 
-    while(cadu->findsync()) {
-        if(cadu->getpayload() == NULL)
-            break;
+    // sync, RS decode and this loop on their own threads
+    if(TLinePool::threads() > 1)
+        cadu->start_pipeline(0, TLinePool::threads() - 2);
 
-        vcid = cadu->vcid();
-
-#ifdef DEBUG_AHRPT
-        qDebug("VCID: %d [0x%02x] @ 0x%08x", vcid, vcid, (unsigned int) cadu->getpacketaddress());
-        cadu->writepacket(true);
-#endif
+    packets.reset();
+    last_apid = 0;
 
-        if(vcid != find_vcid) // TODO: check if it is encrypted...
-            continue;
+    while((packet = nextPacket()) != NULL) {
+        if(frames == 0)
+            block->setFirstFrameSyncPos(packet->address);
 
-        if(cadu->first_hdr_ptr(&hdr_ptr)) {
-            apid = cadu->apid(cadu->get_mpdu_packet(hdr_ptr));
+        // black lines for the lost packets, indexed at the CADU of this one
+        for(fill=lostLines(packet); fill>0; fill--, frames++)
+            block->getIndex()->add(packet->address, packet->vcid, packet->apid,
+                                   (packet->sequence_count - fill) & PACKET_SEQ_MASK, FRAME_FILL);
 
-            // 0x047f fy3a guess
-            if(apid == 103 || apid == 104 /*|| apid == 0x047f*/) {
-                if(frames == 0)
-                    block->setFirstFrameSyncPos(cadu->getpacketaddress());
-
-                frames++;
-            }
-
-#ifdef DEBUG_AHRPT
-
-            if(!(apid == 103 || apid == 104 /*|| apid == 0x047f*/)) {
-                errors++;
-
-                qDebug("Bogus APID: %d @ 0x%08x", apid, (unsigned int) cadu->getpacketaddress());
-            }
-            else
-                qDebug("APID: %d [0x%02x] @ 0x%08x", apid, apid, (unsigned int) cadu->getpacketaddress());
-
-#endif
-
-        }
+        frames++;
+        block->getIndex()->add(packet->address, packet->vcid, packet->apid, packet->sequence_count,
+                               TFrameIndex::rsStatus(packet->rs_errors));
     }
 
 #ifdef DEBUG_AHRPT
-    if(errors)
-        qDebug("Bogus APID's: %d + %d frames = %d", (int)errors, (int)frames, (int)(errors + frames));
+    qDebug("Source packets: %ld, lost: %ld, dropped: %ld, frames: %ld",
+           packets.getPackets(), packets.getLost(), packets.getDropped(), frames);
 #endif
 
+    cadu->stop_pipeline();
+    cadu->collect_stats(false);
     block->setFrames(frames);
 
 #ifdef DEBUG_AHRPT
@@ -194,7 +183,6 @@ long TAHRPT::count_AVHRR_HR_frames(void)
     return frames;
 }
 
-
 //---------------------------------------------------------------------------
 int TAHRPT::getWidth(void)
 {
@@ -208,348 +196,153 @@ int TAHRPT::getNumChannels(void)
 }
 
 //---------------------------------------------------------------------------
-// frame_nr is zero based (0, 1, 2, ... frames - 1)
-bool TAHRPT::readFrameScanLine(int frame_nr)
+// the next AVHRR-HR source packet, NULL at the end of the recording,
+// tail leaves a CADU at the end of a growing recording for the next call
+const TSourcePacket *TAHRPT::nextPacket(bool tail)
 {
-    quint8  *vcdu, *ccsds, last_byte;
-    quint16 apid, hdr_ptr, pixel;
-    long    bits_to_read, tot_bits_red;
-    int     cadu_flags, shift;
-    int     scan_index, read_size, scan_pos;
-    int     i, index;
-    bool    error;
-
-
-#ifdef DEBUG_FRAME
-    int debug_frame = 1595;
-    long tmplong;
-
-    if(frame_nr == debug_frame)
-        qDebug("\n*Frame: %d", frame_nr);
-#endif
-
-    // missed pixels will be shown as black line
-    memset(scanLine, 0, AHRPT_SCAN_SIZE << 1);
-
-    // file pointer MUST be set at firstFrameSyncPos using fseek
-    // when started, frame_nr = 0
-
-    if(frame_nr == 0)
-        vcdu = cadu->getpayload(); // read the whole CADU
-    else {
-        if(frame_nr >= block->getFrames())
-            return false;
-
-        vcdu = cadu->getpayload_buffer(); // CADU is already in buffer
-    }
-
-    if(vcdu == NULL)
-        return false;
-
-    cadu_flags = 1; //  &1 = first loop
-                    //  &2 = file pointer points at frame_nr + CH1
-                    //  &4 = next scanline (frame) found
-                    // &16 = add byte from previous packet
-                    // &32 = image starts in next packet
-    scan_index = 0;
-    scan_pos = 0;
-    tot_bits_red = 0;
-    bits_to_read = 0;
-    index = 1;
-    shift = 0;
+    const TSourcePacket *packet;
 
     while(true) {
-        error = false;
-
-        if(cadu_flags & 1)
-            cadu_flags &= ~1;
-        else {
-            // find next AVHRR-HR packet (part)
-            error = true;
-            while(cadu->findsync()) {
-                if(cadu->getpayload() == NULL)
-                    break;
-
-                if(cadu->vcid() == 0x09) {
-                    error = false;
-                    break;
-                }
-            }
-        }
-
-        if(error) // nothing of interest found or EOF?
-            break;
-
-        ccsds = cadu->get_mpdu();
-        // ccsds = vcdu + 0x08;
-        hdr_ptr = 0;
-        if(cadu->first_hdr_ptr(&hdr_ptr)) {
-            apid = cadu->apid(cadu->get_mpdu_packet(hdr_ptr));
+        while((packet = packets.next()) != NULL) {
             // todo: fy3a
-            if(!(apid == 103 || apid == 104 /*|| apid == 1151*/))
-                continue;
-
-            // TODO: check if it is encrypted
-
-            hdr_ptr += 2; // M-PDU header is 2 bytes
-
-            if(cadu_flags & 2) {
-                cadu_flags |= 4;
-                scan_pos = 2;
-                bits_to_read = 0;
-                // almost done with this scanline, this packet is the last
-            }
-            else {
-                cadu_flags |= 2;
-                scan_pos = hdr_ptr + AHRPT_IMAGE_START; // points at CH 1
-                shift = 0;
-                bits_to_read = -6;
-
-#ifdef DEBUG_FRAME
-                if(frame_nr == debug_frame) {
-                    tmplong = ftell(fp) - 1024;
-
-                    qDebug("Sequence count: %d @ 0x%08x hdr_ptr @ 0x%08x image start: %d",
-                           get_sequence_count(ccsds + hdr_ptr),
-                           (unsigned int) tmplong,
-                           (unsigned int) tmplong + hdr_ptr,
-                           scan_pos);
-                }
-#endif
-
-                if(scan_pos > 884) {
-                    // image starts in next packet
-                    scan_pos = hdr_ptr + AHRPT_IMAGE_START + 2 - 884;
-                    cadu_flags |= 32;
-
-                    continue;
-                }
-            }
-
-        }
-        else {
-            if(!(cadu_flags & 32)) {
-                scan_pos = 2; // points at M-PDU start (continues...)
-                bits_to_read = 0;
-            }
-
-            cadu_flags &= ~32;
-        }
-
-        if(scan_index >= AHRPT_SCAN_SIZE)
-            return true;
-
-        read_size = 884 - scan_pos;
-
-        if(read_size < 1) {
-            read_size = 99;
-            continue; // ??? sumthing is VERY wrong...
-        }
-
-       // cadu->rsdecode();
-
-        bits_to_read += (read_size << 3);
-        tot_bits_red += bits_to_read;
-
-        ccsds += scan_pos; // buffer points at CH 1
-
-#ifdef DEBUG_FRAME
-        if(frame_nr == debug_frame) {
-            qDebug("start bytes 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x",
-                   ccsds[0],ccsds[1],ccsds[2],ccsds[3],
-                   ccsds[4],ccsds[5],ccsds[6],ccsds[7]);
+            if(packet->apid == 103 || packet->apid == 104 /*|| packet->apid == 1151*/)
+                return packet;
         }
 
-#endif
-
-        if(cadu_flags & 16) {
-            pixel = (((last_byte << 8) | ccsds[0]) >> shift) & 0x03ff;
-            scanLine[scan_index] = pixel;
-
-#ifdef DEBUG_FRAME
-            if(frame_nr == debug_frame) {
-                qDebug("add prev byte sample %d, index: %d: shift: %d", (scan_index / 5) - 1, scan_index, shift);
-                qDebug("add prev pixel: %d shift: %d", pixel, shift);
-            }
-#endif
-
-            if(shift == 0) {
-                shift = 6;
-                index = 2;
-            }
-            else {
-                shift -= 2;
-                index = 1;
+        // find next AVHRR-HR packet (part)
+        do {
+            if(tail) {
+                if(cadu->gettailpayload() == NULL)
+                    return NULL; // nothing more written yet
             }
+            else if(!cadu->findsync() || cadu->getpayload() == NULL)
+                return NULL; // EOF
+        } while(!(cadu->vcid() == 0x09)); // TODO: check if it is encrypted
 
-            scan_index++;
-        }
-        else
-            index = 1;
-
-
-        for(i=index; i<read_size && scan_index<AHRPT_SCAN_SIZE; scan_index++) {
-            pixel = (((ccsds[i-1] << 8) | ccsds[i]) >> shift) & 0x03ff;
-            scanLine[scan_index] = pixel;
-
-#ifdef DEBUG_FRAME
-            if(frame_nr == debug_frame)
-                if(i == index)
-                    qDebug("first pixel: %d", pixel);
-#endif
-
-            if(shift == 0) {
-                shift = 6;
-                i += 2;
-            }
-            else {
-                shift -= 2;
-                i++;
-            }
-        }
-
-        cadu_flags &= ~16;
-        if((tot_bits_red % 10) != 0)
-            cadu_flags |= 16;
-
-        last_byte = ccsds[read_size-1];
-
-#ifdef DEBUG_FRAME
-        if(frame_nr == debug_frame) {
-            qDebug("scan index: %d", (scan_index / 5) - 1);
-            qDebug("buffer size: %d bytes, bits to read: %d, tot: %d", read_size, (int)bits_to_read, (int)tot_bits_red);
-            qDebug("last sub pixels: %04d %04d %04d %04d %04d",
-               scanLine[scan_index-5], scanLine[scan_index-4],
-               scanLine[scan_index-3], scanLine[scan_index-2], scanLine[scan_index-1]);
-
-            qDebug("last of image 0x%02x 0x%02x 0x%02x 0x%02x",
-                   ccsds[read_size-4], ccsds[read_size-3], ccsds[read_size-2], ccsds[read_size-1]);
-
-            qDebug("last byte 0x%02x shift: %d\n", last_byte, shift);
-        }
+#ifdef DEBUG_AHRPT
+        cadu->writepacket(true);
 #endif
-        if(cadu_flags & 4)
-            break; // done with this scanline
 
+        packets.push(cadu);
     }
+}
 
-#ifdef DEBUG_FRAME
-
-    if(frame_nr == debug_frame) {
-        qDebug("frame last sample %d: %04d %04d %04d %04d %04d", (scan_index / 5) - 1,
-           scanLine[scan_index-5], scanLine[scan_index-4],
-           scanLine[scan_index-3], scanLine[scan_index-2], scanLine[scan_index-1]);
-
-    }
+//---------------------------------------------------------------------------
+// fill lines for the packets lost before this one, the 3a and 3b APIDs
+// have their own sequence counts
+int TAHRPT::lostLines(const TSourcePacket *packet)
+{
+    int lines = packet->apid == last_apid ? packet->missing:0;
 
-#endif
+    last_apid = packet->apid;
 
-    return true;
+    return lines;
 }
 
 //---------------------------------------------------------------------------
-// returns a 16 bit pixel from a frame channel
-// sample and channel are zero based
-quint16 TAHRPT::getPixel_16(int channel, int sample)
+// all channels of a source packet, missed pixels will be shown as black line
+bool TAHRPT::packetToScanLine(const TSourcePacket *packet)
 {
- quint16 pixel, pos;
+    TRACE_SCOPE("TAHRPT::packetToScanLine");
 
-  if(!check())
-     return 0;
+    memset(scanLine, 0, AHRPT_SCAN_SIZE << 1);
 
-  if(!block->isNorthBound())
-     pos = channel + sample * AHRPT_NUM_CHANNELS;
-  else
-     pos = channel + (AHRPT_SCAN_WIDTH - sample - 1) * AHRPT_NUM_CHANNELS;
+    if(packet->size <= AHRPT_IMAGE_START)
+        return false;
 
-  pixel = scanLine[pos] & 0x03ff;
+    TUnpack10::unpack(scanLine, packet->data + AHRPT_IMAGE_START, packet->size - AHRPT_IMAGE_START,
+                      AHRPT_SCAN_SIZE, AHRPT_IMAGE_SHIFT);
 
-  return pixel;
-}
-
-//---------------------------------------------------------------------------
-// returns a 8 bit pixel from a frame channel
-// sample and channel are zero based
-quint8 TAHRPT::getPixel_8(int channel, int sample)
-{
-  return SCALE16TO8(getPixel_16(channel, sample));
+    return true;
 }
 
 //---------------------------------------------------------------------------
-// fills an 24 bpp image line of the selected channel
-// frame_nr is zero based
-bool TAHRPT::frameToImage(int frame_nr, QImage *image)
+// The line of a packet is its entry in the frame index, the lines of the
+// lost packets are FRAME_FILL entries and stay black. A packet the
+// counting pass did not index, eg. its CADU now fails RS, is left out.
+bool TAHRPT::toStore(TImageStore *store)
 {
- uchar *imagescan, r, g, b;
- int x, y, *ch_rgb;
+ const TSourcePacket *packet;
+ const TFrameEntry   *entry;
+ TFrameIndex *index;
+ int frames, y, i;
 
-  if(!check(1) || image == NULL)
+  if(!check(1) || store == NULL)
      return false;
 
-  if(!readFrameScanLine(frame_nr))
-     return false;
+  index = block->getIndex();
+  frames = block->getFrames();
 
-  if(block->isNorthBound())
-     y = image->height() - frame_nr - 1;
-  else
-     y = frame_nr;
+  if(TLinePool::threads() < 2 ||
+     !cadu->start_pipeline(block->getFirstFrameSyncPos(), TLinePool::threads() - 2))
+     reader->seek(block->getFirstFrameSyncPos());
 
-  imagescan = (uchar *) image->scanLine(y);
-  if(imagescan == NULL)
-     return false;
+  packets.reset();
+  last_apid = 0;
+  following = false;
 
-  switch(block->getImageType()) {
-  case RGB_ImageType:
-      ch_rgb = block->rgbconf->rgb_ch();
-      break;
+  for(y=0; y<frames && (packet = nextPacket()) != NULL; ) {
+     // the entries are in the order of the packets
+     for(i=y; (entry = index->getEntry(i)) != NULL && entry->offset <= packet->address; i++)
+        if(!(entry->status & FRAME_FILL) && entry->offset == packet->address &&
+           entry->apid == packet->apid && entry->sequence == packet->sequence_count)
+           break;
 
-  default:
-      break;
-  }
+     if(entry == NULL || entry->offset > packet->address)
+        continue;
+
+     if(packetToScanLine(packet))
+        store->putInterleaved(i, scanLine);
 
-  for(x=0; x<AHRPT_SCAN_WIDTH; x++) {
-      switch(block->getImageType()) {
-      case Channel_ImageType:
-          r = getPixel_8(block->getImageChannel(), x);
-          g = r;
-          b = r;
-          break;
-
-      case RGB_ImageType:
-          r = getPixel_8(ch_rgb[0] - 1, x);
-          g = getPixel_8(ch_rgb[1] - 1, x);
-          b = getPixel_8(ch_rgb[2] - 1, x);
-          break;
-
-        default:
-           return false;
-     }
-
-     *imagescan++ = r;
-     *imagescan++ = g;
-     *imagescan++ = b;
+     y = i + 1;
   }
 
+  cadu->stop_pipeline();
+
  return true;
 }
 
 //---------------------------------------------------------------------------
-bool TAHRPT::toImage(QImage *image)
+// live decoding, appends the scan lines of the source packets written
+// since toStore or the previous call, returns the number of new lines
+int TAHRPT::follow(TImageStore *store)
 {
- int frames, y;
+ const TSourcePacket *packet;
+ int frames, y, fill;
 
-  if(!check(1))
-     return false;
+  if(!check(1) || store == NULL || !store->isDecoded())
+     return 0;
 
-  fseek(fp, block->getFirstFrameSyncPos() + CADU_SYNC_SIZE, SEEK_SET);
-  frames = block->getFrames();
+  // the packets of the last CADU read by toStore are still in the reassembler
+  if(!following) {
+     if(!cadu->resume())
+        return 0;
+
+     following = true;
+  }
+
+  frames = y = block->getFrames();
 
-  for(y=0; y<frames; y++) {
-     if(!frameToImage(y, image))
+  while((packet = nextPacket(true)) != NULL) {
+     fill = lostLines(packet);
+     if(!store->grow(y + fill + 1))
         break;
+
+     for(; fill>0; fill--, y++)
+        block->getIndex()->add(packet->address, packet->vcid, packet->apid,
+                               (packet->sequence_count - fill) & PACKET_SEQ_MASK, FRAME_FILL);
+
+     block->getIndex()->add(packet->address, packet->vcid, packet->apid, packet->sequence_count,
+                            TFrameIndex::rsStatus(packet->rs_errors));
+
+     if(packetToScanLine(packet))
+        store->putInterleaved(y, scanLine);
+     y++;
   }
 
- return true;
+  block->setFrames(y);
+
+ return y - frames;
 }
 
 #if 0
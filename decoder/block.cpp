@@ -19,7 +19,10 @@
     Web: <http://www.poes-weather.com>
 */
 //---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
 #include <QString>
+#include <QImage>
 #include "block.h"
 #include "hrptblock.h"
 #include "ahrptblock.h"
@@ -28,7 +31,11 @@
 #include "mn1hrptblock.h"
 #include "fy1hrptblock.h"
 #include "lritblock.h"
+#include "linecompositor.h"
+#include "contrast.h"
+#include "vegetationlut.h"
 #include "plist.h"
+#include "trace.h"
 
 static const char *SUPPORTED_BLOCKS[NUM_SUPPORTED_BLOCKS] =
 {
@@ -49,6 +56,15 @@ TBlock::TBlock(void)
 {    
    fp = NULL;
    block = NULL;
+   reader = new TBlockReader;
+   scanner = new TSyncScanner;
+   index = new TFrameIndex;
+   store = new TImageStore;
+   vicache = new TVegetationCache;
+
+   luts = NULL;
+   lutchannels = 0;
+   lutbuilt = lutcontrast = lutstore = 0;
 
    frames = 0;
    firstFrameSyncPos = -1;
@@ -59,6 +75,11 @@ TBlock::TBlock(void)
 
    cadu = new TCADU;
    satprop = new TSatProp;
+   contrast = new TContrast;
+
+   rgbconf = NULL;
+   ndvi = NULL;
+   evi = NULL;
 }
 
 //---------------------------------------------------------------------------
@@ -69,6 +90,15 @@ TBlock::~TBlock(void)
 
     delete cadu;
     delete satprop;
+    delete contrast;
+    delete reader;
+    delete scanner;
+    delete index;
+    delete store;
+    delete vicache;
+
+    if(luts)
+        free(luts);
 }
 
 //---------------------------------------------------------------------------
@@ -124,11 +154,35 @@ void TBlock::close(void)
    if(fp)
       fclose(fp);
    fp = NULL;
+
+   reader->close();
+   scanner->clear();
+   store->clear();
+   vicache->clear();
+}
+
+//---------------------------------------------------------------------------
+// legacy stdio handle for decoders not yet ported to TBlockReader,
+// opened on demand at the current reader position, 64 bit as the reader
+FILE *TBlock::getHandle(void)
+{
+   if(fp == NULL && reader->isOpen()) {
+      fp = fopen(reader->fileName(), "rb");
+
+      if(fp && reader->pos() > 0 && br_fseek(fp, reader->pos()) != 0) {
+         fclose(fp);
+         fp = NULL;
+      }
+   }
+
+   return fp;
 }
 
 //---------------------------------------------------------------------------
 void TBlock::gotoStart(void)
 {
+   reader->seek(0);
+
    if(fp)
       fseek(fp, 0L, SEEK_SET);
 }
@@ -182,6 +236,7 @@ bool TBlock::setBlockType(Block_Type type)
    cadu->reset();
    cadu->derandomize(satprop->derandomize());
    cadu->reed_solomon(satprop->rs_decode());
+   cadu->soft_sync(satprop->softSync(), satprop->syncErrors());
    syncFound(false);
 
    switch(type)
@@ -230,48 +285,80 @@ bool TBlock::setBlockType(Block_Type type)
 // setBlockType must be called before this function
 bool TBlock::open(const char *filename)
 {
+   TRACE_SCOPE("TBlock::open");
+
    if(block == NULL || filename == NULL)
        return false;
 
+ bool rc;
+
    close();
+   cadu->getstats()->reset();
 
-   fp = fopen(filename, "rb");
-   if(fp == NULL)
+   if(!reader->open(filename))
        return false;
 
+   // a valid .idx sidecar replaces the counting pass of the decoder
+   index->clear();
+   index->setKey(filename, blocktype, satprop->decoderFlags() | (satprop->syncErrors() << 8));
+   if(index->load(filename))
+       cadu->getstats()->readSidecar(filename);
+
    switch(blocktype) {
        case HRPT_BlockType:
-          return ((THRPT *) block)->init();
+          rc = ((THRPT *) block)->init();
        break;
 
        case AHRPT_BlockType:
-          return ((TAHRPT *) block)->init();
+          rc = ((TAHRPT *) block)->init();
        break;
 
        case FYAHRPT_BlockType:
-          return ((TFYAHRPT *) block)->init();
+          rc = ((TFYAHRPT *) block)->init();
        break;
 
        case MN1HRPT_BlockType:
-          return ((TMN1HRPT *) block)->init();
+          rc = ((TMN1HRPT *) block)->init();
        break;
 
        case MN1LRPT_BlockType:
-          return ((TMN1LRPT *) block)->init();
+          rc = ((TMN1LRPT *) block)->init();
        break;
 
        case FY1HRPT_BlockType:
-          return ((TFY1HRPT *) block)->init();
+          rc = ((TFY1HRPT *) block)->init();
        break;
 
        case LRIT_GOES_BlockType:
        case LRIT_JPEG_BlockType:
-          return ((TLRIT *) block)->init();
+          rc = ((TLRIT *) block)->init();
        break;
 
        default:
           return false;
    }
+
+   if(rc && !index->isLoaded()) {
+       index->save(filename, Modes & B_BYTESWAP);
+       cadu->getstats()->writeSidecar(filename);
+   }
+
+   return rc;
+}
+
+//---------------------------------------------------------------------------
+// restores the result of the counting pass from the loaded frame index
+bool TBlock::fromIndex(void)
+{
+   if(!index->isLoaded() || index->count() <= 0)
+       return false;
+
+   frames = index->count();
+   firstFrameSyncPos = (long int) index->getOffset(0);
+   setLittleEndian(index->getModes() & B_BYTESWAP ? true:false);
+   syncFound(true);
+
+   return true;
 }
 
 //---------------------------------------------------------------------------
@@ -347,7 +434,7 @@ int TBlock::getHeight(void)
 //---------------------------------------------------------------------------
 long int TBlock::countCADUFrames(long int block_size)
 {
-   if(!block || !fp)
+   if(!block || !reader->isOpen())
       return 0;
 
    gotoStart();
@@ -359,13 +446,13 @@ long int TBlock::countCADUFrames(long int block_size)
       Modes |= B_SYNC_FOUND;
 
       if(frames == 0)
-         firstFrameSyncPos = ftell(fp) - CADU_SYNC_SIZE;
+         firstFrameSyncPos = reader->pos() - CADU_SYNC_SIZE;
 
       ++frames;
 
       // hop to next frame
       if(frames > 1)
-         if(fseek(fp, block_size - CADU_SYNC_SIZE, SEEK_CUR) != 0)
+         if(!reader->skip(block_size - CADU_SYNC_SIZE))
             break;
    }
 
@@ -381,17 +468,10 @@ bool TBlock::findCADUFrameSync(void)
  i = 0;
  if(Modes & B_SYNC_FOUND) {
      // dummy read
-     while(fread(&ch, 1, 1, fp) == 1) {
-        i++;
-
-        if(i == CADU_SYNC_SIZE)
-           return true;
-     }
-
-     return false;
+     return reader->skip(CADU_SYNC_SIZE);
  }
 
-  while(fread(&ch, 1, 1, fp) == 1) {
+  while(reader->readByte(&ch)) {
      if(ch == CADU_SYNC[i])
         i++;
      else
@@ -516,6 +596,7 @@ QStringList TBlock::getImageTypes(void) const
     QStringList sl;
     TRGBConf *rc;
     TNDVI *vi;
+    TEVI *ev;
     int i;
 
     sl.append("Band Number");
@@ -530,6 +611,11 @@ QStringList TBlock::getImageTypes(void) const
         sl.append(vi->name());
     }
 
+    for(i=0; i<satprop->evilist->Count; i++) {
+        ev = (TEVI *) satprop->evilist->ItemAt(i);
+        sl.append(ev->name());
+    }
+
     return sl;
 }
 
@@ -545,59 +631,170 @@ void TBlock::setImageType(int index)
    // channel   = 0
    // rgb       = 1...m
    // ndvi      = m+1...n
-   // etc
+   // evi       = n+1...k
 
-   Block_ImageType type = Channel_ImageType;
+   imagetype = imageType(index, &rgbconf, &ndvi, &evi);
 
-   rgbconf = NULL;
-   ndvi = NULL;
+   if(imagetype == NDVI_ImageType)
+       setImageChannel(ndvi->nir_ch());
+   else if(imagetype == EVI_ImageType)
+       setImageChannel(evi->nir_ch());
+}
 
-   if(index > 0) {
-       // RGB image
-       if(index <= satprop->rgblist->Count) {
-           rgbconf = (TRGBConf *) satprop->rgblist->ItemAt(index - 1);
-           if(rgbconf)
-               type = RGB_ImageType;
-       }
-       else {
-           // NDVI image
-           ndvi = (TNDVI *) satprop->ndvilist->ItemAt(index - satprop->rgblist->Count - 1);
-           if(ndvi) {
-               type = NDVI_ImageType;
-               rgbconf = satprop->get_rgb(ndvi->rgbName());
-               setImageChannel(ndvi->nir_ch());
-           }
-       }
+//---------------------------------------------------------------------------
+// the RGB, NDVI and EVI settings of an image type index, see setImageType
+Block_ImageType TBlock::imageType(int index, TRGBConf **rgb, TNDVI **vi, TEVI **ev) const
+{
+   *rgb = NULL;
+   *vi = NULL;
+   *ev = NULL;
+
+   if(index <= 0)
+       return Channel_ImageType;
+
+   // RGB image
+   if(index <= satprop->rgblist->Count) {
+       *rgb = (TRGBConf *) satprop->rgblist->ItemAt(index - 1);
+
+       return *rgb ? RGB_ImageType:Channel_ImageType;
    }
 
-   imagetype = type;
+   // NDVI image
+   index -= satprop->rgblist->Count + 1;
+   if(index < satprop->ndvilist->Count) {
+       *vi = (TNDVI *) satprop->ndvilist->ItemAt(index);
+       if(*vi == NULL)
+           return Channel_ImageType;
+
+       *rgb = satprop->get_rgb((*vi)->rgbName());
+
+       return NDVI_ImageType;
+   }
+
+   // EVI image
+   *ev = (TEVI *) satprop->evilist->ItemAt(index - satprop->ndvilist->Count);
+   if(*ev == NULL)
+       return Channel_ImageType;
+
+   *rgb = satprop->get_rgb((*ev)->rgbName());
+
+   return EVI_ImageType;
 }
 
 //---------------------------------------------------------------------------
-bool TBlock::toImage(QImage *image)
+// decodes all channels of the opened recording into the image store,
+// done once, see toImage
+bool TBlock::decode(void)
 {
-   if(!block || !image)
+ TRACE_SCOPE("TBlock::decode");
+ bool rc;
+
+   if(!block)
+      return false;
+
+   if(store->isDecoded())
+      return true;
+
+   if(!store->alloc(getWidth(), getHeight(), getNumChannels()))
       return false;
 
    switch(blocktype) {
       case HRPT_BlockType:
-         return ((THRPT *) block)->toImage(image);
+         rc = ((THRPT *) block)->toStore(store);
       break;
 
       case AHRPT_BlockType:
-         return ((TAHRPT *) block)->toImage(image);
+         rc = ((TAHRPT *) block)->toStore(store);
       break;
 
       case FYAHRPT_BlockType:
-         return ((TFYAHRPT *) block)->toImage(image);
+         rc = ((TFYAHRPT *) block)->toStore(store);
       break;
 
       case MN1HRPT_BlockType:
-         return ((TMN1HRPT *) block)->toImage(image);
+         rc = ((TMN1HRPT *) block)->toStore(store);
+      break;
+
+      case FY1HRPT_BlockType:
+         rc = ((TFY1HRPT *) block)->toStore(store);
+      break;
+
+      default:
+         rc = false;
+   }
+
+   if(!rc) {
+      store->clear();
+      return false;
+   }
+
+   store->count(0, store->getHeight());
+   store->setDecoded(true);
+
+   return true;
+}
+
+//---------------------------------------------------------------------------
+// live decoding of a recording that is still being written, see TLiveDecoder.
+// Decodes the scan lines written since the last call into the image store,
+// returns the number of new lines, 0 when there are none or the format has
+// no live decoder.
+int TBlock::follow(void)
+{
+ int first, lines;
+
+   if(!block || !store->isDecoded())
+      return 0;
+
+   reader->refresh();
+   first = store->getHeight();
+
+   switch(blocktype) {
+      case HRPT_BlockType:
+         lines = ((THRPT *) block)->follow(store);
+      break;
+
+      case AHRPT_BlockType:
+         lines = ((TAHRPT *) block)->follow(store);
+      break;
+
+      case FYAHRPT_BlockType:
+         lines = ((TFYAHRPT *) block)->follow(store);
       break;
 
       case FY1HRPT_BlockType:
-         return ((TFY1HRPT *) block)->toImage(image);
+         lines = ((TFY1HRPT *) block)->follow(store);
+      break;
+
+      default:
+         return 0;
+   }
+
+   // the histograms grow with the pass
+   store->count(first, store->getHeight());
+
+   return lines;
+}
+
+//---------------------------------------------------------------------------
+bool TBlock::toImage(QImage *image)
+{
+   if(!block || !image)
+      return false;
+
+   switch(blocktype) {
+      case HRPT_BlockType:
+      case AHRPT_BlockType:
+      case FYAHRPT_BlockType:
+      case MN1HRPT_BlockType:
+      case FY1HRPT_BlockType:
+         if(!decode())
+            return false;
+
+         if(image->width() < store->getWidth() || image->height() < store->getHeight())
+            return false;
+
+         return compose(image, 0, 0, imagetype, imageChannel, rgbconf, ndvi, evi);
       break;
 
       case MN1LRPT_BlockType:
@@ -613,4 +810,200 @@ bool TBlock::toImage(QImage *image)
          return false;
    }
 }
+
+//---------------------------------------------------------------------------
+// Renders image type index (see getImageTypes) and channel (1 ... n) of a
+// decoded pass without changing the selected ones. The image store is only
+// read, so several threads may render products of a pass at the same time.
+bool TBlock::toImage(QImage *image, int type, int channel)
+{
+ Block_ImageType it;
+ TRGBConf *rgb;
+ TNDVI *vi;
+ TEVI *ev;
+ int maxch;
+
+   if(!block || !image || !store->isDecoded())
+      return false;
+
+   if(image->width() < store->getWidth() || image->height() < store->getHeight())
+      return false;
+
+   maxch = getNumChannels() - 1;
+   it = imageType(type, &rgb, &vi, &ev);
+   if(it == NDVI_ImageType)
+      channel = vi->nir_ch();
+   else if(it == EVI_ImageType)
+      channel = ev->nir_ch();
+
+   channel = channel - 1 < 0 ? 0:(channel - 1 > maxch ? maxch:channel - 1);
+
+   return compose(image, 0, 0, it, channel, rgb, vi, ev);
+}
+
+//---------------------------------------------------------------------------
+// Renders the part of the selected image at x, y (image coordinates, a
+// northbound pass already rotated) the size of tile, or less at the right
+// and bottom edges of the pass. For the viewer, false if the format has no
+// image store, see hasImageStore.
+bool TBlock::toTile(QImage *tile, int x, int y)
+{
+   if(!block || !tile || !hasImageStore())
+      return false;
+
+   if(!decode())
+      return false;
+
+   return compose(tile, x, y, imagetype, imageChannel, rgbconf, ndvi, evi);
+}
+
+//---------------------------------------------------------------------------
+// true if the format is decoded into the image store, the others render
+// the whole image at once
+bool TBlock::hasImageStore(void)
+{
+   switch(blocktype) {
+      case HRPT_BlockType:
+      case AHRPT_BlockType:
+      case FYAHRPT_BlockType:
+      case MN1HRPT_BlockType:
+      case FY1HRPT_BlockType:
+         return block ? true:false;
+
+      default:
+         return false;
+   }
+}
+
+//---------------------------------------------------------------------------
+// builds the 24 bpp image of a channel (zero based), RGB, NDVI or EVI from
+// the image store, a northbound pass is rotated 180 degrees.
+// x0, y0 is the top left corner of image in the rotated pass, the part that
+// fits is composed.
+// The contrast tables of the channels are copied from the cache, a line
+// is gathered from them. So is the vegetation index, its table is built
+// once per configuration.
+bool TBlock::compose(QImage *image, int x0, int y0, Block_ImageType it, int channel, TRGBConf *rgb, TNDVI *vi, TEVI *ev)
+{
+ TRACE_SCOPE("TBlock::compose");
+ TLineCompositor compositor;
+ const TVegetationLUT *vilut;
+ const quint16 *planes[COMPOSE_PLANES];
+ quint8 luts[COMPOSE_PLANES][CONTRAST_LUT_SIZE];
+ uchar *imagescan;
+ int i, y, sx, sy, width, height, w, h, *ch_rgb, plane_ch[COMPOSE_PLANES];
+ bool northbound;
+
+   width = store->getWidth();
+   height = store->getHeight();
+
+   if(x0 < 0 || y0 < 0)
+      return false;
+
+   w = width - x0 < image->width() ? width - x0:image->width();
+   h = height - y0 < image->height() ? height - y0:image->height();
+
+   if(w <= 0 || h <= 0)
+      return false;
+
+   northbound = isNorthBound();
+   ch_rgb = it != Channel_ImageType && rgb ? rgb->rgb_ch():NULL;
+
+   vilut = NULL;
+   if(it == NDVI_ImageType && vi)
+      vilut = vicache->get(vi);
+   else if(it == EVI_ImageType && ev)
+      vilut = vicache->get(ev);
+
+   if((it == NDVI_ImageType || it == EVI_ImageType) && vilut == NULL)
+      it = RGB_ImageType;
+
+   compositor.init(it, ch_rgb != NULL, northbound, vilut);
+
+   // zero based channel of every plane
+   for(i=COMPOSE_R; i<=COMPOSE_B; i++)
+      plane_ch[i] = ch_rgb ? ch_rgb[i - COMPOSE_R] - 1:channel;
+
+   plane_ch[COMPOSE_NIR] = plane_ch[COMPOSE_VIS] = plane_ch[COMPOSE_BLUE] = plane_ch[COMPOSE_R];
+
+   if(it == NDVI_ImageType) {
+      plane_ch[COMPOSE_NIR] = vi->nir_ch() - 1;
+      plane_ch[COMPOSE_VIS] = vi->vis_ch() - 1;
+   }
+   else if(it == EVI_ImageType) {
+      plane_ch[COMPOSE_NIR] = ev->nir_ch() - 1;
+      plane_ch[COMPOSE_VIS] = ev->red_ch() - 1;
+      plane_ch[COMPOSE_BLUE] = ev->blue_ch() - 1;
+   }
+
+   for(i=0; i<COMPOSE_PLANES; i++) {
+      contrastLUT(luts[i], plane_ch[i]);
+      compositor.setLUT(i, luts[i]);
+   }
+
+   // the reverse kernels mirror the w samples starting at sx
+   sx = northbound ? width - x0 - w:x0;
+
+   for(y=0; y<h; y++) {
+      imagescan = (uchar *) image->scanLine(y);
+      if(imagescan == NULL)
+         return false;
+
+      sy = northbound ? height - y0 - y - 1:y0 + y;
+
+      for(i=0; i<COMPOSE_PLANES; i++)
+         planes[i] = store->line(plane_ch[i], sy) + sx;
+
+      compositor.line(imagescan, planes, w);
+   }
+
+   return true;
+}
+
+//---------------------------------------------------------------------------
+// the contrast table of channel (zero based) to table. The tables are kept
+// until the contrast settings or the histograms of the store change, so
+// a tile costs a copy and not a table per plane. They are copied under
+// the lock as the render threads and the live decoder share them.
+void TBlock::contrastLUT(quint8 *table, int channel)
+{
+ const quint32 *histogram = store->histogram(channel);
+ int channels = store->getChannels();
+
+   lutlock.lock();
+
+   if(lutchannels != channels) {
+      if(luts)
+         free(luts);
+
+      luts = (quint8 *) malloc((size_t) channels * CONTRAST_LUT_SIZE);
+      lutchannels = luts ? channels:0;
+      lutbuilt = 0;
+
+      if(luts == NULL && channels > 0)
+         qDebug("Failed to allocate %d contrast tables %s:%d", channels, __FILE__, __LINE__);
+   }
+
+   if(lutcontrast != contrast->getSerial() || lutstore != store->getSerial()) {
+      lutcontrast = contrast->getSerial();
+      lutstore = store->getSerial();
+      lutbuilt = 0;
+   }
+
+   if(histogram == NULL || luts == NULL || channel >= 32) {
+      lutlock.unlock();
+      contrast->lut(table, histogram, channel + 1);
+
+      return;
+   }
+
+   if(!(lutbuilt & (1 << channel))) {
+      contrast->lut(luts + (size_t) channel * CONTRAST_LUT_SIZE, histogram, channel + 1);
+      lutbuilt |= 1 << channel;
+   }
+
+   memcpy(table, luts + (size_t) channel * CONTRAST_LUT_SIZE, CONTRAST_LUT_SIZE);
+
+   lutlock.unlock();
+}
 //---------------------------------------------------------------------------
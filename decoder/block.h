@@ -24,10 +24,15 @@
 
 #include <QtGlobal>
 #include <QStringList>
+#include <QMutex>
 #include <stdio.h>
 
 #include "satprop.h"
 #include "cadu.h"
+#include "blockreader.h"
+#include "syncscanner.h"
+#include "frameindex.h"
+#include "imagestore.h"
 
 //---------------------------------------------------------------------------
 #define B_BYTESWAP          1   // little endian data
@@ -58,7 +63,8 @@ typedef enum Block_ImageType_t
 {
     Channel_ImageType = 0,      // grayscale per channel
     RGB_ImageType,              // user defined RGB
-    NDVI_ImageType             // user defined NDVI
+    NDVI_ImageType,             // user defined NDVI
+    EVI_ImageType               // user defined EVI
 } Block_ImageType;
 
 
@@ -81,9 +87,14 @@ typedef enum Block_ImageType_t
 class QImage;
 class QString;
 class TCADU;
+class TBlockReader;
+class TSyncScanner;
 class TSatProp;
 class TRGBConf;
 class TNDVI;
+class TEVI;
+class TContrast;
+class TVegetationCache;
 
 //---------------------------------------------------------------------------
 class TBlock
@@ -93,14 +104,20 @@ class TBlock
     ~TBlock(void);
 
     bool open(const char *filename);
-    FILE *getHandle(void) { return fp; }
     void close(void);
 
+    TBlockReader *getReader(void) { return reader; }
+    TSyncScanner *getScanner(void) { return scanner; }
+    TFrameIndex  *getIndex(void) { return index; }
+    TImageStore  *getStore(void) { return store; }
+    FILE *getHandle(void); // legacy stdio handle, use getReader()
+
     QString    getBlockTypeStr(int index, int flags=0);
     bool       setBlockType(Block_Type type);
     Block_Type getBlockType(void) { return blocktype; }
 
     TCADU *getCADU(void) { return cadu; }
+    TCADUStats *getStats(void) { return cadu->getstats(); }
 
     bool isCompressed(void);
     bool uncompress(const char *filename);
@@ -120,10 +137,14 @@ class TBlock
 
     void setFirstFrameSyncPos(long int count=-1) { firstFrameSyncPos = count; }
     int  getFirstFrameSyncPos(void) { return firstFrameSyncPos; }
+    qint64 getFrameSyncPos(int frame_nr) { return index->getOffset(frame_nr); }
+
+    bool fromIndex(void);
     
     //void setImageType(Block_ImageType type);
     void setImageType(int index);
     Block_ImageType getImageType(void) { return imagetype; }
+    Block_ImageType imageType(int index, TRGBConf **rgb, TNDVI **vi, TEVI **ev) const;
     QStringList getImageTypes(void) const;
 
     void setNorthBound(bool on);
@@ -137,21 +158,43 @@ class TBlock
     int  getWidth(void);
     int  getHeight(void);
     bool toImage(QImage *image);
+    bool toImage(QImage *image, int type, int channel);
+    bool toTile(QImage *tile, int x, int y);
+    bool hasImageStore(void);
+    bool decode(void);
+    int  follow(void);
 
     int  Modes;
 
     TSatProp *satprop;
     TRGBConf *rgbconf;
     TNDVI    *ndvi;
+    TEVI     *evi;
+    TContrast *contrast; // 10 to 8 bit scaling of the decoded channels
 
  protected:
     bool init(void);
     void freeBlock(void);
     void setMode(bool on, int flag);
+    bool compose(QImage *image, int x, int y, Block_ImageType it, int channel, TRGBConf *rgb, TNDVI *vi, TEVI *ev);
+    void contrastLUT(quint8 *table, int channel);
 
 
  private:
+    TBlockReader *reader;
+    TSyncScanner *scanner;
+    TFrameIndex  *index;
+    TImageStore  *store;
+    TVegetationCache *vicache;
     FILE *fp;
+
+    // the contrast tables of the channels, see contrastLUT
+    QMutex  lutlock;
+    quint8  *luts;
+    int     lutchannels;
+    quint32 lutbuilt; // bit channel
+    quint32 lutcontrast, lutstore; // the serials they were built with
+
     int  imageChannel;
     long int frames, firstFrameSyncPos;
 
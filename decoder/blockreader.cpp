@@ -0,0 +1,371 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+
+#include "os.h"
+#include "blockreader.h"
+
+#if defined(__HRPT_WIN__)
+#  include <windows.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#else
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------------
+TBlockReader::TBlockReader(void)
+{
+    filename = NULL;
+    fp = NULL;
+    flags = 0;
+
+    filesize = 0;
+    cursor = 0;
+
+    window = NULL;
+    winpos = 0;
+    winlen = 0;
+
+    buffer = NULL;
+    bufsize = 0;
+
+    maphandle = NULL;
+}
+
+//---------------------------------------------------------------------------
+TBlockReader::~TBlockReader(void)
+{
+    close();
+
+    if(buffer)
+        free(buffer);
+}
+
+//---------------------------------------------------------------------------
+bool TBlockReader::open(const char *filename_)
+{
+    close();
+
+    if(filename_ == NULL)
+        return false;
+
+    filename = strdup(filename_);
+    if(filename == NULL)
+        return false;
+
+    if(map())
+        return true;
+
+    // fall back to stdio and a read-ahead window
+    fp = fopen(filename, "rb");
+    if(fp == NULL) {
+        close();
+        return false;
+    }
+
+    if(fseek(fp, 0L, SEEK_END) == 0) {
+#if defined(__HRPT_WIN__)
+        filesize = _ftelli64(fp);
+#else
+        filesize = ftello(fp);
+#endif
+    }
+
+    if(filesize < 0)
+        filesize = 0;
+
+    rewind(fp);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void TBlockReader::close(void)
+{
+    unmap();
+
+    if(fp)
+        fclose(fp);
+    fp = NULL;
+
+    if(filename)
+        free(filename);
+    filename = NULL;
+
+    flags = 0;
+    filesize = 0;
+    cursor = 0;
+
+    window = NULL;
+    winpos = 0;
+    winlen = 0;
+}
+
+//---------------------------------------------------------------------------
+// picks up the data appended to a recording that is still being written,
+// returns true when the file has grown. The cursor is kept, spans returned
+// before are invalid when the file was mapped.
+bool TBlockReader::refresh(void)
+{
+    qint64 size;
+
+    if(!isOpen())
+        return false;
+
+#if defined(__HRPT_WIN__)
+    struct _stati64 st;
+
+    if(_stati64(filename, &st) != 0)
+        return false;
+#else
+    struct stat st;
+
+    if(stat(filename, &st) != 0)
+        return false;
+#endif
+
+    size = (qint64) st.st_size;
+    if(size <= filesize)
+        return false;
+
+    if(isMapped()) {
+        unmap();
+
+        if(map())
+            return true; // the new mapping is as long as the file is now
+
+        // fall back to stdio and a read-ahead window
+        fp = fopen(filename, "rb");
+        if(fp == NULL) {
+            filesize = 0;
+            cursor = 0;
+            return false;
+        }
+
+        window = NULL;
+        winpos = 0;
+        winlen = 0;
+    }
+
+    // the read-ahead window stays valid, written data does not change
+    filesize = size;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool TBlockReader::map(void)
+{
+#if defined(__HRPT_WIN__)
+
+    HANDLE hfile, hmap;
+    LARGE_INTEGER fsize;
+    void *view;
+
+    hfile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(hfile == INVALID_HANDLE_VALUE)
+        return false;
+
+    if(!GetFileSizeEx(hfile, &fsize) || fsize.QuadPart <= 0 ||
+       (quint64) fsize.QuadPart > (quint64) ((size_t) -1)) {
+        CloseHandle(hfile);
+        return false;
+    }
+
+    hmap = CreateFileMappingA(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(hfile); // the mapping keeps its own reference
+
+    if(hmap == NULL)
+        return false;
+
+    view = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0);
+    if(view == NULL) {
+        CloseHandle(hmap);
+        return false;
+    }
+
+    maphandle = (void *) hmap;
+    filesize = fsize.QuadPart;
+    window = (const quint8 *) view;
+
+#else
+
+    struct stat st;
+    void *view;
+    int fd;
+
+    fd = ::open(filename, O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    if(fstat(fd, &st) != 0 || st.st_size <= 0 ||
+       (quint64) st.st_size > (quint64) ((size_t) -1)) {
+        ::close(fd);
+        return false;
+    }
+
+    view = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference
+
+    if(view == MAP_FAILED)
+        return false;
+
+    // sync searches walk the file from start to end
+    madvise(view, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+    filesize = st.st_size;
+    window = (const quint8 *) view;
+
+#endif
+
+    winpos = 0;
+    winlen = filesize;
+    flags |= BR_MAPPED;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void TBlockReader::unmap(void)
+{
+    if(!isMapped())
+        return;
+
+#if defined(__HRPT_WIN__)
+    UnmapViewOfFile((LPCVOID) window);
+    CloseHandle((HANDLE) maphandle);
+#else
+    munmap((void *) window, (size_t) filesize);
+#endif
+
+    maphandle = NULL;
+    window = NULL;
+    flags &= ~BR_MAPPED;
+}
+
+//---------------------------------------------------------------------------
+// moves the read-ahead window so that [offset, offset + len) is inside it
+bool TBlockReader::fill(qint64 offset, size_t len)
+{
+    size_t size;
+
+    if(offset < 0 || len == 0 || offset + (qint64) len > filesize)
+        return false;
+
+    if(isMapped())
+        return true; // everything is already in the window
+
+    if(fp == NULL)
+        return false;
+
+    if(offset >= winpos && offset + (qint64) len <= winpos + winlen)
+        return true;
+
+    if(bufsize < len || buffer == NULL) {
+        size = len > BR_BUFFER_SIZE ? len:BR_BUFFER_SIZE;
+
+        if(buffer)
+            free(buffer);
+
+        buffer = (quint8 *) malloc(size);
+        if(buffer == NULL) {
+            bufsize = 0;
+            winlen = 0;
+            window = NULL;
+
+            qDebug("Failed to allocate read-ahead buffer %s:%d", __FILE__, __LINE__);
+            return false;
+        }
+
+        bufsize = size;
+    }
+
+    size = bufsize;
+    if(offset + (qint64) size > filesize)
+        size = (size_t) (filesize - offset);
+
+    window = buffer;
+    winpos = offset;
+    winlen = 0;
+
+    if(br_fseek(fp, offset) != 0)
+        return false;
+
+    winlen = (qint64) fread(buffer, 1, size, fp);
+
+    return winlen >= (qint64) len;
+}
+
+//---------------------------------------------------------------------------
+bool TBlockReader::seek(qint64 offset)
+{
+    if(offset < 0 || offset > filesize)
+        return false;
+
+    cursor = offset;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool TBlockReader::skip(qint64 bytes)
+{
+    return seek(cursor + bytes);
+}
+
+//---------------------------------------------------------------------------
+size_t TBlockReader::read(void *dst, size_t len)
+{
+    const quint8 *src;
+
+    if(cursor + (qint64) len > filesize)
+        len = cursor < filesize ? (size_t) (filesize - cursor):0;
+
+    if(len == 0)
+        return 0;
+
+    src = data(cursor, len);
+    if(src == NULL)
+        return 0;
+
+    memcpy(dst, src, len);
+    cursor += len;
+
+    return len;
+}
+
+//---------------------------------------------------------------------------
+// returns a pointer to len bytes at file offset, NULL if not available
+const quint8 *TBlockReader::data(qint64 offset, size_t len)
+{
+    if(!fill(offset, len))
+        return NULL;
+
+    return window + (offset - winpos);
+}
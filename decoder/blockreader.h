@@ -0,0 +1,116 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef BLOCKREADER_H
+#define BLOCKREADER_H
+
+#include <QtGlobal>
+#include <stdio.h>
+
+#include "os.h"
+
+// 64 bit stdio seek to offset from the start of the file
+#if defined(__HRPT_WIN__)
+#  define br_fseek(f, o) _fseeki64(f, o, SEEK_SET)
+#else
+#  include <sys/types.h>
+#  define br_fseek(f, o) fseeko(f, (off_t) (o), SEEK_SET)
+#endif
+
+//---------------------------------------------------------------------------
+#define BR_MAPPED           1   // whole file is memory mapped
+
+#define BR_BUFFER_SIZE      (4 << 20) // read-ahead window when mmap fails, 4 MB
+
+//---------------------------------------------------------------------------
+// Shared input layer for all block decoders.
+// The recording is memory mapped when possible, otherwise it is read
+// through a large read-ahead window. The cursor (pos, seek, skip, read)
+// replaces the old fread/fseek/ftell calls and data() / peek() return
+// spans straight into the mapping or window.
+class TBlockReader
+{
+public:
+    TBlockReader(void);
+    ~TBlockReader(void);
+
+    bool open(const char *filename);
+    void close(void);
+    bool refresh(void);
+
+    bool isOpen(void) { return filename != NULL; }
+    bool isMapped(void) { return flags & BR_MAPPED ? true:false; }
+    const char *fileName(void) { return filename; }
+
+    qint64 size(void) { return filesize; }
+    qint64 pos(void) { return cursor; }
+    bool   atEnd(void) { return cursor >= filesize; }
+
+    bool seek(qint64 offset);
+    bool skip(qint64 bytes);
+
+    // byte wise access, the fast path never leaves this header
+    bool readByte(quint8 *ch)
+    {
+        qint64 i = cursor - winpos;
+
+        if(i < 0 || i >= winlen) {
+            if(!fill(cursor, 1))
+                return false;
+            i = cursor - winpos;
+        }
+
+        *ch = window[i];
+        cursor++;
+
+        return true;
+    }
+
+    size_t read(void *dst, size_t len);
+
+    // spans are valid until the next call that moves the read-ahead window,
+    // they never move when the file is mapped
+    const quint8 *peek(size_t len) { return data(cursor, len); }
+    const quint8 *data(qint64 offset, size_t len);
+
+protected:
+    bool map(void);
+    void unmap(void);
+    bool fill(qint64 offset, size_t len);
+
+private:
+    char   *filename;
+    FILE   *fp;
+    int    flags;
+
+    qint64 filesize, cursor;
+
+    // current window, the whole file when mapped
+    const quint8 *window;
+    qint64 winpos, winlen;
+
+    quint8 *buffer;
+    size_t bufsize;
+
+    void   *maphandle; // win32 file mapping object
+};
+
+#endif // BLOCKREADER_H
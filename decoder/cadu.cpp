@@ -24,40 +24,57 @@
 //---------------------------------------------------------------------------
 #include <QtGlobal>
 
-#ifdef HAVE_LIBFEC
-extern "C" {
-#  include <fec.h>
-}
+#include <memory.h>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
 #endif
 
-#include <memory.h>
 #include "cadu.h"
+#include "blockreader.h"
+#include "syncscanner.h"
+#include "synccorrelator.h"
+#include "rsdecoder.h"
+#include "cadupipeline.h"
+#include "trace.h"
 
 //#define DEBUG_RS
 
 //---------------------------------------------------------------------------
 TCADU::TCADU(void)
 {
-    fp = NULL;
+    reader = NULL;
     outfp = NULL;
 
     flags = 0;
     payload_size = 0;
-    rs_size = 0;
     packets = 0;
+    packet_address = found_address = 0;
+    payload_address = -1;
+
+    pipe = NULL;
+    pipe_ready = false;
 
     payload_buf = NULL;
-    derand_buf = NULL;
-    rs_buf = NULL;
+    rs = NULL;
+    rs_errors = 0;
+
+    correlator = NULL;
+    sync_errors = CORR_DEFAULT_ERRORS;
+    phase = 0;
+    sync_bit = next_bit = -1;
+    reader_pos = 0;
 }
 
 //---------------------------------------------------------------------------
-bool TCADU::init(FILE *fp_, size_t payload_size_, FILE *outfp_)
+bool TCADU::init(TBlockReader *reader_, size_t payload_size_, FILE *outfp_)
 {
     outfp = outfp_;
-    fp = fp_;
+    reader = reader_;
 
-    if(fp == NULL)
+    if(reader == NULL || !reader->isOpen())
         return false;
 
     payload_size = payload_size_;
@@ -66,21 +83,12 @@ bool TCADU::init(FILE *fp_, size_t payload_size_, FILE *outfp_)
     if(payload_buf == NULL)
         return false;
 
-    if(!init_derandomizer())
+    if(!init_correlator())
         return false;
 
-#ifdef HAVE_LIBFEC
-
-    rs_size = 255; // ccsds 255,233
     if(!init_reed_solomon())
         return false;
 
-#else
-
-    reed_solomon(false);
-
-#endif
-
     return true;
 }
 
@@ -93,25 +101,34 @@ TCADU::~TCADU(void)
 //---------------------------------------------------------------------------
 void TCADU::reset(void)
 {
+    stop_pipeline();
+
     if(payload_buf)
         free(payload_buf);
     payload_buf = NULL;
 
-    if(derand_buf)
-        free(derand_buf);
-    derand_buf = NULL;
+    if(rs)
+        delete rs;
+    rs = NULL;
 
-    if(rs_buf)
-        free(rs_buf);
-    rs_buf = NULL;
+    if(correlator)
+        delete correlator;
+    correlator = NULL;
 
-    fp = NULL;
+    reader = NULL;
     outfp = NULL;
 
     flags = 0;
     packets = 0;
+    payload_address = -1;
     payload_size = 0;
-    rs_size = 0;
+
+    sync_errors = CORR_DEFAULT_ERRORS;
+    phase = 0;
+    sync_bit = next_bit = -1;
+    reader_pos = 0;
+
+    stats.reset();
 }
 
 //---------------------------------------------------------------------------
@@ -146,103 +163,177 @@ void TCADU::derandomize(bool enable)
 }
 
 //---------------------------------------------------------------------------
-bool TCADU::init_reed_solomon(void)
+// max_errors is the Hamming distance threshold, -1 keeps the current one
+void TCADU::soft_sync(bool enable, int max_errors)
 {
-#ifdef HAVE_LIBFEC
+    setflag(CADU_SOFT_SYNC, enable);
 
-    if(!reed_solomon() || rs_buf != NULL) // not enabled or already inited
-        return true;
+    if(max_errors >= 0)
+        sync_errors = max_errors;
 
-    rs_buf = (unsigned char *) malloc(rs_size);
-    if(rs_buf == NULL) {
-        reed_solomon(false);
-        qDebug("Failed to allocate reed solomon buffer %s:%d", __FILE__,__LINE__);
+    if(correlator)
+        correlator->setThreshold(sync_errors);
+}
 
-        return false;
-    }
+//---------------------------------------------------------------------------
+// counts every CADU read by getpayload, enabling starts a new pass
+void TCADU::collect_stats(bool enable)
+{
+    if(enable && !collect_stats())
+        stats.reset();
 
-#endif
+    setflag(CADU_STATS, enable);
+}
+
+//---------------------------------------------------------------------------
+bool TCADU::init_correlator(void)
+{
+    if(!soft_sync() || correlator != NULL) // not enabled or already inited
+        return true;
+
+    correlator = new TSyncCorrelator;
+    correlator->setThreshold(sync_errors);
 
     return true;
 }
 
 //---------------------------------------------------------------------------
-bool TCADU::init_derandomizer(void)
+bool TCADU::init_reed_solomon(void)
 {
-    if(!derandomize() || derand_buf != NULL) // not enabled or already inited
+    if(!reed_solomon() || rs != NULL) // not enabled or already inited
         return true;
 
-    derand_buf = (unsigned char *) calloc(payload_size, sizeof(unsigned char));
-    if(derand_buf == NULL) {
-        derandomize(false);
-        qDebug("Failed to allocate derandomizer buffer %s:%d", __FILE__,__LINE__);
+    // ccsds 255,223, the payload holds payload_size / 255 interleaved codewords
+    if(payload_size < RS_NN || (payload_size % RS_NN) != 0 ||
+       payload_size / RS_NN > RS_MAX_INTERLEAVE) {
+        reed_solomon(false);
+        qDebug("Reed Solomon disabled, payload size %d %s:%d", (int) payload_size, __FILE__,__LINE__);
 
-        return false;
+        return true;
     }
 
-    size_t i, r, nbits;
-    int regs[8], reg_7;
+    rs = new TRSDecoder(payload_size / RS_NN, true);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//
+//      CCSDS pseudo random sequence, h(x) = x^8 + x^7 + x^5 + x^3 + 1
+//
+//---------------------------------------------------------------------------
+// The sequence repeats every 255 bytes, the table holds 32 periods so that
+// every 16 and 32 byte block of a payload starts at an aligned table offset
+// and payloads of any size wrap around at a period boundary.
+// It is filled once, before main(), and shared by every TCADU.
+#if defined(_MSC_VER)
+__declspec(align(32)) static quint8 pn_table[CADU_PN_SPAN];
+#else
+static quint8 pn_table[CADU_PN_SPAN] __attribute__((aligned(32)));
+#endif
+
+class TPNTable
+{
+public:
+    TPNTable(void)
+    {
+        quint8 reg, b;
+        int i, j;
+
+        reg = 0xff; // all shift registers set to 1
+
+        for(i=0; i<CADU_PN_PERIOD; i++) {
+            b = 0;
+            for(j=0; j<8; j++) {
+                b = (b << 1) | (reg & 1);
+                reg = (reg >> 1) | ((((reg >> 0) ^ (reg >> 3) ^ (reg >> 5) ^ (reg >> 7)) & 1) << 7);
+            }
+
+            pn_table[i] = b;
+        }
 
-    // init shift registers to 1
-    for(i=0; i<8; i++)
-        regs[i] = 1;
+        for(i=CADU_PN_PERIOD; i<CADU_PN_SPAN; i++)
+            pn_table[i] = pn_table[i - CADU_PN_PERIOD];
+    }
+};
 
-    nbits = payload_size << 3; // payload_size * 8 bits
+static TPNTable pn_table_init;
 
-    for(i=0; i<nbits; i++) {
-        // copy register 0 into next bit of decode array
-        if(regs[0] == 1)
-            derand_buf[i >> 3] |= (1 << ((7 - (i % 8))));
+//---------------------------------------------------------------------------
+// dst = src ^ PN, dst may be src. Fuses the derandomizer into the copy out
+// of the input buffer.
+void TCADU::pn_xor(quint8 *dst, const quint8 *src, size_t len)
+{
+    size_t i, n;
+    const quint8 *pn;
+
+    while(len > 0) {
+        n = len > CADU_PN_SPAN ? CADU_PN_SPAN:len;
+        pn = pn_table;
+        i = 0;
+
+#if defined(__AVX2__)
+        for(; i + 32 <= n; i += 32)
+            _mm256_storeu_si256((__m256i *) (dst + i),
+                                _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (src + i)),
+                                                 _mm256_load_si256((const __m256i *) (pn + i))));
+#endif
 
-        // calculate new top bit
-        reg_7 = ((regs[0] + regs[3] + regs[5] + regs[7]) % 2);
+#if defined(__SSE2__)
+        for(; i + 16 <= n; i += 16)
+            _mm_storeu_si128((__m128i *) (dst + i),
+                             _mm_xor_si128(_mm_loadu_si128((const __m128i *) (src + i)),
+                                           _mm_load_si128((const __m128i *) (pn + i))));
+#endif
 
-        // shift registers
-        for(r=0; r<7; r++)
-            regs[r] = regs[r + 1];
+        for(; i<n; i++)
+            dst[i] = src[i] ^ pn[i];
 
-        // set new top bit
-        regs[7] = reg_7;
+        dst += n;
+        src += n;
+        len -= n;
     }
+}
 
-    return true;
+//---------------------------------------------------------------------------
+const quint8 *TCADU::pn_sequence(void)
+{
+    return pn_table;
 }
 
 //---------------------------------------------------------------------------
 void TCADU::randomize(void)
 {
-    if(derandomize()) {
-        for(size_t i=0; i<payload_size; i++)
-            payload_buf[i] ^= derand_buf[i];
-    }
+    if(derandomize())
+        pn_xor(payload_buf, payload_buf, payload_size);
 }
 
 //---------------------------------------------------------------------------
 bool TCADU::rsdecode(void)
 {
-    if(!reed_solomon())
-        return true;
+    TRACE_SCOPE("TCADU::rsdecode");
 
-#ifdef HAVE_LIBFEC
+    rs_errors = 0;
 
-    int i, j, rc, errors = 0;
+    if(!reed_solomon() || rs == NULL)
+        return true;
 
-    for(i=0; i<4; i++) {
-        for(j=0; j<255; j++)
-            rs_buf[j] = payload_buf[i + j*4];
+    // all interleaves in place, clean codewords exit after the syndromes
+    int errors = rs->decode(payload_buf);
 
-        rc = decode_rs_ccsds(rs_buf, NULL, 0, 0);
-        if(rc == -1) {
-            qDebug("Reed Solomon failed @ address 0x%08X %s:%d", (unsigned int)packet_address, __FILE__, __LINE__);
-            return false;
-        }
+    rs_errors = errors;
 
-        errors += rc;
+    if(collect_stats())
+        stats.rsResult(rs);
 
-        for(j=0; j<255; j++)
-            payload_buf[i + j*4] = rs_buf[j];
+    if(errors < 0) {
+        TRACE_COUNT("TCADU::rs_failed", 1);
+        qDebug("Reed Solomon failed @ address 0x%08X %s:%d", (unsigned int)packet_address, __FILE__, __LINE__);
+        return false;
     }
 
+    TRACE_COUNT("TCADU::rs_symbols", errors);
+
 #ifdef DEBUG_RS
     if(errors == 0) {
         qDebug("Reed Solomon succeded @ address 0x%08X %s:%d", (unsigned int)packet_address, __FILE__, __LINE__);
@@ -252,46 +343,353 @@ bool TCADU::rsdecode(void)
     }
 #endif
 
-#endif // #ifdef HAVE_LIBFEC
-
     return true;
 }
 
 //---------------------------------------------------------------------------
 bool TCADU::findsync(const unsigned char *sync, int sync_size)
 {
-    unsigned char ch;
-    int i = 0;
+    if(pipe) {
+        if(!pipe->next(payload_buf, &packet_address, &rs_errors))
+            return false;
 
-    while(fread(&ch, 1, 1, fp) == 1) {
-        if(ch == sync[i])
-            i++;
-        else
-            i = 0;
+        pipe_ready = true;
+
+        return true;
+    }
+
+    if(!locate(sync, sync_size))
+        return false;
+
+    packet_address = found_address;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// moves the reader past the next sync, sets found_address
+bool TCADU::locate(const unsigned char *sync, int sync_size)
+{
+    const quint8 *buf;
+    qint64 remaining, offset;
+    size_t len;
+
+    if(soft_sync() && correlator)
+        return findsoftsync(sync, sync_size);
+
+    while((remaining = reader->size() - reader->pos()) >= sync_size) {
+        len = remaining > SYNC_SCAN_CHUNK ? SYNC_SCAN_CHUNK:(size_t) remaining;
+
+        buf = reader->peek(len);
+        if(buf == NULL)
+            break;
 
-        if(i == sync_size) {
-            packet_address = ftell(fp) - sync_size;
-            packets++;
+        offset = TSyncScanner::find(buf, len, sync, sync_size);
+        if(offset >= 0) {
+            reader->skip(offset + sync_size);
+
+            found_address = reader->pos() - sync_size;
 
             return true;
         }
+
+        // keep the last bytes, the sync may cross the chunk border
+        if(!reader->skip(len - sync_size + 1))
+            break;
     }
 
     return false;
 }
 
 //---------------------------------------------------------------------------
-unsigned char *TCADU::getpayload(void)
+// Streaming realignment of a bit slipped or phase rotated recording.
+// Once locked the next sync is only checked where the previous CADU ends,
+// a lost lock (bit slip) starts a new search after the previous sync.
+// A sync with bit errors found by searching must be confirmed by the sync
+// of the following CADU before the stream is locked to it.
+bool TCADU::findsoftsync(const unsigned char *sync, int sync_size)
+{
+    qint64 bit, from, frame_bits;
+    int    p, errors;
+
+    if(!correlator->setSync(sync, sync_size))
+        return false;
+
+    frame_bits = (qint64) (sync_size + payload_size) << 3;
+
+    // the reader was moved by the caller, eg. restarted from the beginning
+    if(next_bit >= 0 && reader->pos() != reader_pos)
+        sync_bit = next_bit = -1;
+
+    if(next_bit >= 0) {
+        if(next_bit + correlator->getSyncBits() > (reader->size() << 3)) {
+            reader->seek(reader->size());
+            reader_pos = reader->pos();
+
+            return false; // end of file
+        }
+
+        if(correlator->match(reader, next_bit, phase, NULL)) {
+            sync_bit = next_bit;
+            next_bit += frame_bits;
+        }
+        else {
+            from = sync_bit + correlator->getSyncBits();
+            sync_bit = next_bit = -1;
+            if(collect_stats())
+                stats.slip();
+
+            reader->seek(from >> 3);
+        }
+    }
+
+    if(next_bit < 0) {
+        from = reader->pos() << 3;
+
+        while(correlator->search(reader, from, &bit, &p, &errors)) {
+            if(errors == 0 || correlator->match(reader, bit + frame_bits, p, NULL)) {
+                sync_bit = bit;
+                next_bit = bit + frame_bits;
+                phase = p;
+                break;
+            }
+
+            from = bit + 1;
+        }
+
+        if(next_bit < 0) {
+            reader->seek(reader->size());
+            reader_pos = reader->pos();
+
+            return false;
+        }
+    }
+
+    // byte holding the first payload bit
+    reader->seek((sync_bit + correlator->getSyncBits()) >> 3);
+    reader_pos = reader->pos();
+
+    found_address = (long) (sync_bit >> 3);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// positions at the CADU whose sync starts at sync_address, see getpacketaddress
+bool TCADU::seek(long sync_address)
+{
+    if(soft_sync() && correlator) {
+        sync_bit = next_bit = -1;
+
+        if(!reader->seek(sync_address))
+            return false;
+
+        if(!findsoftsync(CADU_SYNC, CADU_SYNC_SIZE))
+            return false;
+
+        packet_address = found_address;
+
+        return true;
+    }
+
+    packet_address = sync_address;
+
+    return reader->seek(sync_address + CADU_SYNC_SIZE);
+}
+
+//---------------------------------------------------------------------------
+// positions after the CADU of the last payload returned, eg. by a pipeline
+// that has been stopped or a read that ended in a cut off CADU
+bool TCADU::resume(void)
+{
+    sync_bit = next_bit = -1;
+
+    if(payload_address < 0)
+        return reader->seek(0);
+
+    // search on from the byte after the last sync
+    if(soft_sync() && correlator)
+        return reader->seek(payload_address + 1);
+
+    return reader->seek(payload_address + CADU_SYNC_SIZE + payload_size);
+}
+
+//---------------------------------------------------------------------------
+// findsync and getpayload at the end of a growing recording, a CADU that
+// is not completely written yet is left where it is for the next call
+unsigned char *TCADU::gettailpayload(void)
 {
-    if(fread(payload_buf, payload_size, 1, fp) != 1)
+    qint64 from = reader->pos(), tail;
+    unsigned char *payload;
+
+    if(!findsync()) {
+        // the sync may be cut by the end of the file
+        tail = reader->size() - CADU_SYNC_SIZE - 1;
+        reader->seek(tail > from ? tail:from);
+
         return NULL;
+    }
+
+    if((payload = getpayload()) == NULL)
+        reader->seek(packet_address);
+
+    return payload;
+}
+
+//---------------------------------------------------------------------------
+unsigned char *TCADU::getpayload(void)
+{
+    TRACE_SCOPE("TCADU::getpayload");
+
+    if(pipe) {
+        // decoded by a worker, rs_errors is set
+        if(!pipe_ready && !pipe->next(payload_buf, &packet_address, &rs_errors))
+            return NULL;
+
+        pipe_ready = false;
+    }
+    else if(soft_sync() && correlator) {
+        if(sync_bit < 0 ||
+           !correlator->extract(reader, sync_bit + correlator->getSyncBits(), phase, payload_buf, payload_size))
+            return NULL;
 
-    randomize();
-    rsdecode();
+        // the next sync may start inside the last payload byte
+        reader->seek(next_bit >> 3);
+        reader_pos = reader->pos();
+
+        randomize();
+    }
+    else {
+        const quint8 *src = reader->peek(payload_size);
+
+        if(src == NULL)
+            return NULL;
+
+        // copy and derandomize in one pass
+        if(derandomize())
+            pn_xor(payload_buf, src, payload_size);
+        else
+            memcpy(payload_buf, src, payload_size);
+
+        reader->skip(payload_size);
+    }
+
+    // a sync found again after gettailpayload or a slip is counted once
+    if(!pipe) {
+        packets++;
+        rsdecode();
+    }
+
+    payload_address = packet_address;
+
+    if(collect_stats()) {
+        stats.cadus++;
+        stats.vcdu(vcid(), counter());
+    }
 
     return payload_buf;
 }
 
+//---------------------------------------------------------------------------
+// Starts reading the CADUs from sync_address on a sync stage thread and
+// workers decoding threads. The VCDU counters are still collected here in
+// stream order, sync slips by the sync stage (the only writer of slips) and
+// the RS counters of the workers are added by stop_pipeline.
+bool TCADU::start_pipeline(long sync_address, int workers)
+{
+    stop_pipeline();
+
+    if(reader == NULL || payload_buf == NULL)
+        return false;
+
+    sync_bit = next_bit = -1;
+    if(!reader->seek(sync_address))
+        return false;
+
+    pipe = new TCADUPipeline(this, payload_size);
+    if(!pipe->start(workers)) {
+        delete pipe;
+        pipe = NULL;
+
+        return false;
+    }
+
+    pipe_ready = false;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void TCADU::stop_pipeline(void)
+{
+    if(pipe == NULL)
+        return;
+
+    pipe->stop();
+    if(collect_stats())
+        pipe->addStats(&stats);
+
+    delete pipe;
+    pipe = NULL;
+    pipe_ready = false;
+
+    // the sync stage moved the reader, seek before reading on
+    sync_bit = next_bit = -1;
+}
+
+//---------------------------------------------------------------------------
+// the raw payload of the next CADU, as it is in the recording
+bool TCADU::readraw(quint8 *dst, long *address)
+{
+    const quint8 *src;
+
+    if(!locate(CADU_SYNC, CADU_SYNC_SIZE))
+        return false;
+
+    *address = found_address;
+
+    if(soft_sync() && correlator) {
+        if(sync_bit < 0 ||
+           !correlator->extract(reader, sync_bit + correlator->getSyncBits(), phase, dst, payload_size))
+            return false;
+
+        reader->seek(next_bit >> 3);
+        reader_pos = reader->pos();
+    }
+    else {
+        if((src = reader->peek(payload_size)) == NULL)
+            return false;
+
+        memcpy(dst, src, payload_size);
+        reader->skip(payload_size);
+    }
+
+    packets++;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// derandomizes and RS decodes a raw payload in place, returns the
+// corrected symbols or -1, see getrserrors
+int TCADU::decode(quint8 *buf, TRSDecoder *rs_, TCADUStats *stats_)
+{
+    TRACE_SCOPE("TCADU::decode");
+    int errors = 0;
+
+    if(derandomize())
+        pn_xor(buf, buf, payload_size);
+
+    if(reed_solomon() && rs_) {
+        errors = rs_->decode(buf);
+
+        if(stats_)
+            stats_->rsResult(rs_);
+    }
+
+    return errors;
+}
+
 //---------------------------------------------------------------------------
 void TCADU::writepacket(bool include_sync)
 {
@@ -339,6 +737,12 @@ quint8 TCADU::key(void)
     return payload_buf[7]; // 8 bit
 }
 
+//---------------------------------------------------------------------------
+quint32 TCADU::counter(void)
+{
+    return ((quint32) payload_buf[2] << 16) | ((quint32) payload_buf[3] << 8) | payload_buf[4]; // 24 bit
+}
+
 //---------------------------------------------------------------------------
 //
 //      M-PDU (CCSDS) Information, Packet size = 882 (0x0372) bytes
@@ -29,18 +29,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "cadustats.h"
+
 //---------------------------------------------------------------------------
 
 #define CADU_RS_DECODE      1
 #define CADU_DERANDOMIZE    2
 #define CADU_LRIT           4 // LRIT HRIT CADU type
+#define CADU_SOFT_SYNC      8 // bit slip and phase tolerant sync
+#define CADU_STATS          16 // collect link quality statistics
 
 #define CADU_PACKET_SIZE    1020
+
+#define CADU_PN_PERIOD      255                  // bytes
+#define CADU_PN_SPAN        (CADU_PN_PERIOD * 32) // PN table size, 32 byte aligned blocks
 #define CADU_SYNC_SIZE 4
 static const unsigned char CADU_SYNC[CADU_SYNC_SIZE] = {
   0x1A, 0xCF, 0xFC, 0x1D,
 };
 
+//---------------------------------------------------------------------------
+class TBlockReader;
+class TSyncCorrelator;
+class TRSDecoder;
+class TCADUPipeline;
+
 //---------------------------------------------------------------------------
 class TCADU
 {
@@ -48,7 +61,7 @@ public:
     TCADU(void);
     ~TCADU(void);
 
-    bool init(FILE *fp_, size_t payload_size_, FILE *oufp_= NULL);
+    bool init(TBlockReader *reader_, size_t payload_size_, FILE *oufp_= NULL);
     void reset(void);
 
     void lrit_cadu(bool enable);
@@ -59,6 +72,7 @@ public:
     quint8     vcid(void);
     bool       isencrypted(void);
     quint8     key(void);
+    quint32    counter(void);
 
     // CCSDS (M-PDU) Header Information
     quint8     *get_mpdu(void);
@@ -72,16 +86,44 @@ public:
     bool reed_solomon(void) { return flags & CADU_RS_DECODE ? true:false; }
     void reed_solomon(bool enable);
     bool rsdecode(void);
+    int  getrserrors(void) { return rs_errors; } // last CADU, -1 = failed
 
     bool derandomize(void) { return flags & CADU_DERANDOMIZE ? true:false; }
     void derandomize(bool enable);
 
+    static void          pn_xor(quint8 *dst, const quint8 *src, size_t len);
+    static const quint8 *pn_sequence(void);
+
+    bool soft_sync(void) { return flags & CADU_SOFT_SYNC ? true:false; }
+    void soft_sync(bool enable, int max_errors = -1);
+
     bool           findsync(const unsigned char *sync = CADU_SYNC, int sync_size = CADU_SYNC_SIZE);
+    bool           seek(long sync_address);
     unsigned char *getpayload(void);
+
+    // a recording that is still being written, see TBlock::follow
+    bool           resume(void);
+    unsigned char *gettailpayload(void);
+
+    // findsync and getpayload read from a TCADUPipeline while started
+    bool start_pipeline(long sync_address, int workers);
+    void stop_pipeline(void);
+    bool pipelined(void) { return pipe != NULL; }
+
+    // pipeline stages, readraw runs on the sync stage thread and
+    // decode on the worker threads with their own decoder and counters
+    bool readraw(quint8 *dst, long *address);
+    int  decode(quint8 *buf, TRSDecoder *rs_, TCADUStats *stats_);
     unsigned char *getpayload_buffer(void) { return payload_buf; }
 
     long getpacketaddress(void) { return packet_address; }
     long getpackets(void) { return packets; }
+    long getslips(void) { return stats.slips; }
+    int  getphase(void) { return phase; }
+
+    bool        collect_stats(void) { return flags & CADU_STATS ? true:false; }
+    void        collect_stats(bool enable);
+    TCADUStats *getstats(void) { return &stats; }
 
     void writepacket(bool include_sync);
     void writeVCDU(void);
@@ -90,21 +132,35 @@ public:
 
 protected:
     void setflag(int flag, bool on);
-    bool init_derandomizer(void);
     bool init_reed_solomon(void);
     void randomize(void);
+    bool init_correlator(void);
+    bool findsoftsync(const unsigned char *sync, int sync_size);
+    bool locate(const unsigned char *sync, int sync_size);
 
 private:
-    FILE *fp;
+    TBlockReader *reader;
 
     size_t         payload_size;
     unsigned char *payload_buf;
-    unsigned char *derand_buf;
 
-    size_t        rs_size;
-    unsigned char *rs_buf;
+    TRSDecoder    *rs;
+    int            rs_errors;
+
+    long packets; // CADUs read, see getpayload and readraw
+    long packet_address;
+    long payload_address; // CADU of the last payload returned, see resume
+    long found_address; // last sync found by locate
+
+    TCADUPipeline *pipe;
+    bool           pipe_ready; // findsync got the payload of the next getpayload
+
+    TSyncCorrelator *correlator;
+    int    sync_errors, phase;
+    qint64 sync_bit, next_bit; // -1 when not locked
+    qint64 reader_pos;
 
-    long packets, packet_address;
+    TCADUStats stats;
 
     int flags;
 };
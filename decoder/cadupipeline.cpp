@@ -0,0 +1,350 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <QThread>
+#include <string.h>
+
+#include "cadupipeline.h"
+#include "cadu.h"
+
+//---------------------------------------------------------------------------
+//
+//      TCADURing
+//
+//---------------------------------------------------------------------------
+TCADURing::TCADURing(size_t payload_size) :
+    empty(CADUPIPE_SLOTS), full(0), ready(0)
+{
+    int i;
+
+    write = done = read = 0;
+
+    buffer = (quint8 *) malloc(payload_size * CADUPIPE_SLOTS);
+    if(buffer == NULL)
+        qDebug("Failed to allocate CADU ring %s:%d", __FILE__, __LINE__);
+
+    for(i=0; i<CADUPIPE_SLOTS; i++) {
+        entries[i].data = buffer ? buffer + i * payload_size:NULL;
+        entries[i].address = 0;
+        entries[i].rs_errors = 0;
+        entries[i].eof = false;
+    }
+}
+
+//---------------------------------------------------------------------------
+TCADURing::~TCADURing(void)
+{
+    if(buffer)
+        free(buffer);
+}
+
+//---------------------------------------------------------------------------
+// The semaphores publish the slot contents, release and acquire pair like
+// a mutex unlock and lock.
+TCADUSlot *TCADURing::toFill(void)
+{
+    if(!empty.tryAcquire(1, CADUPIPE_WAIT_MS))
+        return NULL; // full, the consumer is behind
+
+    return &entries[write & (CADUPIPE_SLOTS - 1)];
+}
+
+//---------------------------------------------------------------------------
+void TCADURing::filled(void)
+{
+    write++;
+    full.release();
+}
+
+//---------------------------------------------------------------------------
+TCADUSlot *TCADURing::toDecode(void)
+{
+    if(!full.tryAcquire(1, CADUPIPE_WAIT_MS))
+        return NULL;
+
+    return &entries[done & (CADUPIPE_SLOTS - 1)];
+}
+
+//---------------------------------------------------------------------------
+void TCADURing::decoded(void)
+{
+    done++;
+    ready.release();
+}
+
+//---------------------------------------------------------------------------
+TCADUSlot *TCADURing::toConsume(void)
+{
+    if(!ready.tryAcquire(1, CADUPIPE_WAIT_MS))
+        return NULL;
+
+    return &entries[read & (CADUPIPE_SLOTS - 1)];
+}
+
+//---------------------------------------------------------------------------
+void TCADURing::consumed(void)
+{
+    read++;
+    empty.release();
+}
+
+//---------------------------------------------------------------------------
+//
+//      TCADUPipeStage
+//
+//---------------------------------------------------------------------------
+class TCADUPipeStage : public QThread
+{
+public:
+    // worker -1 is the sync stage
+    TCADUPipeStage(TCADUPipeline *pipe_, int worker_)
+    {
+        pipe = pipe_;
+        worker = worker_;
+    }
+
+    void run()
+    {
+        if(worker < 0)
+            pipe->syncStage();
+        else
+            pipe->decodeStage(worker);
+    }
+
+private:
+    TCADUPipeline *pipe;
+    int           worker;
+};
+
+//---------------------------------------------------------------------------
+//
+//      TCADUPipeline
+//
+//---------------------------------------------------------------------------
+TCADUPipeline::TCADUPipeline(TCADU *cadu_, size_t payload_size_) :
+    abort(0)
+{
+    int i;
+
+    cadu = cadu_;
+    payload_size = payload_size_;
+
+    for(i=0; i<CADUPIPE_MAX_WORKERS; i++) {
+        rings[i] = NULL;
+        rs[i] = NULL;
+    }
+
+    for(i=0; i<=CADUPIPE_MAX_WORKERS; i++)
+        stages[i] = NULL;
+
+    workers = turn = 0;
+    finished = true;
+}
+
+//---------------------------------------------------------------------------
+TCADUPipeline::~TCADUPipeline(void)
+{
+    stop();
+}
+
+//---------------------------------------------------------------------------
+// the CADU reader must be positioned, the sync stage starts searching there
+bool TCADUPipeline::start(int nworkers)
+{
+    int i;
+
+    stop();
+
+    if(nworkers < 1)
+        nworkers = 1;
+    else if(nworkers > CADUPIPE_MAX_WORKERS)
+        nworkers = CADUPIPE_MAX_WORKERS;
+
+    for(i=0; i<nworkers; i++) {
+        rings[i] = new TCADURing(payload_size);
+        if(!rings[i]->isValid()) {
+            stop();
+
+            return false;
+        }
+
+        // the decoders keep their syndromes and error counts, one each
+        if(cadu->reed_solomon())
+            rs[i] = new TRSDecoder(payload_size / RS_NN, true);
+
+        stats[i].reset();
+    }
+
+    workers = nworkers;
+    turn = 0;
+    finished = false;
+    abort.fetchAndStoreOrdered(0);
+
+    stages[0] = new TCADUPipeStage(this, -1);
+    for(i=0; i<workers; i++)
+        stages[i + 1] = new TCADUPipeStage(this, i);
+
+    for(i=0; i<=workers; i++)
+        stages[i]->start();
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// stops the stages, CADUs still in flight are dropped
+void TCADUPipeline::stop(void)
+{
+    int i;
+
+    abort.fetchAndStoreOrdered(1);
+
+    for(i=0; i<=CADUPIPE_MAX_WORKERS; i++) {
+        if(stages[i]) {
+            stages[i]->wait();
+            delete stages[i];
+        }
+        stages[i] = NULL;
+    }
+
+    for(i=0; i<CADUPIPE_MAX_WORKERS; i++) {
+        if(rings[i])
+            delete rings[i];
+        rings[i] = NULL;
+
+        if(rs[i])
+            delete rs[i];
+        rs[i] = NULL;
+    }
+
+    workers = turn = 0;
+    finished = true;
+}
+
+//---------------------------------------------------------------------------
+bool TCADUPipeline::isAborted(void)
+{
+    return abort.fetchAndAddAcquire(0) ? true:false;
+}
+
+//---------------------------------------------------------------------------
+bool TCADUPipeline::next(quint8 *payload, long *address, int *rs_errors)
+{
+    TCADURing *ring;
+    TCADUSlot *slot;
+
+    if(finished)
+        return false;
+
+    // toConsume sleeps while the worker is behind
+    ring = rings[turn];
+    while((slot = ring->toConsume()) == NULL)
+        continue;
+
+    if(slot->eof) {
+        ring->consumed();
+        finished = true;
+
+        return false;
+    }
+
+    memcpy(payload, slot->data, payload_size);
+    *address = slot->address;
+    *rs_errors = slot->rs_errors;
+
+    ring->consumed();
+    turn = (turn + 1) % workers;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void TCADUPipeline::addStats(TCADUStats *dst)
+{
+    int i;
+
+    for(i=0; i<CADUPIPE_MAX_WORKERS; i++)
+        dst->add(stats[i]);
+}
+
+//---------------------------------------------------------------------------
+// stage 1, deals the raw CADUs round robin to the workers
+void TCADUPipeline::syncStage(void)
+{
+    TCADUSlot *slot;
+    int  w, i;
+    bool eof;
+
+    w = 0;
+    eof = false;
+
+    while(!eof) {
+        while((slot = rings[w]->toFill()) == NULL) {
+            if(isAborted())
+                return;
+        }
+
+        eof = !cadu->readraw(slot->data, &slot->address);
+        slot->eof = eof;
+        slot->rs_errors = 0;
+
+        rings[w]->filled();
+        w = (w + 1) % workers;
+    }
+
+    // the other workers are done as well
+    for(i=1; i<workers; i++) {
+        while((slot = rings[w]->toFill()) == NULL) {
+            if(isAborted())
+                return;
+        }
+
+        slot->eof = true;
+        rings[w]->filled();
+        w = (w + 1) % workers;
+    }
+}
+
+//---------------------------------------------------------------------------
+// stage 2, derandomizes and Reed Solomon decodes the CADUs of one ring
+void TCADUPipeline::decodeStage(int worker)
+{
+    TCADURing  *ring = rings[worker];
+    TCADUStats *wstats = cadu->collect_stats() ? &stats[worker]:NULL;
+    TCADUSlot  *slot;
+    bool       eof;
+
+    eof = false;
+
+    while(!eof) {
+        while((slot = ring->toDecode()) == NULL) {
+            if(isAborted())
+                return;
+        }
+
+        // the slot belongs to the consumer once it is decoded
+        eof = slot->eof;
+        if(!eof)
+            slot->rs_errors = cadu->decode(slot->data, rs[worker], wstats);
+
+        ring->decoded();
+    }
+}
@@ -0,0 +1,128 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef CADUPIPELINE_H
+#define CADUPIPELINE_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QSemaphore>
+
+#include "cadustats.h"
+#include "rsdecoder.h"
+
+//---------------------------------------------------------------------------
+#define CADUPIPE_SLOTS          64 // CADUs in flight per worker, power of 2
+#define CADUPIPE_MAX_WORKERS    16
+#define CADUPIPE_WAIT_MS        100 // a blocked stage checks for abort this often
+
+class TCADU;
+class TCADUPipeStage;
+
+//---------------------------------------------------------------------------
+typedef struct TCADUSlot_t
+{
+    quint8 *data;      // raw payload, derandomized and RS decoded by a worker
+    long   address;    // sync address
+    int    rs_errors;  // see TCADU::getrserrors
+    bool   eof;        // no more CADUs after this one
+} TCADUSlot;
+
+//---------------------------------------------------------------------------
+// Bounded ring of CADU slots passed along the three pipeline stages.
+// Every index has a single owner, the sync stage fills slots at
+// write, one worker decodes them at done and the consumer empties
+// them at read and hands them back to the sync stage. A semaphore per
+// edge counts the slots waiting for the next stage, a stage sleeps on
+// it while the ring is full or empty.
+class TCADURing
+{
+public:
+    TCADURing(size_t payload_size);
+    ~TCADURing(void);
+
+    bool isValid(void) { return buffer != NULL; }
+
+    // NULL when the queue in front of the stage stayed full or empty
+    // for CADUPIPE_WAIT_MS, a slot returned must be passed on
+    TCADUSlot *toFill(void);
+    void       filled(void);
+    TCADUSlot *toDecode(void);
+    void       decoded(void);
+    TCADUSlot *toConsume(void);
+    void       consumed(void);
+
+private:
+    TCADUSlot  entries[CADUPIPE_SLOTS];
+    quint8     *buffer;
+
+    int        write, done, read;
+    QSemaphore empty, full, ready; // to fill, to decode, to consume
+};
+
+//---------------------------------------------------------------------------
+// Reads a CADU stream on three stages.
+// The sync stage finds the CADUs and copies the raw payloads, the worker
+// stages derandomize and Reed Solomon decode them, CADUs are independent
+// so any number of workers can run. The sync stage deals the CADUs round
+// robin to the workers and the consumer collects them in the same order,
+// so the payloads come out in stream order without any sorting.
+// TCADU::findsync and getpayload take their payloads from here while
+// a pipeline is started, see TCADU::start_pipeline.
+class TCADUPipeline
+{
+public:
+    TCADUPipeline(TCADU *cadu_, size_t payload_size_);
+    ~TCADUPipeline(void);
+
+    bool start(int nworkers);
+    void stop(void);
+
+    // blocks until the next CADU is decoded, false at end of stream
+    bool next(quint8 *payload, long *address, int *rs_errors);
+
+    // merges the RS counters of the workers, after stop
+    void addStats(TCADUStats *stats);
+
+    bool isAborted(void);
+
+protected:
+    friend class TCADUPipeStage;
+
+    void syncStage(void);
+    void decodeStage(int worker);
+
+private:
+    TCADU  *cadu;
+    size_t payload_size;
+
+    TCADURing      *rings[CADUPIPE_MAX_WORKERS];
+    TRSDecoder     *rs[CADUPIPE_MAX_WORKERS];
+    TCADUStats     stats[CADUPIPE_MAX_WORKERS];
+    TCADUPipeStage *stages[CADUPIPE_MAX_WORKERS + 1];
+    int            workers, turn;
+
+    QAtomicInt abort;
+    bool       finished;
+};
+
+#endif // CADUPIPELINE_H
@@ -0,0 +1,311 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <QSettings>
+#include <QFileInfo>
+#include <QDateTime>
+#include <string.h>
+
+#include "cadustats.h"
+
+//---------------------------------------------------------------------------
+static QString sidecarName(const QString &filename)
+{
+    QFileInfo fi(filename);
+
+    return fi.absolutePath() + "/" + fi.fileName() + ".stats";
+}
+
+//---------------------------------------------------------------------------
+TCADUStats::TCADUStats(void)
+{
+    reset();
+}
+
+//---------------------------------------------------------------------------
+void TCADUStats::reset(void)
+{
+    int i;
+
+    cadus = 0;
+    slips = 0;
+
+    interleave = 0;
+    memset(rs_clean, 0, sizeof(rs_clean));
+    memset(rs_corrected, 0, sizeof(rs_corrected));
+    memset(rs_failed, 0, sizeof(rs_failed));
+    rs_symbols = 0;
+
+    memset(vcid, 0, sizeof(vcid));
+    seq_gaps = 0;
+    seq_lost = 0;
+
+    for(i=0; i<STATS_MAX_VCID; i++)
+        last_counter[i] = -1;
+}
+
+//---------------------------------------------------------------------------
+// merges the counters of another decoder, eg. a worker thread
+void TCADUStats::add(const TCADUStats &src)
+{
+    int i;
+
+    cadus += src.cadus;
+    slips += src.slips;
+
+    if(src.interleave > interleave)
+        interleave = src.interleave;
+
+    for(i=0; i<RS_MAX_INTERLEAVE; i++) {
+        rs_clean[i]     += src.rs_clean[i];
+        rs_corrected[i] += src.rs_corrected[i];
+        rs_failed[i]    += src.rs_failed[i];
+    }
+
+    rs_symbols += src.rs_symbols;
+
+    for(i=0; i<STATS_MAX_VCID; i++)
+        vcid[i] += src.vcid[i];
+
+    seq_gaps += src.seq_gaps;
+    seq_lost += src.seq_lost;
+}
+
+//---------------------------------------------------------------------------
+// called after every TRSDecoder::decode
+void TCADUStats::rsResult(TRSDecoder *rs)
+{
+    int i, e;
+
+    interleave = rs->getInterleave();
+
+    for(i=0; i<interleave; i++) {
+        e = rs->getErrors(i);
+
+        if(e == 0)
+            rs_clean[i]++;
+        else if(e > 0) {
+            rs_corrected[i]++;
+            rs_symbols += e;
+        }
+        else
+            rs_failed[i]++;
+    }
+}
+
+//---------------------------------------------------------------------------
+// called for every CADU, counter is the 24 bit VCDU counter
+void TCADUStats::vcdu(quint8 vcid_, quint32 counter)
+{
+    quint32 diff;
+
+    vcid_ &= STATS_MAX_VCID - 1;
+    counter &= STATS_COUNTER_MASK;
+
+    vcid[vcid_]++;
+
+    if(last_counter[vcid_] >= 0) {
+        diff = (counter - (quint32) last_counter[vcid_]) & STATS_COUNTER_MASK;
+
+        if(diff != 1) {
+            seq_gaps++;
+
+            if(diff > 1)
+                seq_lost += diff - 1;
+        }
+    }
+
+    last_counter[vcid_] = (qint32) counter;
+}
+
+//---------------------------------------------------------------------------
+long TCADUStats::rsCodewords(void) const
+{
+    return rsClean() + rsCorrected() + rsFailed();
+}
+
+//---------------------------------------------------------------------------
+long TCADUStats::rsClean(void) const
+{
+    long n = 0;
+
+    for(int i=0; i<interleave; i++)
+        n += rs_clean[i];
+
+    return n;
+}
+
+//---------------------------------------------------------------------------
+long TCADUStats::rsCorrected(void) const
+{
+    long n = 0;
+
+    for(int i=0; i<interleave; i++)
+        n += rs_corrected[i];
+
+    return n;
+}
+
+//---------------------------------------------------------------------------
+long TCADUStats::rsFailed(void) const
+{
+    long n = 0;
+
+    for(int i=0; i<interleave; i++)
+        n += rs_failed[i];
+
+    return n;
+}
+
+//---------------------------------------------------------------------------
+QString TCADUStats::summary(void) const
+{
+    QString str;
+    long    n;
+
+    if(cadus == 0)
+        return QString("No CADU statistics");
+
+    n = rsCodewords();
+
+    if(n > 0)
+        str.sprintf("%ld CADUs, RS %.1f%% clean %.1f%% corrected %.1f%% failed, %ld gaps, %ld slips",
+                    cadus,
+                    100.0 * rsClean() / n,
+                    100.0 * rsCorrected() / n,
+                    100.0 * rsFailed() / n,
+                    seq_gaps, slips);
+    else
+        str.sprintf("%ld CADUs, %ld gaps, %ld slips", cadus, seq_gaps, slips);
+
+    return str;
+}
+
+//---------------------------------------------------------------------------
+// writes the counters next to the recording, <recording>.stats in ini format
+bool TCADUStats::writeSidecar(const QString &filename) const
+{
+    QFileInfo fi(filename);
+    QString   str;
+    int       i;
+
+    if(cadus == 0 || filename.isEmpty())
+        return false;
+
+    QSettings reg(sidecarName(filename), QSettings::IniFormat);
+
+    reg.beginGroup("CADU");
+      reg.setValue("File", fi.fileName());
+      reg.setValue("Size", (qlonglong) fi.size());
+      reg.setValue("Created", QDateTime::currentDateTime().toUTC().toString(Qt::ISODate));
+      reg.setValue("CADUs", (qlonglong) cadus);
+      reg.setValue("SyncSlips", (qlonglong) slips);
+      reg.setValue("SequenceGaps", (qlonglong) seq_gaps);
+      reg.setValue("SequenceLost", (qlonglong) seq_lost);
+    reg.endGroup();
+
+    reg.beginGroup("ReedSolomon");
+      reg.setValue("Interleave", interleave);
+      reg.setValue("Clean", (qlonglong) rsClean());
+      reg.setValue("Corrected", (qlonglong) rsCorrected());
+      reg.setValue("Failed", (qlonglong) rsFailed());
+      reg.setValue("CorrectedSymbols", (qlonglong) rs_symbols);
+
+      for(i=0; i<interleave; i++) {
+          str.sprintf("Interleave-%d", i);
+          reg.beginGroup(str);
+            reg.setValue("Clean", (qlonglong) rs_clean[i]);
+            reg.setValue("Corrected", (qlonglong) rs_corrected[i]);
+            reg.setValue("Failed", (qlonglong) rs_failed[i]);
+          reg.endGroup();
+      }
+    reg.endGroup();
+
+    reg.beginGroup("VCID");
+      for(i=0; i<STATS_MAX_VCID; i++) {
+          if(vcid[i] == 0)
+              continue;
+
+          str.sprintf("VCID-%d", i);
+          reg.setValue(str, (qlonglong) vcid[i]);
+      }
+    reg.endGroup();
+
+    reg.sync();
+
+    return reg.status() == QSettings::NoError;
+}
+
+//---------------------------------------------------------------------------
+// restores the counters of a pass opened from its frame index, false if
+// the sidecar was written for another file or the recording has changed
+bool TCADUStats::readSidecar(const QString &filename)
+{
+    QFileInfo fi(filename);
+    QString   str;
+    int       i;
+
+    reset();
+
+    if(filename.isEmpty() || !QFileInfo(sidecarName(filename)).exists())
+        return false;
+
+    QSettings reg(sidecarName(filename), QSettings::IniFormat);
+
+    reg.beginGroup("CADU");
+      if(reg.value("File", "").toString() != fi.fileName() ||
+         reg.value("Size", -1).toLongLong() != (qlonglong) fi.size()) {
+          reg.endGroup();
+          return false;
+      }
+
+      cadus    = (long) reg.value("CADUs", 0).toLongLong();
+      slips    = (long) reg.value("SyncSlips", 0).toLongLong();
+      seq_gaps = (long) reg.value("SequenceGaps", 0).toLongLong();
+      seq_lost = (long) reg.value("SequenceLost", 0).toLongLong();
+    reg.endGroup();
+
+    reg.beginGroup("ReedSolomon");
+      interleave = reg.value("Interleave", 0).toInt();
+      if(interleave < 0 || interleave > RS_MAX_INTERLEAVE)
+          interleave = 0;
+
+      rs_symbols = (long) reg.value("CorrectedSymbols", 0).toLongLong();
+
+      for(i=0; i<interleave; i++) {
+          str.sprintf("Interleave-%d", i);
+          reg.beginGroup(str);
+            rs_clean[i]     = (long) reg.value("Clean", 0).toLongLong();
+            rs_corrected[i] = (long) reg.value("Corrected", 0).toLongLong();
+            rs_failed[i]    = (long) reg.value("Failed", 0).toLongLong();
+          reg.endGroup();
+      }
+    reg.endGroup();
+
+    reg.beginGroup("VCID");
+      for(i=0; i<STATS_MAX_VCID; i++) {
+          str.sprintf("VCID-%d", i);
+          vcid[i] = (long) reg.value(str, 0).toLongLong();
+      }
+    reg.endGroup();
+
+    return cadus > 0;
+}
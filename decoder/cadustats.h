@@ -0,0 +1,77 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef CADUSTATS_H
+#define CADUSTATS_H
+
+#include <QtGlobal>
+#include <QString>
+
+#include "rsdecoder.h"
+
+//---------------------------------------------------------------------------
+#define STATS_MAX_VCID      64 // 6 bit VCID
+#define STATS_COUNTER_MASK  0x00ffffff // 24 bit VCDU counter
+
+//---------------------------------------------------------------------------
+// Link quality counters of one pass.
+// Each decoder owns its counters and is the only writer, so updates on the
+// hot path are plain increments without locking. Worker threads keep their
+// own TCADUStats and are merged with add() when the pass is done.
+class TCADUStats
+{
+public:
+    TCADUStats(void);
+
+    void reset(void);
+    void add(const TCADUStats &src);
+
+    void rsResult(TRSDecoder *rs);
+    void vcdu(quint8 vcid, quint32 counter);
+    void slip(void) { slips++; }
+
+    long rsCodewords(void) const;
+    long rsClean(void) const;
+    long rsCorrected(void) const;
+    long rsFailed(void) const;
+
+    QString summary(void) const;
+    bool    writeSidecar(const QString &filename) const;
+    bool    readSidecar(const QString &filename);
+
+    long cadus;     // CADUs with a payload
+    long slips;     // sync lost and found again, soft sync only
+
+    int  interleave;
+    long rs_clean[RS_MAX_INTERLEAVE];     // codewords with zero syndromes
+    long rs_corrected[RS_MAX_INTERLEAVE]; // codewords with corrected symbols
+    long rs_failed[RS_MAX_INTERLEAVE];    // uncorrectable codewords
+    long rs_symbols;                      // corrected symbols
+
+    long vcid[STATS_MAX_VCID]; // CADUs per virtual channel
+    long seq_gaps;             // VCDU counter discontinuities
+    long seq_lost;             // CADUs missing in the gaps
+
+private:
+    qint32 last_counter[STATS_MAX_VCID]; // -1 = none yet
+};
+
+#endif // CADUSTATS_H
@@ -0,0 +1,163 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <QImage>
+#include <QFileInfo>
+#include <QMutex>
+#include <QList>
+
+#include "colorscale.h"
+
+//---------------------------------------------------------------------------
+static QMutex                     scales_lock;
+static QList<const TColorScale *> scales;
+static QString                    scales_path;
+
+//---------------------------------------------------------------------------
+TColorScale::TColorScale(void)
+{
+    count = 0;
+}
+
+//---------------------------------------------------------------------------
+// relative file names are looked up in path first, conf/LUT of POES-USRP
+void TColorScale::setPath(const QString &path)
+{
+    scales_lock.lock();
+    scales_path = path;
+    scales_lock.unlock();
+}
+
+//---------------------------------------------------------------------------
+// NULL if filename is empty or not a colour scale
+const TColorScale *TColorScale::get(const QString &filename)
+{
+    const TColorScale *scale;
+    TColorScale *cs;
+    QFileInfo fi(filename);
+    QString path;
+    int i;
+
+    if(filename.isEmpty())
+        return NULL;
+
+    scales_lock.lock();
+
+    path = filename;
+    if(fi.isRelative() && !scales_path.isEmpty() && QFileInfo(scales_path + "/" + filename).exists())
+        path = scales_path + "/" + filename;
+
+    path = QFileInfo(path).absoluteFilePath();
+
+    for(i=0; i<scales.count(); i++) {
+        scale = scales.at(i);
+
+        if(scale->fileName() == path) {
+            scales_lock.unlock();
+            return scale;
+        }
+    }
+
+    cs = new TColorScale;
+    if(!cs->load(path)) {
+        delete cs;
+        scales_lock.unlock();
+
+        return NULL;
+    }
+
+    scales.append(cs);
+    scales_lock.unlock();
+
+    return cs;
+}
+
+//---------------------------------------------------------------------------
+bool TColorScale::load(const QString &filename)
+{
+    QImage image;
+    QRgb   *line;
+    int    x, y, start, run, best, first, last, rows;
+
+    if(!image.load(filename)) {
+        qDebug("Failed to load colour scale %s %s:%d", filename.toStdString().c_str(), __FILE__, __LINE__);
+        return false;
+    }
+
+    image = image.convertToFormat(QImage::Format_ARGB32);
+
+    // the rows of the bar, the longest opaque run
+    best = first = last = rows = 0;
+    start = 0;
+    for(y=0; y<image.height(); y++) {
+        line = (QRgb *) image.scanLine(y);
+
+        for(x=0, run=0; x<=image.width(); x++) {
+            if(x < image.width() && qAlpha(line[x]) == 255) {
+                run++;
+                continue;
+            }
+
+            if(run > best) {
+                best = run;
+                first = x - run;
+                last = x - 1;
+                start = y;
+                rows = 1;
+            }
+            else if(run == best && run > 0 && x - run == first)
+                rows++;
+
+            run = 0;
+        }
+    }
+
+    if(best == 0) {
+        qDebug("No colour scale in %s %s:%d", filename.toStdString().c_str(), __FILE__, __LINE__);
+        return false;
+    }
+
+    line = (QRgb *) image.scanLine(start + rows / 2);
+
+    // the frame
+    if(last - first > 2 && qGray(line[first]) == 0 && qGray(line[first + 1]) != 0)
+        first++;
+    if(last - first > 2 && qGray(line[last]) == 0 && qGray(line[last - 1]) != 0)
+        last--;
+
+    count = last - first + 1;
+    if(count > COLORSCALE_MAX)
+        count = COLORSCALE_MAX;
+
+    // a wider bar is resampled
+    for(x=0; x<count; x++) {
+        y = first + (int) ((qint64) x * (last - first) / (count > 1 ? count - 1:1));
+
+        rgb[x * 3]     = qRed(line[y]);
+        rgb[x * 3 + 1] = qGreen(line[y]);
+        rgb[x * 3 + 2] = qBlue(line[y]);
+    }
+
+    file = filename;
+
+    return true;
+}
@@ -0,0 +1,60 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef COLORSCALE_H
+#define COLORSCALE_H
+
+#include <QtGlobal>
+#include <QString>
+
+//---------------------------------------------------------------------------
+#define COLORSCALE_MAX      1024 // colours of a scale
+
+//---------------------------------------------------------------------------
+// Colour scale of a vegetation index, the colour bar of a PNG like the ones
+// in conf/LUT/Ocean, left is the minimum value.
+// The bar is the widest run of opaque pixels, a black frame around it is
+// not a part of it, so a plain image one pixel high works as well.
+// get loads a file once, the scales are shared and never freed.
+class TColorScale
+{
+public:
+    static const TColorScale *get(const QString &filename);
+    static void setPath(const QString &path);
+
+    QString fileName(void) const { return file; }
+    int     size(void) const { return count; }
+
+    // RGB of colour 0 ... size - 1
+    const uchar *color(int index) const { return rgb + index * 3; }
+
+private:
+    TColorScale(void);
+
+    bool load(const QString &filename);
+
+    QString file;
+    uchar   rgb[COLORSCALE_MAX * 3];
+    int     count;
+};
+
+#endif // COLORSCALE_H
@@ -0,0 +1,172 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <QSettings>
+#include <math.h>
+
+#include "contrast.h"
+
+//---------------------------------------------------------------------------
+TContrast::TContrast(void)
+{
+    serial = 0;
+    zero();
+}
+
+//---------------------------------------------------------------------------
+// SCALE16TO8, the image as it was before there were any settings
+void TContrast::zero(void)
+{
+    stretch = None_Stretch;
+    clip = 1.0;
+    gamma = 1.0;
+    inverted = 0;
+    serial++;
+}
+
+//---------------------------------------------------------------------------
+void TContrast::setClip(double percent)
+{
+    clip = percent < 0 ? 0:(percent > 49 ? 49:percent);
+    serial++;
+}
+
+//---------------------------------------------------------------------------
+void TContrast::setGamma(double g)
+{
+    gamma = g < 0.1 ? 0.1:(g > 10 ? 10:g);
+    serial++;
+}
+
+//---------------------------------------------------------------------------
+void TContrast::setInverted(int channel, bool on)
+{
+    if(channel < 1 || channel > 32)
+        return;
+
+    if(on)
+        inverted |= 1 << (channel - 1);
+    else
+        inverted &= ~(1 << (channel - 1));
+
+    serial++;
+}
+
+//---------------------------------------------------------------------------
+bool TContrast::isInverted(int channel) const
+{
+    if(channel < 1 || channel > 32)
+        return false;
+
+    return inverted & (1 << (channel - 1)) ? true:false;
+}
+
+//---------------------------------------------------------------------------
+// Fills the CONTRAST_LUT_SIZE entries of table for channel (1 ... n).
+// The stretched range lo ... hi is split into 256 levels, a sample is
+// mapped to the level its centre falls in, so that no stretch, gamma 1.0
+// is exactly SCALE16TO8. histogram may be NULL, it is not stretched then.
+void TContrast::lut(quint8 *table, const quint32 *histogram, int channel) const
+{
+ Contrast_Stretch s;
+ double n, sum, limit, t, g;
+ int v, lo, hi;
+ bool invert;
+
+   n = 0;
+   if(histogram)
+      for(v=1; v<CONTRAST_LUT_SIZE; v++)
+         n += histogram[v];
+
+   s = n > 0 ? stretch:None_Stretch;
+   lo = 0;
+   hi = CONTRAST_LUT_SIZE - 1;
+   limit = n * clip / 100.0;
+
+   switch(s) {
+      case Linear_Stretch:
+         for(lo=1; lo<hi && histogram[lo] == 0; lo++);
+         for(; hi>lo && histogram[hi] == 0; hi--);
+      break;
+
+      case Percentile_Stretch:
+         for(sum=0, lo=1; lo<hi; lo++)
+            if((sum += histogram[lo]) > limit)
+               break;
+
+         for(sum=0; hi>lo; hi--)
+            if((sum += histogram[hi]) > limit)
+               break;
+      break;
+
+      default:
+      break;
+   }
+
+   invert = isInverted(channel);
+   g = 1.0 / gamma;
+   sum = 0;
+
+   for(v=0; v<CONTRAST_LUT_SIZE; v++) {
+      if(s == Equalize_Stretch) {
+         // share of the samples darker than v, v itself counts half
+         t = v == 0 ? 0:(sum + histogram[v] * 0.5) / n;
+         sum += v == 0 ? 0:histogram[v];
+      }
+      else
+         t = (v - lo + 0.5) / (hi - lo + 1);
+
+      t = t < 0 ? 0:(t > 1 ? 1:t);
+
+      if(invert)
+         t = 1 - t;
+
+      if(gamma != 1.0)
+         t = pow(t, g);
+
+      t *= 256;
+      table[v] = t >= 255 ? 255:(quint8) t;
+   }
+}
+
+//---------------------------------------------------------------------------
+void TContrast::readSettings(QSettings *reg)
+{
+    int i;
+
+    i = reg->value("stretch", None_Stretch).toInt();
+    stretch = i < None_Stretch || i > Equalize_Stretch ? None_Stretch:(Contrast_Stretch) i;
+
+    setClip(reg->value("clip", 1.0).toDouble());
+    setGamma(reg->value("gamma", 1.0).toDouble());
+    inverted = reg->value("inverted", 0).toUInt();
+    serial++;
+}
+
+//---------------------------------------------------------------------------
+void TContrast::writeSettings(QSettings *reg)
+{
+    reg->setValue("stretch", (int) stretch);
+    reg->setValue("clip", clip);
+    reg->setValue("gamma", gamma);
+    reg->setValue("inverted", inverted);
+}
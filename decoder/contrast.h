@@ -0,0 +1,82 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef CONTRAST_H
+#define CONTRAST_H
+
+#include <QtGlobal>
+
+//---------------------------------------------------------------------------
+#define CONTRAST_LUT_SIZE       1024 // a table entry per 10 bit sample
+
+typedef enum Contrast_Stretch_t
+{
+    None_Stretch = 0,       // drops the two low bits
+    Linear_Stretch,         // darkest ... brightest sample of the channel
+    Percentile_Stretch,     // clips the darkest and brightest clip percent
+    Equalize_Stretch        // histogram equalization
+} Contrast_Stretch;
+
+class QSettings;
+
+//---------------------------------------------------------------------------
+// 10 to 8 bit scaling of a channel.
+// lut builds a table from the histogram of the decoded channel (see
+// TImageStore::histogram), all the floating point is done there so that
+// composing an image is a table lookup per sample however it is enhanced.
+// Samples of 0 are lines the decoder missed and are not counted.
+class TContrast
+{
+public:
+    TContrast(void);
+
+    void zero(void);
+
+    void lut(quint8 *table, const quint32 *histogram, int channel) const;
+
+    void setStretch(Contrast_Stretch s) { stretch = s; serial++; }
+    Contrast_Stretch getStretch(void) const { return stretch; }
+
+    void   setClip(double percent);
+    double getClip(void) const { return clip; }
+
+    void   setGamma(double g);
+    double getGamma(void) const { return gamma; }
+
+    // IR channels are inverted so that cold clouds are white, channel is 1 ... n
+    void setInverted(int channel, bool on);
+    bool isInverted(int channel) const;
+
+    void readSettings(QSettings *reg);
+    void writeSettings(QSettings *reg);
+
+    // changes with every setting, see TBlock::contrastLUT
+    quint32 getSerial(void) const { return serial; }
+
+private:
+    Contrast_Stretch stretch;
+    double clip, gamma;
+    quint32 inverted; // bit channel - 1
+    quint32 serial;
+};
+
+#endif // CONTRAST_H
@@ -0,0 +1,215 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <QFileInfo>
+#include <QDateTime>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frameindex.h"
+
+#define FRAMEINDEX_GROW     4096 // entries
+
+//---------------------------------------------------------------------------
+TFrameIndex::TFrameIndex(void)
+{
+    entries = NULL;
+    frames = capacity = 0;
+
+    memset(&header, 0, sizeof(header));
+    loaded = false;
+}
+
+//---------------------------------------------------------------------------
+TFrameIndex::~TFrameIndex(void)
+{
+    if(entries)
+        free(entries);
+}
+
+//---------------------------------------------------------------------------
+// keeps the allocation, a new pass of the same size needs no realloc
+void TFrameIndex::clear(void)
+{
+    frames = 0;
+    loaded = false;
+
+    memset(&header, 0, sizeof(header));
+}
+
+//---------------------------------------------------------------------------
+// identifies the recording and the settings the index is valid for
+void TFrameIndex::setKey(const char *filename, int blocktype, quint32 options)
+{
+    QFileInfo fi(filename);
+
+    memcpy(header.magic, FRAMEINDEX_MAGIC, 4);
+    header.version = FRAMEINDEX_VERSION;
+    header.entry_size = sizeof(TFrameEntry);
+    header.blocktype = blocktype;
+    header.options = options;
+    header.modes = 0;
+    header.filesize = fi.size();
+    header.mtime = fi.lastModified().toTime_t();
+    header.frames = 0;
+}
+
+//---------------------------------------------------------------------------
+QString TFrameIndex::sidecarName(const char *filename)
+{
+    QFileInfo fi(filename);
+
+    return fi.absolutePath() + "/" + fi.fileName() + ".idx";
+}
+
+//---------------------------------------------------------------------------
+// setKey must be called before this function
+bool TFrameIndex::load(const char *filename)
+{
+    TFrameIndexHeader hdr;
+    FILE *fp;
+    long n;
+
+    frames = 0;
+    loaded = false;
+
+    if(filename == NULL || header.version == 0)
+        return false;
+
+    fp = fopen(sidecarName(filename).toStdString().c_str(), "rb");
+    if(fp == NULL)
+        return false;
+
+    if(fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+       memcmp(hdr.magic, header.magic, 4) != 0 ||
+       hdr.version != header.version ||
+       hdr.entry_size != header.entry_size ||
+       hdr.blocktype != header.blocktype ||
+       hdr.options != header.options ||
+       hdr.filesize != header.filesize ||
+       hdr.mtime != header.mtime ||
+       hdr.frames <= 0) {
+        fclose(fp);
+
+        return false; // stale or foreign
+    }
+
+    n = (long) hdr.frames;
+    if(n > capacity) {
+        TFrameEntry *p = (TFrameEntry *) realloc(entries, n * sizeof(TFrameEntry));
+        if(p == NULL) {
+            qDebug("Failed to allocate frame index %s:%d", __FILE__, __LINE__);
+            fclose(fp);
+
+            return false;
+        }
+
+        entries = p;
+        capacity = n;
+    }
+
+    if(fread(entries, sizeof(TFrameEntry), n, fp) != (size_t) n) {
+        fclose(fp);
+
+        return false;
+    }
+
+    fclose(fp);
+
+    header.modes = hdr.modes;
+    frames = n;
+    loaded = true;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool TFrameIndex::save(const char *filename, quint32 modes)
+{
+    FILE *fp;
+    bool rc;
+
+    if(filename == NULL || header.version == 0 || frames <= 0)
+        return false;
+
+    header.modes = modes;
+    header.frames = frames;
+
+    fp = fopen(sidecarName(filename).toStdString().c_str(), "wb");
+    if(fp == NULL)
+        return false; // read only media, the index is only a cache
+
+    rc = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+         fwrite(entries, sizeof(TFrameEntry), frames, fp) == (size_t) frames;
+
+    fclose(fp);
+
+    if(!rc)
+        remove(sidecarName(filename).toStdString().c_str());
+
+    return rc;
+}
+
+//---------------------------------------------------------------------------
+bool TFrameIndex::add(qint64 offset, quint8 vcid, quint16 apid, quint16 sequence, quint8 status)
+{
+    TFrameEntry *entry;
+
+    if(frames >= capacity) {
+        entry = (TFrameEntry *) realloc(entries, (capacity + FRAMEINDEX_GROW) * sizeof(TFrameEntry));
+        if(entry == NULL) {
+            qDebug("Failed to allocate frame index %s:%d", __FILE__, __LINE__);
+            return false;
+        }
+
+        entries = entry;
+        capacity += FRAMEINDEX_GROW;
+    }
+
+    entry = &entries[frames++];
+
+    entry->offset = offset;
+    entry->sequence = sequence;
+    entry->apid = apid;
+    entry->vcid = vcid;
+    entry->status = status;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// returns -1 when frame is out of range
+qint64 TFrameIndex::getOffset(long frame)
+{
+    if(frame < 0 || frame >= frames)
+        return -1;
+
+    return entries[frame].offset;
+}
+
+//---------------------------------------------------------------------------
+const TFrameEntry *TFrameIndex::getEntry(long frame)
+{
+    if(frame < 0 || frame >= frames)
+        return NULL;
+
+    return &entries[frame];
+}
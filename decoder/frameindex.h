@@ -0,0 +1,99 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef FRAMEINDEX_H
+#define FRAMEINDEX_H
+
+#include <QtGlobal>
+#include <QString>
+#include <stdio.h>
+
+//---------------------------------------------------------------------------
+#define FRAMEINDEX_MAGIC    "PIDX"
+#define FRAMEINDEX_VERSION  3 // 2: AHRPT and FY-3 frames are source packets, 3: their sequence counts
+
+// TFrameEntry status
+#define FRAME_RS_CORRECTED  1 // Reed-Solomon corrected symbols in the first CADU
+#define FRAME_RS_FAILED     2 // uncorrectable first CADU
+#define FRAME_FILL          4 // lost scan line, the offset is of the next one
+
+//---------------------------------------------------------------------------
+// One scan line. For CCSDS formats the scan line starts in the CADU at
+// offset and ends before the CADU of the next entry.
+typedef struct TFrameEntry_t
+{
+    qint64  offset;   // frame or CADU sync address
+    quint16 sequence; // 14 bit source packet sequence count, CCSDS only
+    quint16 apid;     // CCSDS only
+    quint8  vcid;     // CCSDS only
+    quint8  status;   // FRAME_*
+} TFrameEntry;
+
+typedef struct TFrameIndexHeader_t
+{
+    char    magic[4];
+    quint32 version;
+    quint32 entry_size;
+    qint32  blocktype;
+    quint32 options;  // decoder settings the frames were found with
+    quint32 modes;    // detected block modes, eg. endian
+    qint64  filesize;
+    qint64  mtime;
+    qint64  frames;
+} TFrameIndexHeader;
+
+//---------------------------------------------------------------------------
+// Frame offsets of a recording found by the one counting pass at open.
+// Saved as <recording>.idx and reused while the size and modification time
+// of the recording and the decoder settings stay the same.
+class TFrameIndex
+{
+public:
+    TFrameIndex(void);
+    ~TFrameIndex(void);
+
+    void clear(void);
+    void setKey(const char *filename, int blocktype, quint32 options);
+
+    bool load(const char *filename);
+    bool save(const char *filename, quint32 modes);
+    bool isLoaded(void) { return loaded; }
+
+    bool add(qint64 offset, quint8 vcid = 0, quint16 apid = 0, quint16 sequence = 0, quint8 status = 0);
+
+    long   count(void) { return frames; }
+    qint64 getOffset(long frame);
+    const TFrameEntry *getEntry(long frame);
+    quint32 getModes(void) { return header.modes; }
+
+    static QString sidecarName(const char *filename);
+    static quint8  rsStatus(int errors) { return errors < 0 ? FRAME_RS_FAILED:(errors > 0 ? FRAME_RS_CORRECTED:0); }
+
+private:
+    TFrameIndexHeader header;
+
+    TFrameEntry *entries;
+    long frames, capacity;
+
+    bool loaded;
+};
+
+#endif // FRAMEINDEX_H
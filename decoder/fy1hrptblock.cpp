@@ -20,10 +20,12 @@
 */
 //---------------------------------------------------------------------------
 
-#include <QImage>
 #include <stdlib.h>
+#include <string.h>
 #include "fy1hrptblock.h"
 #include "block.h"
+#include "imagestore.h"
+#include "trace.h"
 
 //---------------------------------------------------------------------------
 /*
@@ -72,7 +74,13 @@ TFY1HRPT::TFY1HRPT(TBlock *_block)
   sync_found = false;
 
   scanLine = NULL;
-  fp = NULL;
+  workLines = NULL;
+  workers = 0;
+  store = NULL;
+  reader = NULL;
+
+  sync_le = sync_be = -1;
+  tail = -1;
 }
 
 //---------------------------------------------------------------------------
@@ -80,6 +88,9 @@ TFY1HRPT::~TFY1HRPT(void)
 {
   if(scanLine)
      free(scanLine);
+
+  if(workLines)
+     free(workLines);
 }
 
 //---------------------------------------------------------------------------
@@ -91,16 +102,25 @@ bool TFY1HRPT::init(void)
   block->setFrames(0);
   block->setFirstFrameSyncPos(-1);
   block->setLittleEndian(true); // USRP default format
+  tail = -1;
 
   if(scanLine == NULL)
      scanLine = (quint16 *) malloc(FY1_HRPT_SCAN_SIZE << 1); // 20480 bytes
 
-  fp = block->getHandle();
-  if(countFrames() <= 0) {
-     // retry using different endian
-     block->setLittleEndian(!block->isLittleEndian());
-     countFrames();
-  }
+  reader = block->getReader();
+  if(!check())
+     return false;
+
+  if(block->fromIndex())
+     return check(1);
+
+  // one pass over the file finds the frame sync in both endians,
+  // use the one with most hits (USRP default on a tie)
+  scanSync();
+  if(block->getScanner()->count(sync_be) > block->getScanner()->count(sync_le))
+     block->setLittleEndian(false);
+
+  countFrames();
 
   return check(1);
 }
@@ -110,7 +130,7 @@ bool TFY1HRPT::init(void)
 bool TFY1HRPT::check(int flags)
 {
   // check allocation and file pointer status
-  if(block == NULL || fp == NULL || scanLine == NULL)
+  if(block == NULL || reader == NULL || !reader->isOpen() || scanLine == NULL)
      return false;
 
   // check found stuff
@@ -122,11 +142,27 @@ bool TFY1HRPT::check(int flags)
   return true;
 }
 
+//---------------------------------------------------------------------------
+void TFY1HRPT::scanSync(void)
+{
+  TSyncScanner *scanner = block->getScanner();
+
+  scanner->clear();
+  sync_le = scanner->addPattern16(FY1_HRPT_SYNC, FY1_HRPT_SYNC_SIZE, true);
+  sync_be = scanner->addPattern16(FY1_HRPT_SYNC, FY1_HRPT_SYNC_SIZE, false);
+
+  scanner->scan(reader);
+}
+
 //---------------------------------------------------------------------------
 int TFY1HRPT::countFrames(void)
 {
- long int syncSize, firstFrameSyncPos;
- int frames;
+ TRACE_SCOPE("TFY1HRPT::countFrames");
+ TSyncScanner *scanner;
+ TSyncMatch *match;
+ qint64 stride, next, firstFrameSyncPos;
+ long i;
+ int frames, pattern, parity;
 
   if(!check())
      return 0; // fatal error
@@ -134,77 +170,38 @@ int TFY1HRPT::countFrames(void)
   if(check(1)) // already done
      return block->getFrames();
 
-  block->gotoStart();
+  scanner = block->getScanner();
 
-  syncSize = FY1_HRPT_SYNC_SIZE << 1; // 12 bytes
+  stride = FY1_HRPT_BLOCK_SIZE << 1;
+  pattern = block->isLittleEndian() ? sync_le:sync_be;
+  parity = scanner->parity(pattern);
   firstFrameSyncPos = -1;
   frames = 0;
-  sync_found = false;
+  next = 0;
+
+  for(i = scanner->nextMatch(pattern, next); i >= 0; i = scanner->nextMatch(pattern, next, i + 1)) {
+     match = scanner->getMatch(i);
+
+     if((match->offset & 1) != parity)
+        continue; // not word aligned with most of the frames
 
-  while(findFrameSync()) {
-     // we just read 6 words, FY1_HRPT_SYNC_SIZE
      if(frames == 0)
-        firstFrameSyncPos = ftell(fp) - syncSize;
+        firstFrameSyncPos = match->offset;
 
      ++frames;
+     block->getIndex()->add(match->offset);
 
      // hop to next frame
-     if(fseek(fp, (FY1_HRPT_BLOCK_SIZE << 1) - syncSize, SEEK_CUR) != 0)
-        break;
-
-     sync_found = true;
+     next = match->offset + stride;
   }
 
+  sync_found = frames > 0;
   block->setFrames(frames);
   block->setFirstFrameSyncPos(firstFrameSyncPos);
 
  return frames;
 }
 
-//---------------------------------------------------------------------------
-bool TFY1HRPT::findFrameSync(void)
-{
- quint8  ch[2];
- quint16 w;
- int i;
-
-#if 0
-
- // flush the sync and continue
- if(sync_found) {
-     i = 0;
-     while(fread(ch, sizeof(ch), 1, fp) == 1) {
-         i++;
-
-         if(i == FY1_HRPT_SYNC_SIZE)
-            return true;
-     }
-
-     return false;
-
- }
-
-#endif
-
-  i = 0;
-  while(fread(ch, sizeof(ch), 1, fp) == 1) {
-     if(block->isLittleEndian())
-        w = (ch[1] << 8) | ch[0];
-     else
-        w = (ch[0] << 8) | ch[1];
-        
-     if(w == FY1_HRPT_SYNC[i])
-        i++;
-     else
-        i = 0;
-
-     if(i == FY1_HRPT_SYNC_SIZE)
-        return true;
-  }
-
- return false;
-}
-
 //---------------------------------------------------------------------------
 int TFY1HRPT::getWidth(void)
 {
@@ -219,139 +216,183 @@ int TFY1HRPT::getNumChannels(void)
 
 //---------------------------------------------------------------------------
 // frame_nr is zero based (0, 1, 2, ... frames - 1)
-bool TFY1HRPT::readFrameScanLine(int frame_nr)
+// line is scanLine when NULL, the reader cursor is not used so workers with
+// their own line may call this at the same time on a mapped recording
+bool TFY1HRPT::readFrameScanLine(int frame_nr, quint16 *line)
 {
- long int pos, scanPos;
+ TRACE_SCOPE("TFY1HRPT::readFrameScanLine");
+ const quint8 *src;
+ qint64 scanPos;
  int x;
 
   if(!check(1))
      return false;
 
-  pos = ftell(fp);
-  if(pos < 0)
+  scanPos = block->getFrameSyncPos(frame_nr);
+  if(scanPos < 0)
      return false;
 
-  scanPos = block->getFirstFrameSyncPos() + ((FY1_HRPT_IMAGE_START + frame_nr*FY1_HRPT_BLOCK_SIZE) << 1);
-
-  if(pos != scanPos) {
-     if(pos > scanPos)
-        fseek(fp, scanPos, SEEK_SET);
-     else
-        fseek(fp, scanPos - pos, SEEK_CUR);
-  }
+  scanPos += FY1_HRPT_IMAGE_START << 1;
 
   // todo: implement different packing features
-  if(fread(scanLine, FY1_HRPT_SCAN_SIZE << 1, 1, fp) != 1)
+  src = reader->data(scanPos, FY1_HRPT_SCAN_SIZE << 1);
+  if(src == NULL)
      return false;
 
+  if(line == NULL)
+     line = scanLine;
+
+  memcpy(line, src, FY1_HRPT_SCAN_SIZE << 1);
+
   if(!block->isLittleEndian())
      for(x=0; x < (FY1_HRPT_SCAN_WIDTH * FY1_HRPT_NUM_CHANNELS); x++)
-        SWAP16PTR(&scanLine[x]);
+        SWAP16PTR(&line[x]);
 
  return true;
 }
 
 //---------------------------------------------------------------------------
-// returns a 16 bit pixel from a frame channel
-// sample and channel are zero based
-quint16 TFY1HRPT::getPixel_16(int channel, int sample)
+// copies all channels of a frame to the image store
+// frame_nr is zero based
+bool TFY1HRPT::frameToStore(int frame_nr, TImageStore *store)
 {
- quint16 pixel, pos;
-
-  if(!check())
-     return 0;
-
-  if(!block->isNorthBound())
-     pos = channel + sample * FY1_HRPT_NUM_CHANNELS;
-  else
-     pos = channel + (FY1_HRPT_SCAN_WIDTH - sample - 1) * FY1_HRPT_NUM_CHANNELS;
+  if(!readFrameScanLine(frame_nr))
+     return false;
 
-  pixel = scanLine[pos] & 0x03ff;
+  store->putInterleaved(frame_nr, scanLine);
 
-  return pixel;
+ return true;
 }
 
 //---------------------------------------------------------------------------
-// returns a 8 bit pixel from a frame channel
-// sample and channel are zero based
-quint8 TFY1HRPT::getPixel_8(int channel, int sample)
+// scan line of a worker thread, see toStore
+bool TFY1HRPT::decodeLine(int worker, int y)
 {
-  return SCALE16TO8(getPixel_16(channel, sample));
+ quint16 *line = workLines + (size_t) worker * FY1_HRPT_SCAN_SIZE;
+
+  if(!readFrameScanLine(y, line))
+     return false;
+
+  store->putInterleaved(y, line);
+
+ return true;
 }
 
 //---------------------------------------------------------------------------
-// fills an 24 bpp image line of the selected channel
-// frame_nr is zero based
-bool TFY1HRPT::frameToImage(int frame_nr, QImage *image)
+bool TFY1HRPT::toStore(TImageStore *store_)
 {
- uchar *imagescan, r, g, b;
- int x, y, *ch_rgb;
+ int frames, y, threads;
 
-  if(!check(1) || image == NULL)
+  if(!check(1) || store_ == NULL)
      return false;
 
-  if(!readFrameScanLine(frame_nr))
-     return false;
+  store = store_;
 
-  if(block->isNorthBound())
-     y = image->height() - frame_nr - 1;
-  else
-     y = frame_nr;
+  block->gotoStart();
+  frames = block->getFrames();
 
-  imagescan = (uchar *) image->scanLine(y);
-  if(imagescan == NULL)
-     return false;
+  // frames are independent, decode them on all cores when the
+  // recording is mapped and every worker can read its own frames
+  threads = TLinePool::threads();
+  if(reader->isMapped() && threads > 1 && frames > LINEPOOL_CHUNK) {
+     if(workLines == NULL || workers < threads) {
+        if(workLines)
+           free(workLines);
 
-  switch(block->getImageType()) {
-  case RGB_ImageType:
-      ch_rgb = block->rgbconf->rgb_ch();
-      break;
+        workers = threads;
+        workLines = (quint16 *) malloc((size_t) workers * (FY1_HRPT_SCAN_SIZE << 1));
+     }
 
-  default:
-      break;
-  }
+     if(workLines) {
+        TLinePool::run(this, frames, threads);
 
-  for(x=0; x<FY1_HRPT_SCAN_WIDTH; x++) {
-      switch(block->getImageType()) {
-      case Channel_ImageType:
-          r = getPixel_8(block->getImageChannel(), x);
-          g = r;
-          b = r;
-          break;
-
-      case RGB_ImageType:
-          r = getPixel_8(ch_rgb[0] - 1, x);
-          g = getPixel_8(ch_rgb[1] - 1, x);
-          b = getPixel_8(ch_rgb[2] - 1, x);
-          break;
-
-       default:
-          return false;
+        return true;
      }
 
-     *imagescan++ = r;
-     *imagescan++ = g;
-     *imagescan++ = b;
+     workers = 0;
+     qDebug("Failed to allocate worker scan lines %s:%d", __FILE__, __LINE__);
+  }
+
+  for(y=0; y<frames; y++) {
+     if(!frameToStore(y, store))
+        break;
   }
 
  return true;
 }
 
 //---------------------------------------------------------------------------
-bool TFY1HRPT::toImage(QImage *image)
+// live decoding, appends the frames written since toStore or the previous
+// call, returns the number of new lines
+int TFY1HRPT::follow(TImageStore *store_)
 {
- int frames, y;
+ TSyncScanner *scanner;
+ const quint8 *buf;
+ qint64 offset, frameSize, remaining;
+ size_t len;
+ long i;
+ int frames, y, pattern;
+
+  if(!check(1) || store_ == NULL || !store_->isDecoded())
+     return 0;
 
-  if(!check(1))
-     return false;
+  store = store_;
+  scanner = block->getScanner();
+  frames = y = block->getFrames();
+  frameSize = (FY1_HRPT_IMAGE_START + FY1_HRPT_SCAN_SIZE) << 1;
 
-  block->gotoStart();
-  frames = block->getFrames();
+  // the frames came from the index, nothing has been scanned
+  if(sync_le < 0 || sync_be < 0) {
+     scanner->clear();
+     sync_le = scanner->addPattern16(FY1_HRPT_SYNC, FY1_HRPT_SYNC_SIZE, true);
+     sync_be = scanner->addPattern16(FY1_HRPT_SYNC, FY1_HRPT_SYNC_SIZE, false);
+  }
 
-  for(y=0; y<frames; y++) {
-     if(!frameToImage(y, image))
+  pattern = block->isLittleEndian() ? sync_le:sync_be;
+
+  if(tail < 0)
+     tail = block->getFrameSyncPos(frames - 1) + (FY1_HRPT_BLOCK_SIZE << 1);
+
+  while(tail + frameSize <= reader->size()) {
+     // the frame is a block after the previous one unless the sync was lost
+     remaining = reader->size() - tail;
+     len = remaining > SYNC_SCAN_CHUNK ? SYNC_SCAN_CHUNK:(size_t) remaining;
+
+     buf = reader->data(tail, len);
+     if(buf == NULL)
+        break;
+
+     scanner->clearMatches();
+     scanner->scan(buf, len, tail);
+
+     // word aligned with the first frame
+     for(i = scanner->nextMatch(pattern, tail); i >= 0; i = scanner->nextMatch(pattern, tail, i + 1))
+        if(!((scanner->getMatch(i)->offset - block->getFirstFrameSyncPos()) & 1))
+           break;
+
+     if(i < 0) {
+        // keep the last bytes, the sync may cross the chunk border
+        tail += len - (FY1_HRPT_SYNC_SIZE << 1) + 1;
+        continue;
+     }
+
+     offset = scanner->getMatch(i)->offset;
+     if(offset + frameSize > reader->size()) {
+        tail = offset; // not completely written yet
+        break;
+     }
+
+     if(!store->grow(y + 1))
         break;
+
+     block->getIndex()->add(offset);
+     block->setFrames(y + 1);
+
+     frameToStore(y++, store);
+
+     // hop to next frame
+     tail = offset + (FY1_HRPT_BLOCK_SIZE << 1);
   }
 
- return true;
+ return y - frames;
 }
@@ -31,6 +31,8 @@
 #include <QtGlobal>
 #include <stdio.h>
 
+#include "linepool.h"
+
 //---------------------------------------------------------------------------
 //
 //                      typedef's
@@ -39,11 +41,12 @@
 
 //---------------------------------------------------------------------------
 
-class QImage;
+class TImageStore;
 class TBlock;
+class TBlockReader;
 
 //---------------------------------------------------------------------------
-class TFY1HRPT
+class TFY1HRPT : public TLineJob
 {
  public:
     TFY1HRPT(TBlock *_block);
@@ -55,26 +58,33 @@ class TFY1HRPT
 
     int  getNumChannels(void);
 
-    bool readFrameScanLine(int frame_nr);
-    bool frameToImage(int frame_nr, QImage *image);
-    bool toImage(QImage *image);
+    bool readFrameScanLine(int frame_nr, quint16 *line = NULL);
+    bool frameToStore(int frame_nr, TImageStore *store);
+    bool toStore(TImageStore *store_);
+    int  follow(TImageStore *store_);
 
-    quint16 getPixel_16(int channel, int sample);
-    quint8  getPixel_8(int channel, int sample);
+    bool decodeLine(int worker, int y);
 
     int Modes;
 
  protected:
     bool check(int flags=0);
 
-    bool findFrameSync(void);
+    void scanSync(void);
     bool sync_found;
 
  private:
     TBlock  *block;
-    FILE    *fp;
+    TBlockReader *reader;
+    int     sync_le, sync_be;
+    qint64  tail; // where the next frame sync of a growing recording is searched from
 
     quint16 *scanLine;
+
+    // one scan line per worker thread
+    quint16 *workLines;
+    int     workers;
+    TImageStore *store;
 };
 
 //---------------------------------------------------------------------------
@@ -33,6 +33,8 @@
 #include <QtGlobal>
 #include <stdio.h>
 
+#include "packetreassembler.h"
+
 //---------------------------------------------------------------------------
 //
 //                      typedef's
@@ -40,8 +42,9 @@
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
-class QImage;
+class TImageStore;
 class TBlock;
+class TBlockReader;
 class TCADU;
 
 
@@ -58,12 +61,8 @@ class TFYAHRPT
 
     int  getNumChannels(void);
 
-    bool readFrameScanLine(int frame_nr);
-    bool frameToImage(int frame_nr, QImage *image);
-    bool toImage(QImage *image);
-
-    quint16 getPixel_16(int channel, int sample);
-    quint8  getPixel_8(int channel, int sample);
+    bool toStore(TImageStore *store);
+    int  follow(TImageStore *store);
 
     int Modes;
 
@@ -72,6 +71,10 @@ class TFYAHRPT
     bool findFrameSync(void);
     long count_AVHRR_HR_frames(void);
 
+    const TSourcePacket *nextPacket(bool tail = false);
+    int  lostLines(const TSourcePacket *packet);
+    bool packetToScanLine(const TSourcePacket *packet);
+
 #if 0
     const char *spacecraftname(quint8 scid);
     const char *vcidTypeStr(quint8 vcid);
@@ -80,10 +83,14 @@ class TFYAHRPT
 
  private:
     TBlock  *block;
-    FILE    *fp;
+    TBlockReader *reader;
 
     TCADU   *cadu;
     quint16 *scanLine;
+
+    TPacketReassembler packets;
+    quint16 last_apid;
+    bool    following; // reading on a growing recording from where toStore ended
 };
 
 //---------------------------------------------------------------------------
@@ -20,10 +20,12 @@
 */
 //---------------------------------------------------------------------------
 
-#include <QImage>
 #include <stdlib.h>
+#include <string.h>
 #include "hrptblock.h"
 #include "block.h"
+#include "imagestore.h"
+#include "trace.h"
 
 //---------------------------------------------------------------------------
 /*
@@ -50,11 +52,6 @@ const int HRPT_SCAN_WIDTH   = 2048;  // words, one image scan
 const int HRPT_SCAN_SIZE    = 10240; // words, width * channels
 const int HRPT_IMAGE_START  = 750;   // offset words from frame sync
 
-#define HRPT_SYNC_SIZE 6
-static const quint16 HRPT_SYNC[HRPT_SYNC_SIZE] = {
-  0x0284, 0x016F, 0x035C, 0x019D, 0x020F, 0x0095
-};
-
 //---------------------------------------------------------------------------
 
 
@@ -65,7 +62,13 @@ THRPT::THRPT(TBlock *_block)
 
   datatype = UNPACKED16BIT;
   scanLine = NULL;
-  fp = NULL;
+  workLines = NULL;
+  workers = 0;
+  store = NULL;
+  reader = NULL;
+
+  sync_le = sync_be = -1;
+  tail = -1;
 }
 
 //---------------------------------------------------------------------------
@@ -73,6 +76,9 @@ THRPT::~THRPT(void)
 {
   if(scanLine)
      free(scanLine);
+
+  if(workLines)
+     free(workLines);
 }
 
 //---------------------------------------------------------------------------
@@ -84,16 +90,25 @@ bool THRPT::init(void)
   block->setFrames(0);
   block->setFirstFrameSyncPos(-1);
   block->setLittleEndian(true); // USRP default format
+  tail = -1;
 
   if(scanLine == NULL)
      scanLine = (quint16 *) malloc(HRPT_SCAN_SIZE << 1); // 20480 bytes
 
-  fp = block->getHandle();
-  if(countFrames() <= 0) {
-     // retry using different endian
-     block->setLittleEndian(!block->isLittleEndian());
-     countFrames();
-  }
+  reader = block->getReader();
+  if(!check())
+     return false;
+
+  if(block->fromIndex())
+     return check(1);
+
+  // one pass over the file finds the frame sync in both endians,
+  // use the one with most hits (USRP default on a tie)
+  scanSync();
+  if(block->getScanner()->count(sync_be) > block->getScanner()->count(sync_le))
+     block->setLittleEndian(false);
+
+  countFrames();
 
   return check(1);
 }
@@ -103,7 +118,7 @@ bool THRPT::init(void)
 bool THRPT::check(int flags)
 {
   // check allocation and file pointer status
-  if(block == NULL || fp == NULL || scanLine == NULL)
+  if(block == NULL || reader == NULL || !reader->isOpen() || scanLine == NULL)
      return false;
 
   // check found stuff
@@ -115,11 +130,28 @@ bool THRPT::check(int flags)
   return true;
 }
 
+//---------------------------------------------------------------------------
+void THRPT::scanSync(void)
+{
+  TSyncScanner *scanner = block->getScanner();
+
+  scanner->clear();
+  sync_le = scanner->addPattern16(HRPT_SYNC, HRPT_SYNC_SIZE, true);
+  sync_be = scanner->addPattern16(HRPT_SYNC, HRPT_SYNC_SIZE, false);
+
+  if(block->satprop->syncCheck())
+     scanner->scan(reader);
+}
+
 //---------------------------------------------------------------------------
 int THRPT::countFrames(void)
 {
- long int syncSize, firstFrameSyncPos;
- int frames;
+ TRACE_SCOPE("THRPT::countFrames");
+ TSyncScanner *scanner;
+ TSyncMatch *match;
+ qint64 syncSize, stride, next, firstFrameSyncPos;
+ long i;
+ int frames, pattern, parity;
 
   if(!check())
      return 0; // fatal error
@@ -127,71 +159,54 @@ int THRPT::countFrames(void)
   if(check(1)) // already done
      return block->getFrames();
 
-  block->gotoStart();
+  scanner = block->getScanner();
 
   syncSize = HRPT_SYNC_SIZE << 1; // 12 bytes
+  stride = HRPT_BLOCK_SIZE << 1;
   firstFrameSyncPos = -1;
   block->syncFound(false);
   frames = 0;
 
-  while(findFrameSync()) {
-     // we just read 6 words, HRPT_SYNC_SIZE
-     if(frames == 0)
-        firstFrameSyncPos = ftell(fp) - syncSize;
+  if(block->satprop->syncCheck()) {
+     pattern = block->isLittleEndian() ? sync_le:sync_be;
+     parity = scanner->parity(pattern);
+     next = 0;
 
-     ++frames;
+     for(i = scanner->nextMatch(pattern, next); i >= 0; i = scanner->nextMatch(pattern, next, i + 1)) {
+        match = scanner->getMatch(i);
 
-     // hop to next frame
-     if(fseek(fp, (HRPT_BLOCK_SIZE << 1) - syncSize, SEEK_CUR) != 0)
-        break;
+        if((match->offset & 1) != parity)
+           continue; // not word aligned with most of the frames
+
+        if(frames == 0)
+           firstFrameSyncPos = match->offset;
+
+        ++frames;
+        block->getIndex()->add(match->offset);
+
+        // hop to next frame
+        next = match->offset + stride;
+     }
+  }
+
+  else {
+     // no sync check, every block from the start of file is a frame
+     if(reader->size() >= syncSize) {
+        firstFrameSyncPos = 0;
+        frames = (int) ((reader->size() - syncSize) / stride) + 1;
 
-     block->syncFound(true);
+        for(i=0; i<frames; i++)
+           block->getIndex()->add(i * stride);
+     }
   }
 
+  block->syncFound(frames > 0);
   block->setFrames(frames);
   block->setFirstFrameSyncPos(firstFrameSyncPos);
 
  return frames;
 }
 
-//---------------------------------------------------------------------------
-bool THRPT::findFrameSync(void)
-{
-    quint8  ch[2];
-    quint16 w;
-    int i;
-
-    if(block->satprop->syncCheck()) {
-        i = 0;
-        while(fread(ch, sizeof(ch), 1, fp) == 1) {
-           if(block->isLittleEndian())
-              w = (ch[1] << 8) | ch[0];
-           else
-              w = (ch[0] << 8) | ch[1];
-
-           if(w == HRPT_SYNC[i])
-              i++;
-           else
-              i = 0;
-
-           if(i == HRPT_SYNC_SIZE)
-              return true;
-        }
-    }
-    else {
-        // no sync check, flush the sync
-        i = 0;
-        while(fread(ch, sizeof(ch), 1, fp) == 1) {
-            i++;
-
-            if(i == HRPT_SYNC_SIZE)
-               return true;
-        }
-    }
-
- return false;
-}
-
 //---------------------------------------------------------------------------
 int THRPT::getWidth(void)
 {
@@ -206,181 +221,188 @@ int THRPT::getNumChannels(void)
 
 //---------------------------------------------------------------------------
 // frame_nr is zero based (0, 1, 2, ... frames - 1)
-bool THRPT::readFrameScanLine(int frame_nr)
+// line is scanLine when NULL, the reader cursor is not used so workers with
+// their own line may call this at the same time on a mapped recording
+bool THRPT::readFrameScanLine(int frame_nr, quint16 *line)
 {
- long int pos, scanPos;
+ TRACE_SCOPE("THRPT::readFrameScanLine");
+ const quint8 *src;
+ qint64 scanPos;
  int x;
 
   if(!check(1))
      return false;
 
-  pos = ftell(fp);
-  if(pos < 0)
+  // frames are not always a block apart, eg. after a lost sync
+  scanPos = block->getFrameSyncPos(frame_nr);
+  if(scanPos < 0)
      return false;
 
-  scanPos = block->getFirstFrameSyncPos() + ((HRPT_IMAGE_START + frame_nr*HRPT_BLOCK_SIZE) << 1);
-
-  if(pos != scanPos) {
-     if(pos > scanPos)
-        fseek(fp, scanPos, SEEK_SET);
-     else
-        fseek(fp, scanPos - pos, SEEK_CUR);
-  }
+  scanPos += HRPT_IMAGE_START << 1;
 
   // todo: implement different packing features
-  if(fread(scanLine, HRPT_SCAN_SIZE << 1, 1, fp) != 1)
+  src = reader->data(scanPos, HRPT_SCAN_SIZE << 1);
+  if(src == NULL)
      return false;
 
+  if(line == NULL)
+     line = scanLine;
+
+  memcpy(line, src, HRPT_SCAN_SIZE << 1);
+
   if(!block->isLittleEndian())
      for(x=0; x < (HRPT_SCAN_WIDTH * HRPT_NUM_CHANNELS); x++)
-        SWAP16PTR(&scanLine[x]);
+        SWAP16PTR(&line[x]);
 
  return true;
 }
 
 //---------------------------------------------------------------------------
-// returns a 16 bit pixel from a frame channel
-// sample and channel are zero based
-quint16 THRPT::getPixel_16(int channel, int sample)
+// copies all channels of a frame to the image store
+// frame_nr is zero based
+bool THRPT::frameToStore(int frame_nr, TImageStore *store)
 {
- quint16 pixel, pos;
-
-  if(!check())
-     return 0;
-
-  if(!block->isNorthBound())
-     pos = channel + sample * HRPT_NUM_CHANNELS; // left to right
-  else
-     pos = channel + (HRPT_SCAN_WIDTH - sample - 1) * HRPT_NUM_CHANNELS; // right to left
+  if(!readFrameScanLine(frame_nr))
+     return false;
 
-  pixel = scanLine[pos] & 0x03ff;
+  store->putInterleaved(frame_nr, scanLine);
 
-  return pixel;
+ return true;
 }
 
 //---------------------------------------------------------------------------
-// returns a 8 bit pixel from a frame channel
-// sample and channel are zero based
-quint8 THRPT::getPixel_8(int channel, int sample)
+// scan line of a worker thread, see toStore
+bool THRPT::decodeLine(int worker, int y)
 {
-  return SCALE16TO8(getPixel_16(channel, sample));
+ quint16 *line = workLines + (size_t) worker * HRPT_SCAN_SIZE;
+
+  if(!readFrameScanLine(y, line))
+     return false;
+
+  store->putInterleaved(y, line);
+
+ return true;
 }
 
 //---------------------------------------------------------------------------
-// fills an 24 bpp image line of the selected channel
-// frame_nr is zero based
-bool THRPT::frameToImage(int frame_nr, QImage *image)
+bool THRPT::toStore(TImageStore *store_)
 {
-    Block_ImageType it;
-    uchar *imagescan, r, g, b;
-    quint16 r2, g2, b2;
-    double vi;
-    int x, y, *ch_rgb;
-
-    if(!check(1) || image == NULL)
-       return false;
-
-    if(!readFrameScanLine(frame_nr))
-       return false;
-
-    if(block->isNorthBound())
-       y = image->height() - frame_nr - 1;
-    else
-       y = frame_nr;
-
-    imagescan = (uchar *) image->scanLine(y);
-    if(imagescan == NULL)
-       return false;
-
-    it = block->getImageType();
-    switch(it) {
-    case RGB_ImageType:
-        ch_rgb = block->rgbconf->rgb_ch();
-        break;
+ int frames, y, threads;
 
-    case NDVI_ImageType:
-    {
-        if(block->rgbconf) {
-            ch_rgb = block->rgbconf->rgb_ch();
-            it = RGB_ImageType;
-        }
-        else
-            it = Channel_ImageType;
-    }
-        break;
+  if(!check(1) || store_ == NULL)
+     return false;
 
-    default:
-        it = Channel_ImageType;
-    }
-
-    for(x=0; x<HRPT_SCAN_WIDTH; x++) {
-        switch(it) {
-        case Channel_ImageType:
-            r = getPixel_8(block->getImageChannel(), x);
-            g = r;
-            b = r;
-            break;
-
-        case RGB_ImageType:
-            r = getPixel_8(ch_rgb[0] - 1, x);
-            g = getPixel_8(ch_rgb[1] - 1, x);
-            b = getPixel_8(ch_rgb[2] - 1, x);
-            break;
-
-        default:
-            return false;
-        }
+  store = store_;
 
-        if(block->getImageType() == NDVI_ImageType) {
-            // use all 10 bits
-            r2 = getPixel_16(block->ndvi->nir_ch() - 1, x);
-            b2 = getPixel_16(block->ndvi->vis_ch() - 1, x);
-            vi = block->ndvi->ndvi(r2, b2);
+  block->gotoStart();
+  frames = block->getFrames();
 
-            if(block->ndvi->isValid(vi)) {
-                g2 = block->ndvi->toColor_16(vi);
+  // frames are independent, decode them on all cores when the
+  // recording is mapped and every worker can read its own frames
+  threads = TLinePool::threads();
+  if(reader->isMapped() && threads > 1 && frames > LINEPOOL_CHUNK) {
+     if(workLines == NULL || workers < threads) {
+        if(workLines)
+           free(workLines);
 
-                switch(it) {
-                case Channel_ImageType:
-                    g = SCALE16TO8(g2);
-                    break;
+        workers = threads;
+        workLines = (quint16 *) malloc((size_t) workers * (HRPT_SCAN_SIZE << 1));
+     }
 
-                case RGB_ImageType:
-                    r = SCALE16TO8(r2);
-                    g = SCALE16TO8(g2);
-                    b = SCALE16TO8(b2);
-                    break;
+     if(workLines) {
+        TLinePool::run(this, frames, threads);
 
-                default:
-                    return false;
-                }
+        return true;
+     }
 
-            }
-        }
+     workers = 0;
+     qDebug("Failed to allocate worker scan lines %s:%d", __FILE__, __LINE__);
+  }
 
-        *imagescan++ = r;
-        *imagescan++ = g;
-        *imagescan++ = b;
-    }
+  for(y=0; y<frames; y++) {
+     if(!frameToStore(y, store))
+        break;
+  }
 
-    return true;
+ return true;
 }
 
 //---------------------------------------------------------------------------
-bool THRPT::toImage(QImage *image)
+// live decoding, appends the frames written since toStore or the previous
+// call, returns the number of new lines
+int THRPT::follow(TImageStore *store_)
 {
- int frames, y;
+ TSyncScanner *scanner;
+ const quint8 *buf;
+ qint64 offset, frameSize, remaining;
+ size_t len;
+ long i;
+ int frames, y, pattern;
+
+  if(!check(1) || store_ == NULL || !store_->isDecoded())
+     return 0;
 
-  if(!check(1))
-     return false;
+  store = store_;
+  scanner = block->getScanner();
+  frames = y = block->getFrames();
+  frameSize = (HRPT_IMAGE_START + HRPT_SCAN_SIZE) << 1;
 
-  block->gotoStart();
-  frames = block->getFrames();
+  // the frames came from the index, nothing has been scanned
+  if(sync_le < 0 || sync_be < 0) {
+     scanner->clear();
+     sync_le = scanner->addPattern16(HRPT_SYNC, HRPT_SYNC_SIZE, true);
+     sync_be = scanner->addPattern16(HRPT_SYNC, HRPT_SYNC_SIZE, false);
+  }
 
-  for(y=0; y<frames; y++) {
-     if(!frameToImage(y, image))
+  pattern = block->isLittleEndian() ? sync_le:sync_be;
+
+  if(tail < 0)
+     tail = block->getFrameSyncPos(frames - 1) + (HRPT_BLOCK_SIZE << 1);
+
+  while(tail + frameSize <= reader->size()) {
+     offset = tail;
+
+     if(block->satprop->syncCheck()) {
+        // the frame is a block after the previous one unless the sync was lost
+        remaining = reader->size() - tail;
+        len = remaining > SYNC_SCAN_CHUNK ? SYNC_SCAN_CHUNK:(size_t) remaining;
+
+        buf = reader->data(tail, len);
+        if(buf == NULL)
+           break;
+
+        scanner->clearMatches();
+        scanner->scan(buf, len, tail);
+
+        // word aligned with the first frame
+        for(i = scanner->nextMatch(pattern, tail); i >= 0; i = scanner->nextMatch(pattern, tail, i + 1))
+           if(!((scanner->getMatch(i)->offset - block->getFirstFrameSyncPos()) & 1))
+              break;
+
+        if(i < 0) {
+           // keep the last bytes, the sync may cross the chunk border
+           tail += len - (HRPT_SYNC_SIZE << 1) + 1;
+           continue;
+        }
+
+        offset = scanner->getMatch(i)->offset;
+        if(offset + frameSize > reader->size()) {
+           tail = offset; // not completely written yet
+           break;
+        }
+     }
+
+     if(!store->grow(y + 1))
         break;
+
+     block->getIndex()->add(offset);
+     block->setFrames(y + 1);
+
+     frameToStore(y++, store);
+
+     // hop to next frame
+     tail = offset + (HRPT_BLOCK_SIZE << 1);
   }
 
- return true;
+ return y - frames;
 }
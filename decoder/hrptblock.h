@@ -31,6 +31,8 @@
 #include <QtGlobal>
 #include <stdio.h>
 
+#include "linepool.h"
+
 //---------------------------------------------------------------------------
 //
 //                      typedef's
@@ -44,12 +46,20 @@ typedef enum HRPT_DataType_t
 } HRPT_DataType;
 
 //---------------------------------------------------------------------------
+// 10 bit frame sync, FY-1 frames start with the same words
+#define HRPT_SYNC_SIZE 6
+static const quint16 HRPT_SYNC[HRPT_SYNC_SIZE] = {
+  0x0284, 0x016F, 0x035C, 0x019D, 0x020F, 0x0095
+};
 
-class QImage;
+//---------------------------------------------------------------------------
+
+class TImageStore;
 class TBlock;
+class TBlockReader;
 
 //---------------------------------------------------------------------------
-class THRPT
+class THRPT : public TLineJob
 {
  public:
     THRPT(TBlock *_block);
@@ -61,25 +71,32 @@ class THRPT
 
     int  getNumChannels(void);
 
-    bool readFrameScanLine(int frame_nr);
-    bool frameToImage(int frame_nr, QImage *image);
-    bool toImage(QImage *image);
+    bool readFrameScanLine(int frame_nr, quint16 *line = NULL);
+    bool frameToStore(int frame_nr, TImageStore *store);
+    bool toStore(TImageStore *store_);
+    int  follow(TImageStore *store_);
 
-    quint16 getPixel_16(int channel, int sample);
-    quint8  getPixel_8(int channel, int sample);
+    bool decodeLine(int worker, int y);
 
     HRPT_DataType datatype;
     int Modes;
 
  protected:
     bool check(int flags=0);
-    bool findFrameSync(void);
+    void scanSync(void);
 
  private:
     TBlock  *block;
-    FILE    *fp;
+    TBlockReader *reader;
+    int     sync_le, sync_be;
+    qint64  tail; // where the next frame sync of a growing recording is searched from
 
     quint16 *scanLine;
+
+    // one scan line per worker thread
+    quint16 *workLines;
+    int     workers;
+    TImageStore *store;
 };
 
 //---------------------------------------------------------------------------
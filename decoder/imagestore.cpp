@@ -0,0 +1,199 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <string.h>
+
+#include "imagestore.h"
+
+//---------------------------------------------------------------------------
+TImageStore::TImageStore(void)
+{
+    buffer = zeros = NULL;
+    hist = NULL;
+    serial = 0;
+    size = 0;
+
+    width = height = rows = channels = 0;
+    decoded = false;
+}
+
+//---------------------------------------------------------------------------
+TImageStore::~TImageStore(void)
+{
+    clear();
+}
+
+//---------------------------------------------------------------------------
+void TImageStore::clear(void)
+{
+    if(buffer)
+        free(buffer);
+    buffer = NULL;
+
+    if(zeros)
+        free(zeros);
+    zeros = NULL;
+
+    if(hist)
+        free(hist);
+    hist = NULL;
+
+    size = 0;
+    width = height = rows = channels = 0;
+    decoded = false;
+    serial++;
+}
+
+//---------------------------------------------------------------------------
+// zero filled, lines the decoder fails to read stay black
+bool TImageStore::alloc(int width_, int height_, int channels_)
+{
+    clear();
+
+    if(width_ <= 0 || height_ <= 0 || channels_ <= 0)
+        return false;
+
+    size = (size_t) width_ * height_ * channels_;
+
+    buffer = (quint16 *) calloc(size, sizeof(quint16));
+    zeros = (quint16 *) calloc(width_, sizeof(quint16));
+    hist = (quint32 *) calloc((size_t) channels_ * STORE_HIST_BINS, sizeof(quint32));
+
+    if(buffer == NULL || zeros == NULL || hist == NULL) {
+        qDebug("Failed to allocate image store %dx%dx%d %s:%d", width_, height_, channels_, __FILE__, __LINE__);
+        clear();
+
+        return false;
+    }
+
+    width = width_;
+    height = rows = height_;
+    channels = channels_;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// adds zero filled lines to the end of every channel, room for as many
+// lines again is reserved so a growing pass is copied only now and then
+bool TImageStore::grow(int height_)
+{
+    quint16 *planes;
+    int ch, rows_;
+
+    if(buffer == NULL || height_ < height)
+        return false;
+
+    if(height_ <= rows) {
+        height = height_;
+        return true;
+    }
+
+    rows_ = height_ < (rows << 1) ? (rows << 1):height_;
+
+    planes = (quint16 *) calloc((size_t) width * rows_ * channels, sizeof(quint16));
+    if(planes == NULL) {
+        qDebug("Failed to allocate image store %dx%dx%d %s:%d", width, rows_, channels, __FILE__, __LINE__);
+        return false;
+    }
+
+    for(ch=0; ch<channels; ch++)
+        memcpy(planes + (size_t) ch * rows_ * width,
+               buffer + (size_t) ch * rows * width,
+               (size_t) height * width * sizeof(quint16));
+
+    free(buffer);
+    buffer = planes;
+
+    size = (size_t) width * rows_ * channels;
+    height = height_;
+    rows = rows_;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// channel and y are zero based
+quint16 *TImageStore::line(int channel, int y)
+{
+    if(buffer == NULL || channel < 0 || channel >= channels || y < 0 || y >= height)
+        return zeros;
+
+    return buffer + ((size_t) channel * rows + y) * width;
+}
+
+//---------------------------------------------------------------------------
+// splits a scan line of channel interleaved words (ch 1, ch 2, ... ch n, ch 1, ...)
+// into the channel planes
+void TImageStore::putInterleaved(int y, const quint16 *src)
+{
+    quint16 *dst;
+    int ch, x;
+
+    if(buffer == NULL || src == NULL || y < 0 || y >= height)
+        return;
+
+    for(ch=0; ch<channels; ch++) {
+        dst = line(ch, y);
+
+        for(x=0; x<width; x++)
+            dst[x] = src[x * channels + ch] & STORE_PIXEL_MASK;
+    }
+}
+
+//---------------------------------------------------------------------------
+// a single pass over the lines, called from one thread once the decoder
+// has filled them, see TBlock::decode and TBlock::follow
+void TImageStore::count(int first, int last)
+{
+    const quint16 *src;
+    quint32 *bins;
+    int ch, x, y;
+
+    if(buffer == NULL || hist == NULL)
+        return;
+
+    first = first < 0 ? 0:first;
+    last = last > height ? height:last;
+
+    for(ch=0; ch<channels; ch++) {
+        bins = hist + (size_t) ch * STORE_HIST_BINS;
+
+        for(y=first; y<last; y++) {
+            src = line(ch, y);
+
+            for(x=0; x<width; x++)
+                bins[src[x] & STORE_PIXEL_MASK]++;
+        }
+    }
+
+    serial++;
+}
+
+//---------------------------------------------------------------------------
+// STORE_HIST_BINS counts, channel is zero based, NULL if out of range
+const quint32 *TImageStore::histogram(int channel)
+{
+    if(hist == NULL || channel < 0 || channel >= channels)
+        return NULL;
+
+    return hist + (size_t) channel * STORE_HIST_BINS;
+}
@@ -0,0 +1,79 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef IMAGESTORE_H
+#define IMAGESTORE_H
+
+#include <QtGlobal>
+#include <stdlib.h>
+
+//---------------------------------------------------------------------------
+#define STORE_PIXEL_MASK    0x03ff // 10 bit samples
+#define STORE_HIST_BINS     (STORE_PIXEL_MASK + 1)
+
+//---------------------------------------------------------------------------
+// Decoded pass, every channel as a plane of width x height 10 bit samples
+// in the order they were received (southbound, left to right).
+// The decoders fill it once per opened recording, channel, RGB, NDVI and
+// northbound changes only recompose the image from it.
+// A live decoded pass grows, planes are rows lines apart so that lines
+// can be added without moving them until the rows are used up.
+class TImageStore
+{
+public:
+    TImageStore(void);
+    ~TImageStore(void);
+
+    bool alloc(int width_, int height_, int channels_);
+    bool grow(int height_);
+    void clear(void);
+
+    bool isDecoded(void) { return decoded; }
+    void setDecoded(bool yes) { decoded = yes; }
+
+    int  getWidth(void) { return width; }
+    int  getHeight(void) { return height; }
+    int  getChannels(void) { return channels; }
+
+    // a line of zeros when channel or y is out of range
+    quint16 *line(int channel, int y);
+
+    void putInterleaved(int y, const quint16 *src);
+
+    // the sample counts of every channel, lines first ... last - 1 are
+    // added by count once they are decoded
+    void count(int first, int last);
+    const quint32 *histogram(int channel);
+
+    // changes with the histograms, see TBlock::contrastLUT
+    quint32 getSerial(void) { return serial; }
+
+private:
+    quint16 *buffer, *zeros;
+    quint32 *hist;
+    quint32  serial;
+    size_t   size;
+
+    int  width, height, rows, channels;
+    bool decoded;
+};
+
+#endif // IMAGESTORE_H
@@ -0,0 +1,197 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include "linecompositor.h"
+#include "imagestore.h"
+#include "vegetationlut.h"
+#include "colorscale.h"
+
+//---------------------------------------------------------------------------
+// SCALE16TO8 as a table
+class TScaleLUT
+{
+public:
+    TScaleLUT(void)
+    {
+        int v;
+
+        for(v=0; v<=STORE_PIXEL_MASK; v++)
+            lut[v] = SCALE16TO8(v);
+    }
+
+    quint8 lut[STORE_PIXEL_MASK + 1];
+};
+
+static TScaleLUT scale;
+
+//---------------------------------------------------------------------------
+// reverse mirrors the line, __restrict tells the compiler dst does not
+// overlap the planes
+template <bool reverse>
+static void composeChannel(uchar * __restrict dst, const quint16 * const *planes, const quint8 * const *luts, int width, const TVegetationLUT *)
+{
+    const quint16 * __restrict src = planes[COMPOSE_R];
+    const quint8 *lut = luts[COMPOSE_R];
+    quint8 v;
+    int x, sx;
+
+    for(x=0; x<width; x++) {
+        sx = reverse ? width - x - 1:x;
+        v = lut[src[sx] & STORE_PIXEL_MASK];
+
+        dst[x * 3]     = v;
+        dst[x * 3 + 1] = v;
+        dst[x * 3 + 2] = v;
+    }
+}
+
+//---------------------------------------------------------------------------
+template <bool reverse>
+static void composeRGB(uchar * __restrict dst, const quint16 * const *planes, const quint8 * const *luts, int width, const TVegetationLUT *)
+{
+    const quint16 * __restrict r = planes[COMPOSE_R];
+    const quint16 * __restrict g = planes[COMPOSE_G];
+    const quint16 * __restrict b = planes[COMPOSE_B];
+    const quint8 *lr = luts[COMPOSE_R], *lg = luts[COMPOSE_G], *lb = luts[COMPOSE_B];
+    int x, sx;
+
+    for(x=0; x<width; x++) {
+        sx = reverse ? width - x - 1:x;
+
+        dst[x * 3]     = lr[r[sx] & STORE_PIXEL_MASK];
+        dst[x * 3 + 1] = lg[g[sx] & STORE_PIXEL_MASK];
+        dst[x * 3 + 2] = lb[b[sx] & STORE_PIXEL_MASK];
+    }
+}
+
+//---------------------------------------------------------------------------
+// The grayscale or RGB line, where the NDVI or EVI is valid its colour.
+// Without a colour scale it is the green and red and blue are the NIR and
+// VIS channels of an RGB one. The index of COMPOSE_CHUNK source samples
+// is looked up at a time.
+template <bool reverse, bool rgb, bool palette>
+static void composeVI(uchar *dst, const quint16 * const *planes, const quint8 * const *luts, int width, const TVegetationLUT *vi)
+{
+    const quint16 *nir = planes[COMPOSE_NIR], *vis = planes[COMPOSE_VIS];
+    const quint8 *lnir = luts[COMPOSE_NIR], *lvis = luts[COMPOSE_VIS];
+    const TColorScale *cs = vi->getScale();
+    const uchar *color;
+    quint16 pos[COMPOSE_CHUNK];
+    uchar *d;
+    int i, n, sx, x;
+
+    if(rgb)
+        composeRGB<reverse>(dst, planes, luts, width, vi);
+    else
+        composeChannel<reverse>(dst, planes, luts, width, vi);
+
+    for(sx=0; sx<width; sx+=n) {
+        n = width - sx < COMPOSE_CHUNK ? width - sx:COMPOSE_CHUNK;
+
+        vi->index(pos, nir + sx, vis + sx, planes[COMPOSE_BLUE] + sx, n);
+
+        for(i=0; i<n; i++) {
+            if(pos[i] == VI_INVALID)
+                continue;
+
+            x = reverse ? width - sx - i - 1:sx + i;
+            d = dst + x * 3;
+
+            if(palette) {
+                color = cs->color(pos[i]);
+
+                d[0] = color[0];
+                d[1] = color[1];
+                d[2] = color[2];
+            }
+            else {
+                d[1] = SCALE16TO8(pos[i]);
+
+                if(rgb) {
+                    d[0] = lnir[nir[sx + i] & STORE_PIXEL_MASK];
+                    d[2] = lvis[vis[sx + i] & STORE_PIXEL_MASK];
+                }
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+TLineCompositor::TLineCompositor(void)
+{
+    int i;
+
+    compose = composeChannel<false>;
+    vi = NULL;
+
+    for(i=0; i<COMPOSE_PLANES; i++)
+        luts[i] = scale.lut;
+}
+
+//---------------------------------------------------------------------------
+// lut has STORE_PIXEL_MASK + 1 entries, NULL drops the two low bits
+void TLineCompositor::setLUT(int plane, const quint8 *lut)
+{
+    if(plane >= 0 && plane < COMPOSE_PLANES)
+        luts[plane] = lut ? lut:scale.lut;
+}
+
+//---------------------------------------------------------------------------
+// rgb composes the R, G and B planes instead of the R (channel) plane,
+// also the base of an NDVI or EVI image, false if it is one of them and
+// vi_ is NULL
+bool TLineCompositor::init(Block_ImageType it, bool rgb, bool northbound, const TVegetationLUT *vi_)
+{
+    vi = vi_;
+
+    switch(it) {
+        case NDVI_ImageType:
+        case EVI_ImageType:
+            if(vi == NULL)
+                return false;
+
+            if(vi->getScale()) {
+                if(rgb)
+                    compose = northbound ? composeVI<true, true, true>:composeVI<false, true, true>;
+                else
+                    compose = northbound ? composeVI<true, false, true>:composeVI<false, false, true>;
+            }
+            else {
+                if(rgb)
+                    compose = northbound ? composeVI<true, true, false>:composeVI<false, true, false>;
+                else
+                    compose = northbound ? composeVI<true, false, false>:composeVI<false, false, false>;
+            }
+        break;
+
+        case RGB_ImageType:
+            if(rgb) {
+                compose = northbound ? composeRGB<true>:composeRGB<false>;
+                break;
+            }
+            // fall through, no RGB settings
+
+        default:
+            compose = northbound ? composeChannel<true>:composeChannel<false>;
+    }
+
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef LINECOMPOSITOR_H
+#define LINECOMPOSITOR_H
+
+#include <QtGlobal>
+
+#include "block.h"
+
+//---------------------------------------------------------------------------
+// planes of a scan line, see TLineCompositor::line
+#define COMPOSE_R           0 // the channel of a grayscale image
+#define COMPOSE_G           1
+#define COMPOSE_B           2
+#define COMPOSE_NIR         3
+#define COMPOSE_VIS         4 // VIS of an NDVI, red of an EVI
+#define COMPOSE_BLUE        5 // blue of an EVI
+#define COMPOSE_PLANES      6
+
+#define COMPOSE_CHUNK       256 // vegetation index samples looked up at a time
+
+class TVegetationLUT;
+
+typedef void (*TComposeLine)(uchar *dst, const quint16 * const *planes, const quint8 * const *luts, int width, const TVegetationLUT *vi);
+
+//---------------------------------------------------------------------------
+// Scan line to RGB888.
+// init picks the loop compiled for the image type and the scan direction
+// once per image, the loop of a line has no branches on them. planes are
+// the (planar) channels of TImageStore::line, a northbound line is
+// mirrored.
+// A sample is scaled to 8 bits by the table of its plane, see TContrast,
+// planes without one drop the two low bits.
+class TLineCompositor
+{
+public:
+    TLineCompositor(void);
+
+    bool init(Block_ImageType it, bool rgb, bool northbound, const TVegetationLUT *vi_ = NULL);
+    void setLUT(int plane, const quint8 *lut);
+
+    void line(uchar *dst, const quint16 * const *planes, int width)
+    {
+        compose(dst, planes, luts, width, vi);
+    }
+
+private:
+    TComposeLine compose;
+    const TVegetationLUT *vi;
+    const quint8 *luts[COMPOSE_PLANES];
+};
+
+#endif // LINECOMPOSITOR_H
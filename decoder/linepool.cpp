@@ -0,0 +1,104 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <QThread>
+#include <QAtomicInt>
+
+#include "linepool.h"
+#include "trace.h"
+
+//---------------------------------------------------------------------------
+class TLineWorker : public QThread
+{
+public:
+    TLineWorker(TLineJob *job_, int worker_, int lines_, QAtomicInt *next_, QAtomicInt *decoded_)
+    {
+        job = job_;
+        worker = worker_;
+        lines = lines_;
+        next = next_;
+        decoded = decoded_;
+    }
+
+    void run()
+    {
+        int y, first, last;
+
+        while((first = next->fetchAndAddOrdered(LINEPOOL_CHUNK)) < lines) {
+            last = first + LINEPOOL_CHUNK > lines ? lines:first + LINEPOOL_CHUNK;
+
+            TRACE_SCOPE("TLinePool::chunk");
+            for(y=first; y<last; y++)
+                if(job->decodeLine(worker, y))
+                    decoded->fetchAndAddRelaxed(1);
+        }
+    }
+
+private:
+    TLineJob   *job;
+    int        worker, lines;
+    QAtomicInt *next, *decoded;
+};
+
+//---------------------------------------------------------------------------
+int TLinePool::threads(void)
+{
+    int n = QThread::idealThreadCount();
+
+    return n < 1 ? 1:(n > LINEPOOL_MAX_THREADS ? LINEPOOL_MAX_THREADS:n);
+}
+
+//---------------------------------------------------------------------------
+// returns the number of decoded lines, blocks until all are done
+long TLinePool::run(TLineJob *job, int lines, int nthreads)
+{
+    TLineWorker *workers[LINEPOOL_MAX_THREADS];
+    QAtomicInt next(0), decoded(0);
+    long n;
+    int i, y;
+
+    if(job == NULL || lines <= 0)
+        return 0;
+
+    if(nthreads > LINEPOOL_MAX_THREADS)
+        nthreads = LINEPOOL_MAX_THREADS;
+
+    if(nthreads <= 1) {
+        n = 0;
+        for(y=0; y<lines; y++)
+            if(job->decodeLine(0, y))
+                n++;
+
+        return n;
+    }
+
+    for(i=0; i<nthreads; i++) {
+        workers[i] = new TLineWorker(job, i, lines, &next, &decoded);
+        workers[i]->start();
+    }
+
+    for(i=0; i<nthreads; i++) {
+        workers[i]->wait();
+        delete workers[i];
+    }
+
+    return (long) decoded.fetchAndAddOrdered(0);
+}
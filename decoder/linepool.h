@@ -0,0 +1,54 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef LINEPOOL_H
+#define LINEPOOL_H
+
+#include <QtGlobal>
+
+//---------------------------------------------------------------------------
+#define LINEPOOL_CHUNK          32 // scan lines claimed by a worker at a time
+#define LINEPOOL_MAX_THREADS    64
+
+//---------------------------------------------------------------------------
+// A decoder whose scan lines are independent of each other.
+// decodeLine is called from several threads at once, worker is
+// 0 ... threads - 1 and selects the buffers owned by that thread.
+class TLineJob
+{
+public:
+    virtual ~TLineJob(void) {}
+
+    virtual bool decodeLine(int worker, int y) = 0;
+};
+
+//---------------------------------------------------------------------------
+// Decodes lines 0 ... lines - 1 of a job on a set of worker threads.
+// Workers claim chunks of LINEPOOL_CHUNK lines from a shared counter until
+// all are taken, so a slow chunk never leaves the others idle.
+class TLinePool
+{
+public:
+    static int  threads(void);
+    static long run(TLineJob *job, int lines, int nthreads);
+};
+
+#endif // LINEPOOL_H
@@ -0,0 +1,99 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include "livedecoder.h"
+#include "block.h"
+
+//---------------------------------------------------------------------------
+TLiveDecoder::TLiveDecoder(TBlock *block_, QObject *parent) : QThread(parent)
+{
+    block = block_;
+    stopped = false;
+}
+
+//---------------------------------------------------------------------------
+TLiveDecoder::~TLiveDecoder(void)
+{
+    stop();
+}
+
+//---------------------------------------------------------------------------
+// blocks until the thread has ended
+void TLiveDecoder::stop(void)
+{
+    stopped = true;
+
+    wait();
+}
+
+//---------------------------------------------------------------------------
+// before start()
+void TLiveDecoder::setRecording(const QString &filename)
+{
+    recording = filename;
+}
+
+//---------------------------------------------------------------------------
+void TLiveDecoder::run(void)
+{
+    int  first, lines, idle;
+    bool rc;
+
+    idle = 0;
+
+    // TBlock::open fails until the first sync has been written
+    while(!stopped && !recording.isEmpty() && idle < LIVE_SYNC_TIMEOUT * 1000) {
+        msleep(LIVE_POLL_INTERVAL);
+
+        lock.lock();
+        rc = block->open(recording.toStdString().c_str());
+        lock.unlock();
+
+        if(rc) {
+            recording.clear();
+            idle = 0;
+
+            emit opened();
+        }
+        else
+            idle += LIVE_POLL_INTERVAL;
+    }
+
+    if(!recording.isEmpty())
+        return;
+
+    while(!stopped && idle < LIVE_IDLE_TIMEOUT * 1000) {
+        msleep(LIVE_POLL_INTERVAL);
+
+        lock.lock();
+        first = block->getHeight();
+        lines = block->follow();
+        lock.unlock();
+
+        if(lines > 0) {
+            emit linesDecoded(first, lines);
+            idle = 0;
+        }
+        else
+            idle += LIVE_POLL_INTERVAL;
+    }
+}
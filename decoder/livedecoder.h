@@ -0,0 +1,74 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef LIVEDECODER_H
+#define LIVEDECODER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QString>
+
+//---------------------------------------------------------------------------
+#define LIVE_POLL_INTERVAL     1000 // ms between looks at the recording
+#define LIVE_IDLE_TIMEOUT      60   // s without new data before the recording is assumed to be done
+#define LIVE_SYNC_TIMEOUT      900  // s a new recording may take to find its first sync
+
+class TBlock;
+
+//---------------------------------------------------------------------------
+// Follows a recording while the rx script is still writing it.
+// The file is polled, which works the same on every platform and is quick
+// enough for a few scan lines a second, and the lines written since the
+// last look are decoded by TBlock::follow. Every batch is announced with
+// linesDecoded, the receiver must hold mutex() while it uses the block.
+// The thread ends by itself when no lines have been added for LIVE_IDLE_TIMEOUT.
+// A recording the rx script has just started has no frame yet, with
+// setRecording the thread opens it once the first sync has been written
+// and announces it with opened.
+class TLiveDecoder : public QThread
+{
+    Q_OBJECT
+
+public:
+    TLiveDecoder(TBlock *block_, QObject *parent = 0);
+    ~TLiveDecoder(void);
+
+    void   stop(void);
+    void   setRecording(const QString &filename);
+    QMutex *mutex(void) { return &lock; }
+
+signals:
+    void opened(void);
+    void linesDecoded(int first, int count);
+
+protected:
+    void run(void);
+
+private:
+    TBlock  *block;
+    QMutex  lock;
+    QString recording; // to be opened, the block type must have been set
+
+    volatile bool stopped;
+};
+
+#endif // LIVEDECODER_H
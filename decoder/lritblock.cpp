@@ -25,6 +25,7 @@
 #include "block.h"
 #include "cadu.h"
 #include "lritblock.h"
+#include "trace.h"
 // #include <RiceDecompression.h>
 
 
@@ -141,6 +142,7 @@ bool TLRIT::init(void)
 //---------------------------------------------------------------------------
 int TLRIT::countFrames(void)
 {
+ TRACE_SCOPE("TLRIT::countFrames");
  long int filepos, nextpos, firstFrameSyncPos;
  int frames, pdu_hdrlen;
  quint32 fieldLen;
@@ -160,9 +162,7 @@ int TLRIT::countFrames(void)
    while((pdu_hdrlen = read_PDU_PrimaryHeader(&fieldLen)) > 0) {
       filepos = ftell(fp);
       nextpos = filepos + fieldLen;
-      qDebug("frame start filepos: 0x%x, next 0x%x",
-             (unsigned int) (filepos - LRIT_PDU_PRIM_HDR_LEN),
-             (unsigned int) nextpos);
+      TRACE_COUNT("TLRIT::pdus", 1);
 
       if(read_ImageStructureRecord()) {
          if(frames == 0) {
@@ -174,8 +174,6 @@ int TLRIT::countFrames(void)
          ++frames;
       }
 
-      qDebug("filepos: 0x%x", (unsigned int) ftell(fp));
-
       // hop to next primary header
       if(fseek(fp, nextpos - ftell(fp) - LRIT_PDU_PRIM_HDR_LEN, SEEK_CUR) != 0)
          break;
@@ -493,6 +491,7 @@ bool TLRIT::toImage(QImage *image)
 // frame_nr is zero based
 bool TLRIT::frameToImage(int frame_nr, QImage *image)
 {
+ TRACE_SCOPE("TLRIT::frameToImage");
  long int scanPos;
  bool rc;
 
@@ -500,7 +499,6 @@ bool TLRIT::frameToImage(int frame_nr, QImage *image)
      return false;
 
   scanPos = block->getFirstFrameSyncPos() + (LRIT_IMAGE_START + frame_nr*LRIT_BLOCK_SIZE);
-  qDebug("lrit scanPos: 0x%x frame: %d", (unsigned int) scanPos, frame_nr);
 
   if(fseek(fp, scanPos - ftell(fp), SEEK_CUR) != 0)
      return false;
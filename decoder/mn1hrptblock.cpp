@@ -19,11 +19,13 @@
     Web: <http://www.poes-weather.com>
 */
 //---------------------------------------------------------------------------
-#include <QImage>
 #include <stdlib.h>
+#include <string.h>
 
 #include "mn1hrptblock.h"
 #include "block.h"
+#include "imagestore.h"
+#include "trace.h"
 
 
 const int MN1_HRPT_BLOCK_SIZE       = 256;   // size in bytes
@@ -35,12 +37,6 @@ const int MN1_HRPT_SCAN_SIZE        = 11600; // 11550 bytes of image starting at
 const int MN1_HRPT_IMAGE_START      = 22;    // offset bytes from CADU sync start and second sync
 const int MN1_HRPT_SCAN_WIDTH       = 1540;
 
-#define MN1_HRPT_SYNC2_SIZE 8
-static const quint8 MN1_HRPT_SYNC2[MN1_HRPT_SYNC2_SIZE] = {
-  0x02, 0x18, 0xA7, 0xA3,
-  0x92, 0xDD, 0x9A, 0xBF
-};
-
 
 
 //---------------------------------------------------------------------------
@@ -49,8 +45,10 @@ TMN1HRPT::TMN1HRPT(TBlock *_block)
   block      = _block;
 
   scanLine   = NULL;
-  imgBlock   = NULL;
-  fp         = NULL;
+  workScans  = NULL;
+  workers    = 0;
+  store      = NULL;
+  reader     = NULL;
 
   testfp = NULL;
 
@@ -64,8 +62,8 @@ TMN1HRPT::~TMN1HRPT(void)
   if(scanLine)
      free(scanLine);
 
-  if(imgBlock)
-     free(imgBlock);
+  if(workScans)
+     free(workScans);
 
   if(testfp != NULL)
      fclose(testfp);
@@ -79,15 +77,14 @@ bool TMN1HRPT::init(void)
 
   if(scanLine == NULL)
      scanLine = (quint8 *) malloc(MN1_HRPT_SCAN_SIZE * sizeof(quint8));
-  if(imgBlock == NULL)
-     imgBlock = (quint8 *) malloc(MN1_HRPT_IMAGE_BLOCK_SIZE * sizeof(quint8));
 
   block->setFrames(0);
   block->setFirstFrameSyncPos(-1);
 
-  fp = block->getHandle();
+  reader = block->getReader();
 
-  countFrames();
+  if(!block->fromIndex())
+     countFrames();
 
   return check(1);
 }
@@ -97,7 +94,7 @@ bool TMN1HRPT::init(void)
 bool TMN1HRPT::check(int flags)
 {
   // check allocation and file pointer status
-  if(block == NULL || fp == NULL || scanLine == NULL || imgBlock == NULL)
+  if(block == NULL || reader == NULL || !reader->isOpen() || scanLine == NULL)
      return false;
 
   // check found stuff
@@ -112,49 +109,62 @@ bool TMN1HRPT::check(int flags)
 //---------------------------------------------------------------------------
 long int TMN1HRPT::countFrames(void)
 {
- long int frames, sync_pos, pos;
-
-  if(block == NULL || fp == NULL)
+ TRACE_SCOPE("TMN1HRPT::countFrames");
+ TSyncScanner *scanner;
+ TSyncMatch *match;
+ qint64 sync_pos, pos, delta;
+ long int frames, i;
+ int asm_id, sync2_id;
+
+  if(block == NULL || reader == NULL)
      return 0; // fatal error
 
   frames = block->getFrames();
   if(frames > 0) // already done
      return frames;
 
-  block->gotoStart();
+  // one pass over the file finds both the ASM and the second sync
+  scanner = block->getScanner();
+  scanner->clear();
+  asm_id   = scanner->addPattern(CADU_SYNC, CADU_SYNC_SIZE);
+  sync2_id = scanner->addPattern(MN1_HRPT_SYNC2, MN1_HRPT_SYNC2_SIZE);
+  scanner->scan(reader);
 
   frames = 0;
   sync_pos = -1;
   block->Modes &= ~B_SYNC_FOUND;
 
-  while(block->findCADUFrameSync()) {
-     pos = ftell(fp) - CADU_SYNC_SIZE;
+  i = scanner->nextMatch(asm_id, 0);
+  if(i >= 0) {
+     // the CADUs follow each other after the first ASM
      block->Modes |= B_SYNC_FOUND;
-     qDebug("ASM Sync marker 0x%08x [%d:%s]", (unsigned int)pos, __LINE__, __FILE__);
+     pos = scanner->getMatch(i)->offset;
+     i = 0;
 
-     // set pointer at byte 22 from sync
-     if(fseek(fp, MN1_HRPT_IMAGE_START - CADU_SYNC_SIZE, SEEK_CUR) != 0)
-        break;
+     while(pos + MN1_HRPT_IMAGE_START + MN1_HRPT_SYNC2_SIZE <= reader->size()) {
+        // second sync at byte 22 from the CADU sync
+        i = scanner->nextMatch(sync2_id, pos + MN1_HRPT_IMAGE_START, i);
+        if(i < 0)
+           break;
 
-     if(findFrameSync2()) {
-        if(frames == 0)
-           sync_pos = pos;
+        match = scanner->getMatch(i);
+        delta = match->offset - (pos + MN1_HRPT_IMAGE_START);
 
-        frames++;
+        if(delta == 0) {
+           if(frames == 0)
+              sync_pos = pos;
 
-        // set pointer at next CADU sync start + 50 frames
-        pos  = MN1_HRPT_BLOCK_SIZE - MN1_HRPT_IMAGE_START - MN1_HRPT_SYNC2_SIZE;
-        pos += (MN1_HRPT_BLOCK_SIZE * (MN1_HRPT_BLOCKS_PER_SCAN - 1));
-     }
-     else {
-        // check next frame
-        pos = MN1_HRPT_BLOCK_SIZE - (ftell(fp) - pos);
-     }
+           frames++;
+           block->getIndex()->add(pos);
 
-     if(fseek(fp, pos, SEEK_CUR) != 0)
-        break;
-
-     // pos = ftell(fp);
+           // next CADU sync start + 50 frames
+           pos += MN1_HRPT_BLOCK_SIZE * MN1_HRPT_BLOCKS_PER_SCAN;
+        }
+        else {
+           // hop to the CADU where the next second sync may be
+           pos += ((delta + MN1_HRPT_BLOCK_SIZE - 1) / MN1_HRPT_BLOCK_SIZE) * MN1_HRPT_BLOCK_SIZE;
+        }
+     }
   }
 
   block->setFrames(frames);
@@ -163,26 +173,6 @@ long int TMN1HRPT::countFrames(void)
  return frames;
 }
 
-//---------------------------------------------------------------------------
-bool TMN1HRPT::findFrameSync2(void)
-{
- quint8 ch;
- int    i;
-
-  i = 0;
-  while(fread(&ch, 1, 1, fp) == 1) {
-     if(ch == MN1_HRPT_SYNC2[i])
-        i++;
-     else
-        return false;
-
-     if(i == MN1_HRPT_SYNC2_SIZE)
-        return true;
-  }
-
- return false;
-}
-
 //---------------------------------------------------------------------------
 int TMN1HRPT::getWidth(void)
 {
@@ -206,45 +196,47 @@ int TMN1HRPT::getNumChannels(void)
 
 //---------------------------------------------------------------------------
 // frame_nr is zero based (0, 1, 2, ... frames - 1)
-bool TMN1HRPT::readFrameScan(int frame_nr)
+// scan is scanLine when NULL, a worker thread passes its own buffer and
+// leaves the reader cursor alone
+bool TMN1HRPT::readFrameScan(int frame_nr, quint8 *scan)
 {
- long int pos, scanPos;
+ TRACE_SCOPE("TMN1HRPT::readFrameScan");
+ const quint8 *src;
+ qint64 scanPos;
+ long int pos;
  int i;
 
   if(!check(1))
      return false;
 
-  pos = ftell(fp);
-  if(pos < 0)
+  // scan lines are not always 50 CADUs apart, eg. after a lost sync
+  scanPos = block->getFrameSyncPos(frame_nr);
+  if(scanPos < 0)
      return false;
 
-  scanPos = block->getFirstFrameSyncPos() + MN1_HRPT_IMAGE_START + (frame_nr * MN1_HRPT_BLOCK_SIZE * MN1_HRPT_BLOCKS_PER_SCAN);
-
-  if(pos != scanPos) {
-     if(pos > scanPos)
-        fseek(fp, scanPos, SEEK_SET);
-     else
-        fseek(fp, scanPos - pos, SEEK_CUR);
-  }
+  scanPos += MN1_HRPT_IMAGE_START;
 
-  pos = ftell(fp);
+  if(scan == NULL)
+     scan = scanLine;
 
-  memset(scanLine, 0, sizeof(quint8) * MN1_HRPT_SCAN_SIZE);
+  memset(scan, 0, sizeof(quint8) * MN1_HRPT_SCAN_SIZE);
 
   pos = 0;
   for(i=0; i<MN1_HRPT_BLOCKS_PER_SCAN; i++) {
-     if(fread(imgBlock, MN1_HRPT_IMAGE_BLOCK_SIZE, 1, fp) != 1)
+     // image part starts at byte 22 in every CADU
+     src = reader->data(scanPos, MN1_HRPT_IMAGE_BLOCK_SIZE);
+     if(src == NULL)
         break;
 
-     memcpy(scanLine + pos, imgBlock, MN1_HRPT_IMAGE_BLOCK_SIZE);
+     memcpy(scan + pos, src, MN1_HRPT_IMAGE_BLOCK_SIZE);
      pos += MN1_HRPT_IMAGE_BLOCK_SIZE;
+     scanPos += MN1_HRPT_BLOCK_SIZE;
+  }
 
-     // we are now at bytepos 254 from CADU sync
-     // hop to byte 22 in the next CADU
+  if(scan != scanLine)
+     return i > 0 ? true:false;
 
-     if(fseek(fp, MN1_HRPT_IMAGE_START + 2, SEEK_CUR) != 0)
-        break;
-  }
+  reader->seek(scanPos);
 
   if(testfp != NULL)
      if((signed) fwrite(scanLine, 1, MN1_HRPT_SCAN_SIZE, testfp) != MN1_HRPT_SCAN_SIZE)
@@ -255,6 +247,7 @@ bool TMN1HRPT::readFrameScan(int frame_nr)
 
 //---------------------------------------------------------------------------
 // returns a 16 bit pixel from a frame channel
+// group is the 5 bytes * 6 channels of 4 samples
 // sample (0-3) and channel are zero based
 
 /*
@@ -265,18 +258,15 @@ bool TMN1HRPT::readFrameScan(int frame_nr)
     11 11 11 11  11 22 22 22  22 22 33 33  33 33 33 44  44 44 44 44  10 x 4 bit out
 */
 
-quint16 TMN1HRPT::getPixel_16(int channel, int sample)
+quint16 TMN1HRPT::getPixel_16(const quint8 *group, int channel, int sample)
 {
  quint16 pixel_16, tmp16;
  int     pos, shift;
 
-  if(!check())
-     return 0;
-
   pos = channel * MN1_HRPT_CHANNEL_SIZE + sample;
 
   // XXXX XXXX YYYY YYYY
-  pixel_16 = (imgBlock[pos] << 8) | imgBlock[pos + 1];
+  pixel_16 = (group[pos] << 8) | group[pos + 1];
   // 0000 00XX XXXX XXYY
   shift = 6 - (sample * 2);
   pixel_16 >>= shift;
@@ -299,77 +289,31 @@ quint16 TMN1HRPT::getPixel_16(int channel, int sample)
 }
 
 //---------------------------------------------------------------------------
-// returns a 8 bit pixel from a frame channel
-// sample (0-3) and channel are zero based
-quint8 TMN1HRPT::getPixel_8(int channel, int sample)
-{
-  return SCALE16TO8(getPixel_16(channel, sample));
-}
-
-//---------------------------------------------------------------------------
-// fills an 24 bpp image line of the selected channel
-// scan_nr is zero based
-bool TMN1HRPT::scanToImage(int scan_nr, QImage *image)
+// unpacks all channels of a scan to the image store
+// scan_nr is zero based, scan as in readFrameScan
+bool TMN1HRPT::scanToStore(int scan_nr, TImageStore *store, quint8 *scan)
 {
- Block_ImageType it;
- uchar *imagescan;
- quint8 r, g, b;
+ quint16 *dst;
  long int pos;
- int i, j, y, ch, width, *ch_rgb;
+ int i, j, ch, width;
 
- if(!readFrameScan(scan_nr))
+ if(!readFrameScan(scan_nr, scan))
     return false;
 
- if(block->isNorthBound())
-    y = image->height() - scan_nr - 1;
- else
-    y = scan_nr;
-
-  imagescan = (uchar *) image->scanLine(y);
-  if(imagescan == NULL)
-     return false;
-
-  it = block->getImageType();
-  ch = block->getImageChannel();
-
-  switch(it) {
-  case RGB_ImageType:
-      ch_rgb = block->rgbconf->rgb_ch();
-      break;
-
-  default:
-      break;
-  }
+ if(scan == NULL)
+    scan = scanLine;
 
   // width / 4 = 385 samples needed to produce one scanline
   width = (MN1_HRPT_SCAN_WIDTH >> 2);
 
   pos = 50;
   for(i=0; i<width; i++) {
-     // copy all channels 5 bytes * 6 ch
-     memcpy(imgBlock, scanLine + pos, MN1_HRPT_CHANNEL_SIZE * MN1_HRPT_NUM_CHANNELS);
-
-     for(j=0; j<4; j++) {
-         switch(it) {
-         case Channel_ImageType:
-             r = getPixel_8(ch, j);
-             g = r;
-             b = r;
-         break;
-
-         case RGB_ImageType:
-             r = getPixel_8(ch_rgb[0] - 1, j);
-             g = getPixel_8(ch_rgb[1] - 1, j);
-             b = getPixel_8(ch_rgb[2] - 1, j);
-         break;
-
-         default:
-             return false;
-        }
+     // all channels 5 bytes * 6 ch
+     for(ch=0; ch<MN1_HRPT_NUM_CHANNELS; ch++) {
+         dst = store->line(ch, scan_nr) + (i << 2);
 
-        *imagescan++ = r;
-        *imagescan++ = g;
-        *imagescan++ = b;
+         for(j=0; j<4; j++)
+             dst[j] = getPixel_16(scan + pos, ch, j);
      }
 
      pos += MN1_HRPT_CHANNEL_SIZE * MN1_HRPT_NUM_CHANNELS;
@@ -379,18 +323,47 @@ bool TMN1HRPT::scanToImage(int scan_nr, QImage *image)
 }
 
 //---------------------------------------------------------------------------
-bool TMN1HRPT::toImage(QImage *image)
+// scan of a worker thread, see toStore
+bool TMN1HRPT::decodeLine(int worker, int y)
+{
+  return scanToStore(y, store, workScans + (size_t) worker * MN1_HRPT_SCAN_SIZE);
+}
+
+//---------------------------------------------------------------------------
+bool TMN1HRPT::toStore(TImageStore *store_)
 {
  long int frames, y;
+ int threads;
 
-  if(!check(1) || image == NULL)
+  if(!check(1) || store_ == NULL)
      return false;
 
+  store = store_;
+
   block->gotoStart();
   frames = block->getFrames();
 
+  // scans are independent, decode them on all cores when the
+  // recording is mapped and every worker can read its own CADUs
+  threads = TLinePool::threads();
+  if(reader->isMapped() && testfp == NULL && threads > 1 && frames > LINEPOOL_CHUNK) {
+     if(workScans == NULL || workers < threads) {
+        if(workScans)
+           free(workScans);
+
+        workers = threads;
+        workScans = (quint8 *) malloc((size_t) workers * MN1_HRPT_SCAN_SIZE);
+     }
+
+     if(workScans)
+        return TLinePool::run(this, (int) frames, threads) > 0;
+
+     workers = 0;
+     qDebug("Failed to allocate worker scans %s:%d", __FILE__, __LINE__);
+  }
+
   for(y=0; y<frames; y++) {
-     if(!scanToImage(y, image))
+     if(!scanToStore(y, store))
         break;
   }
 
@@ -25,12 +25,23 @@
 #include <QtGlobal>
 #include <stdio.h>
 
+#include "linepool.h"
+
+//---------------------------------------------------------------------------
+// second sync, starts the scan line in the CADU stream
+#define MN1_HRPT_SYNC2_SIZE 8
+static const quint8 MN1_HRPT_SYNC2[MN1_HRPT_SYNC2_SIZE] = {
+  0x02, 0x18, 0xA7, 0xA3,
+  0x92, 0xDD, 0x9A, 0xBF
+};
+
 //---------------------------------------------------------------------------
-class QImage;
+class TImageStore;
 class TBlock;
+class TBlockReader;
 
 //---------------------------------------------------------------------------
-class TMN1HRPT
+class TMN1HRPT : public TLineJob
 {
 public:
     TMN1HRPT(TBlock *_block);
@@ -43,25 +54,31 @@ public:
 
     int  getNumChannels(void);
 
-    bool readFrameScan(int frame_nr);
-    bool scanToImage(int scan_nr, QImage *image);
-    bool toImage(QImage *image);
+    bool readFrameScan(int frame_nr, quint8 *scan = NULL);
+    bool scanToStore(int scan_nr, TImageStore *store, quint8 *scan = NULL);
+    bool toStore(TImageStore *store_);
+
+    bool decodeLine(int worker, int y);
 
     int Modes;
 
  protected:
     bool check(int flags=0);
     bool findFrameSync(void);
-    bool findFrameSync2(void);
 
-    quint16 getPixel_16(int channel, int sample);
-    quint8  getPixel_8(int channel, int sample);
+    static quint16 getPixel_16(const quint8 *group, int channel, int sample);
 
  private:
     TBlock  *block;
-    FILE    *fp, *testfp;
+    TBlockReader *reader;
+    FILE    *testfp;
+
+    quint8 *scanLine;
 
-    quint8 *scanLine, *imgBlock;
+    // one scan per worker thread
+    quint8 *workScans;
+    int    workers;
+    TImageStore *store;
 };
 
 //---------------------------------------------------------------------------
@@ -23,7 +23,8 @@
 
 #include "mn1lrptblock.h"
 #include "block.h"
-#include "ReedSolomon.h"
+#include "rsdecoder.h"
+#include "trace.h"
 
 
 const int MN1LRPT_BLOCK_SIZE    = 256;  // undecoded rs decoded size in bytes
@@ -46,22 +47,15 @@ TMN1LRPT::TMN1LRPT(TBlock *_block)
 
   scanLine   = NULL;
   rsData     = NULL;
-  fp         = NULL;
+  reader     = NULL;
   syncOffset = 0;
 
   rawData  = (quint8 *) malloc(MN1LRPT_BLOCK_SIZE * sizeof(quint8)); // holds the undecoded frame
   rsData   = (quint8 *) malloc(MN1LRPT_RS_BLOCK_SIZE * sizeof(quint8)); // holds the rs decoded frame
   scanLine = (quint8 *) malloc(10); // MN1LRPT_SCAN_WIDTH * MN1LRPT_NUM_CHANNELS * sizeof(quint8));
 
-  rs = new CReedSolomon(8,                      // int BitsPerSymbol
-                        16,                     // int CorrectableErrors
-                        112,                    // int mo
-                        11,                     // int poa
-                        0,                      // int VirtualFill
-                        4,                      // int Interleave
-                        MN1LRPT_SYNC_SIZE,      // int FrameSyncLength
-                        1                       // int mode, dual
-                       );
+  // ccsds 255,223, 4 interleaves, dual basis
+  rs = new TRSDecoder(4, true);
 }
 
 //---------------------------------------------------------------------------
@@ -89,20 +83,20 @@ bool TMN1LRPT::init(void)
   block->setFirstFrameSyncPos(-1);
   syncOffset = 0;
 
-  fp = block->getHandle();
+  reader = block->getReader();
   frames = countFrames();
 
 #if 0
 //  if(check(1) && fseek(fp, block->getFirstFrameSyncPos() + (MN1LRPT_BLOCK_SIZE * 100), SEEK_SET) == 0) {
-  if(check(1) && fseek(fp, 0L, SEEK_SET) == 0) {
+  if(check(1) && reader->seek(0)) {
      for(int i=0;  i<1000; i++) {
-        if(fread(rsData, MN1LRPT_BLOCK_SIZE, 1, fp) == 1) {
+        if(reader->read(rsData, MN1LRPT_BLOCK_SIZE) == MN1LRPT_BLOCK_SIZE) {
            // qDebug("RS decode frame: %d", i);
-           if(rs->Decode(rsData))
+           if(rs->decode(rsData + MN1LRPT_SYNC_SIZE) == 0)
               qDebug("RS decode OK! Frame: %d", i);
            /*
            else
-              qDebug("RS decode failed! Correctable errors: %d, Uncorrectable errors: %d", rs->CorrectableErrorsInFrame(), rs->UncorrectableErrorsInFrame());
+              qDebug("RS decode failed! Uncorrectable codewords: %d", rs->getFailed());
               */
         }
      }
@@ -119,7 +113,7 @@ bool TMN1LRPT::init(void)
 bool TMN1LRPT::check(int flags)
 {
   // check allocation and file pointer status
-  if(block == NULL || fp == NULL || scanLine == NULL ||
+  if(block == NULL || reader == NULL || !reader->isOpen() || scanLine == NULL ||
      rsData == NULL || rawData == NULL)
      return false;
 
@@ -135,10 +129,14 @@ bool TMN1LRPT::check(int flags)
 //---------------------------------------------------------------------------
 int TMN1LRPT::countFrames(void)
 {
- long int firstFrameSyncPos;
- int frames;
-
-  if(block == NULL || fp == NULL)
+ TRACE_SCOPE("TMN1LRPT::countFrames");
+ TSyncScanner *scanner;
+ TSyncMatch *match;
+ long int firstFrameSyncPos, i;
+ qint64 next;
+ int frames, sync_id;
+
+  if(block == NULL || reader == NULL)
      return 0; // fatal error
 
   frames = block->getFrames();
@@ -151,18 +149,26 @@ int TMN1LRPT::countFrames(void)
   frames            = 0;
   syncOffset        = 0;
 
-  while(findFrameSync()) {
+  scanner = block->getScanner();
+  scanner->clear();
+  sync_id = scanner->addPattern(MN1LRPT_SYNC, MN1LRPT_SYNC_SIZE);
+  scanner->scan(reader);
+
+  next = 0;
+  i = 0;
+  while((i = scanner->nextMatch(sync_id, next, i)) >= 0) {
+     match = scanner->getMatch(i);
+
      if(frames == 0)
-        firstFrameSyncPos = ftell(fp) - MN1LRPT_SYNC_SIZE;
+        firstFrameSyncPos = match->offset;
      else if(frames == 1)
-        syncOffset = ftell(fp) - MN1LRPT_SYNC_SIZE - firstFrameSyncPos;
+        syncOffset = match->offset - firstFrameSyncPos;
 
      ++frames;
 
      // hop to next frame
-     if(frames > 1)
-        if(fseek(fp, syncOffset - MN1LRPT_SYNC_SIZE, SEEK_CUR) != 0)
-           break;
+     next = match->offset + (frames > 1 ? syncOffset:MN1LRPT_SYNC_SIZE);
+     i++;
   }
 
   block->setFrames(frames);
@@ -172,26 +178,6 @@ int TMN1LRPT::countFrames(void)
  return frames;
 }
 
-//---------------------------------------------------------------------------
-bool TMN1LRPT::findFrameSync(void)
-{
- quint8 ch;
- int    i;
-
-  i = 0;
-  while(fread(&ch, 1, 1, fp) == 1) {
-     if(ch == MN1LRPT_SYNC[i])
-        i++;
-     else
-        i = 0;
-
-     if(i == MN1LRPT_SYNC_SIZE)
-        return true;
-  }
-
- return false;
-}
-
 //---------------------------------------------------------------------------
 int TMN1LRPT::getWidth(void)
 {
@@ -28,7 +28,8 @@
 //---------------------------------------------------------------------------
 class QImage;
 class TBlock;
-class CReedSolomon;
+class TBlockReader;
+class TRSDecoder;
 
 //---------------------------------------------------------------------------
 class TMN1LRPT
@@ -54,15 +55,14 @@ public:
 
  protected:
     bool check(int flags=0);
-    bool findFrameSync(void);
 
  private:
     TBlock  *block;
     int     syncOffset;
-    FILE    *fp;
+    TBlockReader *reader;
 
     quint8 *scanLine, *rsData, *rawData;
-    CReedSolomon *rs;
+    TRSDecoder *rs;
 };
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,265 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+
+#include "packetreassembler.h"
+#include "cadu.h"
+
+#define VCDU_COUNTER_MASK   0x00ffffff // 24 bit
+
+//---------------------------------------------------------------------------
+TPacketReassembler::TPacketReassembler(void)
+{
+    pool[0] = (quint8 *) malloc(PACKET_MAX_SIZE);
+    pool[1] = (quint8 *) malloc(PACKET_MAX_SIZE);
+
+    if(pool[0] == NULL || pool[1] == NULL)
+        qDebug("Failed to allocate packet pool %s:%d", __FILE__, __LINE__);
+
+    reset();
+}
+
+//---------------------------------------------------------------------------
+TPacketReassembler::~TPacketReassembler(void)
+{
+    if(pool[0])
+        free(pool[0]);
+    if(pool[1])
+        free(pool[1]);
+}
+
+//---------------------------------------------------------------------------
+void TPacketReassembler::reset(void)
+{
+    int i;
+
+    for(i=0; i<=PACKET_IDLE_APID; i++) {
+        last_sequence[i] = -1;
+        last_packet[i] = 0;
+    }
+
+    last_counter = -1;
+    vcid = -1;
+
+    active = 0;
+    partial_len = partial_size = 0;
+
+    out_count = out_next = 0;
+    packets = lost = dropped = 0;
+}
+
+//---------------------------------------------------------------------------
+void TPacketReassembler::drop(void)
+{
+    if(partial_len > 0)
+        dropped++;
+
+    partial_len = partial_size = 0;
+}
+
+//---------------------------------------------------------------------------
+// a packet starts in the CADU in the buffer
+void TPacketReassembler::start(TCADU *cadu)
+{
+    partial_len = partial_size = 0;
+
+    partial.address = cadu->getpacketaddress();
+    partial.counter = cadu->counter();
+    partial.rs_errors = cadu->getrserrors();
+}
+
+//---------------------------------------------------------------------------
+// adds up to len bytes to the packet being gathered, returns the bytes used
+int TPacketReassembler::gather(const quint8 *src, int len, TCADU *cadu)
+{
+    quint8 *buf = pool[active];
+    int    used, n;
+
+    if(buf == NULL)
+        return len;
+
+    if(cadu->getrserrors() < 0)
+        partial.rs_errors = -1;
+    else if(partial.rs_errors >= 0 && cadu->getrserrors() > partial.rs_errors)
+        partial.rs_errors = cadu->getrserrors();
+
+    used = 0;
+
+    if(partial_size == 0) {
+        n = PACKET_PRIMARY_HDR_LEN - partial_len;
+        if(n > len)
+            n = len;
+
+        memcpy(buf + partial_len, src, n);
+        partial_len += n;
+        used = n;
+
+        if(partial_len < PACKET_PRIMARY_HDR_LEN)
+            return used;
+
+        // packet data length is the data field size - 1
+        partial_size = PACKET_PRIMARY_HDR_LEN + ((buf[4] << 8) | buf[5]) + 1;
+    }
+
+    n = partial_size - partial_len;
+    if(n > len - used)
+        n = len - used;
+
+    memcpy(buf + partial_len, src + used, n);
+    partial_len += n;
+    used += n;
+
+    if(partial_len == partial_size) {
+        complete(buf, partial_size, &partial);
+
+        // the completed packet stays valid until the next push
+        active ^= 1;
+        partial_len = partial_size = 0;
+    }
+
+    return used;
+}
+
+//---------------------------------------------------------------------------
+void TPacketReassembler::complete(const quint8 *data, int size, TSourcePacket *info)
+{
+    TSourcePacket *packet;
+    quint16 apid;
+    long    cadus;
+
+    apid = ((data[0] & 0x07) << 8) | data[1];
+    if(apid == PACKET_IDLE_APID || out_count >= PACKET_MAX_PER_MPDU)
+        return;
+
+    packet = &out[out_count++];
+    *packet = *info;
+
+    packet->data = data;
+    packet->size = size;
+    packet->vcid = (quint8) vcid;
+    packet->apid = apid;
+    packet->sequenceflag = (data[2] >> 6) & 0x03;
+    packet->sequence_count = ((data[2] << 8) | data[3]) & PACKET_SEQ_MASK;
+
+    packet->missing = 0;
+    packets++;
+
+    if(packet->rs_errors < 0)
+        return;
+
+    if(last_sequence[apid] >= 0) {
+        packet->missing = (packet->sequence_count - last_sequence[apid] - 1) & PACKET_SEQ_MASK;
+
+        // a corrupted count, it is taken up again from this packet
+        cadus = (packet->counter - last_packet[apid]) & VCDU_COUNTER_MASK;
+        if(packet->missing > cadus * (MPDU_DATA_UNIT - MPDU_HDR_LEN) / size + 1)
+            packet->missing = 0;
+    }
+
+    last_sequence[apid] = packet->sequence_count;
+    last_packet[apid] = packet->counter;
+
+    lost += packet->missing;
+}
+
+//---------------------------------------------------------------------------
+// returns the number of packets completed by this CADU
+int TPacketReassembler::push(TCADU *cadu)
+{
+    const quint8 *mpdu, *zone;
+    TSourcePacket info;
+    quint32 counter;
+    int     hdr_ptr, zone_len, pos, left, size, n;
+
+    out_count = out_next = 0;
+
+    mpdu = cadu->get_mpdu();
+    zone = mpdu + MPDU_HDR_LEN;
+    zone_len = MPDU_DATA_UNIT - (int) (zone - cadu->getpayload_buffer());
+
+    // the M_PDUs of a virtual channel only continue each other without a gap
+    counter = cadu->counter();
+    if(cadu->vcid() != vcid ||
+       (last_counter >= 0 && counter != (((quint32) last_counter + 1) & VCDU_COUNTER_MASK)))
+        drop();
+
+    vcid = cadu->vcid();
+    last_counter = (qint32) counter;
+
+    hdr_ptr = ((mpdu[0] << 8) | mpdu[1]) & 0x07ff; // 11 bit
+    if(hdr_ptr == MPDU_IDLE)
+        return 0;
+
+    if(hdr_ptr != MPDU_NO_HEADER && hdr_ptr >= zone_len) {
+        drop(); // bogus header pointer
+        return 0;
+    }
+
+    // the zone starts with the rest of the packet being gathered
+    if(partial_len > 0) {
+        n = hdr_ptr == MPDU_NO_HEADER ? zone_len:hdr_ptr;
+        gather(zone, n, cadu);
+
+        // it must end where the header pointer says the next one starts
+        if(hdr_ptr != MPDU_NO_HEADER && partial_len > 0)
+            drop();
+    }
+
+    if(hdr_ptr == MPDU_NO_HEADER)
+        return out_count;
+
+    info.address = cadu->getpacketaddress();
+    info.counter = counter;
+    info.rs_errors = cadu->getrserrors();
+
+    for(pos=hdr_ptr; pos<zone_len; pos+=size) {
+        left = zone_len - pos;
+
+        if(left >= PACKET_PRIMARY_HDR_LEN) {
+            size = PACKET_PRIMARY_HDR_LEN + ((zone[pos + 4] << 8) | zone[pos + 5]) + 1;
+
+            if(size <= left) {
+                complete(zone + pos, size, &info); // in place
+                continue;
+            }
+        }
+
+        // continues in the next M_PDU
+        start(cadu);
+        gather(zone + pos, left, cadu);
+        break;
+    }
+
+    return out_count;
+}
+
+//---------------------------------------------------------------------------
+// the next packet completed by the last push, NULL when there are no more
+const TSourcePacket *TPacketReassembler::next(void)
+{
+    if(out_next >= out_count)
+        return NULL;
+
+    return &out[out_next++];
+}
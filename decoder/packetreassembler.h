@@ -0,0 +1,112 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef PACKETREASSEMBLER_H
+#define PACKETREASSEMBLER_H
+
+#include <QtGlobal>
+
+//---------------------------------------------------------------------------
+#define MPDU_DATA_UNIT          892    // VCDU without the RS check symbols
+#define MPDU_HDR_LEN            2
+#define MPDU_NO_HEADER          0x07ff // first header pointer, no packet starts here
+#define MPDU_IDLE               0x07fe // first header pointer, idle data only
+
+#define PACKET_PRIMARY_HDR_LEN  6
+#define PACKET_MAX_SIZE         (PACKET_PRIMARY_HDR_LEN + 65536)
+#define PACKET_IDLE_APID        0x07ff
+#define PACKET_SEQ_MASK         0x3fff // 14 bit sequence count
+#define PACKET_MAX_PER_MPDU     128    // 7 byte packets in an 884 byte zone
+
+class TCADU;
+
+//---------------------------------------------------------------------------
+// A CCSDS source packet (CP_PDU) as it came out of the M_PDUs
+typedef struct TSourcePacket_t
+{
+    const quint8 *data;   // primary header and data field
+    int     size;         // bytes
+
+    quint8  vcid;
+    quint16 apid;
+    quint16 sequence_count;
+    quint8  sequenceflag;
+    int     missing;      // packets of this APID lost since the previous one
+
+    long    address;      // sync address of the CADU with the primary header
+    quint32 counter;      // and its VCDU counter
+    int     rs_errors;    // worst CADU of the packet, -1 = RS failed
+} TSourcePacket;
+
+//---------------------------------------------------------------------------
+// Reassembles the source packets of one virtual channel.
+// push() splits the M_PDU packet zone of a CADU at its first header
+// pointer and next() returns the packets that were completed by it.
+// A packet inside one CADU points straight into the CADU payload, one that
+// spans several is gathered in a pooled buffer. Both stay valid until the
+// next push.
+// A VCDU counter gap or a header pointer that disagrees with the packet
+// being gathered drops that packet, the sequence counts of the following
+// packets tell how many were lost. The count of a packet in a CADU that
+// failed RS is not used, nor a gap larger than the CADUs since the last
+// packet of the APID could hold.
+class TPacketReassembler
+{
+public:
+    TPacketReassembler(void);
+    ~TPacketReassembler(void);
+
+    void reset(void);
+
+    int                  push(TCADU *cadu);
+    const TSourcePacket *next(void);
+
+    long getPackets(void) { return packets; }
+    long getLost(void) { return lost; }
+    long getDropped(void) { return dropped; }
+
+protected:
+    void drop(void);
+    int  gather(const quint8 *src, int len, TCADU *cadu);
+    void start(TCADU *cadu);
+    void complete(const quint8 *data, int size, TSourcePacket *info);
+
+private:
+    // packet being gathered
+    quint8        *pool[2];
+    int           active;
+    int           partial_len, partial_size; // size is 0 until the header is in
+    TSourcePacket partial;
+
+    // packets completed by the last push
+    TSourcePacket out[PACKET_MAX_PER_MPDU];
+    int           out_count, out_next;
+
+    qint32 last_sequence[PACKET_IDLE_APID + 1]; // -1 = none yet
+    quint32 last_packet[PACKET_IDLE_APID + 1];  // VCDU counter of that packet
+    qint32 last_counter;                        // VCDU counter, -1 = none yet
+    int    vcid;
+
+    long packets, lost, dropped;
+};
+
+#endif // PACKETREASSEMBLER_H
@@ -0,0 +1,467 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+
+    Berlekamp-Massey, Chien search and Forney as in libfec by Phil Karn, KA9Q
+*/
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSSE3__)
+#  include <tmmintrin.h>
+#endif
+
+#include "rsdecoder.h"
+
+#define A0          RS_NN // log of zero
+#define MODNN(x)    ((x) % RS_NN)
+
+//---------------------------------------------------------------------------
+// Field, dual basis and per root multiply tables, shared by all decoders
+// and filled once before main()
+static quint8 alpha_to[256];   // exp
+static quint8 index_of[256];   // log
+static quint8 genpoly[RS_NROOTS + 1]; // index form
+static quint8 taltab[256];     // conventional to dual basis
+static quint8 tal1tab[256];    // dual to conventional basis
+static quint8 rootmul[RS_NROOTS][256]; // x * root k
+
+class TRSTables
+{
+public:
+    TRSTables(void)
+    {
+        static const quint8 tal[8] = { 0x8d, 0xef, 0xec, 0x86, 0xfa, 0x99, 0xaf, 0x7b };
+        int i, j, k, sr, root;
+
+        // GF(256) with x^8 + x^7 + x^2 + x + 1
+        index_of[0] = A0;
+        alpha_to[A0] = 0;
+        sr = 1;
+        for(i=0; i<RS_NN; i++) {
+            index_of[sr] = i;
+            alpha_to[i] = sr;
+            sr <<= 1;
+            if(sr & 0x100)
+                sr ^= RS_GFPOLY;
+        }
+
+        // generator polynomial
+        genpoly[0] = 1;
+        for(i=0, root=RS_FCR * RS_PRIM; i<RS_NROOTS; i++, root+=RS_PRIM) {
+            genpoly[i + 1] = 1;
+
+            for(j=i; j>0; j--) {
+                if(genpoly[j] != 0)
+                    genpoly[j] = genpoly[j - 1] ^ alpha_to[MODNN(index_of[genpoly[j]] + root)];
+                else
+                    genpoly[j] = genpoly[j - 1];
+            }
+
+            genpoly[0] = alpha_to[MODNN(index_of[genpoly[0]] + root)];
+        }
+
+        for(i=0; i<=RS_NROOTS; i++)
+            genpoly[i] = index_of[genpoly[i]];
+
+        // Berlekamp's dual basis
+        for(i=0; i<256; i++) {
+            taltab[i] = 0;
+            for(k=0; k<8; k++)
+                if(i & (1 << k))
+                    taltab[i] ^= tal[7 - k];
+
+            tal1tab[taltab[i]] = i;
+        }
+
+        for(k=0; k<RS_NROOTS; k++) {
+            root = MODNN((RS_FCR + k) * RS_PRIM);
+
+            rootmul[k][0] = 0;
+            for(i=1; i<256; i++)
+                rootmul[k][i] = alpha_to[MODNN(index_of[i] + root)];
+        }
+    }
+};
+
+static TRSTables rs_tables;
+
+//---------------------------------------------------------------------------
+// a * alpha^e, e in index form
+static inline quint8 gf_mulexp(quint8 a, int e)
+{
+    return a ? alpha_to[MODNN(index_of[a] + e)]:0;
+}
+
+//---------------------------------------------------------------------------
+TRSDecoder::TRSDecoder(int interleave_, bool dual_)
+{
+    int k, n, e, step;
+
+    interleave = interleave_ < 1 ? 1:(interleave_ > RS_MAX_INTERLEAVE ? RS_MAX_INTERLEAVE:interleave_);
+    dual = dual_;
+    failed = 0;
+
+    memset(errors, 0, sizeof(errors));
+
+    // 16 byte blocks hold 16 / interleave symbols of every codeword
+    tables = NULL;
+    if(16 % interleave != 0)
+        return; // no lane layout, the scalar path is used
+
+    tables = (quint8 *) malloc(RS_NROOTS * 32 + 32);
+    if(tables == NULL) {
+        qDebug("Failed to allocate Reed Solomon tables %s:%d", __FILE__, __LINE__);
+        return;
+    }
+
+    step = 16 / interleave;
+
+    for(k=0; k<RS_NROOTS; k++) {
+        e = MODNN((RS_FCR + k) * RS_PRIM * step);
+
+        for(n=0; n<16; n++) {
+            tables[k * 32 + n]      = gf_mulexp(n, e);
+            tables[k * 32 + 16 + n] = gf_mulexp(n << 4, e);
+        }
+    }
+
+    // dual to conventional is linear, it splits into nibbles too
+    for(n=0; n<16; n++) {
+        tables[RS_NROOTS * 32 + n]      = dual ? tal1tab[n]:n;
+        tables[RS_NROOTS * 32 + 16 + n] = dual ? tal1tab[n << 4]:(n << 4);
+    }
+}
+
+//---------------------------------------------------------------------------
+TRSDecoder::~TRSDecoder(void)
+{
+    if(tables)
+        free(tables);
+}
+
+//---------------------------------------------------------------------------
+const char *TRSDecoder::engine(void)
+{
+#if defined(__SSSE3__)
+    return "SSSE3";
+#else
+    return "scalar";
+#endif
+}
+
+//---------------------------------------------------------------------------
+int TRSDecoder::getErrors(int codeword)
+{
+    if(codeword < 0 || codeword >= interleave)
+        return 0;
+
+    return errors[codeword];
+}
+
+//---------------------------------------------------------------------------
+// s[codeword * RS_NROOTS + k], conventional basis
+void TRSDecoder::syndromes(const quint8 *data, quint8 *s)
+{
+    const quint8 *cv = dual ? tal1tab:NULL;
+    quint8 y;
+    int i, j, k, start;
+
+    start = 0;
+
+#if defined(__SSSE3__)
+    if(tables) {
+        // Lane l = m * interleave + i holds symbol b * step + m of codeword i
+        // for block b, every lane runs Horner with root^step over the blocks.
+        __m128i acc[RS_NROOTS];
+        __m128i lo, hi, x, a, nib;
+        quint8  lanes[16];
+        int     step, nb, m, e;
+
+        nib  = _mm_set1_epi8(0x0f);
+        step = 16 / interleave;
+        nb   = RS_NN / step;
+
+        for(k=0; k<RS_NROOTS; k++)
+            acc[k] = _mm_setzero_si128();
+
+        lo = _mm_loadu_si128((const __m128i *) (tables + RS_NROOTS * 32));
+        hi = _mm_loadu_si128((const __m128i *) (tables + RS_NROOTS * 32 + 16));
+
+        for(j=0; j<nb; j++) {
+            x = _mm_loadu_si128((const __m128i *) (data + (j << 4)));
+            x = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(x, nib)),
+                              _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(x, 4), nib)));
+
+            for(k=0; k<RS_NROOTS; k++) {
+                a = acc[k];
+                a = _mm_xor_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (tables + k * 32)),
+                                                   _mm_and_si128(a, nib)),
+                                  _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (tables + k * 32 + 16)),
+                                                   _mm_and_si128(_mm_srli_epi16(a, 4), nib)));
+                acc[k] = _mm_xor_si128(a, x);
+            }
+        }
+
+        // fold the lanes into the syndromes of every codeword, Horner
+        // goes on with the tail symbols below
+        for(k=0; k<RS_NROOTS; k++) {
+            _mm_storeu_si128((__m128i *) lanes, acc[k]);
+            e = MODNN((RS_FCR + k) * RS_PRIM);
+
+            for(i=0; i<interleave; i++) {
+                y = 0;
+                for(m=0; m<step; m++)
+                    y ^= gf_mulexp(lanes[m * interleave + i], MODNN(e * (step - 1 - m)));
+
+                s[i * RS_NROOTS + k] = y;
+            }
+        }
+
+        start = nb * step;
+    }
+#endif
+
+    if(start == 0)
+        memset(s, 0, interleave * RS_NROOTS);
+
+    // Horner, remaining symbols or the whole codeword without SIMD
+    for(j=start; j<RS_NN; j++) {
+        for(i=0; i<interleave; i++) {
+            y = data[j * interleave + i];
+            if(cv)
+                y = cv[y];
+
+            quint8 *si = s + i * RS_NROOTS;
+            for(k=0; k<RS_NROOTS; k++)
+                si[k] = rootmul[k][si[k]] ^ y;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// Berlekamp-Massey, Chien search and Forney on one codeword, the errors
+// are XORed into the interleaved data. Returns the number of corrected
+// symbols or -1 when uncorrectable, the data is left as it is then.
+int TRSDecoder::correct(quint8 *data, int codeword, quint8 *s)
+{
+    quint8 lambda[RS_NROOTS + 1], b[RS_NROOTS + 1], t[RS_NROOTS + 1];
+    quint8 omega[RS_NROOTS + 1], reg[RS_NROOTS + 1];
+    quint8 root[RS_NROOTS], loc[RS_NROOTS], err[RS_NROOTS];
+    int    i, j, k, r, el, q, count;
+    int    deg_lambda, deg_omega, discr_r, tmp, num1, num2, den;
+
+    for(i=0; i<RS_NROOTS; i++)
+        s[i] = index_of[s[i]];
+
+    memset(lambda, 0, sizeof(lambda));
+    lambda[0] = 1;
+
+    for(i=0; i<RS_NROOTS + 1; i++)
+        b[i] = index_of[lambda[i]];
+
+    // Berlekamp-Massey
+    r = 0;
+    el = 0;
+    while(++r <= RS_NROOTS) {
+        discr_r = 0;
+        for(i=0; i<r; i++) {
+            if(lambda[i] != 0 && s[r - i - 1] != A0)
+                discr_r ^= alpha_to[MODNN(index_of[lambda[i]] + s[r - i - 1])];
+        }
+
+        discr_r = index_of[discr_r];
+
+        if(discr_r == A0) {
+            memmove(&b[1], b, RS_NROOTS);
+            b[0] = A0;
+        }
+        else {
+            t[0] = lambda[0];
+            for(i=0; i<RS_NROOTS; i++) {
+                if(b[i] != A0)
+                    t[i + 1] = lambda[i + 1] ^ alpha_to[MODNN(discr_r + b[i])];
+                else
+                    t[i + 1] = lambda[i + 1];
+            }
+
+            if(2 * el <= r - 1) {
+                el = r - el;
+                for(i=0; i<=RS_NROOTS; i++)
+                    b[i] = (lambda[i] == 0) ? A0:MODNN(index_of[lambda[i]] - discr_r + RS_NN);
+            }
+            else {
+                memmove(&b[1], b, RS_NROOTS);
+                b[0] = A0;
+            }
+
+            memcpy(lambda, t, RS_NROOTS + 1);
+        }
+    }
+
+    deg_lambda = 0;
+    for(i=0; i<RS_NROOTS + 1; i++) {
+        lambda[i] = index_of[lambda[i]];
+        if(lambda[i] != A0)
+            deg_lambda = i;
+    }
+
+    if(deg_lambda == 0 || deg_lambda > RS_NROOTS / 2)
+        return -1;
+
+    // Chien search for the roots of lambda
+    memcpy(&reg[1], &lambda[1], RS_NROOTS);
+    count = 0;
+    for(i=1, k=RS_IPRIM - 1; i<=RS_NN; i++, k=MODNN(k + RS_IPRIM)) {
+        q = 1; // lambda[0] is always 0
+        for(j=deg_lambda; j>0; j--) {
+            if(reg[j] != A0) {
+                reg[j] = MODNN(reg[j] + j);
+                q ^= alpha_to[reg[j]];
+            }
+        }
+
+        if(q != 0)
+            continue;
+
+        root[count] = i;
+        loc[count] = k;
+
+        if(++count == deg_lambda)
+            break;
+    }
+
+    if(count != deg_lambda)
+        return -1;
+
+    // omega(x) = s(x) * lambda(x) mod x^RS_NROOTS
+    deg_omega = deg_lambda - 1;
+    for(i=0; i<=deg_omega; i++) {
+        tmp = 0;
+        for(j=i; j>=0; j--) {
+            if(s[i - j] != A0 && lambda[j] != A0)
+                tmp ^= alpha_to[MODNN(s[i - j] + lambda[j])];
+        }
+
+        omega[i] = index_of[tmp];
+    }
+
+    // Forney
+    for(j=count-1; j>=0; j--) {
+        num1 = 0;
+        for(i=deg_omega; i>=0; i--) {
+            if(omega[i] != A0)
+                num1 ^= alpha_to[MODNN(omega[i] + i * root[j])];
+        }
+
+        num2 = alpha_to[MODNN(root[j] * (RS_FCR - 1) + RS_NN)];
+
+        den = 0;
+        // lambda[i+1] for i even is the formal derivative of lambda
+        for(i=qMin(deg_lambda, RS_NROOTS - 1) & ~1; i>=0; i-=2) {
+            if(lambda[i + 1] != A0)
+                den ^= alpha_to[MODNN(lambda[i + 1] + i * root[j])];
+        }
+
+        // a root of lambda that is also a root of its derivative
+        if(den == 0)
+            return -1;
+
+        err[j] = num1 == 0 ? 0:alpha_to[MODNN(index_of[num1] + index_of[num2] + RS_NN - index_of[den])];
+    }
+
+    // both bases are linear, the error converts on its own
+    for(j=0; j<count; j++)
+        data[loc[j] * interleave + codeword] ^= dual ? taltab[err[j]]:err[j];
+
+    return count;
+}
+
+//---------------------------------------------------------------------------
+// decodes interleave * 255 bytes in place, returns the number of corrected
+// symbols or -1 if any codeword is uncorrectable
+int TRSDecoder::decode(quint8 *data)
+{
+    quint8 s[RS_MAX_INTERLEAVE * RS_NROOTS];
+    quint8 any;
+    int i, k, rc, total;
+
+    if(data == NULL)
+        return -1;
+
+    syndromes(data, s);
+
+    total = 0;
+    failed = 0;
+
+    for(i=0; i<interleave; i++) {
+        any = 0;
+        for(k=0; k<RS_NROOTS; k++)
+            any |= s[i * RS_NROOTS + k];
+
+        if(any == 0) {
+            errors[i] = 0; // fast path, codeword is clean
+            continue;
+        }
+
+        rc = correct(data, i, s + i * RS_NROOTS);
+        errors[i] = rc;
+
+        if(rc < 0)
+            failed++;
+        else
+            total += rc;
+    }
+
+    return failed ? -1:total;
+}
+
+//---------------------------------------------------------------------------
+// fills the last 32 symbols of every codeword with parity, used to build
+// synthetic test data
+void TRSDecoder::encode(quint8 *data)
+{
+    quint8 parity[RS_NROOTS];
+    quint8 feedback, y;
+    int i, j, c;
+
+    for(c=0; c<interleave; c++) {
+        memset(parity, 0, RS_NROOTS);
+
+        for(i=0; i<RS_KK; i++) {
+            y = data[i * interleave + c];
+            if(dual)
+                y = tal1tab[y];
+
+            feedback = index_of[y ^ parity[0]];
+
+            if(feedback != A0) {
+                for(j=1; j<RS_NROOTS; j++)
+                    parity[j] ^= alpha_to[MODNN(feedback + genpoly[RS_NROOTS - j])];
+            }
+
+            memmove(&parity[0], &parity[1], RS_NROOTS - 1);
+            parity[RS_NROOTS - 1] = feedback != A0 ? alpha_to[MODNN(feedback + genpoly[0])]:0;
+        }
+
+        for(i=0; i<RS_NROOTS; i++)
+            data[(RS_KK + i) * interleave + c] = dual ? taltab[parity[i]]:parity[i];
+    }
+}
@@ -0,0 +1,82 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef RSDECODER_H
+#define RSDECODER_H
+
+#include <QtGlobal>
+#include <stdio.h>
+
+//---------------------------------------------------------------------------
+// CCSDS Reed-Solomon (255,223), E=16
+#define RS_NN               255
+#define RS_NROOTS           32
+#define RS_KK               (RS_NN - RS_NROOTS)
+#define RS_FCR              112
+#define RS_PRIM             11
+#define RS_IPRIM            116 // RS_PRIM * RS_IPRIM = 1 mod RS_NN
+#define RS_GFPOLY           0x187
+
+#define RS_MAX_INTERLEAVE   16
+
+//---------------------------------------------------------------------------
+// In-tree CCSDS RS(255,223) decoder.
+// The codewords of a frame are interleaved, symbol j of codeword i is at
+// data[j * interleave + i], and all of them are decoded in place in one
+// strided pass. Syndromes are computed 16 bytes at a time when built with
+// SSSE3 (GF(256) multiply by split nibble tables and PSHUFB), a frame with
+// only zero syndromes costs nothing more. Symbols are in Berlekamp's dual
+// basis unless dual is false.
+class TRSDecoder
+{
+public:
+    TRSDecoder(int interleave = 4, bool dual = true);
+    ~TRSDecoder(void);
+
+    int  decode(quint8 *data);
+    void encode(quint8 *data);
+
+    int  getInterleave(void) { return interleave; }
+    int  getFrameSize(void) { return interleave * RS_NN; }
+    bool isDual(void) { return dual; }
+
+    // results of the last decode, -1 = uncorrectable codeword
+    int  getErrors(int codeword);
+    int  getFailed(void) { return failed; }
+
+    static const char *engine(void);
+
+protected:
+    void syndromes(const quint8 *data, quint8 *s);
+    int  correct(quint8 *data, int codeword, quint8 *s);
+
+private:
+    int  interleave;
+    bool dual;
+
+    int  errors[RS_MAX_INTERLEAVE];
+    int  failed;
+
+    // nibble tables, multiply by root^(16 / interleave) and dual to conventional
+    quint8 *tables;
+};
+
+#endif // RSDECODER_H
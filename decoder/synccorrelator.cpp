@@ -0,0 +1,332 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+
+#include "synccorrelator.h"
+#include "syncscanner.h"
+#include "blockreader.h"
+
+#define CORR_HI_BITS    Q_UINT64_C(0xAAAAAAAAAAAAAAAA) // I bit of every symbol
+#define CORR_LO_BITS    Q_UINT64_C(0x5555555555555555) // Q bit of every symbol
+
+//---------------------------------------------------------------------------
+static inline int bitcount(quint64 x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+
+    while(x) {
+        x &= x - 1;
+        n++;
+    }
+
+    return n;
+#endif
+}
+
+//---------------------------------------------------------------------------
+TSyncCorrelator::TSyncCorrelator(void)
+{
+    syncsize = 0;
+    syncbits = 0;
+    mask = 0;
+
+    memset(pattern, 0, sizeof(pattern));
+
+    threshold = CORR_DEFAULT_ERRORS;
+    prefilter = NULL;
+}
+
+//---------------------------------------------------------------------------
+TSyncCorrelator::~TSyncCorrelator(void)
+{
+    if(prefilter)
+        free(prefilter);
+}
+
+//---------------------------------------------------------------------------
+// sync is 1 ... CORR_MAX_SIZE bytes, the first byte is sent first
+bool TSyncCorrelator::setSync(const quint8 *sync_, int size)
+{
+    quint64 bits;
+    int i;
+
+    if(sync_ == NULL || size < 1 || size > CORR_MAX_SIZE)
+        return false;
+
+    if(size == syncsize && memcmp(sync, sync_, size) == 0)
+        return true; // no change
+
+    memcpy(sync, sync_, size);
+    syncsize = size;
+    syncbits = size << 3;
+    mask = (Q_UINT64_C(1) << syncbits) - 1;
+
+    bits = 0;
+    for(i=0; i<size; i++)
+        bits = (bits << 8) | sync[i];
+
+    for(i=0; i<CORR_PHASES; i++)
+        pattern[i] = rotate(bits, syncbits, i);
+
+    if(syncbits < CORR_PREFILTER_BITS) {
+        if(prefilter)
+            free(prefilter);
+        prefilter = NULL;
+
+        return true;
+    }
+
+    if(prefilter == NULL) {
+        prefilter = (quint8 *) malloc(1 << CORR_PREFILTER_BITS);
+        if(prefilter == NULL) {
+            qDebug("Failed to allocate sync prefilter %s:%d", __FILE__, __LINE__);
+            return true; // slower but still works
+        }
+    }
+
+    quint64 lead;
+    int v, p, e, best;
+
+    for(v=0; v<(1 << CORR_PREFILTER_BITS); v++) {
+        best = CORR_PREFILTER_BITS;
+
+        for(p=0; p<CORR_PHASES; p++) {
+            lead = pattern[p] >> (syncbits - CORR_PREFILTER_BITS);
+            e = bitcount(lead ^ (quint64) v);
+            if(e < best)
+                best = e;
+        }
+
+        prefilter[v] = (quint8) best;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void TSyncCorrelator::setThreshold(int errors)
+{
+    threshold = errors < 0 ? 0:(errors > CORR_MAX_ERRORS ? CORR_MAX_ERRORS:errors);
+}
+
+//---------------------------------------------------------------------------
+// rotates nbits (even) of symbol pairs, I is the high and Q the low bit
+//   0: ( I,  Q)
+//   1: (~Q,  I)
+//   2: (~I, ~Q)
+//   3: ( Q, ~I)
+quint64 TSyncCorrelator::rotate(quint64 bits, int nbits, int phase)
+{
+    quint64 m, swap;
+
+    m = nbits >= 64 ? ~Q_UINT64_C(0):((Q_UINT64_C(1) << nbits) - 1);
+    swap = ((bits & CORR_HI_BITS) >> 1) | ((bits & CORR_LO_BITS) << 1);
+
+    switch(phase & 3) {
+        case 1:  bits = swap ^ CORR_HI_BITS; break;
+        case 2:  bits = ~bits; break;
+        case 3:  bits = swap ^ CORR_LO_BITS; break;
+        default: break;
+    }
+
+    return bits & m;
+}
+
+//---------------------------------------------------------------------------
+// undoes rotate(phase) on byte aligned data
+void TSyncCorrelator::derotate(quint8 *buf, size_t len, int phase)
+{
+    quint8 b, swap, x;
+    size_t i;
+
+    phase &= 3;
+    if(phase == 0)
+        return;
+
+    // 1 and 3 are inverses of each other, 2 is its own inverse
+    x = phase == 2 ? 0xff:(phase == 1 ? 0x55:0xaa);
+
+    for(i=0; i<len; i++) {
+        b = buf[i];
+
+        if(phase == 2)
+            buf[i] = b ^ x;
+        else {
+            swap = ((b & 0xaa) >> 1) | ((b & 0x55) << 1);
+            buf[i] = swap ^ x;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// returns syncbits bits starting at bit, right aligned
+bool TSyncCorrelator::getBits(TBlockReader *reader, qint64 bit, quint64 *bits)
+{
+    const quint8 *src;
+    quint64 x;
+    size_t i, len;
+    int shift;
+
+    if(bit < 0 || syncbits == 0)
+        return false;
+
+    shift = (int) (bit & 7);
+    len = (shift + syncbits + 7) >> 3;
+
+    src = reader->data(bit >> 3, len);
+    if(src == NULL)
+        return false;
+
+    x = 0;
+    for(i=0; i<len; i++)
+        x = (x << 8) | src[i];
+
+    *bits = (x >> ((len << 3) - shift - syncbits)) & mask;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// checks for the sync at bit using the given phase
+bool TSyncCorrelator::match(TBlockReader *reader, qint64 bit, int phase, int *errors)
+{
+    quint64 bits;
+    int e;
+
+    if(reader == NULL || !getBits(reader, bit, &bits))
+        return false;
+
+    e = bitcount(bits ^ pattern[phase & 3]);
+    if(errors)
+        *errors = e;
+
+    return e <= threshold;
+}
+
+//---------------------------------------------------------------------------
+// searches the first sync at or after from_bit, every bit offset and phase
+// is tried, the phase with the fewest errors wins
+bool TSyncCorrelator::search(TBlockReader *reader, qint64 from_bit, qint64 *bit, int *phase, int *errors)
+{
+    const quint8 *buf;
+    quint64 reg, w;
+    qint64 offset, size, start;
+    size_t len, i;
+    int filled, k, p, e, best, best_phase;
+
+    if(reader == NULL || syncbits == 0 || from_bit < 0)
+        return false;
+
+    size = reader->size();
+    offset = from_bit >> 3;
+    reg = 0;
+    filled = 0;
+
+    while(offset < size) {
+        len = size - offset > SYNC_SCAN_CHUNK ? SYNC_SCAN_CHUNK:(size_t) (size - offset);
+
+        buf = reader->data(offset, len);
+        if(buf == NULL)
+            return false;
+
+        for(i=0; i<len; i++) {
+            reg = (reg << 8) | buf[i];
+            if(filled < 64)
+                filled += 8;
+
+            if(filled < syncbits)
+                continue;
+
+            // windows ending k bits before the end of this byte, in stream order
+            for(k=7; k>=0; k--) {
+                if(filled - k < syncbits)
+                    continue;
+
+                start = ((offset + (qint64) i + 1) << 3) - k - syncbits;
+                if(start < from_bit)
+                    continue;
+
+                w = (reg >> k) & mask;
+
+                if(prefilter && prefilter[w >> (syncbits - CORR_PREFILTER_BITS)] > threshold)
+                    continue;
+
+                best = syncbits + 1;
+                best_phase = 0;
+
+                for(p=0; p<CORR_PHASES; p++) {
+                    e = bitcount(w ^ pattern[p]);
+                    if(e < best) {
+                        best = e;
+                        best_phase = p;
+                    }
+                }
+
+                if(best <= threshold) {
+                    *bit = start;
+                    *phase = best_phase;
+                    if(errors)
+                        *errors = best;
+
+                    return true;
+                }
+            }
+        }
+
+        offset += len;
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+// copies len bytes starting at bit into dst, byte aligned and derotated
+bool TSyncCorrelator::extract(TBlockReader *reader, qint64 bit, int phase, quint8 *dst, size_t len)
+{
+    const quint8 *src;
+    size_t i;
+    int shift;
+
+    if(reader == NULL || dst == NULL || bit < 0)
+        return false;
+
+    shift = (int) (bit & 7);
+
+    src = reader->data(bit >> 3, len + (shift ? 1:0));
+    if(src == NULL)
+        return false;
+
+    if(shift == 0)
+        memcpy(dst, src, len);
+    else {
+        for(i=0; i<len; i++)
+            dst[i] = (quint8) ((src[i] << shift) | (src[i + 1] >> (8 - shift)));
+    }
+
+    derotate(dst, len, phase);
+
+    return true;
+}
@@ -0,0 +1,81 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef SYNCCORRELATOR_H
+#define SYNCCORRELATOR_H
+
+#include <QtGlobal>
+#include <stdio.h>
+
+//---------------------------------------------------------------------------
+#define CORR_PHASES         4   // QPSK phase ambiguities, 0, 90, 180 and 270 degrees
+#define CORR_MAX_SIZE       6   // sync bytes, the sync and one byte of slip fit in 64 bits
+#define CORR_MAX_ERRORS     8   // upper limit of the Hamming distance threshold
+#define CORR_DEFAULT_ERRORS 3
+#define CORR_PREFILTER_BITS 16
+
+class TBlockReader;
+
+//---------------------------------------------------------------------------
+// Bit level sync word correlator.
+// Finds the sync at any bit offset under any of the four QPSK phase
+// ambiguities, a candidate is accepted when its Hamming distance to the
+// rotated sync is within the threshold. Bit positions are counted from the
+// first bit (MSB) of the file.
+// Phase p means that the stream holds the sync rotated p * 90 degrees,
+// extract() removes the rotation so the output is byte aligned and upright.
+class TSyncCorrelator
+{
+public:
+    TSyncCorrelator(void);
+    ~TSyncCorrelator(void);
+
+    bool setSync(const quint8 *sync, int size);
+    int  getSyncBits(void) { return syncbits; }
+
+    void setThreshold(int errors);
+    int  getThreshold(void) { return threshold; }
+
+    bool search(TBlockReader *reader, qint64 from_bit, qint64 *bit, int *phase, int *errors);
+    bool match(TBlockReader *reader, qint64 bit, int phase, int *errors);
+    bool extract(TBlockReader *reader, qint64 bit, int phase, quint8 *dst, size_t len);
+
+    static quint64 rotate(quint64 bits, int nbits, int phase);
+    static void    derotate(quint8 *buf, size_t len, int phase);
+
+protected:
+    bool getBits(TBlockReader *reader, qint64 bit, quint64 *bits);
+
+private:
+    quint8  sync[CORR_MAX_SIZE];
+    int     syncsize, syncbits;
+
+    quint64 pattern[CORR_PHASES];
+    quint64 mask;
+
+    // smallest Hamming distance of every 16 bit value to the leading
+    // 16 bits of the rotated syncs, rejects most positions with one lookup
+    quint8  *prefilter;
+
+    int     threshold;
+};
+
+#endif // SYNCCORRELATOR_H
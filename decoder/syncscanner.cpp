@@ -0,0 +1,392 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+#include "syncscanner.h"
+#include "blockreader.h"
+
+//---------------------------------------------------------------------------
+static inline int lowest_bit(unsigned int mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int i = 0;
+
+    while(!(mask & 1)) {
+        mask >>= 1;
+        i++;
+    }
+
+    return i;
+#endif
+}
+
+//---------------------------------------------------------------------------
+TSyncScanner::TSyncScanner(void)
+{
+    matches = NULL;
+    allocated = 0;
+
+    clear();
+}
+
+//---------------------------------------------------------------------------
+TSyncScanner::~TSyncScanner(void)
+{
+    if(matches)
+        free(matches);
+}
+
+//---------------------------------------------------------------------------
+void TSyncScanner::clear(void)
+{
+    npatterns = 0;
+    maxsize = 0;
+
+    clearMatches();
+}
+
+//---------------------------------------------------------------------------
+void TSyncScanner::clearMatches(void)
+{
+    nmatches = 0;
+
+    memset(patterncount, 0, sizeof(patterncount));
+}
+
+//---------------------------------------------------------------------------
+// returns the pattern id or -1 on error, patterns must be at least 2 bytes
+int TSyncScanner::addPattern(const quint8 *sync, int size)
+{
+    if(sync == NULL || size < 2 || size > SYNC_MAX_SIZE || npatterns >= SYNC_MAX_PATTERNS)
+        return -1;
+
+    memcpy(pattern[npatterns], sync, size);
+    patternsize[npatterns] = size;
+    patterncount[npatterns] = 0;
+
+    if(size > maxsize)
+        maxsize = size;
+
+    return npatterns++;
+}
+
+//---------------------------------------------------------------------------
+// adds a 16 bit word sequence, eg HRPT 10 bit sync words
+int TSyncScanner::addPattern16(const quint16 *sync, int words, bool little_endian)
+{
+    quint8 buf[SYNC_MAX_SIZE];
+    int i;
+
+    if(sync == NULL || words < 1 || (words << 1) > SYNC_MAX_SIZE)
+        return -1;
+
+    for(i=0; i<words; i++) {
+        if(little_endian) {
+            buf[i*2]     = sync[i] & 0xff;
+            buf[i*2 + 1] = sync[i] >> 8;
+        }
+        else {
+            buf[i*2]     = sync[i] >> 8;
+            buf[i*2 + 1] = sync[i] & 0xff;
+        }
+    }
+
+    return addPattern(buf, words << 1);
+}
+
+//---------------------------------------------------------------------------
+const char *TSyncScanner::engine(void)
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+//---------------------------------------------------------------------------
+bool TSyncScanner::addMatch(qint64 offset, int pattern_id)
+{
+    TSyncMatch *m;
+    long size;
+
+    if(nmatches >= allocated) {
+        size = allocated ? allocated * 2:4096;
+
+        m = (TSyncMatch *) realloc(matches, size * sizeof(TSyncMatch));
+        if(m == NULL) {
+            qDebug("Failed to allocate sync match buffer %s:%d", __FILE__, __LINE__);
+            return false;
+        }
+
+        matches = m;
+        allocated = size;
+    }
+
+    matches[nmatches].offset = offset;
+    matches[nmatches].pattern = pattern_id;
+    nmatches++;
+
+    patterncount[pattern_id]++;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void TSyncScanner::verify(const quint8 *buf, size_t len, size_t pos, qint64 base)
+{
+    int p;
+
+    for(p=0; p<npatterns; p++) {
+        if(pos + patternsize[p] > len)
+            continue;
+
+        if(buf[pos] == pattern[p][0] && memcmp(buf + pos, pattern[p], patternsize[p]) == 0)
+            addMatch(base + pos, p);
+    }
+}
+
+//---------------------------------------------------------------------------
+// checks every start position 0 ... nstarts - 1, buf holds len bytes
+long TSyncScanner::scanBlock(const quint8 *buf, size_t len, size_t nstarts, qint64 base)
+{
+    long found = nmatches;
+    size_t i = 0;
+    int p;
+
+    if(npatterns == 0)
+        return 0;
+
+#if defined(__AVX2__)
+    __m256i a32[SYNC_MAX_PATTERNS], b32[SYNC_MAX_PATTERNS];
+    __m256i v0, v1, hit;
+    unsigned int mask;
+
+    for(p=0; p<npatterns; p++) {
+        a32[p] = _mm256_set1_epi8((char) pattern[p][0]);
+        b32[p] = _mm256_set1_epi8((char) pattern[p][1]);
+    }
+
+    while(i + 32 <= nstarts && i + 33 <= len) {
+        v0  = _mm256_loadu_si256((const __m256i *) (buf + i));
+        v1  = _mm256_loadu_si256((const __m256i *) (buf + i + 1));
+        hit = _mm256_setzero_si256();
+
+        for(p=0; p<npatterns; p++)
+            hit = _mm256_or_si256(hit, _mm256_and_si256(_mm256_cmpeq_epi8(v0, a32[p]),
+                                                        _mm256_cmpeq_epi8(v1, b32[p])));
+
+        mask = (unsigned int) _mm256_movemask_epi8(hit);
+        while(mask) {
+            verify(buf, len, i + lowest_bit(mask), base);
+            mask &= mask - 1;
+        }
+
+        i += 32;
+    }
+#endif
+
+#if defined(__SSE2__)
+    __m128i a16[SYNC_MAX_PATTERNS], b16[SYNC_MAX_PATTERNS];
+    __m128i w0, w1, whit;
+    unsigned int wmask;
+
+    for(p=0; p<npatterns; p++) {
+        a16[p] = _mm_set1_epi8((char) pattern[p][0]);
+        b16[p] = _mm_set1_epi8((char) pattern[p][1]);
+    }
+
+    while(i + 16 <= nstarts && i + 17 <= len) {
+        w0   = _mm_loadu_si128((const __m128i *) (buf + i));
+        w1   = _mm_loadu_si128((const __m128i *) (buf + i + 1));
+        whit = _mm_setzero_si128();
+
+        for(p=0; p<npatterns; p++)
+            whit = _mm_or_si128(whit, _mm_and_si128(_mm_cmpeq_epi8(w0, a16[p]),
+                                                    _mm_cmpeq_epi8(w1, b16[p])));
+
+        wmask = (unsigned int) _mm_movemask_epi8(whit);
+        while(wmask) {
+            verify(buf, len, i + lowest_bit(wmask), base);
+            wmask &= wmask - 1;
+        }
+
+        i += 16;
+    }
+#endif
+
+    // scalar tail, or the whole block without SIMD
+    for(; i<nstarts && i<len; i++) {
+        for(p=0; p<npatterns; p++) {
+            if(buf[i] == pattern[p][0]) {
+                verify(buf, len, i, base);
+                break;
+            }
+        }
+    }
+
+    return nmatches - found;
+}
+
+//---------------------------------------------------------------------------
+// scans a memory buffer, base is the file offset of buf[0]
+long TSyncScanner::scan(const quint8 *buf, size_t len, qint64 base)
+{
+    if(buf == NULL)
+        return 0;
+
+    return scanBlock(buf, len, len, base);
+}
+
+//---------------------------------------------------------------------------
+// scans the whole file, the reader cursor is not moved
+long TSyncScanner::scan(TBlockReader *reader)
+{
+    const quint8 *buf;
+    qint64 offset, size;
+    size_t len, overlap;
+    long found = 0;
+
+    if(reader == NULL || !reader->isOpen() || npatterns == 0)
+        return 0;
+
+    size = reader->size();
+
+    if(reader->isMapped()) {
+        buf = reader->data(0, (size_t) size);
+
+        return buf ? scanBlock(buf, (size_t) size, (size_t) size, 0):0;
+    }
+
+    // chunks overlap so that patterns crossing a chunk border are found once
+    overlap = maxsize - 1;
+    offset = 0;
+
+    while(offset < size) {
+        len = size - offset > SYNC_SCAN_CHUNK ? SYNC_SCAN_CHUNK:(size_t) (size - offset);
+
+        buf = reader->data(offset, len);
+        if(buf == NULL)
+            break;
+
+        if(offset + (qint64) len >= size) {
+            found += scanBlock(buf, len, len, offset);
+            break;
+        }
+
+        found += scanBlock(buf, len, len - overlap, offset);
+        offset += len - overlap;
+    }
+
+    return found;
+}
+
+//---------------------------------------------------------------------------
+long TSyncScanner::count(int pattern_id)
+{
+    if(pattern_id < 0 || pattern_id >= npatterns)
+        return 0;
+
+    return patterncount[pattern_id];
+}
+
+//---------------------------------------------------------------------------
+// the offset parity (0 even, 1 odd) most matches of pattern have, that of
+// the first match on a tie, -1 if there are none. The frames of a 16 bit
+// recording are word aligned, a false sync at the other parity before the
+// first frame must not decide it.
+int TSyncScanner::parity(int pattern_id)
+{
+    long i, hits[2];
+    int  first;
+
+    hits[0] = hits[1] = 0;
+    first = -1;
+
+    for(i=0; i<nmatches; i++) {
+        if(matches[i].pattern != pattern_id)
+            continue;
+
+        if(first < 0)
+            first = (int) (matches[i].offset & 1);
+
+        hits[matches[i].offset & 1]++;
+    }
+
+    if(first < 0 || hits[0] == hits[1])
+        return first;
+
+    return hits[1] > hits[0] ? 1:0;
+}
+
+//---------------------------------------------------------------------------
+// returns the index of the first match of pattern at or after offset,
+// searching from match index from, -1 if none
+long TSyncScanner::nextMatch(int pattern_id, qint64 offset, long from)
+{
+    long i;
+
+    for(i=from < 0 ? 0:from; i<nmatches; i++) {
+        if(matches[i].pattern == pattern_id && matches[i].offset >= offset)
+            return i;
+    }
+
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+// single pattern search, returns the offset in buf or -1
+qint64 TSyncScanner::find(const quint8 *buf, size_t len, const quint8 *sync, int size)
+{
+    const quint8 *p, *end;
+
+    if(buf == NULL || sync == NULL || size < 1 || len < (size_t) size)
+        return -1;
+
+    p = buf;
+    end = buf + len - size + 1;
+
+    // memchr is vectorized by the C library
+    while(p < end) {
+        p = (const quint8 *) memchr(p, sync[0], end - p);
+        if(p == NULL)
+            break;
+
+        if(memcmp(p, sync, size) == 0)
+            return p - buf;
+
+        p++;
+    }
+
+    return -1;
+}
@@ -0,0 +1,89 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef SYNCSCANNER_H
+#define SYNCSCANNER_H
+
+#include <QtGlobal>
+#include <stdio.h>
+
+//---------------------------------------------------------------------------
+#define SYNC_MAX_PATTERNS   8
+#define SYNC_MAX_SIZE       16   // bytes
+
+#define SYNC_SCAN_CHUNK     (1 << 20) // bytes per pass when the file is not mapped
+
+//---------------------------------------------------------------------------
+typedef struct TSyncMatch_t
+{
+    qint64 offset;  // file offset of the first sync byte
+    int    pattern; // pattern id returned by addPattern
+} TSyncMatch;
+
+class TBlockReader;
+
+//---------------------------------------------------------------------------
+// Multi pattern sync word scanner.
+// All registered patterns are located in one pass over the data, candidate
+// positions are found 32 (AVX2) or 16 (SSE2) bytes at a time by comparing the
+// two leading bytes of every pattern, then verified with memcmp.
+// Matches are stored in file order.
+class TSyncScanner
+{
+public:
+    TSyncScanner(void);
+    ~TSyncScanner(void);
+
+    void clear(void);
+    void clearMatches(void);
+
+    int  addPattern(const quint8 *sync, int size);
+    int  addPattern16(const quint16 *sync, int words, bool little_endian);
+    int  getPatterns(void) { return npatterns; }
+
+    long scan(const quint8 *buf, size_t len, qint64 base = 0);
+    long scan(TBlockReader *reader);
+
+    long        getMatches(void) { return nmatches; }
+    TSyncMatch *getMatch(long index) { return index < 0 || index >= nmatches ? NULL:(matches + index); }
+    long        count(int pattern);
+    int         parity(int pattern);
+    long        nextMatch(int pattern, qint64 offset, long from = 0);
+
+    static const char *engine(void);
+    static qint64 find(const quint8 *buf, size_t len, const quint8 *sync, int size);
+
+protected:
+    long scanBlock(const quint8 *buf, size_t len, size_t nstarts, qint64 base);
+    void verify(const quint8 *buf, size_t len, size_t pos, qint64 base);
+    bool addMatch(qint64 offset, int pattern);
+
+private:
+    quint8 pattern[SYNC_MAX_PATTERNS][SYNC_MAX_SIZE];
+    int    patternsize[SYNC_MAX_PATTERNS];
+    long   patterncount[SYNC_MAX_PATTERNS];
+    int    npatterns, maxsize;
+
+    TSyncMatch *matches;
+    long       nmatches, allocated;
+};
+
+#endif // SYNCSCANNER_H
@@ -0,0 +1,139 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSSE3__)
+#  include <tmmintrin.h>
+#endif
+
+#include "unpack10.h"
+
+//---------------------------------------------------------------------------
+// the sample starting at bit, bit & 7 is even so it spans two bytes
+static inline quint16 sample_at(const quint8 *src, qint64 bit)
+{
+    const quint8 *p = src + (bit >> 3);
+
+    return (((p[0] << 8) | p[1]) >> (6 - (bit & 7))) & 0x03ff;
+}
+
+#if defined(__SSSE3__)
+//---------------------------------------------------------------------------
+// Two 5 byte groups in the low 10 bytes of a register. Each word gets the
+// big endian pair holding its sample, sample k of a group sits 6, 4, 2, 0
+// bits from the right. The multiply shifts it up to the top 10 bits, that
+// drops the bits of the previous sample, and the shift moves it down again.
+#define UNPACK10_SHUFFLE    1, 0, 2, 1, 3, 2, 4, 3, 6, 5, 7, 6, 8, 7, 9, 8
+#define UNPACK10_SHIFTS     1, 4, 16, 64, 1, 4, 16, 64
+#endif
+
+//---------------------------------------------------------------------------
+int TUnpack10::unpack(quint16 *dst, const quint8 *src, size_t len, int samples, int bit_offset)
+{
+    const quint8 *p;
+    qint64 bit, available;
+    size_t left;
+    int    n;
+
+    if(dst == NULL || src == NULL || samples <= 0 || (bit_offset & ~6))
+        return 0;
+
+    available = (((qint64) len << 3) - bit_offset) / 10;
+    if(available <= 0)
+        return 0;
+    if(samples > available)
+        samples = (int) available;
+
+    n = 0;
+    bit = bit_offset;
+
+    // up to the first byte that starts a sample
+    while(n < samples && (bit & 7)) {
+        dst[n++] = sample_at(src, bit);
+        bit += 10;
+    }
+
+    p = src + (bit >> 3);
+    left = len - (size_t) (bit >> 3);
+
+#if defined(__AVX2__)
+    {
+        const __m256i shuffle = _mm256_setr_epi8(UNPACK10_SHUFFLE, UNPACK10_SHUFFLE);
+        const __m256i shifts  = _mm256_setr_epi16(UNPACK10_SHIFTS, UNPACK10_SHIFTS);
+        __m256i v;
+
+        // 20 bytes, the load of the upper lane reads 6 bytes ahead
+        while(samples - n >= 16 && left >= 26) {
+            v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) p)),
+                                        _mm_loadu_si128((const __m128i *) (p + 10)), 1);
+            v = _mm256_shuffle_epi8(v, shuffle);
+            v = _mm256_srli_epi16(_mm256_mullo_epi16(v, shifts), 6);
+
+            _mm256_storeu_si256((__m256i *) (dst + n), v);
+
+            n += 16;
+            p += 20;
+            left -= 20;
+        }
+    }
+#endif
+
+#if defined(__SSSE3__)
+    {
+        const __m128i shuffle = _mm_setr_epi8(UNPACK10_SHUFFLE);
+        const __m128i shifts  = _mm_setr_epi16(UNPACK10_SHIFTS);
+        __m128i v;
+
+        // 10 bytes, the load reads 6 bytes ahead
+        while(samples - n >= 8 && left >= 16) {
+            v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) p), shuffle);
+            v = _mm_srli_epi16(_mm_mullo_epi16(v, shifts), 6);
+
+            _mm_storeu_si128((__m128i *) (dst + n), v);
+
+            n += 8;
+            p += 10;
+            left -= 10;
+        }
+    }
+#endif
+
+    while(samples - n >= 4 && left >= 5) {
+        dst[n]     = (quint16) (( p[0]         << 2) | (p[1] >> 6));
+        dst[n + 1] = (quint16) (((p[1] & 0x3f) << 4) | (p[2] >> 4));
+        dst[n + 2] = (quint16) (((p[2] & 0x0f) << 6) | (p[3] >> 2));
+        dst[n + 3] = (quint16) (((p[3] & 0x03) << 8) |  p[4]);
+
+        n += 4;
+        p += 5;
+        left -= 5;
+    }
+
+    bit = (qint64) (p - src) << 3;
+    while(n < samples) {
+        dst[n++] = sample_at(src, bit);
+        bit += 10;
+    }
+
+    return n;
+}
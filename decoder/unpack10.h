@@ -0,0 +1,46 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef UNPACK10_H
+#define UNPACK10_H
+
+#include <QtGlobal>
+#include <stdlib.h>
+
+//---------------------------------------------------------------------------
+// bytes of samples 10 bit words starting bit_offset bits into the first byte
+#define UNPACK10_BYTES(samples, bit_offset)  ((((samples) * 10) + (bit_offset) + 7) >> 3)
+
+//---------------------------------------------------------------------------
+// Unpacks a stream of MSB first 10 bit samples to 16 bit words.
+// Every 5 bytes hold 4 samples, the byte aligned groups are unpacked by
+// SSSE3 or AVX2 shuffles, two or four groups per step, the samples before
+// the first aligned group and the tail one at a time.
+class TUnpack10
+{
+public:
+    // bit_offset is 0, 2, 4 or 6, returns the unpacked samples,
+    // fewer than samples when src holds less
+    static int unpack(quint16 *dst, const quint8 *src, size_t len, int samples, int bit_offset = 0);
+};
+
+#endif // UNPACK10_H
@@ -0,0 +1,327 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+#include "vegetationlut.h"
+#include "colorscale.h"
+#include "imagestore.h"
+#include "ndvi.h"
+#include "evi.h"
+
+//---------------------------------------------------------------------------
+#define VI_TYPE_NONE        0
+#define VI_TYPE_NDVI        1
+#define VI_TYPE_EVI2        2 // EVI without the blue term, a table
+#define VI_TYPE_EVI3        3 // computed
+
+//---------------------------------------------------------------------------
+TVegetationLUT::TVegetationLUT(void)
+{
+    table = NULL;
+    scale = NULL;
+
+    setKey(VI_TYPE_NONE, -1, 1, QString());
+    g = c1 = c2 = l = 0;
+    soil = false;
+}
+
+//---------------------------------------------------------------------------
+TVegetationLUT::~TVegetationLUT(void)
+{
+    if(table)
+        free(table);
+}
+
+//---------------------------------------------------------------------------
+void TVegetationLUT::setKey(int type_, double vmin, double vmax, const QString &lut)
+{
+    type = type_;
+    min_value = vmin;
+    max_value = vmax;
+    lutfile = lut;
+}
+
+//---------------------------------------------------------------------------
+// the table is what the per pixel lutIndex or toColor_16 of the index was
+bool TVegetationLUT::build(TNDVI *vi)
+{
+    double value;
+    int nir, vis;
+
+    if(table == NULL)
+        table = (quint16 *) malloc(VI_LUT_SIZE * sizeof(quint16));
+
+    if(table == NULL) {
+        qDebug("Failed to allocate NDVI table %s:%d", __FILE__, __LINE__);
+        return false;
+    }
+
+    setKey(VI_TYPE_NDVI, vi->minValue(), vi->maxValue(), vi->lut());
+    scale = TColorScale::get(lutfile);
+
+    for(nir=0; nir<=STORE_PIXEL_MASK; nir++)
+        for(vis=0; vis<=STORE_PIXEL_MASK; vis++) {
+            value = vi->ndvi(nir, vis);
+
+            if(!vi->isValid(value))
+                table[(nir << VI_SAMPLE_BITS) | vis] = VI_INVALID;
+            else
+                table[(nir << VI_SAMPLE_BITS) | vis] = scale ? vi->lutIndex(value, scale->size()):vi->toColor_16(value);
+        }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool TVegetationLUT::build(TEVI *evi)
+{
+    double value;
+    int nir, red;
+
+    setKey(evi->coef.c2 == 0 ? VI_TYPE_EVI2:VI_TYPE_EVI3, evi->minValue(), evi->maxValue(), evi->lut());
+    scale = TColorScale::get(lutfile);
+
+    g = evi->coef.g;
+    c1 = evi->coef.c1;
+    c2 = evi->coef.c2;
+    l = evi->coef.l;
+    soil = evi->soilAgorithm();
+
+    if(type == VI_TYPE_EVI3) {
+        if(table)
+            free(table);
+        table = NULL;
+
+        return true;
+    }
+
+    if(table == NULL)
+        table = (quint16 *) malloc(VI_LUT_SIZE * sizeof(quint16));
+
+    if(table == NULL) {
+        qDebug("Failed to allocate EVI table %s:%d", __FILE__, __LINE__);
+        return false;
+    }
+
+    for(nir=0; nir<=STORE_PIXEL_MASK; nir++)
+        for(red=0; red<=STORE_PIXEL_MASK; red++) {
+            value = evi->evi(nir, red, 0);
+
+            if(!evi->isValid(value))
+                table[(nir << VI_SAMPLE_BITS) | red] = VI_INVALID;
+            else
+                table[(nir << VI_SAMPLE_BITS) | red] = scale ? evi->lutIndex(value, scale->size()):evi->toColor_16(value);
+        }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool TVegetationLUT::matches(TNDVI *vi) const
+{
+    return type == VI_TYPE_NDVI &&
+           min_value == vi->minValue() && max_value == vi->maxValue() &&
+           lutfile == vi->lut();
+}
+
+//---------------------------------------------------------------------------
+bool TVegetationLUT::matches(TEVI *evi) const
+{
+    if(type != VI_TYPE_EVI2 && type != VI_TYPE_EVI3)
+        return false;
+
+    return (evi->coef.c2 == 0) == (type == VI_TYPE_EVI2) &&
+           min_value == evi->minValue() && max_value == evi->maxValue() &&
+           g == evi->coef.g && c1 == evi->coef.c1 && c2 == evi->coef.c2 && l == evi->coef.l &&
+           soil == evi->soilAgorithm() && lutfile == evi->lut();
+}
+
+//---------------------------------------------------------------------------
+// blue is only read by an EVI with the blue term
+void TVegetationLUT::index(quint16 *dst, const quint16 *nir, const quint16 *vis, const quint16 *blue, int n) const
+{
+    float fn, fr, fb, den, value, k, p;
+    int i, pos;
+
+    if(table) {
+        for(i=0; i<n; i++)
+            dst[i] = table[((nir[i] & STORE_PIXEL_MASK) << VI_SAMPLE_BITS) | (vis[i] & STORE_PIXEL_MASK)];
+
+        return;
+    }
+
+    if(type != VI_TYPE_EVI3 || max_value <= min_value) {
+        for(i=0; i<n; i++)
+            dst[i] = VI_INVALID;
+
+        return;
+    }
+
+    // palette positions per index unit
+    k = scale ? (scale->size() - 1) / (max_value - min_value):1023.0f;
+    i = 0;
+
+#if defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    __m128i mask10 = _mm_set1_epi32(STORE_PIXEL_MASK);
+    __m128i invalid = _mm_set1_epi32(-1);
+    __m128 vg = _mm_set1_ps(g), vc1 = _mm_set1_ps(c1), vc2 = _mm_set1_ps(c2), vl = _mm_set1_ps(l);
+    __m128 vmin = _mm_set1_ps(min_value), vmax = _mm_set1_ps(max_value), vk = _mm_set1_ps(k);
+    __m128 sign = _mm_set1_ps(-0.0f), fzero = _mm_setzero_ps();
+    __m128 vn, vr, vb, vden, vvalue, valid;
+    __m128i ipos;
+
+    for(; i + 4 <= n; i += 4) {
+        vn = _mm_cvtepi32_ps(_mm_and_si128(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (nir + i)), zero), mask10));
+        vr = _mm_cvtepi32_ps(_mm_and_si128(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (vis + i)), zero), mask10));
+        vb = _mm_cvtepi32_ps(_mm_and_si128(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (blue + i)), zero), mask10));
+
+        vden = _mm_add_ps(_mm_sub_ps(_mm_add_ps(vn, _mm_mul_ps(vc1, vr)), _mm_mul_ps(vc2, vb)), vl);
+        vvalue = _mm_div_ps(_mm_mul_ps(vg, _mm_sub_ps(vn, vr)), vden);
+        if(soil)
+            vvalue = _mm_add_ps(vvalue, vl);
+
+        // NaN and inf of a zero divisor compare false
+        valid = _mm_and_ps(_mm_cmpneq_ps(vden, fzero),
+                           _mm_and_ps(_mm_cmpge_ps(vvalue, vmin), _mm_cmple_ps(vvalue, vmax)));
+
+        if(scale)
+            ipos = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(vvalue, vmin), vk));
+        else
+            ipos = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(_mm_andnot_ps(sign, vvalue), vk)), mask10);
+
+        ipos = _mm_or_si128(_mm_and_si128(_mm_castps_si128(valid), ipos),
+                            _mm_andnot_si128(_mm_castps_si128(valid), invalid));
+
+        _mm_storel_epi64((__m128i *) (dst + i), _mm_packs_epi32(ipos, ipos));
+    }
+#endif
+
+    for(; i<n; i++) {
+        fn = nir[i] & STORE_PIXEL_MASK;
+        fr = vis[i] & STORE_PIXEL_MASK;
+        fb = blue[i] & STORE_PIXEL_MASK;
+
+        den = fn + (float) c1 * fr - (float) c2 * fb + (float) l;
+        value = (float) g * (fn - fr) / den;
+        if(soil)
+            value += (float) l;
+
+        if(den == 0 || !(value >= (float) min_value && value <= (float) max_value)) {
+            dst[i] = VI_INVALID;
+            continue;
+        }
+
+        p = scale ? (value - (float) min_value) * k:fabsf(value) * k;
+        pos = (int) rintf(p);
+
+        dst[i] = scale ? (quint16) pos:(quint16) (pos & STORE_PIXEL_MASK);
+    }
+}
+
+//---------------------------------------------------------------------------
+TVegetationCache::TVegetationCache(void)
+{
+}
+
+//---------------------------------------------------------------------------
+TVegetationCache::~TVegetationCache(void)
+{
+    clear();
+}
+
+//---------------------------------------------------------------------------
+// not while a thread composes an image
+void TVegetationCache::clear(void)
+{
+    lock.lock();
+
+    while(!luts.isEmpty())
+        delete luts.takeLast();
+
+    lock.unlock();
+}
+
+//---------------------------------------------------------------------------
+// NULL if out of memory
+const TVegetationLUT *TVegetationCache::get(TNDVI *vi)
+{
+    TVegetationLUT *lut;
+    int i;
+
+    lock.lock();
+
+    for(i=0; i<luts.count(); i++)
+        if(luts.at(i)->matches(vi)) {
+            lut = luts.at(i);
+            lock.unlock();
+
+            return lut;
+        }
+
+    lut = new TVegetationLUT;
+    if(lut->build(vi))
+        luts.append(lut);
+    else {
+        delete lut;
+        lut = NULL;
+    }
+
+    lock.unlock();
+
+    return lut;
+}
+
+//---------------------------------------------------------------------------
+const TVegetationLUT *TVegetationCache::get(TEVI *evi)
+{
+    TVegetationLUT *lut;
+    int i;
+
+    lock.lock();
+
+    for(i=0; i<luts.count(); i++)
+        if(luts.at(i)->matches(evi)) {
+            lut = luts.at(i);
+            lock.unlock();
+
+            return lut;
+        }
+
+    lut = new TVegetationLUT;
+    if(lut->build(evi))
+        luts.append(lut);
+    else {
+        delete lut;
+        lut = NULL;
+    }
+
+    lock.unlock();
+
+    return lut;
+}
@@ -0,0 +1,96 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef VEGETATIONLUT_H
+#define VEGETATIONLUT_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QMutex>
+#include <QList>
+
+//---------------------------------------------------------------------------
+#define VI_SAMPLE_BITS      10
+#define VI_LUT_SIZE         (1 << (VI_SAMPLE_BITS * 2)) // (NIR, VIS) pairs
+#define VI_INVALID          0xffff // outside the min ... max of the index
+
+class TNDVI;
+class TEVI;
+class TColorScale;
+
+//---------------------------------------------------------------------------
+// NDVI or EVI of a configuration as palette positions.
+// An index of two channels (NDVI, EVI without the blue term) is a table of
+// the VI_LUT_SIZE (NIR, VIS) sample pairs built once, a line is a gather
+// from it. A three channel EVI would need 1 G entries, it is computed
+// with float math, 4 pixels at a time where there is SSE2.
+// Without a colour scale the value is the 10 bit |index| of toColor_16,
+// composed as the green of the base image like it always was.
+class TVegetationLUT
+{
+public:
+    TVegetationLUT(void);
+    ~TVegetationLUT(void);
+
+    bool build(TNDVI *vi);
+    bool build(TEVI *evi);
+    bool matches(TNDVI *vi) const;
+    bool matches(TEVI *evi) const;
+
+    const TColorScale *getScale(void) const { return scale; }
+
+    // palette positions of n samples, VI_INVALID where there is no index
+    void index(quint16 *dst, const quint16 *nir, const quint16 *vis, const quint16 *blue, int n) const;
+
+private:
+    void setKey(int type_, double vmin, double vmax, const QString &lut);
+
+    quint16 *table;
+    const TColorScale *scale;
+
+    // the configuration the table is built for
+    int     type;
+    double  min_value, max_value;
+    double  g, c1, c2, l;
+    bool    soil;
+    QString lutfile;
+};
+
+//---------------------------------------------------------------------------
+// The tables in use by a block, built on the first compose of a
+// configuration. Render threads share them, they are only freed by clear.
+class TVegetationCache
+{
+public:
+    TVegetationCache(void);
+    ~TVegetationCache(void);
+
+    const TVegetationLUT *get(TNDVI *vi);
+    const TVegetationLUT *get(TEVI *evi);
+    void clear(void);
+
+private:
+    QMutex lock;
+    QList<TVegetationLUT *> luts;
+};
+
+#endif // VEGETATIONLUT_H
@@ -0,0 +1,535 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <QtGui>
+#include <QMutex>
+
+#include "imageview.h"
+#include "block.h"
+#include "trace.h"
+
+//---------------------------------------------------------------------------
+static quint64 tileKey(int level, int tx, int ty)
+{
+    return ((quint64) level << 48) | ((quint64) ty << 24) | (quint64) tx;
+}
+
+//---------------------------------------------------------------------------
+TImageView::TImageView(QWidget *parent) :
+    QAbstractScrollArea(parent)
+{
+    block = NULL;
+    image = NULL;
+    mutex = NULL;
+
+    newest = oldest = NULL;
+    listed = 0;
+    cacheSize = TILE_CACHE;
+    imageWidth = imageHeight = 0;
+    level = 0;
+
+    viewport()->setBackgroundRole(QPalette::Dark);
+    viewport()->setAutoFillBackground(true);
+    setFocusPolicy(Qt::StrongFocus);
+}
+
+//---------------------------------------------------------------------------
+TImageView::~TImageView(void)
+{
+    invalidate();
+}
+
+//---------------------------------------------------------------------------
+// tiles are composed from the image store of block
+void TImageView::setBlock(TBlock *block_)
+{
+    block = block_;
+    image = NULL;
+
+    updateSize();
+}
+
+//---------------------------------------------------------------------------
+// tiles are copied from image, it must live as long as it is shown
+void TImageView::setImage(const QImage *image_)
+{
+    block = NULL;
+    image = image_;
+
+    updateSize();
+}
+
+//---------------------------------------------------------------------------
+// held while a tile is composed from the block, NULL if there is no
+// live decoder
+void TImageView::setMutex(QMutex *mutex_)
+{
+    mutex = mutex_;
+}
+
+//---------------------------------------------------------------------------
+void TImageView::clear(void)
+{
+    block = NULL;
+    image = NULL;
+
+    updateSize();
+}
+
+//---------------------------------------------------------------------------
+// the block has grown from line first, the lines of a northbound pass are
+// drawn bottom up so all of it moves down
+void TImageView::grow(int first)
+{
+    if(block == NULL)
+        return;
+
+    if(mutex)
+        mutex->lock();
+
+    imageWidth = block->getWidth();
+    imageHeight = block->getHeight();
+
+    if(block->isNorthBound())
+        first = 0;
+
+    if(mutex)
+        mutex->unlock();
+
+    invalidate(first);
+    updateScrollBars();
+
+    viewport()->update();
+}
+
+//---------------------------------------------------------------------------
+// drops the tiles below level 0 line first (all of them by default), they
+// are composed again when drawn. The image may have grown, the pinned
+// tiles of the levels no longer coarse are put in the LRU list.
+void TImageView::invalidate(int first)
+{
+    QHash<quint64, TTile *>::iterator it;
+    TTile *t;
+    int pinned = pinnedLevel();
+
+    it = tiles.begin();
+    while(it != tiles.end()) {
+        t = it.value();
+
+        if((((qint64) t->ty + 1) * TILE_SIZE << t->level) > first) {
+            unlink(t);
+            delete t;
+            it = tiles.erase(it);
+        }
+        else {
+            if(t->pinned && t->level < pinned) {
+                t->pinned = false;
+                link(t);
+            }
+
+            ++it;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+void TImageView::updateSize(void)
+{
+    invalidate();
+
+    imageWidth = imageHeight = 0;
+
+    if(block) {
+        if(mutex)
+            mutex->lock();
+
+        imageWidth = block->getWidth();
+        imageHeight = block->getHeight();
+
+        if(mutex)
+            mutex->unlock();
+    }
+    else if(image) {
+        imageWidth = image->width();
+        imageHeight = image->height();
+    }
+
+    if(level > maxLevel())
+        level = maxLevel();
+
+    updateScrollBars();
+
+    viewport()->update();
+}
+
+//---------------------------------------------------------------------------
+void TImageView::updateScrollBars(void)
+{
+    QSize vs = viewport()->size();
+    int w, h;
+
+    w = levelWidth(level);
+    h = levelHeight(level);
+
+    horizontalScrollBar()->setPageStep(vs.width());
+    horizontalScrollBar()->setSingleStep(TILE_SIZE / 8);
+    horizontalScrollBar()->setRange(0, w > vs.width() ? w - vs.width():0);
+
+    verticalScrollBar()->setPageStep(vs.height());
+    verticalScrollBar()->setSingleStep(TILE_SIZE / 8);
+    verticalScrollBar()->setRange(0, h > vs.height() ? h - vs.height():0);
+}
+
+//---------------------------------------------------------------------------
+int TImageView::levelWidth(int level_) const
+{
+    return imageWidth > 0 ? (imageWidth + (1 << level_) - 1) >> level_:0;
+}
+
+//---------------------------------------------------------------------------
+int TImageView::levelHeight(int level_) const
+{
+    return imageHeight > 0 ? (imageHeight + (1 << level_) - 1) >> level_:0;
+}
+
+//---------------------------------------------------------------------------
+// the first level that fits in one tile
+int TImageView::maxLevel(void) const
+{
+    int l = 0;
+
+    while(l < VIEW_MAX_LEVEL && (levelWidth(l) > TILE_SIZE || levelHeight(l) > TILE_SIZE))
+        l++;
+
+    return l;
+}
+
+//---------------------------------------------------------------------------
+// the lowest level of at most TILE_PINNED tiles, the tiles of it and the
+// levels above are kept
+int TImageView::pinnedLevel(void) const
+{
+    int l = 0, m = maxLevel();
+
+    while(l < m && ((levelWidth(l) + TILE_SIZE - 1) / TILE_SIZE) *
+                   ((levelHeight(l) + TILE_SIZE - 1) / TILE_SIZE) > TILE_PINNED)
+        l++;
+
+    return l;
+}
+
+//---------------------------------------------------------------------------
+// zooms out by a factor of 2 per level, the centre of the view stays put
+void TImageView::setLevel(int level_)
+{
+    QSize vs = viewport()->size();
+    qint64 cx, cy;
+
+    level_ = level_ < 0 ? 0:(level_ > maxLevel() ? maxLevel():level_);
+    if(level_ == level)
+        return;
+
+    cx = (qint64) (horizontalScrollBar()->value() + vs.width() / 2) << level;
+    cy = (qint64) (verticalScrollBar()->value() + vs.height() / 2) << level;
+
+    level = level_;
+    updateScrollBars();
+
+    horizontalScrollBar()->setValue((int) (cx >> level) - vs.width() / 2);
+    verticalScrollBar()->setValue((int) (cy >> level) - vs.height() / 2);
+
+    viewport()->update();
+}
+
+//---------------------------------------------------------------------------
+void TImageView::zoomIn(void)
+{
+    setLevel(level - 1);
+}
+
+//---------------------------------------------------------------------------
+void TImageView::zoomOut(void)
+{
+    setLevel(level + 1);
+}
+
+//---------------------------------------------------------------------------
+// the tiles of the level in sight
+void TImageView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    QRect r;
+    TTile *t;
+    int x0, y0, tx, ty;
+
+    if(!hasImage())
+        return;
+
+    x0 = horizontalScrollBar()->value();
+    y0 = verticalScrollBar()->value();
+
+    r = event->rect().translated(x0, y0) & QRect(0, 0, levelWidth(level), levelHeight(level));
+    if(r.isEmpty())
+        return;
+
+    for(ty=r.top() / TILE_SIZE; ty<=r.bottom() / TILE_SIZE; ty++)
+        for(tx=r.left() / TILE_SIZE; tx<=r.right() / TILE_SIZE; tx++) {
+            t = tile(level, tx, ty);
+            if(t == NULL)
+                continue;
+
+            if(t->pixmap.isNull()) {
+                TRACE_SCOPE("QPixmap::fromImage");
+                t->pixmap = QPixmap::fromImage(t->image);
+            }
+
+            painter.drawPixmap(tx * TILE_SIZE - x0, ty * TILE_SIZE - y0, t->pixmap);
+        }
+}
+
+//---------------------------------------------------------------------------
+// the cache holds the tiles in sight twice over, the tiles of the level
+// below are used to build them
+void TImageView::resizeEvent(QResizeEvent *event)
+{
+    QSize vs = viewport()->size();
+
+    cacheSize = (vs.width() / TILE_SIZE + 2) * (vs.height() / TILE_SIZE + 2) * 2;
+    cacheSize = cacheSize < TILE_CACHE ? TILE_CACHE:cacheSize;
+
+    QAbstractScrollArea::resizeEvent(event);
+
+    updateScrollBars();
+}
+
+//---------------------------------------------------------------------------
+// Ctrl + wheel zooms
+void TImageView::wheelEvent(QWheelEvent *event)
+{
+    if(event->modifiers() & Qt::ControlModifier) {
+        if(event->delta() > 0)
+            zoomIn();
+        else if(event->delta() < 0)
+            zoomOut();
+
+        event->accept();
+    }
+    else
+        QAbstractScrollArea::wheelEvent(event);
+}
+
+//---------------------------------------------------------------------------
+void TImageView::keyPressEvent(QKeyEvent *event)
+{
+    switch(event->key()) {
+        case Qt::Key_Plus:
+            zoomIn();
+        break;
+
+        case Qt::Key_Minus:
+            zoomOut();
+        break;
+
+        default:
+            QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+//---------------------------------------------------------------------------
+// the cached tile, built if it is not, NULL if it is outside of the image.
+// A tile may be dropped by the next call, use it before.
+TTile *TImageView::tile(int level_, int tx, int ty)
+{
+    TTile *t, *child;
+    QImage src;
+    quint64 key;
+    int w, h, i, j;
+
+    key = tileKey(level_, tx, ty);
+
+    t = tiles.value(key, NULL);
+    if(t) {
+        if(!t->pinned) {
+            unlink(t);
+            link(t);
+        }
+
+        return t;
+    }
+
+    w = levelWidth(level_) - tx * TILE_SIZE;
+    h = levelHeight(level_) - ty * TILE_SIZE;
+
+    if(w <= 0 || h <= 0)
+        return NULL;
+
+    w = w > TILE_SIZE ? TILE_SIZE:w;
+    h = h > TILE_SIZE ? TILE_SIZE:h;
+
+    t = new TTile;
+    t->level = level_;
+    t->tx = tx;
+    t->ty = ty;
+    t->pinned = level_ >= pinnedLevel();
+    t->prev = t->next = NULL;
+    t->image = QImage(w, h, QImage::Format_RGB888);
+
+    if(t->image.isNull()) {
+        qDebug("Failed to allocate tile %dx%d %s:%d", w, h, __FILE__, __LINE__);
+        delete t;
+
+        return NULL;
+    }
+
+    t->image.fill(0);
+
+    if(level_ == 0)
+        compose(&t->image, tx * TILE_SIZE, ty * TILE_SIZE);
+    else
+        for(j=0; j<2; j++)
+            for(i=0; i<2; i++) {
+                child = tile(level_ - 1, tx * 2 + i, ty * 2 + j);
+                if(child == NULL)
+                    continue;
+
+                src = child->image;
+                downsample(&t->image, &src, i * TILE_SIZE / 2, j * TILE_SIZE / 2);
+            }
+
+    if(!t->pinned) {
+        drop();
+        link(t);
+    }
+
+    tiles.insert(key, t);
+
+    return t;
+}
+
+//---------------------------------------------------------------------------
+// the part of the image at x, y the size of dst
+bool TImageView::compose(QImage *dst, int x, int y)
+{
+    TRACE_SCOPE("TImageView::compose");
+    bool rc;
+
+    if(block) {
+        if(mutex)
+            mutex->lock();
+
+        rc = block->toTile(dst, x, y);
+
+        if(mutex)
+            mutex->unlock();
+
+        return rc;
+    }
+
+    if(image) {
+        *dst = image->copy(x, y, dst->width(), dst->height()).convertToFormat(QImage::Format_RGB888);
+
+        return !dst->isNull();
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+// the average of every 2x2 pixels of src to dst at dx, dy, an odd last
+// column or row is doubled
+void TImageView::downsample(QImage *dst, const QImage *src, int dx, int dy)
+{
+    const uchar *s0, *s1;
+    uchar *d;
+    int x, y, c, w, h, x0, x1;
+
+    w = (src->width() + 1) >> 1;
+    h = (src->height() + 1) >> 1;
+
+    w = dx + w > dst->width() ? dst->width() - dx:w;
+    h = dy + h > dst->height() ? dst->height() - dy:h;
+
+    for(y=0; y<h; y++) {
+        s0 = src->scanLine(y * 2);
+        s1 = y * 2 + 1 < src->height() ? src->scanLine(y * 2 + 1):s0;
+        d = dst->scanLine(dy + y) + dx * 3;
+
+        for(x=0; x<w; x++) {
+            x0 = x * 6;
+            x1 = x * 2 + 1 < src->width() ? x0 + 3:x0;
+
+            for(c=0; c<3; c++)
+                d[x * 3 + c] = (s0[x0 + c] + s0[x1 + c] + s1[x0 + c] + s1[x1 + c] + 2) >> 2;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// makes room for a tile, the least recently used one goes
+void TImageView::drop(void)
+{
+    TTile *t;
+
+    while(listed >= cacheSize && oldest) {
+        t = oldest;
+        unlink(t);
+
+        tiles.remove(tileKey(t->level, t->tx, t->ty));
+        delete t;
+    }
+}
+
+//---------------------------------------------------------------------------
+// to the front of the LRU list
+void TImageView::link(TTile *t)
+{
+    t->prev = NULL;
+    t->next = newest;
+
+    if(newest)
+        newest->prev = t;
+    else
+        oldest = t;
+
+    newest = t;
+    listed++;
+}
+
+//---------------------------------------------------------------------------
+// out of the LRU list, a pinned tile is not in it
+void TImageView::unlink(TTile *t)
+{
+    if(t->pinned)
+        return;
+
+    if(t->prev)
+        t->prev->next = t->next;
+    else
+        newest = t->next;
+
+    if(t->next)
+        t->next->prev = t->prev;
+    else
+        oldest = t->prev;
+
+    t->prev = t->next = NULL;
+    listed--;
+}
@@ -0,0 +1,117 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef IMAGEVIEW_H
+#define IMAGEVIEW_H
+
+#include <QtGui/QAbstractScrollArea>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+
+//---------------------------------------------------------------------------
+#define TILE_SIZE       256 // pixels, square
+#define TILE_CACHE      192 // tiles at least, about 36 MB of images and as much of pixmaps
+#define TILE_PINNED     16  // tiles, the coarse levels of at most as many are kept
+#define VIEW_MAX_LEVEL  8   // 1:256
+
+//---------------------------------------------------------------------------
+class QMutex;
+class TBlock;
+
+//---------------------------------------------------------------------------
+// A part of the image pyramid, level 0 is the full resolution image and
+// every level above it half the size of the one below.
+class TTile
+{
+public:
+    int     level, tx, ty;
+    bool    pinned;      // not in the LRU list, never dropped to make room
+    TTile   *prev, *next; // LRU list, the most recently used first
+    QImage  image;   // 24 bpp, downsampled to the next level
+    QPixmap pixmap;  // uploaded when drawn the first time
+};
+
+//---------------------------------------------------------------------------
+// The viewer of the decoded image. Only the tiles in sight are composed
+// and uploaded, from the image store of the block or a copy of a whole
+// image (the formats without a store). The levels above 0 are 2x box
+// downsampled from the four tiles below, both are built when first drawn
+// and the least recently used ones are dropped. The coarse levels are
+// pinned, as the overview is built from every tile of level 0.
+class TImageView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    TImageView(QWidget *parent = 0);
+    ~TImageView(void);
+
+    void setBlock(TBlock *block_);
+    void setImage(const QImage *image_);
+    void setMutex(QMutex *mutex_);
+    void clear(void);
+
+    void grow(int first);
+    void invalidate(int first = 0);
+
+    bool hasImage(void) const { return block || image; }
+    int  getLevel(void) const { return level; }
+    void setLevel(int level_);
+
+public slots:
+    void zoomIn(void);
+    void zoomOut(void);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void wheelEvent(QWheelEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+
+    void    updateSize(void);
+    void    updateScrollBars(void);
+    int     levelWidth(int level_) const;
+    int     levelHeight(int level_) const;
+    int     maxLevel(void) const;
+    int     pinnedLevel(void) const;
+
+    TTile   *tile(int level_, int tx, int ty);
+    bool    compose(QImage *dst, int x, int y);
+    void    downsample(QImage *dst, const QImage *src, int dx, int dy);
+    void    drop(void);
+    void    link(TTile *t);
+    void    unlink(TTile *t);
+
+private:
+    TBlock       *block;
+    const QImage *image;
+    QMutex       *mutex; // the live decoder appends lines to the block
+
+    QHash<quint64, TTile *> tiles;
+    TTile   *newest, *oldest; // LRU list of the tiles that are not pinned
+    int     listed, cacheSize;
+
+    int imageWidth, imageHeight;
+    int level;
+};
+
+#endif // IMAGEVIEW_H
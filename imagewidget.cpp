@@ -24,6 +24,7 @@
 
 #include "mainwindow.h"
 #include "block.h"
+#include "contrast.h"
 #include "plist.h"
 
 #define F_NO_EVENTS 256
@@ -85,6 +86,29 @@ void ImageWidget::setFrames(QString format, long int frames)
   m_ui->framesLabel->setText(str);
 }
 
+//---------------------------------------------------------------------------
+// CADU link quality of the pass, empty for non CCSDS formats
+void ImageWidget::setLinkStats(TCADUStats *stats)
+{
+ QString str;
+ long    n;
+
+  if(stats == NULL || stats->cadus == 0) {
+      m_ui->linkLabel->clear();
+      m_ui->linkLabel->setToolTip(QString());
+      return;
+  }
+
+  n = stats->rsCodewords();
+  if(n > 0)
+      str.sprintf("RS %.1f%% OK, %ld gaps", 100.0 * (n - stats->rsFailed()) / n, stats->seq_gaps);
+  else
+      str.sprintf("%ld CADUs, %ld gaps", stats->cadus, stats->seq_gaps);
+
+  m_ui->linkLabel->setText(str);
+  m_ui->linkLabel->setToolTip(stats->summary());
+}
+
 //---------------------------------------------------------------------------
 bool ImageWidget::isNorthbound(void)
 {
@@ -121,6 +145,25 @@ void ImageWidget::setProperties(bool northbound)
     block->checkSatProps();
 
     flags &= ~F_NO_EVENTS;
+
+    setContrast();
+}
+
+//---------------------------------------------------------------------------
+// the contrast controls from the settings of the block
+void ImageWidget::setContrast(void)
+{
+    TContrast *contrast = mw->getBlock()->contrast;
+
+    flags |= F_NO_EVENTS;
+
+    m_ui->stretchCb->setCurrentIndex(contrast->getStretch());
+    m_ui->clipSpinBox->setValue(contrast->getClip());
+    m_ui->clipSpinBox->setEnabled(contrast->getStretch() == Percentile_Stretch);
+    m_ui->gammaSpinBox->setValue(contrast->getGamma());
+    m_ui->invertCb->setChecked(contrast->isInverted(m_ui->channelSpinBox->value()));
+
+    flags &= ~F_NO_EVENTS;
 }
 
 //---------------------------------------------------------------------------
@@ -143,6 +186,10 @@ void ImageWidget::on_channelSpinBox_valueChanged(int value)
 
     TBlock *b = mw->getBlock();
 
+    flags |= F_NO_EVENTS;
+    m_ui->invertCb->setChecked(b->contrast->isInverted(value));
+    flags &= ~F_NO_EVENTS;
+
     if(b->getImageType() == Channel_ImageType) {
         b->setImageChannel(value);
         mw->renderImage();
@@ -174,3 +221,53 @@ void ImageWidget::on_enhanceCb_currentIndexChanged(int index)
 }
 
 //---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+void ImageWidget::on_stretchCb_currentIndexChanged(int index)
+{
+    if(flags & F_NO_EVENTS)
+        return;
+
+    TBlock *b = mw->getBlock();
+
+    b->contrast->setStretch((Contrast_Stretch) index);
+    m_ui->clipSpinBox->setEnabled(index == Percentile_Stretch);
+    mw->renderImage();
+}
+
+//---------------------------------------------------------------------------
+void ImageWidget::on_clipSpinBox_valueChanged(double value)
+{
+    if(flags & F_NO_EVENTS)
+        return;
+
+    TBlock *b = mw->getBlock();
+
+    b->contrast->setClip(value);
+    mw->renderImage();
+}
+
+//---------------------------------------------------------------------------
+void ImageWidget::on_gammaSpinBox_valueChanged(double value)
+{
+    if(flags & F_NO_EVENTS)
+        return;
+
+    TBlock *b = mw->getBlock();
+
+    b->contrast->setGamma(value);
+    mw->renderImage();
+}
+
+//---------------------------------------------------------------------------
+// inverts the band number, also where it is a part of an RGB image
+void ImageWidget::on_invertCb_clicked()
+{
+    if(flags & F_NO_EVENTS)
+        return;
+
+    TBlock *b = mw->getBlock();
+
+    b->contrast->setInverted(m_ui->channelSpinBox->value(), m_ui->invertCb->isChecked());
+    mw->renderImage();
+}
@@ -32,6 +32,7 @@ namespace Ui {
 class MainWindow;
 class QSize;
 class QString;
+class TCADUStats;
 
 //---------------------------------------------------------------------------
 class ImageWidget : public QDockWidget {
@@ -46,8 +47,10 @@ public:
     bool  isNorthbound(void);
     int   getImageType(void);
     void  setMaxChannels(int channels);
+    void  setContrast(void);
 
     void setFrames(QString format, long int frames = 0);
+    void setLinkStats(TCADUStats *stats);
 
 protected:
     void changeEvent(QEvent *e);
@@ -59,6 +62,10 @@ private:
     int flags;
 
 private slots:
+    void on_invertCb_clicked();
+    void on_gammaSpinBox_valueChanged(double value);
+    void on_clipSpinBox_valueChanged(double value);
+    void on_stretchCb_currentIndexChanged(int index);
     void on_enhanceCb_currentIndexChanged(int index);
     void on_NorthboundCb_clicked();
     void on_channelSpinBox_valueChanged(int value);
@@ -32,13 +32,22 @@
 #endif
 
 #include "mainwindow.h"
+#include "trace.h"
 
 int main(int argc, char *argv[])
 {    
     Q_INIT_RESOURCE(application);
 
     QApplication a(argc, argv);
-    MainWindow w;
-    w.show();
-    return a.exec();
+    int rc;
+
+    TRACE_START();
+    {
+        MainWindow w;
+        w.show();
+        rc = a.exec();
+    }
+    TRACE_STOP("poes-usrp-trace.json");
+
+    return rc;
 }
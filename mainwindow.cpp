@@ -33,6 +33,9 @@
 #include "plist.h"
 
 #include "block.h"
+#include "contrast.h"
+#include "colorscale.h"
+#include "livedecoder.h"
 #include "stationdialog.h"
 #include "station.h"
 #include "tledialog.h"
@@ -40,12 +43,14 @@
 #include "satpassdialog.h"
 #include "trackwidget.h"
 #include "imagewidget.h"
+#include "imageview.h"
 #include "activesatdialog.h"
 #include "satpropdialog.h"
 #include "rigdialog.h"
 #include "gpsdialog.h"
 
 #include "Satellite.h"
+#include "passtimeline.h"
 #include "satutil.h"
 #include "utils.h"
 #include "settings.h"
@@ -53,6 +58,7 @@
 
 #include "os.h"
 #include "version.h"
+#include "trace.h"
 
 #include "trackthread.h"
 #include "cadusplitterdialog.h"
@@ -65,6 +71,7 @@ MainWindow::MainWindow(QWidget *parent)
 
   blockImage = NULL;
   block      = new TBlock;
+  live       = NULL;
 
   qth       = new TStation;
   satList   = new PList;
@@ -72,12 +79,14 @@ MainWindow::MainWindow(QWidget *parent)
   rig       = new TRig;
   gps       = NULL;
   opensat   = new TSat;
+  timeline  = new TPassTimeline(this);
 
   QCoreApplication::setOrganizationName("poes-weather");
   QCoreApplication::setOrganizationDomain("poes-weather.com");
   QCoreApplication::setApplicationName("POES Weather Satellite Decoder");
 
   createPaths();
+  TColorScale::setPath(qApp->applicationDirPath() + "/" + PATH_LUT);
 
   exitAct = new QAction(tr("E&xit"), this);
   exitAct->setShortcut(tr("Ctrl+Q"));
@@ -90,15 +99,8 @@ MainWindow::MainWindow(QWidget *parent)
   ui->menuView->addAction(ui->mainToolBar->toggleViewAction());
   ui->mainToolBar->setWindowTitle("Toolbar");
 
-  imageLabel = new QLabel;
-
-  imageLabel->setBackgroundRole(QPalette::Dark);
-  imageLabel->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-  imageLabel->setScaledContents(false);
-
-  ui->scrollArea->setWidget(imageLabel);
-  ui->scrollArea->setBackgroundRole(QPalette::Dark);
-  setCentralWidget(ui->scrollArea);
+  imageView = new TImageView(this);
+  setCentralWidget(imageView);
 
   imageWidget = new ImageWidget(this);
   ui->menuView->addAction(imageWidget->toggleViewAction());
@@ -114,8 +116,8 @@ MainWindow::~MainWindow()
 {
     delete ui;
 
+    stopLive();
     delete block;
-    delete imageLabel;
 
     if(blockImage)
        delete blockImage;
@@ -128,6 +130,7 @@ MainWindow::~MainWindow()
         delete gps;
 
     delete opensat;
+    delete timeline;
 
     clearSatList(satList, 1);
 }
@@ -238,6 +241,8 @@ void MainWindow::on_actionOpen_triggered()
   qDebug("Filter: %s, index: %d", dialog.selectedNameFilter().toStdString().c_str(), index);
 
   FileName = fileName;
+  stopLive();
+  imageView->clear();
 
  // QApplication::processEvents();
   QApplication::setOverrideCursor(Qt::WaitCursor);
@@ -271,7 +276,6 @@ void MainWindow::on_actionOpen_triggered()
      rc = renderImage();
 
   if(!rc) {
-     imageLabel->clear();
      if(blockImage)
         delete blockImage;
      blockImage = NULL;
@@ -279,16 +283,41 @@ void MainWindow::on_actionOpen_triggered()
   }
 
   imageWidget->setFrames(block->getBlockTypeStr(index), block->getFrames());
+  imageWidget->setLinkStats(block->getStats());
 
   ui->actionSave_As->setEnabled(rc);
   ui->actionClose->setEnabled(rc);
   setCaption(FileName);
 
+  if(rc && ui->actionFollow->isChecked())
+     startLive();
+
   QApplication::restoreOverrideCursor();
 }
 
 //---------------------------------------------------------------------------
 bool MainWindow::processData(const char *filename, int blockType)
+{
+ QString str;
+
+  if(!setupBlock(filename, blockType))
+     return false;
+
+  if(!block->open(filename)) {
+     str.sprintf("No frames found in file %s", filename);
+     ui->statusBar->showMessage(str);
+
+     block->close();
+
+     return false;
+  }
+
+  return createImage();
+}
+
+//---------------------------------------------------------------------------
+// the block type and the satellite properties of the passinfo file
+bool MainWindow::setupBlock(const char *filename, int blockType)
 {
  QString str;
  TSat    *sat;
@@ -326,22 +355,25 @@ bool MainWindow::processData(const char *filename, int blockType)
 
   imageWidget->setProperties(rc ? opensat->isNorthbound():imageWidget->isNorthbound());
 
-  if(!block->open(filename)) {
-     str.sprintf("No frames found in file %s", filename);
-     ui->statusBar->showMessage(str);
-
-     block->close();
-
-     return false;
-  }
+  return true;
+}
 
+//---------------------------------------------------------------------------
+// of the opened block, unless it has an image store
+bool MainWindow::createImage(void)
+{
   if(blockImage)
      delete blockImage;
+  blockImage = NULL;
+
+  qDebug("width: %d height: %d", block->getWidth(), block->getHeight());
+
+  // the tiles of the viewer are composed from the image store
+  if(block->hasImageStore())
+     return true;
 
   try {
      blockImage = new QImage(block->getWidth(), block->getHeight(), QImage::Format_RGB888);
-
-     qDebug("width: %d height: %d", block->getWidth(), block->getHeight());
   }
   catch(...)
   {
@@ -361,8 +393,10 @@ void MainWindow::on_actionSave_As_triggered()
 {
  QFileDialog dialog(this);
  QString fileName, str;
+ QImage *image;
+ bool rc;
 
- if(!blockImage || FileName.isEmpty())
+ if(!imageView->hasImage() || FileName.isEmpty())
      return;
 
  dialog.setAcceptMode(QFileDialog::AcceptSave);
@@ -382,7 +416,25 @@ void MainWindow::on_actionSave_As_triggered()
 
  fileName = dialog.selectedFiles().at(0);
 
- if(blockImage->save(fileName, 0, 75))
+ if(blockImage)
+    rc = blockImage->save(fileName, 0, 75);
+ else {
+    // the viewer keeps only the tiles in sight, the whole image is
+    // composed for the file
+    if(live)
+       live->mutex()->lock();
+
+    image = new QImage(block->getWidth(), block->getHeight(), QImage::Format_RGB888);
+    rc = !image->isNull() && block->toImage(image);
+
+    if(live)
+       live->mutex()->unlock();
+
+    rc = rc && image->save(fileName, 0, 75);
+    delete image;
+ }
+
+ if(rc)
     str.sprintf("Image saved: %s" ,fileName.toStdString().c_str());
  else
     str.sprintf("Failed to save image: %s" ,fileName.toStdString().c_str());
@@ -395,6 +447,9 @@ void MainWindow::on_actionSave_As_triggered()
 //---------------------------------------------------------------------------
 void MainWindow::on_actionClose_triggered()
 {
+    stopLive();
+    imageView->clear();
+
     if(blockImage)
        delete blockImage;
     blockImage = NULL;
@@ -404,10 +459,149 @@ void MainWindow::on_actionClose_triggered()
     setCaption();
     imageWidget->setVisible(false);
 
-    imageLabel->setPixmap(NULL);
     ui->actionClose->setEnabled(false);
 }
 
+//---------------------------------------------------------------------------
+void MainWindow::on_actionFollow_toggled(bool checked)
+{
+    if(checked)
+        startLive();
+    else
+        stopLive();
+}
+
+//---------------------------------------------------------------------------
+// keeps decoding the opened recording while the rx script writes it
+void MainWindow::startLive(void)
+{
+    stopLive();
+
+    if(!imageView->hasImage())
+        return;
+
+    live = new TLiveDecoder(block, this);
+    connect(live, SIGNAL(linesDecoded(int, int)), this, SLOT(liveLinesDecoded(int, int)));
+
+    imageView->setMutex(live->mutex());
+
+    live->start();
+}
+
+//---------------------------------------------------------------------------
+// the tracker started the rx script. With Follow recording checked the
+// recording replaces the image, it is opened by the live decoder once the
+// first sync has been written, with the decoder of the file opened last
+void MainWindow::followRecording(const QString &fileName)
+{
+ QString str;
+ int     blockType;
+
+    if(!ui->actionFollow->isChecked() || fileName.isEmpty())
+        return;
+
+    blockType = block->getBlockType();
+    if(blockType == Undefined_BlockType)
+        blockType = HRPT_BlockType;
+
+    stopLive();
+    imageView->clear();
+
+    if(blockImage)
+       delete blockImage;
+    blockImage = NULL;
+    block->close();
+
+    FileName = fileName;
+    setCaption(FileName);
+
+    ui->actionSave_As->setEnabled(false);
+    ui->actionClose->setEnabled(false);
+
+    if(!setupBlock(FileName.toStdString().c_str(), blockType))
+        return;
+
+    live = new TLiveDecoder(block, this);
+    connect(live, SIGNAL(opened()), this, SLOT(liveOpened()));
+    connect(live, SIGNAL(linesDecoded(int, int)), this, SLOT(liveLinesDecoded(int, int)));
+
+    imageView->setMutex(live->mutex());
+
+    live->setRecording(FileName);
+    live->start();
+
+    str.sprintf("Waiting for the first frame of %s", FileName.toStdString().c_str());
+    ui->statusBar->showMessage(str);
+}
+
+//---------------------------------------------------------------------------
+// the live decoder found the first sync of the recording
+void MainWindow::liveOpened(void)
+{
+ bool rc;
+
+    if(live == NULL)
+        return;
+
+    live->mutex()->lock();
+    rc = createImage();
+    live->mutex()->unlock();
+
+    if(rc)
+        rc = renderImage();
+
+    if(!rc) {
+        stopLive();
+
+        if(blockImage)
+           delete blockImage;
+        blockImage = NULL;
+        block->close();
+    }
+
+    imageWidget->setFrames(block->getBlockTypeStr(block->getBlockType()), block->getFrames());
+    imageWidget->setLinkStats(block->getStats());
+
+    ui->actionSave_As->setEnabled(rc);
+    ui->actionClose->setEnabled(rc);
+}
+
+//---------------------------------------------------------------------------
+void MainWindow::stopLive(void)
+{
+    if(live == NULL)
+        return;
+
+    imageView->setMutex(NULL);
+
+    live->stop();
+    delete live;
+    live = NULL;
+}
+
+//---------------------------------------------------------------------------
+// the image grows by count lines from line first, only the tiles of the
+// viewer with new lines are composed again
+void MainWindow::liveLinesDecoded(int first, int count)
+{
+ QString str;
+ int height;
+
+    if(live == NULL || !imageView->hasImage())
+        return;
+
+    live->mutex()->lock();
+    height = block->getHeight();
+    live->mutex()->unlock();
+
+    imageView->grow(first);
+
+    imageWidget->setFrames(block->getBlockTypeStr(block->getBlockType()), height);
+
+    str.sprintf("Following %s, %d lines (+%d)", FileName.toStdString().c_str(), first + count, count);
+    ui->statusBar->showMessage(str);
+}
+
 //---------------------------------------------------------------------------
 QString MainWindow::getImageFormats(void)
 {
@@ -431,18 +625,32 @@ QString MainWindow::getImageFormats(void)
 }
 
 //---------------------------------------------------------------------------
+// decodes the pass once, the viewer composes the tiles in sight again
+// with the selected channel or image type
 bool MainWindow::renderImage(void)
 {
  bool rc;
 
-  if(!blockImage)
+  if(!blockImage && !block->hasImageStore())
      return false;
 
   QApplication::setOverrideCursor(Qt::WaitCursor);
 
-  rc = block->toImage(blockImage);
-  if(rc)
-     imageLabel->setPixmap(QPixmap::fromImage(*blockImage));
+  // the live decoder appends lines to the block
+  if(live)
+     live->mutex()->lock();
+
+  rc = blockImage ? block->toImage(blockImage):block->decode();
+
+  if(live)
+     live->mutex()->unlock();
+
+  if(rc) {
+     if(blockImage)
+        imageView->setImage(blockImage);
+     else
+        imageView->setBlock(block);
+  }
 
   if(!imageWidget->isVisible())
      imageWidget->setVisible(true);
@@ -473,6 +681,7 @@ void MainWindow::readSettings(void)
     qth->readSettings(&reg);
     readSatelliteSettings();
     rig->readSettings(&reg);
+    timeline->invalidate(satList, rig);
 
     // window settings
     QDesktopWidget *desktop = QApplication::desktop();
@@ -533,6 +742,9 @@ void MainWindow::readSettings(void)
       }
 
       imageWidget->setVisible(false);
+
+      block->contrast->readSettings(&reg);
+      imageWidget->setContrast();
     reg.endGroup();
 
     // finally...
@@ -568,6 +780,8 @@ void MainWindow::writeSettings(void)
       reg.setValue("visible", imageWidget->isVisible());
       reg.setValue("floating", imageWidget->isFloating());
       reg.setValue("dock", dockWidgetArea(imageWidget));
+
+      block->contrast->writeSettings(&reg);
     reg.endGroup();
 
     qth->writeSettings(&reg);
@@ -588,6 +802,7 @@ void MainWindow::on_actionRig_triggered()
 
 
   if(dlg.exec()) {
+      timeline->invalidate(satList, rig);
       trackWidget->restartThread();
   }
   else
@@ -615,10 +830,12 @@ void MainWindow::updateQTH(void)
         sat->AssignObsInfo(qth);
     }
 
+    timeline->invalidate(satList, rig);
+
     if(satList->Count)
        trackWidget->restartThread();
 
-    setCaption(blockImage != NULL ? FileName:"");
+    setCaption(imageView->hasImage() ? FileName:"");
 }
 
 //---------------------------------------------------------------------------
@@ -774,8 +991,10 @@ void MainWindow::on_actionKeplerian_elements_triggered()
 {
   tledialog dlg(satList, qth, this);
 
-  if(dlg.exec())
+  if(dlg.exec()) {
+      timeline->invalidate(satList, rig);
       trackWidget->updateSatCb();
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -801,8 +1020,10 @@ void MainWindow::on_actionActive_satellites_triggered()
 {
     ActiveSatDialog dlg(this);
 
-    if(dlg.exec())
+    if(dlg.exec()) {
+        timeline->invalidate(satList, rig);
         trackWidget->updateSatCb();
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -815,11 +1036,18 @@ void MainWindow::on_actionProperties_triggered()
     // TODO: backup settings incase cancel is toggled
     if(countSats()) {
         if(dlg.exec()) {
-            if(blockImage) {
+            if(imageView->hasImage()) {
                 sat = getSat(satList, opensat->name);
 
                 if(sat) {
+                    if(live)
+                        live->mutex()->lock();
+
                     *block->satprop = *sat->sat_props;
+
+                    if(live)
+                        live->mutex()->unlock();
+
                     imageWidget->setProperties(opensat->isNorthbound());
                 }
                 renderImage();
@@ -838,11 +1066,12 @@ PList *MainWindow::getSatList(void)
 //---------------------------------------------------------------------------
 TSat *MainWindow::getNextSat(double daynum_)
 {
- TSat   *sat;
- PList  *list;
- double utc_daynum, now_utc_daynum, daynum;
- TSat   *nextsat = NULL;
- int    i, flags, ii, max_ii;
+ TSat      *sat;
+ PList     *list;
+ TPassItem item;
+ double    utc_daynum, now_utc_daynum, daynum;
+ TSat      *nextsat = NULL;
+ int       i, flags, ii, max_ii, rc;
 
     if(!countSats(1))
         return NULL;
@@ -855,6 +1084,40 @@ TSat *MainWindow::getNextSat(double daynum_)
     else
         utc_daynum = now_utc_daynum;
 
+    // the next pass of the recording plan, see TPassScheduler. One in
+    // range that is receding is skipped as below. Once there is a plan the
+    // passes it leaves out are not tracked
+    daynum = utc_daynum;
+    while((rc = timeline->planned(daynum, &item)) > 0) {
+        daynum = item.pass.los;
+
+        sat = getSat(satList, item.name);
+        if(sat == NULL || !sat->isActive())
+            continue;
+
+        sat->SetPass(&item.pass, item.northbound);
+
+        if(sat->aostime < utc_daynum) {
+            sat->daynum = now_utc_daynum;
+            sat->Calc();
+
+            if(sat->get_range_rate() >= 0)
+                continue;
+        }
+
+        sat->CheckThresholds(rig);
+
+        return sat;
+    }
+
+    if(rc == 0)
+        return NULL;
+
+    // not in the timeline yet, it predicts the passes on its thread and
+    // they are calculated one satellite at a time here meanwhile.
+    // CheckThresholds sets the recording times of the one selected
+    timeline->request(utc_daynum, utc_daynum + 1);
+
     list = new PList;
     ii = 0;
     max_ii = 144; // search 24 x 6 hours (6 days) forward
@@ -863,7 +1126,7 @@ TSat *MainWindow::getNextSat(double daynum_)
         // get one satellite pass from each active satellite
         for(i=0; i<satList->Count; i++) {
             sat = (TSat *)satList->ItemAt(i);
-            if(!sat->isActive() || !sat->CalcAll(utc_daynum))
+            if(!sat->isActive() || !calcPass(sat, utc_daynum))
                 continue;
 
 #if 1
@@ -884,15 +1147,9 @@ TSat *MainWindow::getNextSat(double daynum_)
 
 
             if(flags & 1) {
-                // find next orbit pass
-                while(sat->GetNextRiseTime(utc, 1) > 0) {
-                    if(!sat->CalcAll(sat->aostime))
-                        break;
-                    if(sat->aostime >= utc_daynum) {
-                        list->Add(sat);
-                        break;
-                    }
-                }
+                // next orbit pass
+                if(calcPass(sat, sat->lostime + PASS_SKIP) && sat->aostime >= utc_daynum)
+                    list->Add(sat);
             }
 #else
             // is it currently above qth?
@@ -991,7 +1248,7 @@ TSat *MainWindow::getNextSatByName(const QString &name, double daynum_)
     else
         utc_daynum = now_utc_daynum;
 
-    if(!sat->CalcAll(utc_daynum))
+    if(!calcPass(sat, utc_daynum))
        return NULL;
 
     flags = 0;
@@ -1012,17 +1269,24 @@ TSat *MainWindow::getNextSatByName(const QString &name, double daynum_)
         flags |= 1;
 
     if(flags & 1) {
-        while(sat->GetNextRiseTime(utc, 1) > 0) {
-           if(!sat->CalcAll(sat->aostime))
-              return NULL;
-           if(sat->aostime >= utc_daynum)
-              return sat;
-        }
+        if(calcPass(sat, sat->lostime + PASS_SKIP) && sat->aostime >= utc_daynum)
+            return sat;
     }
 
  return NULL;
 }
 
+//---------------------------------------------------------------------------
+// the pass of sat in range at daynum or the next one, from the timeline
+// if it has been predicted there
+bool MainWindow::calcPass(TSat *sat, double daynum)
+{
+    if(timeline->assign(sat, daynum))
+        return true;
+
+    return sat->CalcAll(daynum);
+}
+
 //---------------------------------------------------------------------------
 //
 //                  TOOLS
@@ -34,19 +34,21 @@ namespace Ui
 
 //---------------------------------------------------------------------------
 class QSettings;
-class QLabel;
 class QImage;
 
 class THRPT;
 class TBlock;
+class TLiveDecoder;
 
 class PList;
 class TStation;
 class TSat;
 class TSettings;
 class TRig;
+class TPassTimeline;
 
 class ImageWidget;
+class TImageView;
 class TrackWidget;
 class TrackThread;
 class GPSDialog;
@@ -76,9 +78,13 @@ public:
     TRig      *getRig(void);
     PList     *getSatList(void);
     TStation  *getQTH(void) { return qth; }
+    TPassTimeline *getTimeline(void) { return timeline; }
 
     void updateQTH(void);
 
+public slots:
+     void followRecording(const QString &fileName);
+
 private slots:
      void on_actionSplit_CADU_to_file_triggered();
      void on_actionGPS_triggered();
@@ -92,14 +98,23 @@ private slots:
      void on_actionOpen_triggered();
 
      void on_actionClose_triggered();
+     void on_actionFollow_toggled(bool checked);
 
      void on_actionProperties_triggered();
 
+     void liveOpened(void);
+     void liveLinesDecoded(int first, int count);
+
 protected:
      void closeEvent(QCloseEvent *event);
      bool processData(const char *filename, int blockType);
+     bool setupBlock(const char *filename, int blockType);
+     bool createImage(void);
      void setCaption(const QString &filename = 0);
 
+     void startLive(void);
+     void stopLive(void);
+
      void writeSettings(void);
      void readSettings(void);
      void writeSatelliteSettings(void);
@@ -110,22 +125,26 @@ protected:
 
      QString   getImageFormats(void);
 
+     bool      calcPass(TSat *sat, double daynum);
+
 private:
     Ui::MainWindow *ui;
     QAction *exitAct;
 
     QString FileName;
-    QLabel *imageLabel;
-    QImage *blockImage;
+    TImageView *imageView;
+    QImage *blockImage; // the formats without an image store, see TBlock::hasImageStore
 
 
     TBlock    *block;
+    TLiveDecoder *live;
     PList     *satList;
     TStation  *qth;
     TSettings *settings;
     TRig      *rig;
     GPSDialog *gps;
     TSat      *opensat;
+    TPassTimeline *timeline;
 
     TrackWidget *trackWidget;
     ImageWidget  *imageWidget;
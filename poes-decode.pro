@@ -0,0 +1,114 @@
+# -------------------------------------------------
+# poes-decode, the decoder without the GUI
+# qmake poes-decode.pro && make
+# -------------------------------------------------
+TARGET = poes-decode
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+# QImage only, no widgets
+QT += core gui
+
+SOURCES += tools/decode/main.cpp \
+    tools/decode/batchdecoder.cpp \
+    decoder/block.cpp \
+    decoder/hrptblock.cpp \
+    decoder/fy1hrptblock.cpp \
+    decoder/ahrptblock.cpp \
+    decoder/fyahrptblock.cpp \
+    decoder/mn1hrptblock.cpp \
+    decoder/mn1lrptblock.cpp \
+    decoder/lritblock.cpp \
+    decoder/ljpeg/ljpegreader.cpp \
+    decoder/ljpeg/ljpegdecompressor.cpp \
+    decoder/ljpeg/ljpegcomponent.cpp \
+    decoder/ljpeg/ljpeghuffmantable.cpp \
+    decoder/cadu.cpp \
+    decoder/blockreader.cpp \
+    decoder/syncscanner.cpp \
+    decoder/synccorrelator.cpp \
+    decoder/rsdecoder.cpp \
+    decoder/cadustats.cpp \
+    decoder/frameindex.cpp \
+    decoder/imagestore.cpp \
+    decoder/linepool.cpp \
+    decoder/cadupipeline.cpp \
+    decoder/unpack10.cpp \
+    decoder/packetreassembler.cpp \
+    decoder/linecompositor.cpp \
+    decoder/contrast.cpp \
+    decoder/colorscale.cpp \
+    decoder/vegetationlut.cpp \
+    satellite/property/satprop.cpp \
+    satellite/property/rgbconf.cpp \
+    satellite/property/ndvi.cpp \
+    satellite/property/evi.cpp \
+    utils/plist.cpp \
+    utils/trace.cpp
+HEADERS += tools/decode/batchdecoder.h \
+    version.h \
+    os.h \
+    config.h \
+    decoder/block.h \
+    decoder/hrptblock.h \
+    decoder/fy1hrptblock.h \
+    decoder/ahrptblock.h \
+    decoder/fyahrptblock.h \
+    decoder/mn1hrptblock.h \
+    decoder/mn1lrptblock.h \
+    decoder/lritblock.h \
+    decoder/ljpeg/ljpegdecompressor.h \
+    decoder/ljpeg/ljpegcomponent.h \
+    decoder/ljpeg/ljpegreader.h \
+    decoder/ljpeg/ljpeghuffmantable.h \
+    decoder/ljpeg/ljpeg.h \
+    decoder/cadu.h \
+    decoder/blockreader.h \
+    decoder/syncscanner.h \
+    decoder/synccorrelator.h \
+    decoder/rsdecoder.h \
+    decoder/cadustats.h \
+    decoder/frameindex.h \
+    decoder/imagestore.h \
+    decoder/linepool.h \
+    decoder/cadupipeline.h \
+    decoder/unpack10.h \
+    decoder/packetreassembler.h \
+    decoder/linecompositor.h \
+    decoder/contrast.h \
+    decoder/colorscale.h \
+    decoder/vegetationlut.h \
+    satellite/property/satprop.h \
+    satellite/property/rgbconf.h \
+    satellite/property/ndvi.h \
+    satellite/property/evi.h \
+    utils/plist.h \
+    utils/trace.h
+DEFINES += _CRT_SECURE_NO_WARNINGS
+INCLUDEPATH += . \
+    decoder \
+    decoder/ljpeg \
+    satellite/property \
+    utils \
+    tools/decode
+
+# --------------------------------------------------------------------------------
+# uncomment the two lines below if you have installed the tiff image plugin and clean + build
+# QTPLUGIN += qtiff
+# DEFINES += HAVE_IMAGE_PLUGINS
+# --------------------------------------------------------------------------------
+
+# sync scanner and derandomizer use SSE2 by default, uncomment for the AVX2 path
+#QMAKE_CXXFLAGS += -mavx2
+# Reed Solomon syndromes and the 10 bit unpacker need SSSE3 (PSHUFB), implied by -mavx2
+#QMAKE_CXXFLAGS += -mssse3
+
+# hot path timers and counters, build with qmake CONFIG+=trace, see utils/trace.h
+trace {
+    DEFINES += POES_TRACE
+}
+
+win32 {
+    DEFINES += __HRPT_WIN__
+}
@@ -0,0 +1,91 @@
+# -------------------------------------------------
+# poes-sgp4test, TSGP4Batch against TSat::Calc
+# qmake poes-sgp4test.pro && make && ./poes-sgp4test
+# -------------------------------------------------
+TARGET = poes-sgp4test
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+# TSat pulls in the rig for the doppler shift, see POES-Decoder.pro
+SOURCES += tools/test/sgp4test.cpp \
+    satellite/predict/Satellite.cpp \
+    satellite/predict/sgp4batch.cpp \
+    satellite/predict/satscript.cpp \
+    satellite/station/station.cpp \
+    satellite/property/satprop.cpp \
+    satellite/property/rgbconf.cpp \
+    satellite/property/ndvi.cpp \
+    satellite/property/evi.cpp \
+    rig/rig.cpp \
+    rig/rotor.cpp \
+    rig/stepper.cpp \
+    rig/gs232b.cpp \
+    rig/alphaspid.cpp \
+    rig/jrk.cpp \
+    rig/monstrum.cpp \
+    rig/qextserialport/qextserialport.cpp \
+    rig/usb/usbdevice.cpp \
+    rig/usb/tusb.cpp \
+    rig/jrkusb.cpp \
+    rig/jrklut.cpp \
+    utils/utils.cpp \
+    utils/plist.cpp \
+    utils/trace.cpp
+HEADERS += version.h \
+    satellite/predict/Satellite.h \
+    satellite/predict/sgp4batch.h \
+    satellite/predict/satcalc.h \
+    satellite/predict/satscript.h \
+    satellite/station/station.h \
+    satellite/property/satprop.h \
+    satellite/property/rgbconf.h \
+    satellite/property/ndvi.h \
+    satellite/property/evi.h \
+    rig/rig.h \
+    rig/rotor.h \
+    rig/stepper.h \
+    rig/gs232b.h \
+    rig/alphaspid.h \
+    rig/jrk.h \
+    rig/monstrum.h \
+    rig/qextserialport/qextserialport.h \
+    rig/usb/usbdevice.h \
+    rig/usb/tusb.h \
+    rig/jrkusb.h \
+    rig/jrk_protocol.h \
+    rig/jrklut.h \
+    utils/utils.h \
+    utils/plist.h \
+    utils/trace.h
+DEFINES += _CRT_SECURE_NO_WARNINGS
+INCLUDEPATH += . \
+    decoder \
+    satellite \
+    satellite/predict \
+    satellite/property \
+    satellite/station \
+    utils \
+    rig \
+    rig/usb \
+    rig/qextserialport
+
+# the SIMD path under test, as POES-Decoder.pro is built
+#QMAKE_CXXFLAGS += -mavx2
+
+unix {
+    DEFINES += _TTY_LINUX_
+    SOURCES += rig/OakFeatureReports.cpp \
+        rig/OakHidBase.cpp \
+        rig/qextserialport/posix_qextserialport.cpp
+    HEADERS += rig/OakFeatureReports.h \
+        rig/OakHidBase.h
+    LIBS += -lusb
+}
+
+win32 {
+    DEFINES += __HRPT_WIN__ _TTY_WIN_
+    HEADERS += rig/WinIo.h
+    LIBS += -LC:/Programming/HRPT/HRPT-Decoder/branches/1.0.0.6 -lWinIo
+    SOURCES += rig/qextserialport/win_qextserialport.cpp
+}
@@ -550,10 +550,7 @@ unsigned long TRotor::getRotationTime(double toAz, double toEl)
 
 #if 1
 
-    double az_time = fabs(getAzimuth() - toAz) * ((double) az_speed);
-    double el_time = fabs(getElevation() - toEl) * ((double) el_speed);
-
-    ms = rint(MAX(az_time, el_time));
+    ms = getRotationTime(getAzimuth(), getElevation(), toAz, toEl);
 
     return ms;
 
@@ -583,6 +580,16 @@ unsigned long TRotor::getRotationTime(double toAz, double toEl)
 
 }
 
+//---------------------------------------------------------------------------
+// milliseconds from one position to another, the rotor is not read
+unsigned long TRotor::getRotationTime(double fromAz, double fromEl, double toAz, double toEl)
+{
+    double az_time = fabs(fromAz - toAz) * ((double) az_speed);
+    double el_time = fabs(fromEl - toEl) * ((double) el_speed);
+
+    return rint(MAX(az_time, el_time));
+}
+
 //---------------------------------------------------------------------------
 void TRotor::AzEltoXY(double az, double el, double *x, double *y)
 {
@@ -113,7 +113,7 @@ public:
     QString getErrorString(void);
     QString getStatusString(void);
 
-    void AzEltoXY(double az, double el, double *x, double *y);
+    static void AzEltoXY(double az, double el, double *x, double *y);
     void XYtoAzEl(double X, double Y, double *az, double *el);
 
     void setCCWFlag(double aos_az, double los_az, double sat_maz_el);
@@ -150,6 +150,7 @@ public:
 
     bool readPosition(void);
     unsigned long getRotationTime(double toAz, double toEl);
+    unsigned long getRotationTime(double fromAz, double fromEl, double toAz, double toEl);
 
     int  flags;
     char *iobuff;
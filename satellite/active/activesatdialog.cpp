@@ -169,6 +169,8 @@ void ActiveSatDialog::on_satListWidget_itemClicked(QListWidgetItem* item)
     m_ui->freqCb->lineEdit()->setText(script->downlink());
     m_ui->downconvertCb->setChecked(script->downconvert());
     downconvert(sat);
+    m_ui->prioritySb->setValue(script->priority());
+    m_ui->minElevSb->setValue(script->min_elevation());
 
     // RX-Script
     m_ui->enableRXScriptCb->setChecked(script->rx_srcrip_enable());
@@ -224,6 +226,8 @@ void ActiveSatDialog::on_applyButton_clicked()
     script->downlink(m_ui->freqCb->currentText());
     script->downconvert(m_ui->downconvertCb->isChecked());
     downconvert(sat);
+    script->priority(m_ui->prioritySb->value());
+    script->min_elevation(m_ui->minElevSb->value());
 
     // RX-Script
     script->rx_srcrip_enable(m_ui->enableRXScriptCb->isChecked());
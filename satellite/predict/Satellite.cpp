@@ -37,6 +37,7 @@
 #include <QFileInfo>
 #include <QSettings>
 #include <time.h>
+#include <float.h>
 
 #include "settings.h"
 #include "rig.h"
@@ -44,8 +45,10 @@
 #include "satcalc.h"
 #include "utils.h"
 #include "version.h"
+#include "trace.h"
 
 #include "Satellite.h"
+#include "sgp4batch.h"
 
 //---------------------------------------------------------------------------
 TSat::TSat(void)
@@ -698,7 +701,6 @@ void TSat::SatellitePasses(TRig *rig, QTableWidget *grid, QDateTime utc, int mod
     QDateTime local;
     double    dn_utc;
     int       row;
-    bool      add;
 
     if(!(mode & 1))
         clearGrid(grid);
@@ -732,20 +734,7 @@ void TSat::SatellitePasses(TRig *rig, QTableWidget *grid, QDateTime utc, int mod
 
    row = grid->rowCount();
    do {
-       add = true;
-       daynum = tcatime;
-       Calc();
-
-       if(rig->passthresholds() && sat_ele < rig->pass_elev)
-           add = false;
-
-       if(add) {
-           row = grid->rowCount() + 1;
-           grid->setRowCount(row);
-
-           FillPassGrid(rig, grid, Daynum2String(aostime, 2|16),
-                        sat_azi, sat_lat, sat_lon, sat_range, rv);
-       }
+       row = AddPassToGrid(rig, grid);
 
        /* Move to next orbit */
        daynum = NextAOS();
@@ -762,10 +751,30 @@ void TSat::SatellitePasses(TRig *rig, QTableWidget *grid, QDateTime utc, int mod
 
 }
 
+//---------------------------------------------------------------------------
+// adds the pass aostime - lostime to the grid unless it stays below the pass
+// threshold, returns the number of rows
+int TSat::AddPassToGrid(TRig *rig, QTableWidget *grid)
+{
+  daynum = tcatime;
+  Calc();
+
+  if(!rig->passthresholds() || sat_ele >= rig->pass_elev) {
+     grid->setRowCount(grid->rowCount() + 1);
+
+     FillPassGrid(rig, grid, Daynum2String(aostime, 2|16),
+                  sat_azi, sat_lat, sat_lon, sat_range, rv);
+  }
+
+ return grid->rowCount();
+}
+
 //---------------------------------------------------------------------------
 // mode&1 = aostime is calculated, dn = daynum
 bool TSat::CalcAll(double dn, int mode)
 {
+ TRACE_SCOPE("TSat::CalcAll");
+ pass_t pass;
  double aos_lat, los_lat;
 
   // fixme: to be removed
@@ -777,24 +786,23 @@ bool TSat::CalcAll(double dn, int mode)
   if(!CanCalc(obs_geodetic.lat, daynum, 1))
      return false;
 
-  // check if the sat is currently up
-  if(!(mode&1)) {
-     Calc();
-     if(sat_ele > 0.0)
-        daynum -= 0.014; // about -20 minutes
+  // the pass in progress or the next one
+  if(!FindPass(mode&1 ? aostime:dn, &pass))
+     return false;
 
-     if(!FindAOS())
-        return false; }
+  aostime     = pass.aos;
+  tcatime     = pass.tca;
+  lostime     = pass.los;
+  sat_max_ele = pass.max_ele;
 
+  daynum = aostime;
+  Calc();
   aos_lat = sat_lat;
 
-  if(!FindMaxElevation(aostime))
-     return false;
-
-  if(!FindLOS2())
-     return false;
-
+  daynum = lostime;
+  Calc();
   los_lat = sat_lat;
+
   setDirection(aos_lat < los_lat ? true:false);
 
  return true;
@@ -1087,8 +1095,9 @@ bool TSat::SavePassinfo(void)
     if(file.isEmpty())
         return false;
 
+    // the recording name up to its extension, dots in the name are kept
     QFileInfo fi(file);
-    QString   inifile = fi.absolutePath() + "/" + fi.baseName() + ".ini";
+    QString   inifile = fi.absolutePath() + "/" + fi.completeBaseName() + ".ini";
 
     fi.setFile(inifile);
     if(fi.exists())
@@ -1117,6 +1126,7 @@ bool TSat::SavePassinfo(void)
        reg.setValue("AOS",     rec_aostime);
        reg.setValue("LOS",     rec_lostime);
        reg.setValue("MaxElev", sat_max_ele);
+       reg.setValue("Northbound", isNorthbound());
        reg.setValue("AOS-UTC", Daynum2String(rec_aostime, 4|8));
        reg.setValue("LOS-UTC", Daynum2String(rec_lostime, 4|8));
     reg.endGroup();
@@ -1138,11 +1148,17 @@ bool TSat::SavePassinfo(void)
 bool TSat::ReadPassinfo(QString hrptfile)
 {
     QFileInfo fi(hrptfile);
-    QString   inifile = fi.absolutePath() + "/" + fi.baseName() + ".ini";
+    QString   inifile = fi.absolutePath() + "/" + fi.completeBaseName() + ".ini";
+    QString   oldfile = fi.absolutePath() + "/" + fi.baseName() + ".ini";
 
+    // up to the first dot before SavePassinfo kept the whole name
     fi.setFile(inifile);
-    if(!fi.exists())
-        return false;
+    if(!fi.exists()) {
+        inifile = oldfile;
+        fi.setFile(inifile);
+        if(!fi.exists())
+            return false;
+    }
 
     QSettings reg(inifile, QSettings::IniFormat);
     QString str1, str2, str3;
@@ -1289,9 +1305,33 @@ void TSat::PreCalc(void)
   SetFlag(INITIALIZED_FLAG);
 }
 
+//---------------------------------------------------------------------------
+// true if SDP4 propagates the satellite (period >= 225 minutes)
+bool TSat::IsDeepSpace(void)
+{
+  if(!isFlagSet(INITIALIZED_FLAG))
+     PreCalc();
+
+  return isFlagSet(DEEP_SPACE_EPHEM_FLAG) ? true:false;
+}
+
+//---------------------------------------------------------------------------
+// the element set as select_ephemeris prepared it for SGP4/SDP4 and its
+// epoch as a Julian date, see TSGP4Batch
+void TSat::GetElements(tle_t *elements, double *jd_epoch)
+{
+  if(!isFlagSet(INITIALIZED_FLAG))
+     PreCalc();
+
+  *elements = tle;
+  *jd_epoch = Julian_Date_of_Epoch(tle.epoch);
+}
+
 //---------------------------------------------------------------------------
 void TSat::Calc(void)
 {
+ TRACE_SCOPE("TSat::Calc");
+
  /* This is the stuff we need to do repetitively... */
 
  vector_t   zero_vector = {0,0,0,0};    /* Zero vector for initializations */
@@ -1371,191 +1411,530 @@ void TSat::Calc(void)
 }
 
 //---------------------------------------------------------------------------
-double TSat::FindLOS(void)
+// LOS of the pass in progress at daynum or of the next one
+double TSat::FindLOS2(void)
 {
- lostime = 0.0;
-
-  if(CanCalc(obs_geodetic.lat, daynum)) {
-     Calc();
+ pass_t pass;
 
-     do {
-     	daynum += sat_ele*sqrt(sat_alt)/502500.0;
-     	Calc();
+  if(Flags&(DECAYED_FLAG | GEOSTAT_FLAG | NORISE_FLAG))
+     return 0;
 
-     	if(fabs(sat_ele) < 0.03)
-     	   lostime = daynum;
+  lostime = 0.0;
 
-     } while(lostime==0.0);
-  }
+  if(FindPass(daynum, &pass)) {
+     lostime = daynum = pass.los;
+     Calc(); }
 
  return lostime;
 }
 
 //---------------------------------------------------------------------------
-double TSat::FindLOS2(void)
+// returns the lostime when this elevation happens,
+// CalcAll must have been called before this function
+double TSat::FindLOSElevation(double elevation)
 {
- /* This function steps through the pass to find LOS.
-    FindLOS() is called to "fine tune" and return the result. */
+  if(elevation <= 0.0)
+     return lostime;
 
-  if(Flags&(DECAYED_FLAG | GEOSTAT_FLAG | NORISE_FLAG))
+  if(sat_max_ele < elevation)
      return 0;
 
-  do {
-     daynum += cos((sat_ele-1.0)*deg2rad)*sqrt(sat_alt)/25000.0;
-     Calc();
+  daynum = SolveElevation(tcatime, lostime, sat_max_ele-elevation, -elevation,
+                          elevation, PASS_TOLERANCE);
+  Calc();
 
-  } while(sat_ele >= 0.0);
+ return daynum;
+}
 
- return FindLOS();
+//---------------------------------------------------------------------------
+double TSat::NextAOS(void)
+{
+ /* This function finds and returns the time of the next
+    AOS for a satellite that is currently in range. */
+ pass_t pass;
+
+  aostime = 0.0;
+
+  if(CanCalc(obs_geodetic.lat, daynum) && FindPass(daynum, &pass)) {
+     // skip the pass in progress or about to start
+     if(pass.aos < daynum+PASS_SKIP && !FindPass(pass.los+PASS_SKIP, &pass))
+        return 0.0;
+
+     aostime = daynum = pass.aos;
+     Calc(); }
+
+ return aostime;
 }
 
 //---------------------------------------------------------------------------
-double TSat::FindLOSElevation(double elevation)
+double TSat::FindAOS(void)
 {
- double step = 1.0/86400.0; // increment 1 sec
- double elev, _elevation;
- int    iter = 0;
+ /* This function finds and returns the time of AOS (aostime)
+    of the pass in progress or the next one. */
+ pass_t pass;
 
-  if(elevation == 0.0)
-     return lostime;
+  aostime = 0.0;
 
-  daynum = lostime;
+  if(CanCalc(obs_geodetic.lat, daynum, 1) && FindPass(daynum, &pass)) {
+     aostime = daynum = pass.aos;
+     Calc(); }
+
+ return aostime;
+}
+
+//---------------------------------------------------------------------------
+// returns the aostime when this elevation happens,
+// CalcAll must have been called before this function
+double TSat::FindAOSElevation(double elevation)
+{
+  daynum = aostime;
+
+  if(elevation > 0.0) {
+     if(sat_max_ele < elevation)
+        return 0;
+
+     daynum = SolveElevation(aostime, tcatime, -elevation, sat_max_ele-elevation,
+                             elevation, PASS_TOLERANCE);
+  }
+
+  Calc();
+
+ return daynum;
+}
+
+//---------------------------------------------------------------------------
+double TSat::FindMaxElevation(double aosdaynum)
+{
+ double dn, ele;
+
+  daynum = aosdaynum;
   Calc();
+  sat_max_ele = sat_ele;
+  tcatime     = daynum;
+
+  if(Flags&(DECAYED_FLAG | GEOSTAT_FLAG | NORISE_FLAG) || meanmo <= 0.0)
+     return sat_max_ele;
+
+  dn = StepMaxElevation(aosdaynum, aosdaynum, sat_ele, 1.0/(PASS_ORBIT_STEPS*meanmo),
+                        PASS_TOLERANCE, &ele);
+  if(dn > 0.0) {
+     tcatime     = daynum = dn;
+     sat_max_ele = ele;
+     Calc(); }
+
+ return sat_max_ele > 0.0 ? sat_max_ele:0;
+}
+
+//---------------------------------------------------------------------------
+/* Finds the pass in progress at dn or the next one. The elevation is
+   sampled coarsely to bracket AOS, TCA and LOS, they are refined to
+   tolerance days with Brent's method, as are the times the satellite
+   crosses aos_elev and los_elev (0 = the horizon). daynum and the
+   sat_ values are left as they are. */
+bool TSat::FindPass(double dn, pass_t *pass, double aos_elev, double los_elev, double tolerance)
+{
+ TRACE_SCOPE("TSat::FindPass");
+ double period, step, alt, last, ta, tb, tc, tm, ea, eb, ec, em;
+ int    iter;
 
-  _elevation = elevation-0.03;
+  memset(pass, 0, sizeof(pass_t));
 
-  while(iter < 1800) { // iterate max 30 min
-     if(sat_ele >= _elevation)
-        return daynum;
+  if(!CanCalc(obs_geodetic.lat, dn) || meanmo <= 0.0)
+     return false;
+
+  period = 1.0/meanmo;
+  step   = period/PASS_ORBIT_STEPS;
+
+  /* In range, back to before AOS */
+  tb = dn;
+  eb = Elevation(tb, &alt);
+
+  for(iter=0; eb > 0.0; iter++) {
+     if(iter >= PASS_ORBIT_STEPS)
+        return false;
+
+     tb -= step;
+     eb = Elevation(tb, &alt);
+  }
+
+  /* Below the horizon the elevation is sampled in batches up to where
+     the steps below may not be period/8 */
+  if(iter == 0) {
+     last = tb + PASS_MAX_STEPS*period/8.0;
+     tb   = SkipBelow(tb, last);
+     if(tb > last)
+        return false;
+
+     eb = Elevation(tb, &alt);
+  }
+
+  /* Forward to AOS, below -1 deg in the steps of PREDICT's FindAOS.
+     A maximum between samples below the horizon is solved, the
+     satellite may graze it. */
+  ta = tb;
+  ea = eb;
+
+  for(iter=0; ; iter++) {
+     if(iter >= PASS_MAX_STEPS)
+        return false;
 
-     daynum -= step;
-     iter++;
-     elev = sat_ele;
-     Calc();
+     tc = tb+RiseStep(eb, alt, period);
+     ec = Elevation(tc, &alt);
 
-     if(sat_ele < elev)
+     if(ec > 0.0) {
+        pass->aos = SolveElevation(tb, tc, eb, ec, 0.0, tolerance);
+        pass->tca = StepMaxElevation(pass->aos, tc, ec, step, tolerance, &pass->max_ele);
+        break; }
+
+     if(eb > ea && ec < eb && eb > -5.0) {
+        tm = SolveMaxElevation(ta, tc, tolerance, &em);
+
+        if(em > 0.0) {
+           pass->aos     = SolveElevation(ta, tm, ea, em, 0.0, tolerance);
+           pass->tca     = tm;
+           pass->max_ele = em;
+           break; }
+     }
+
+     ta = tb;
+     ea = eb;
+     tb = tc;
+     eb = ec;
+  }
+
+  if(pass->tca == 0.0)
+     return false;
+
+  /* Forward to LOS */
+  tb = pass->tca;
+  eb = pass->max_ele;
+
+  for(iter=0; ; iter++) {
+     if(iter >= PASS_MAX_STEPS)
+        return false;
+
+     tc = tb+step;
+     ec = Elevation(tc);
+
+     if(ec <= 0.0)
         break;
+
+     tb = tc;
+     eb = ec;
   }
 
- return 0;
+  pass->los = SolveElevation(tb, tc, eb, ec, 0.0, tolerance);
+
+  /* Threshold crossings */
+  pass->rec_aos = pass->aos;
+  pass->rec_los = pass->los;
+
+  if(aos_elev > 0.0)
+     pass->rec_aos = pass->max_ele < aos_elev ? 0:
+                     SolveElevation(pass->aos, pass->tca, -aos_elev, pass->max_ele-aos_elev,
+                                    aos_elev, tolerance);
+  if(los_elev > 0.0)
+     pass->rec_los = pass->max_ele < los_elev ? 0:
+                     SolveElevation(pass->tca, pass->los, pass->max_ele-los_elev, -los_elev,
+                                    los_elev, tolerance);
+
+ return true;
 }
 
 //---------------------------------------------------------------------------
-double TSat::NextAOS(void)
+/* The step of PREDICT's FindAOS, a satellite at ele degrees and alt km
+   does not rise within it. period/8 days at most. */
+double TSat::RiseStep(double ele, double alt, double period)
 {
- /* This function finds and returns the time of the next
-    AOS for a satellite that is currently in range. */
-
-  aostime = 0.0;
+ double step;
 
-  if(CanCalc(obs_geodetic.lat, daynum))
-     daynum = FindLOS2()+0.014;  /* Move to LOS + 20 minutes */
+  step = ele < -1.0 ? 0.00035*(-ele*((alt/8400.0)+0.46)+2.0):0.0007;
 
- return FindAOS();
+ return step < period/8.0 ? step:period/8.0;
 }
 
 //---------------------------------------------------------------------------
-double TSat::FindAOS(void)
+/* Where FindPass starts stepping to AOS from dn. Far below the horizon
+   the step is period/8 (RiseStep), those samples are propagated with
+   TSGP4Batch, a batch at a time, up to the first one closer to the
+   horizon. FindPass starts at the sample before it and takes the same
+   steps from there. At last or beyond if the satellite does not get
+   closer before, dn itself for a deep space satellite. */
+double TSat::SkipBelow(double dn, double last)
 {
- /* This function finds and returns the time of AOS (aostime). */
- int iter = 0;
- aostime = 0.0;
+ TRACE_SCOPE("TSat::SkipBelow");
+ TSGP4Batch batch;
+ TSGP4State state;
+ double t[PASS_BATCH], ele[PASS_BATCH];
+ double period, step, alt;
+ int    i, n, size, set;
+
+  if(meanmo <= 0.0)
+     return dn;
+
+  set = batch.add(this);
+  if(set < 0 || !state.alloc(PASS_BATCH))
+     return dn;
+
+  period = 1.0/meanmo;
+  step   = period/8.0;
+  size   = 8;
 
-  if(CanCalc(obs_geodetic.lat, daynum, 1)) {
-     Calc();
+  t[0] = dn;
 
-     /* Get the satellite in range */
-     while(sat_ele < -1.0 && iter++ < 10000) {
-        daynum -= 0.00035*(sat_ele*(((sat_alt/8400.0)+0.46))-2.0);
+  while(t[0] < last) {
+     n = (int) ((last - t[0])/step) + 2;
+     if(n > size)
+        n = size;
 
-	/* Technically, this should be:
+     for(i=1; i<n; i++)
+        t[i] = t[0] + i*step;
 
-	   daynum-=0.0007*(sat_ele*(((sat_alt/8400.0)+0.46))-2.0);
+     if(!batch.propagate(set, t, n, &state))
+        return t[0];
 
-	   but it sometimes skipped passes for
-	   satellites in highly elliptical orbits. */
+     TSGP4Batch::look(&obs_geodetic, t, 1, &state, n, NULL, ele, NULL);
 
-	Calc();
+     for(i=0; i<n; i++) {
+        alt = sqrt(state.x[i]*state.x[i] + state.y[i]*state.y[i] + state.z[i]*state.z[i]) - xkmper;
+
+        if(RiseStep(ele[i], alt, period) < step)
+           return i ? t[i-1]:t[0];
      }
 
-     if(sat_ele < -1.0)
-        return 0.0;
-     /* Find AOS */
-
-     /** Users using Keplerian data to track the Sun MAY find
-         this section goes into an infinite loop when tracking
-         the Sun if their QTH is below 30 deg N! **/
-
-     iter = 0;
-     while(aostime == 0.0 && iter++ < 10000)
-     	if(fabs(sat_ele) < 0.03)
-     	   aostime = daynum;
-     	else {
-     	   daynum -= sat_ele*sqrt(sat_alt)/530000.0;
-     	   Calc(); }
+     // the last one again, FindPass starts at it if the next is close
+     t[0] = t[n-1];
+     size = size < PASS_BATCH/2 ? size << 1:PASS_BATCH;
   }
 
- return aostime;
+ return t[0];
 }
 
 //---------------------------------------------------------------------------
-// returns the aostime when this elevation happens
-double TSat::FindAOSElevation(double elevation)
+// a pass of FindPass or TPassTimeline
+void TSat::SetPass(const pass_t *pass, bool northbound)
 {
- double step = 1.0/86400.0; // increment 1 sec
- double elev, _elevation;
- int    iter = 0;
+  aostime     = pass->aos;
+  tcatime     = pass->tca;
+  lostime     = pass->los;
+  sat_max_ele = pass->max_ele;
+  rec_aostime = pass->rec_aos;
+  rec_lostime = pass->rec_los;
 
-  daynum = aostime;
-  Calc();
+  setDirection(northbound);
+}
 
-  if(elevation == 0.0)
-      return aostime;
+//---------------------------------------------------------------------------
+// the elevation in degrees at dn, only the propagation and look angle
+// part of Calc(), alt is the approximate altitude in km
+double TSat::Elevation(double dn, double *alt)
+{
+ TRACE_SCOPE("TSat::Elevation");
+ vector_t pos, vel, obs_set;
+ double   jd, ts;
+
+  if(!isFlagSet(INITIALIZED_FLAG))
+     PreCalc();
 
-  _elevation = elevation-0.03;
-  while(iter < 1800) { // iterate max 30 min
-     if(sat_ele >= _elevation)
-        return daynum;
+  jd = dn+2444238.5;
+  ts = (jd-Julian_Date_of_Epoch(tle.epoch))*xmnpda;
 
-     daynum += step;
-     iter++;
-     elev = sat_ele;
-     Calc();
-     if(sat_ele < elev) // receding
+  if(isFlagSet(DEEP_SPACE_EPHEM_FLAG))
+     SDP4(ts, &tle, &pos, &vel);
+  else
+     SGP4(ts, &tle, &pos, &vel);
+
+  Convert_Sat_State(&pos, &vel);
+  Calculate_Obs(jd, &pos, &vel, &obs_geodetic, &obs_set);
+
+  if(alt) {
+     Magnitude(&pos);
+     *alt = pos.w-xkmper; }
+
+ return Degrees(obs_set.y);
+}
+
+//---------------------------------------------------------------------------
+/* Brent's method for the time in [a, b] when the satellite is at
+   elevation, fa and fb are the elevations at a and b minus elevation,
+   of opposite sign. */
+double TSat::SolveElevation(double a, double b, double fa, double fb,
+                            double elevation, double tolerance)
+{
+ double c, d, e, fc, m, p, q, r, s, tol;
+ int    iter;
+
+  c  = a;
+  fc = fa;
+  d  = e = b-a;
+
+  for(iter=0; iter<PASS_MAX_ITER; iter++) {
+     if((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0)) {
+        c  = a;
+        fc = fa;
+        d  = e = b-a; }
+
+     if(fabs(fc) < fabs(fb)) {
+        a  = b;
+        b  = c;
+        c  = a;
+        fa = fb;
+        fb = fc;
+        fc = fa; }
+
+     tol = 2.0*DBL_EPSILON*fabs(b)+0.5*tolerance;
+     m   = 0.5*(c-b);
+
+     if(fabs(m) <= tol || fb == 0.0)
         break;
+
+     if(fabs(e) < tol || fabs(fa) <= fabs(fb))
+        d = e = m; // bisection
+     else {
+        s = fb/fa;
+
+        if(a == c) { // secant
+           p = 2.0*m*s;
+           q = 1.0-s; }
+        else {       // inverse quadratic interpolation
+           q = fa/fc;
+           r = fb/fc;
+           p = s*(2.0*m*q*(q-r)-(b-a)*(r-1.0));
+           q = (q-1.0)*(r-1.0)*(s-1.0); }
+
+        if(p > 0.0)
+           q = -q;
+        else
+           p = -p;
+
+        if(2.0*p < 3.0*m*q-fabs(tol*q) && p < fabs(0.5*e*q)) {
+           e = d;
+           d = p/q; }
+        else
+           d = e = m;
+     }
+
+     a  = b;
+     fa = fb;
+     b += fabs(d) > tol ? d:(m > 0.0 ? tol:-tol);
+     fb = Elevation(b)-elevation;
   }
 
- return 0;
+ return b;
 }
 
 //---------------------------------------------------------------------------
-double TSat::FindMaxElevation(double aosdaynum)
+/* Brent's method for the time of the highest elevation in [a, b],
+   the elevation rises to it and falls after it. */
+double TSat::SolveMaxElevation(double a, double b, double tolerance, double *max_ele)
 {
- double step = 1.0/86400.0; // increment 1 sec
- int    iter = 0;
+ const double cgold = 0.3819660112501051; // (3-sqrt(5))/2
+ double t0, d, e, m, p, q, r, tol, u, v, w, x, fu, fv, fw, fx;
+ int    iter;
 
-  daynum = aosdaynum;
-  Calc();
-  sat_max_ele = sat_ele;
-  tcatime     = daynum;
+  /* Relative to a, a daynum is too large for the relative tolerance */
+  t0 = a;
+  b -= a;
+  a  = 0.0;
 
-  if(Flags&(DECAYED_FLAG | GEOSTAT_FLAG | NORISE_FLAG))
-     return sat_max_ele;
+  x  = w = v = cgold*b;
+  fx = fw = fv = -Elevation(t0+x);
+  d  = e = 0.0;
 
-  while(iter < 1800) {
-     daynum += step;
-     iter++;
-     Calc();
+  for(iter=0; iter<PASS_MAX_ITER; iter++) {
+     m   = 0.5*(a+b);
+     tol = sqrt(DBL_EPSILON)*fabs(x)+tolerance/3.0;
 
-     if(sat_ele > sat_max_ele)
-        sat_max_ele = sat_ele;
-     else
+     if(fabs(x-m) <= 2.0*tol-0.5*(b-a))
         break;
+
+     p = q = r = 0.0;
+
+     if(fabs(e) > tol) { // parabola through x, v and w
+        r = (x-w)*(fx-fv);
+        q = (x-v)*(fx-fw);
+        p = (x-v)*q-(x-w)*r;
+        q = 2.0*(q-r);
+
+        if(q > 0.0)
+           p = -p;
+        else
+           q = -q;
+
+        r = e;
+        e = d; }
+
+     if(fabs(p) < fabs(0.5*q*r) && p > q*(a-x) && p < q*(b-x)) {
+        d = p/q;
+        u = x+d;
+
+        if(u-a < 2.0*tol || b-u < 2.0*tol)
+           d = x < m ? tol:-tol; }
+     else {                // golden section
+        e = (x < m ? b:a)-x;
+        d = cgold*e; }
+
+     u  = fabs(d) >= tol ? x+d:x+(d > 0.0 ? tol:-tol);
+     fu = -Elevation(t0+u);
+
+     if(fu <= fx) {
+        if(u < x)
+           b = x;
+        else
+           a = x;
+
+        v  = w;
+        fv = fw;
+        w  = x;
+        fw = fx;
+        x  = u;
+        fx = fu; }
+     else {
+        if(u < x)
+           a = u;
+        else
+           b = u;
+
+        if(fu <= fw || w == x) {
+           v  = w;
+           fv = fw;
+           w  = u;
+           fw = fu; }
+        else if(fu <= fv || v == x || v == w) {
+           v  = u;
+           fv = fu; }
+     }
   }
 
-  tcatime = daynum;
+  *max_ele = -fx;
 
- return sat_max_ele > 0.0 ? sat_max_ele:0;
+ return t0+x;
+}
+
+//---------------------------------------------------------------------------
+/* Steps from dn at elevation ele until the elevation falls and solves
+   the maximum, the elevation rises from a. 0 if it never falls. */
+double TSat::StepMaxElevation(double a, double dn, double ele, double step,
+                              double tolerance, double *max_ele)
+{
+ double t, e;
+ int    iter;
+
+  for(iter=0; iter<PASS_MAX_STEPS; iter++) {
+     t = dn+step;
+     e = Elevation(t);
+
+     if(e < ele)
+        return SolveMaxElevation(a, t, tolerance, max_ele);
+
+     a   = dn;
+     dn  = t;
+     ele = e;
+  }
+
+  *max_ele = 0;
+
+ return 0;
 }
 
 //---------------------------------------------------------------------------
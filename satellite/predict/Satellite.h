@@ -93,6 +93,13 @@ typedef struct
  double  ds50;
 }  deep_arg_t;
 
+/* One pass over the station, times are daynums, 0 if the elevation
+   is not reached. rec_aos and rec_los cross the threshold elevations. */
+typedef struct
+{
+ double aos, tca, los, max_ele, rec_aos, rec_los;
+} pass_t;
+
 
 // sat_flags
 #define SAT_NORTHBOUND     1
@@ -100,6 +107,14 @@ typedef struct
 #define SAT_DELETE         4
 #define SAT_IN_SUNLIGHT    8
 
+// pass events are solved to this tolerance, days
+#define PASS_TOLERANCE     (0.1/86400.0)
+#define PASS_ORBIT_STEPS   64    // coarse steps per orbit from AOS to LOS
+#define PASS_MAX_STEPS     5000
+#define PASS_MAX_ITER      100   // Brent's method
+#define PASS_SKIP          (1.0/1440.0) // a pass starting within a minute is the current one
+#define PASS_BATCH         64    // elevations TSGP4Batch samples at a time, see SkipBelow
+
 //---------------------------------------------------------------------------
 class QString;
 class QDateTime;
@@ -141,6 +156,8 @@ class TSat
    bool CheckIsInSunLight(TSettings *setting);
    bool DoesRise(double lat);
    bool IsGeostationary(void);
+   bool IsDeepSpace(void);
+   void GetElements(tle_t *elements, double *jd_epoch);
 
    bool    Decayed(double daynum=0);
    double  CalcDecayedDayNum(double dnum=0);
@@ -154,6 +171,11 @@ class TSat
    double GetSetTime(void);
    bool   IsUp(TStation *_qth, QDateTime dt, double min_sat_ele = 0.0);
 
+   bool   FindPass(double dn, pass_t *pass, double aos_elev=0, double los_elev=0,
+                   double tolerance=PASS_TOLERANCE);
+   void   SetPass(const pass_t *pass, bool northbound);
+   static double RiseStep(double ele, double alt, double period);
+   double SkipBelow(double dn, double last);
    double FindAOSElevation(double elevation);
    double FindMaxElevation(double aosdaynum);
    double FindLOSElevation(double elevation);
@@ -185,6 +207,7 @@ class TSat
    bool   ReadPassinfo(QString hrptfile);
 
    void   SatellitePasses(TRig *rig, QTableWidget *grid, QDateTime utc, int mode=0);
+   int    AddPassToGrid(TRig *rig, QTableWidget *grid);
 
    void    Track(void);
    QString GetTrackStr(TRig *rig, int mode=0);
@@ -325,10 +348,16 @@ class TSat
    void   select_ephemeris(tle_t *tle);
 
    double FindAOS(void);
-   double FindLOS(void);
    double FindLOS2(void);
    double NextAOS(void);
 
+   double Elevation(double dn, double *alt=NULL);
+   double SolveElevation(double a, double b, double fa, double fb,
+                         double elevation, double tolerance);
+   double SolveMaxElevation(double a, double b, double tolerance, double *max_ele);
+   double StepMaxElevation(double a, double dn, double ele, double step,
+                           double tolerance, double *max_ele);
+
    void   SDP4(double tsince, tle_t *tle, vector_t *pos, vector_t *vel);
    void   SGP4(double tsince, tle_t *tle, vector_t *pos, vector_t *vel);
    double FixAngle(double x);
@@ -0,0 +1,327 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <QThread>
+#include <QAtomicInt>
+#include <stdlib.h>
+#include <string.h>
+
+#include "passpool.h"
+#include "satcalc.h"
+#include "plist.h"
+#include "rig.h"
+#include "trace.h"
+
+//---------------------------------------------------------------------------
+class TPassWorker : public QThread
+{
+public:
+    TPassWorker(TPassPool *pool_, QAtomicInt *next_)
+    {
+        pool = pool_;
+        next = next_;
+
+        items = NULL;
+        count = size = 0;
+        failed = false;
+    }
+
+    ~TPassWorker(void)
+    {
+        if(items)
+            free(items);
+    }
+
+    void run()
+    {
+        int i;
+
+        while(!failed && !pool->isStopped() &&
+              (i = next->fetchAndAddOrdered(1)) < pool->sats->Count)
+            failed = !pool->predictSat((TSat *) pool->sats->ItemAt(i), &items, &count, &size);
+    }
+
+    TPassItem *items;       // the passes of the satellites this worker claimed
+    int       count, size;
+    bool      failed;
+
+private:
+    TPassPool  *pool;
+    QAtomicInt *next;
+};
+
+//---------------------------------------------------------------------------
+static int compareAOS(const void *a, const void *b)
+{
+    double d = ((const TPassItem *) a)->pass.aos - ((const TPassItem *) b)->pass.aos;
+
+    return d < 0 ? -1:(d > 0 ? 1:0);
+}
+
+//---------------------------------------------------------------------------
+TPassPool::TPassPool(void)
+{
+    sats = new PList;
+
+    thresholds = false;
+    threshold = aos_elev = los_elev = 0;
+
+    first_dn = last_dn = 0;
+    max_passes = 0;
+    stopped = NULL;
+}
+
+//---------------------------------------------------------------------------
+TPassPool::~TPassPool(void)
+{
+    clear();
+
+    delete sats;
+}
+
+//---------------------------------------------------------------------------
+void TPassPool::clear(void)
+{
+    TSat *sat;
+
+    while(sats->Count) {
+        sat = (TSat *) sats->ItemAt(0);
+        sats->Delete(0);
+        delete sat;
+    }
+}
+
+//---------------------------------------------------------------------------
+// copies the active satellites of satList, call it from the GUI thread
+void TPassPool::add(PList *satList)
+{
+    TSat *sat;
+    int  i;
+
+    for(i=0; i<satList->Count; i++) {
+        sat = (TSat *) satList->ItemAt(i);
+        if(sat->isActive())
+            sats->Add(new TSat(sat));
+    }
+}
+
+//---------------------------------------------------------------------------
+// see TSat::CheckThresholds
+void TPassPool::setThresholds(TRig *rig)
+{
+    thresholds = rig->passthresholds() && rig->pass_elev >= 1;
+    threshold  = rig->threshold;
+    aos_elev   = rig->aos_elev;
+    los_elev   = rig->los_elev;
+}
+
+//---------------------------------------------------------------------------
+int TPassPool::count(void)
+{
+    return sats->Count;
+}
+
+//---------------------------------------------------------------------------
+int TPassPool::threads(void)
+{
+    int n = QThread::idealThreadCount();
+
+    return n < 1 ? 1:(n > PASSPOOL_MAX_THREADS ? PASSPOOL_MAX_THREADS:n);
+}
+
+//---------------------------------------------------------------------------
+// The passes in range between first and last, at most max_passes of each
+// satellite unless it is 0. Blocks until all are predicted, *list is sorted
+// by AOS and must be freed with free(). -1 if stopped is set meanwhile or
+// the memory runs out.
+int TPassPool::predict(double first, double last, int max_passes_, TPassItem **list,
+                       volatile bool *stopped_)
+{
+    TRACE_SCOPE("TPassPool::predict");
+    TPassWorker *workers[PASSPOOL_MAX_THREADS];
+    QAtomicInt  next(0);
+    TPassItem   *items;
+    bool        failed;
+    int         i, n, size, nthreads;
+
+    *list = NULL;
+
+    first_dn   = first;
+    last_dn    = last;
+    max_passes = max_passes_;
+    stopped    = stopped_;
+
+    items  = NULL;
+    n      = size = 0;
+    failed = false;
+
+    nthreads = threads();
+    if(nthreads > sats->Count)
+        nthreads = sats->Count;
+
+    if(nthreads <= 1) {
+        for(i=0; i<sats->Count && !failed && !isStopped(); i++)
+            failed = !predictSat((TSat *) sats->ItemAt(i), &items, &n, &size);
+    }
+    else {
+        for(i=0; i<nthreads; i++) {
+            workers[i] = new TPassWorker(this, &next);
+            workers[i]->start();
+        }
+
+        for(i=0; i<nthreads; i++) {
+            workers[i]->wait();
+
+            n += workers[i]->count;
+            if(workers[i]->failed)
+                failed = true;
+        }
+
+        // merge
+        if(!failed && n && (items = (TPassItem *) malloc(n * sizeof(TPassItem))) == NULL) {
+            qDebug("Failed to allocate %d passes %s:%d", n, __FILE__, __LINE__);
+            failed = true;
+        }
+
+        for(n=0, i=0; i<nthreads; i++) {
+            if(items && workers[i]->count)
+                memcpy(items + n, workers[i]->items, workers[i]->count * sizeof(TPassItem));
+
+            n += workers[i]->count;
+            delete workers[i];
+        }
+    }
+
+    if(failed || isStopped()) {
+        if(items)
+            free(items);
+
+        return -1;
+    }
+
+    if(n > 1)
+        qsort(items, n, sizeof(TPassItem), compareAOS);
+
+    *list = items;
+
+    return n;
+}
+
+//---------------------------------------------------------------------------
+// appends the passes of sat to *list, false if the memory runs out
+bool TPassPool::predictSat(TSat *sat, TPassItem **list, int *n, int *size)
+{
+    TRACE_SCOPE("TPassPool::predictSat");
+    TPassItem *tmp;
+    pass_t    pass;
+    double    dn = first_dn;
+    int       passes = 0;
+
+    // geostationary, decayed or never rising, see TSat::CalcAll
+    if(!sat->CanCalc(sat->obs_geodetic.lat, dn, 1))
+        return true;
+
+    while(!isStopped() && (max_passes <= 0 || passes < max_passes) &&
+          sat->FindPass(dn, &pass) && pass.aos < last_dn) {
+        if(*n == *size) {
+            *size = *size ? *size << 1:256;
+            tmp = (TPassItem *) realloc(*list, *size * sizeof(TPassItem));
+            if(tmp == NULL) {
+                qDebug("Failed to allocate %d passes %s:%d", *size, __FILE__, __LINE__);
+                return false;
+            }
+            *list = tmp;
+        }
+
+        fill(sat, &pass, &(*list)[(*n)++]);
+        passes++;
+
+        dn = pass.los + PASS_SKIP;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// direction and recording thresholds, as CalcAll and CheckThresholds
+void TPassPool::fill(TSat *sat, const pass_t *pass, TPassItem *item)
+{
+    double lat;
+    int    aos, los;
+
+    strcpy(item->name, sat->name);
+    item->pass = *pass;
+    item->priority = sat->sat_scripts->priority();
+    item->min_elevation = sat->sat_scripts->min_elevation();
+
+    lookAt(sat, pass->aos, &item->aos_az, &item->aos_el);
+    lat = sat->sat_lat;
+
+    lookAt(sat, pass->los, &item->los_az, &item->los_el);
+    item->northbound = lat < sat->sat_lat ? true:false;
+
+    sat->SetPass(pass, item->northbound);
+
+    if(!thresholds)
+        return;
+
+    if(threshold == AOS_LOS) {
+        aos = aos_elev;
+        los = los_elev;
+    }
+    else { // North/South definition
+        aos = item->northbound ? los_elev:aos_elev;
+        los = item->northbound ? aos_elev:los_elev;
+    }
+
+    item->pass.rec_aos = sat->FindAOSElevation(aos);
+    item->pass.rec_los = sat->FindLOSElevation(los);
+
+    if(item->pass.rec_aos > 0)
+        lookAt(sat, item->pass.rec_aos, &item->aos_az, &item->aos_el);
+    if(item->pass.rec_los > 0)
+        lookAt(sat, item->pass.rec_los, &item->los_az, &item->los_el);
+}
+
+//---------------------------------------------------------------------------
+void TPassPool::lookAt(TSat *sat, double dn, double *az, double *el)
+{
+    sat->daynum = dn;
+    sat->Calc();
+
+    *az = sat->sat_azi;
+    *el = sat->sat_ele;
+}
+
+//---------------------------------------------------------------------------
+// the first pass of the satellite name in range at dn or after it, list
+// sorted by AOS, NULL if there is none
+TPassItem *TPassPool::find(TPassItem *list, int n, const char *name, double dn)
+{
+    int i;
+
+    for(i=0; i<n; i++)
+        if(list[i].pass.los > dn && strcmp(list[i].name, name) == 0)
+            return &list[i];
+
+    return NULL;
+}
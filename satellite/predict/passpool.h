@@ -0,0 +1,88 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef PASSPOOL_H
+#define PASSPOOL_H
+
+#include "Satellite.h"
+
+//---------------------------------------------------------------------------
+#define PASSPOOL_MAX_THREADS    16
+
+class PList;
+class TRig;
+class TPassWorker;
+
+//---------------------------------------------------------------------------
+typedef struct TPassItem_t
+{
+    char   name[TLE_NAMELEN+1];
+    pass_t pass;        // rec_aos and rec_los with the pass thresholds of the rig
+    bool   northbound;
+    double aos_az, aos_el;  // where the satellite is at rec_aos and rec_los
+    double los_az, los_el;
+    int    priority, min_elevation; // see TSatScript
+} TPassItem;
+
+//---------------------------------------------------------------------------
+// Predicts the passes of a set of satellites on worker threads. The pool
+// owns copies of the satellites and a worker claims one satellite at a
+// time, so the copies are never shared. The passes of the workers are
+// merged and sorted by AOS once all of them are done.
+class TPassPool
+{
+    friend class TPassWorker;
+
+public:
+    TPassPool(void);
+    ~TPassPool(void);
+
+    void clear(void);
+    void add(PList *satList);
+    void setThresholds(TRig *rig);
+    int  count(void);
+
+    int  predict(double first, double last, int max_passes, TPassItem **list,
+                 volatile bool *stopped = NULL);
+
+    static int       threads(void);
+    static TPassItem *find(TPassItem *list, int n, const char *name, double dn);
+
+protected:
+    bool predictSat(TSat *sat, TPassItem **list, int *n, int *size);
+    void fill(TSat *sat, const pass_t *pass, TPassItem *item);
+    void lookAt(TSat *sat, double dn, double *az, double *el);
+
+    bool isStopped(void) { return stopped && *stopped; }
+
+private:
+    PList  *sats;           // copies of the active satellites
+    bool   thresholds;
+    int    threshold, aos_elev, los_elev;
+
+    // the current predict()
+    double first_dn, last_dn;
+    int    max_passes;
+    volatile bool *stopped;
+};
+
+#endif // PASSPOOL_H
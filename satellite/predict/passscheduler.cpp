@@ -0,0 +1,260 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <math.h>
+
+#include "passscheduler.h"
+#include "rig.h"
+#include "rotor.h"
+#include "utils.h"
+#include "trace.h"
+
+//---------------------------------------------------------------------------
+typedef struct TPlanNode_t
+{
+    double start, end;      // rec_aos and LOS of the pass
+    double worth;           // of the best plan that ends with this pass
+    int    item, prev;      // prev is the node before in that plan, or -1
+} TPlanNode;
+
+//---------------------------------------------------------------------------
+static int compareEnd(const void *a, const void *b)
+{
+    double d = ((const TPlanNode *) a)->end - ((const TPlanNode *) b)->end;
+
+    return d < 0 ? -1:(d > 0 ? 1:0);
+}
+
+//---------------------------------------------------------------------------
+// the number of nodes 0 ... n-1 that end at dn or before it
+static int endedBy(const TPlanNode *nodes, int n, double dn)
+{
+    int lo = 0, hi = n, mid;
+
+    while(lo < hi) {
+        mid = (lo + hi) >> 1;
+
+        if(nodes[mid].end <= dn)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+//---------------------------------------------------------------------------
+TPassScheduler::TPassScheduler(void)
+{
+    rotor = xy = zenith = false;
+    az_max = az_min = el_max = el_min = 0;
+    az_speed = el_speed = 0;
+    thresholds = false;
+    pass_elev = 0;
+    slew_max = 0;
+}
+
+//---------------------------------------------------------------------------
+// see TSat::CheckThresholds and TrackThread::run
+void TPassScheduler::setRig(TRig *rig)
+{
+    thresholds = rig->passthresholds() && rig->pass_elev >= 1;
+    pass_elev  = rig->pass_elev;
+
+    rotor    = rig->rotor->enable();
+    xy       = rig->rotor->isXY();
+    zenith   = rig->rotor->turnElOnlyWhenZenith();
+    az_max   = rig->rotor->az_max;
+    az_min   = rig->rotor->az_min;
+    el_max   = rig->rotor->el_max;
+    el_min   = rig->rotor->el_min;
+    az_speed = rig->rotor->az_speed;
+    el_speed = rig->rotor->el_speed;
+    slew_max = 0;
+
+    // corner to corner, rotorPosition clips to the limits
+    if(rotor && xy)
+        slew_max = MAX(180.0 * az_speed, 180.0 * el_speed) / 86400000.0;
+    else if(rotor)
+        slew_max = MAX(fabs(az_max - az_min) * az_speed,
+                       fabs(el_max - el_min) * el_speed) / 86400000.0;
+}
+
+//---------------------------------------------------------------------------
+bool TPassScheduler::recordable(const TPassItem *item)
+{
+    if(item->pass.rec_aos <= 0 || item->pass.rec_los <= 0)
+        return false;
+
+    if(item->pass.max_ele < item->min_elevation)
+        return false;
+
+    if(thresholds && item->pass.max_ele < pass_elev)
+        return false;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+double TPassScheduler::weight(const TPassItem *item)
+{
+    return item->priority + item->pass.max_ele / 90.0;
+}
+
+//---------------------------------------------------------------------------
+// days from the end of one recording to the start of the next
+// see TRotor::getRotationTime
+double TPassScheduler::slew(const TPassItem *from, const TPassItem *to)
+{
+    double x1, y1, x2, y2;
+
+    if(!rotor)
+        return 0;
+
+    rotorPosition(from, true, &x1, &y1);
+    rotorPosition(to, false, &x2, &y2);
+
+    return MAX(fabs(x1 - x2) * az_speed, fabs(y1 - y2) * el_speed) / 86400000.0;
+}
+
+//---------------------------------------------------------------------------
+// The rotor position at the AOS or LOS of item, the pass sets the CCW or
+// zenith pass mode as in TRotor::setCCWFlag. On a zenith pass the rotor is
+// turned over once the satellite recedes, see TrackThread::run, and the
+// position is clipped to the limits and made XY as in TRotor::moveTo.
+void TPassScheduler::rotorPosition(const TPassItem *item, bool los, double *x, double *y)
+{
+    double az = los ? item->los_az:item->aos_az;
+    double el = los ? item->los_el:item->aos_el;
+
+    if(zenith && item->pass.max_ele > 87) {
+        if(los) {
+            az -= 180.0;
+            el = 180.0 - el;
+        }
+    }
+    else if(!xy && el_max > 90 && fabs(item->aos_az - item->los_az) > 185) {
+        az += 180.0;
+        el = 180.0 - el;
+    }
+
+    if(az > 360)
+        az -= 360.0;
+    if(az < 0)
+        az += 360.0;
+
+    *x = ClipValue(az, az_max, az_min);
+    *y = ClipValue(el, el_max, el_min);
+
+    if(xy)
+        TRotor::AzEltoXY(*x, *y, x, y);
+}
+
+//---------------------------------------------------------------------------
+// Weighted interval scheduling over the n passes of items that end after
+// from. The nodes are sorted by their end, so every pass that may come
+// before a node is one of the nodes before it. Of those that ended slew_max
+// before its start, whichever slew they need, the best plan is kept as a
+// running maximum and the rest are checked one by one. *plan is sorted by
+// AOS and must be freed with free(), -1 if the memory runs out.
+int TPassScheduler::schedule(const TPassItem *items, int n, double from, TPassItem **plan)
+{
+    TRACE_SCOPE("TPassScheduler::schedule");
+    TPlanNode *nodes, *node;
+    double    worth;
+    int       *best;    // the node of the best plan among nodes 0 ... i
+    int       i, j, m;
+
+    *plan = NULL;
+
+    if(n <= 0)
+        return 0;
+
+    nodes = (TPlanNode *) malloc(n * sizeof(TPlanNode));
+    best  = (int *) malloc(n * sizeof(int));
+
+    if(nodes == NULL || best == NULL) {
+        qDebug("Failed to allocate %d plan nodes %s:%d", n, __FILE__, __LINE__);
+
+        if(nodes)
+            free(nodes);
+        if(best)
+            free(best);
+
+        return -1;
+    }
+
+    for(m=0, i=0; i<n; i++) {
+        if(items[i].pass.los <= from || !recordable(&items[i]))
+            continue;
+
+        nodes[m].start = items[i].pass.rec_aos;
+        nodes[m].end   = items[i].pass.los;
+        nodes[m].item  = i;
+        m++;
+    }
+
+    qsort(nodes, m, sizeof(TPlanNode), compareEnd);
+
+    for(i=0; i<m; i++) {
+        node  = &nodes[i];
+        worth = 0;
+        node->prev = -1;
+
+        j = endedBy(nodes, i, node->start - slew_max);
+
+        if(j > 0) {
+            node->prev = best[j-1];
+            worth = nodes[node->prev].worth;
+        }
+
+        for(; j<i && nodes[j].end <= node->start; j++)
+            if(nodes[j].worth > worth &&
+               nodes[j].end + slew(&items[nodes[j].item], &items[node->item]) <= node->start) {
+                node->prev = j;
+                worth = nodes[j].worth;
+            }
+
+        node->worth = worth + weight(&items[node->item]);
+        best[i] = i && nodes[best[i-1]].worth >= node->worth ? best[i-1]:i;
+    }
+
+    // back from the last pass of the best plan
+    n = 0;
+    for(i=m ? best[m-1]:-1; i>=0; i=nodes[i].prev)
+        n++;
+
+    if(n && (*plan = (TPassItem *) malloc(n * sizeof(TPassItem))) == NULL) {
+        qDebug("Failed to allocate %d planned passes %s:%d", n, __FILE__, __LINE__);
+        n = -1;
+    }
+
+    if(*plan)
+        for(j=n, i=best[m-1]; i>=0; i=nodes[i].prev)
+            (*plan)[--j] = items[nodes[i].item];
+
+    free(nodes);
+    free(best);
+
+    return n;
+}
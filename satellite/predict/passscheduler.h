@@ -0,0 +1,65 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef PASSSCHEDULER_H
+#define PASSSCHEDULER_H
+
+#include "passpool.h"
+
+class TRig;
+
+//---------------------------------------------------------------------------
+// The recording plan over a list of passes. A pass is worth the priority of
+// its satellite plus up to one for its maximum elevation, so a pass of a
+// higher priority satellite wins over a higher one, while two passes may
+// outweigh a single one. The plan is the set of passes of the largest total
+// worth that the tracker can record one after the other, it is free again at
+// LOS and then needs the rotor rotation time from the last position to the
+// next AOS, both in rotor coordinates. Passes below the pass threshold of the rig or the minimum
+// elevation of their satellite are left out.
+class TPassScheduler
+{
+public:
+    TPassScheduler(void);
+
+    void setRig(TRig *rig);
+    int  schedule(const TPassItem *items, int n, double from, TPassItem **plan);
+
+protected:
+    bool   recordable(const TPassItem *item);
+    double weight(const TPassItem *item);
+    double slew(const TPassItem *from, const TPassItem *to);
+    void   rotorPosition(const TPassItem *item, bool los, double *x, double *y);
+
+private:
+    // copied from the TRotor of the rig, the track thread changes its flags
+    bool   rotor;           // false if it is not enabled
+    bool   xy, zenith;      // XY rotor, turn elevation only on zenith passes
+    double az_max, az_min, el_max, el_min;
+    int    az_speed, el_speed;
+
+    bool   thresholds;
+    int    pass_elev;
+    double slew_max;        // days
+};
+
+#endif // PASSSCHEDULER_H
@@ -0,0 +1,375 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <QDateTime>
+#include <stdlib.h>
+
+#include "passtimeline.h"
+#include "utils.h"
+#include "trace.h"
+
+//---------------------------------------------------------------------------
+TPassTimeline::TPassTimeline(QObject *parent) : QThread(parent)
+{
+    pool = new TPassPool;
+    scheduler = new TPassScheduler;
+    items = NULL;
+    latest = NULL;
+    count = 0;
+    plan = NULL;
+    plan_count = -1;
+    first_dn = last_dn = from = until = 0;
+    queued = false;
+    ready = false;
+    stopped = false;
+}
+
+//---------------------------------------------------------------------------
+TPassTimeline::~TPassTimeline(void)
+{
+    stop();
+    clear();
+
+    delete pool;
+    delete scheduler;
+}
+
+//---------------------------------------------------------------------------
+// blocks until the thread has ended
+void TPassTimeline::stop(void)
+{
+    lock.lock();
+    stopped = true;
+    lock.unlock();
+
+    wait();
+}
+
+//---------------------------------------------------------------------------
+// the thread must not be running
+void TPassTimeline::clear(void)
+{
+    pool->clear();
+
+    lock.lock();
+
+    if(items)
+        free(items);
+    if(latest)
+        free(latest);
+    if(plan)
+        free(plan);
+
+    items = NULL;
+    latest = NULL;
+    count = 0;
+    plan = NULL;
+    plan_count = -1;
+    ready = false;
+
+    lock.unlock();
+}
+
+//---------------------------------------------------------------------------
+// called from the GUI thread, satList and rig are only read here
+void TPassTimeline::invalidate(PList *satList, TRig *rig)
+{
+    stop();
+    clear();
+
+    pool->add(satList);
+    pool->setThresholds(rig);
+    scheduler->setRig(rig);
+
+    if(pool->count() == 0)
+        return;
+
+    lock.lock();
+    stopped = false;
+    queue(GetStartTime(QDateTime::currentDateTime().toUTC()), 0);
+    lock.unlock();
+}
+
+//---------------------------------------------------------------------------
+// the thread predicts first..last, at least TIMELINE_DAYS, once it is done
+// with the current window, lock is held
+void TPassTimeline::queue(double first_, double last)
+{
+    from  = first_;
+    until = last > from + TIMELINE_DAYS ? last:from + TIMELINE_DAYS;
+
+    if(isRunning())
+        queued = true;
+    else
+        start(QThread::IdlePriority);
+}
+
+//---------------------------------------------------------------------------
+// moves the window on once it began TIMELINE_ROLL days ago, or back to
+// now after request() moved it ahead. The passes predicted before are
+// used until the new ones are ready
+void TPassTimeline::roll(void)
+{
+    double dn = GetStartTime(QDateTime::currentDateTime().toUTC());
+
+    lock.lock();
+
+    if(!stopped && ready && (dn < first_dn || dn > first_dn + TIMELINE_ROLL) && !isRunning())
+        queue(dn, 0);
+
+    lock.unlock();
+}
+
+//---------------------------------------------------------------------------
+// called from the GUI thread instead of predicting the passes of all the
+// satellites there. The window is extended to cover first..last, or moved
+// to it if that is more than TIMELINE_MAX_DAYS ahead, and finished() is
+// emitted when the passes are ready. False if they are ready already or
+// there are no satellites
+bool TPassTimeline::request(double first_, double last)
+{
+    double dn = GetStartTime(QDateTime::currentDateTime().toUTC());
+    bool   rc = false;
+
+    lock.lock();
+
+    if(!stopped && pool->count() > 0 && !(ready && first_ >= first_dn && last <= last_dn)) {
+        rc = true;
+
+        // being predicted already
+        if(!(isRunning() && first_ >= from && last <= until)) {
+            if(first_ > dn && last < dn + TIMELINE_MAX_DAYS)
+                first_ = dn;
+
+            queue(first_, last);
+        }
+    }
+
+    lock.unlock();
+
+    return rc;
+}
+
+//---------------------------------------------------------------------------
+// the first item that may be in range at dn or after it, lock is held
+int TPassTimeline::first(double dn)
+{
+    int lo = 0, hi = count, mid;
+
+    while(lo < hi) {
+        mid = (lo + hi) >> 1;
+
+        if(latest[mid] > dn)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return lo;
+}
+
+//---------------------------------------------------------------------------
+// true if the passes between first and last have been predicted
+bool TPassTimeline::covers(double first_, double last)
+{
+    bool rc;
+
+    lock.lock();
+    rc = ready && first_ >= first_dn && last <= last_dn;
+    lock.unlock();
+
+    return rc;
+}
+
+//---------------------------------------------------------------------------
+// the pass of sat in range at dn or the next one, see TSat::CalcAll
+bool TPassTimeline::assign(TSat *sat, double dn)
+{
+    TPassItem *item;
+    bool rc = false;
+    int  i;
+
+    lock.lock();
+
+    if(ready && dn >= first_dn && dn < last_dn) {
+        i = first(dn);
+
+        if((item = TPassPool::find(items + i, count - i, sat->name, dn))) {
+            sat->SetPass(&item->pass, item->northbound);
+            rc = true;
+        }
+    }
+
+    lock.unlock();
+
+    if(!rc)
+        roll();
+
+    return rc;
+}
+
+//---------------------------------------------------------------------------
+// 1 and the first pass of the recording plan whose LOS is after dn, see
+// TPassScheduler. 0 if the plan has no more passes, -1 if there is no plan
+// yet or dn is outside the window
+int TPassTimeline::planned(double dn, TPassItem *item)
+{
+    int rc = -1, i;
+
+    lock.lock();
+
+    if(ready && plan_count >= 0 && dn >= first_dn && dn < last_dn) {
+        rc = 0;
+
+        for(i=0; i<plan_count; i++)
+            if(plan[i].pass.los > dn) {
+                *item = plan[i];
+                rc = 1;
+                break;
+            }
+    }
+
+    lock.unlock();
+
+    if(rc <= 0)
+        roll();
+
+    return rc;
+}
+
+//---------------------------------------------------------------------------
+// the passes in range between first and last sorted by AOS, *list must be
+// freed with free(), -1 if they are not ready or outside the window
+int TPassTimeline::passes(double first_, double last, TPassItem **list)
+{
+    int i, n;
+
+    *list = NULL;
+
+    lock.lock();
+
+    if(!ready || first_ < first_dn || last > last_dn) {
+        lock.unlock();
+        roll();
+
+        return -1;
+    }
+
+    for(n=0, i=first(first_); i<count && items[i].pass.aos < last; i++)
+        if(items[i].pass.los > first_)
+            n++;
+
+    if(n && (*list = (TPassItem *) malloc(n * sizeof(TPassItem))) == NULL) {
+        qDebug("Failed to allocate %d passes %s:%d", n, __FILE__, __LINE__);
+        n = 0;
+    }
+
+    if(*list)
+        for(n=0, i=first(first_); i<count && items[i].pass.aos < last; i++)
+            if(items[i].pass.los > first_)
+                (*list)[n++] = items[i];
+
+    lock.unlock();
+
+    return n;
+}
+
+//---------------------------------------------------------------------------
+// until request() or roll() stop moving the window
+void TPassTimeline::run(void)
+{
+    double first_, last;
+
+    lock.lock();
+
+    do {
+        first_ = from;
+        last   = until;
+        queued = false;
+
+        lock.unlock();
+        predict(first_, last);
+        lock.lock();
+    } while(!stopped && queued);
+
+    lock.unlock();
+}
+
+//---------------------------------------------------------------------------
+// the passes and the plan of first..last replace the ones before
+void TPassTimeline::predict(double first_, double last)
+{
+    TRACE_SCOPE("TPassTimeline::predict");
+    TPassItem *list, *sched, *tmp;
+    double    *late;
+    int       i, n, m;
+
+    late  = NULL;
+    sched = NULL;
+    m     = 0;
+
+    n = pool->predict(first_, last, 0, &list, &stopped);
+
+    if(n > 0 && (late = (double *) malloc(n * sizeof(double))) == NULL) {
+        qDebug("Failed to allocate %d passes %s:%d", n, __FILE__, __LINE__);
+        n = -1;
+    }
+
+    for(i=0; i<n; i++)
+        late[i] = i && late[i-1] > list[i].pass.los ? late[i-1]:list[i].pass.los;
+
+    // without a plan getNextSat selects the passes itself
+    if(n > 0 && !stopped)
+        m = scheduler->schedule(list, n, first_, &sched);
+
+    lock.lock();
+
+    if(!stopped && n >= 0) {
+        tmp = items;
+        items = list;
+        list = tmp;
+
+        if(latest)
+            free(latest);
+        latest = late;
+        late = NULL;
+
+        tmp = plan;
+        plan = sched;
+        sched = tmp;
+        plan_count = m;
+
+        count = n;
+        first_dn = first_;
+        last_dn = last;
+        ready = true;
+    }
+
+    lock.unlock();
+
+    if(list)
+        free(list);
+    if(late)
+        free(late);
+    if(sched)
+        free(sched);
+}
@@ -0,0 +1,92 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef PASSTIMELINE_H
+#define PASSTIMELINE_H
+
+#include <QThread>
+#include <QMutex>
+
+#include "passpool.h"
+#include "passscheduler.h"
+
+//---------------------------------------------------------------------------
+#define TIMELINE_DAYS      7    // passes are predicted this many days ahead
+#define TIMELINE_ROLL      1    // days, then the window is moved on
+#define TIMELINE_MAX_DAYS  31   // a request further out moves the window instead
+
+class PList;
+class TRig;
+
+//---------------------------------------------------------------------------
+// The passes of the active satellites over a rolling window of TIMELINE_DAYS,
+// predicted by a TPassPool on a thread of its own and sorted by AOS, and the
+// recording plan of a TPassScheduler over them. The pool works on copies of
+// the satellites, invalidate() takes new ones and must be called when the
+// TLEs, the active satellites, their priorities, the station or the rig
+// change. Until the passes are ready, and outside the window, the queries
+// fail. request() moves the window, the caller gets finished() once the
+// passes are ready and meanwhile predicts the passes of a satellite itself.
+class TPassTimeline : public QThread
+{
+public:
+    TPassTimeline(QObject *parent = 0);
+    ~TPassTimeline(void);
+
+    void invalidate(PList *satList, TRig *rig);
+    void roll(void);
+    void stop(void);
+    bool request(double first, double last);
+
+    bool covers(double first, double last);
+    bool assign(TSat *sat, double dn);
+    int  passes(double first, double last, TPassItem **list);
+    int  planned(double dn, TPassItem *item);
+
+protected:
+    void run(void);
+    void predict(double first, double last);
+
+    void clear(void);
+    void queue(double first, double last);
+    int  first(double dn);
+
+private:
+    QMutex lock;
+
+    TPassPool      *pool;
+    TPassScheduler *scheduler;
+    double         from, until; // what the thread predicts next
+    bool           queued;      // from..until changed while it was running
+
+    TPassItem *items;       // sorted by AOS
+    double    *latest;      // the latest LOS of items 0..i
+    int       count;
+    TPassItem *plan;        // sorted by AOS
+    int       plan_count;   // -1 without a plan
+    double    first_dn, last_dn;
+    bool      ready;
+
+    volatile bool stopped;
+};
+
+#endif // PASSTIMELINE_H
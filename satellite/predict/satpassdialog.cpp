@@ -23,6 +23,7 @@
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QDate>
+#include <stdlib.h>
 
 #include "satpassdialog.h"
 #include "ui_satpassdialog.h"
@@ -30,6 +31,7 @@
 #include "mainwindow.h"
 #include "plist.h"
 #include "Satellite.h"
+#include "passtimeline.h"
 #include "satutil.h"
 #include "utils.h"
 #include "rig.h"
@@ -51,6 +53,10 @@ satpassdialog::satpassdialog(PList *_satList, QWidget *parent) :
 
     mw = (MainWindow *) parent;
     satList = _satList;
+    waiting = false;
+
+    // the timeline thread may still be predicting, see on_activeSatBtn_clicked
+    connect(mw->getTimeline(), SIGNAL(finished()), this, SLOT(timelineFinished()));
 
     flags = 0;
     for(i=0; i<satList->Count; i++) {
@@ -102,25 +108,51 @@ void satpassdialog::on_activeSatBtn_clicked()
     QDateTime      utc  = getSelectedUTC();
     TRig           *rig = mw->getRig();
     TSat           *sat;
-    int            i;
+    TPassItem      *list;
+    double         first, last;
+    int            i, n;
 
     QApplication::setOverrideCursor(Qt::WaitCursor);
 
     m_ui->tableWidget->setSortingEnabled(false);
     clearGrid(m_ui->tableWidget);
 
-    for(i=0; i<satList->Count; i++) {
-        sat = (TSat *) satList->ItemAt(i);
-        if(sat->isActive())
-            sat->SatellitePasses(rig, m_ui->tableWidget, utc, 1);
+    // the passes from utc to the end of the local day, see TSat::SatellitePasses
+    first = GetStartTime(utc);
+    last  = GetStartTime(QDateTime(utc.toLocalTime().date().addDays(1)).toUTC());
+
+    n = mw->getTimeline()->passes(first, last, &list);
+
+    // still predicting or outside the window, the timeline predicts the
+    // day and the passes are shown when it is done
+    waiting = n < 0 && mw->getTimeline()->request(first, last);
+
+    for(i=0; i<n; i++) {
+        sat = getSat(satList, list[i].name);
+        if(sat == NULL || !sat->isActive())
+            continue;
+
+        sat->SetPass(&list[i].pass, list[i].northbound);
+        sat->AddPassToGrid(rig, m_ui->tableWidget);
     }
 
+    if(list)
+        free(list);
+
     m_ui->tableWidget->setSortingEnabled(true);
     m_ui->tableWidget->sortItems(AOS_COL_NR);
 
     QApplication::restoreOverrideCursor();
 }
 
+//---------------------------------------------------------------------------
+// queued from the timeline thread, unless a satellite was selected meanwhile
+void satpassdialog::timelineFinished(void)
+{
+    if(waiting)
+        on_activeSatBtn_clicked();
+}
+
 //---------------------------------------------------------------------------
 void satpassdialog::on_timecheckBox_clicked()
 {
@@ -166,6 +198,8 @@ void satpassdialog::on_satListWidget_currentItemChanged(QListWidgetItem* current
     if(sat == NULL)
         return;
 
+    waiting = false;
+
     QApplication::setOverrideCursor(Qt::WaitCursor);
 
     m_ui->tableWidget->setSortingEnabled(false);
@@ -64,8 +64,10 @@ private:
     Ui::satpassdialog *m_ui;
     PList *satList;
     MainWindow *mw;
+    bool waiting; // for the timeline to show the active satellites
 
 private slots:
+    void timelineFinished(void);
     void on_satListWidget_itemClicked(QListWidgetItem* item);
     void on_dateEdit_dateChanged(QDate date);
     void on_timecheckBox_clicked();
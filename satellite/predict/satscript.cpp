@@ -54,6 +54,8 @@ TSatScript::TSatScript(void)
     _postproc_script_args = new QStringList;
 
     _flags = 0;
+    _priority = SS_DEFAULT_PRIORITY;
+    _min_elevation = 0;
 
     constants = NULL;
     commands  = NULL;
@@ -72,6 +74,8 @@ TSatScript::TSatScript(const TSatScript& src)
     _postproc_script_args = new QStringList(src.postproc_script_args());
 
     _flags = src.flags();
+    _priority = src.priority();
+    _min_elevation = src.min_elevation();
 
     constants = NULL;
     commands  = NULL;
@@ -122,6 +126,8 @@ TSatScript& TSatScript::operator = (const TSatScript& src)
     _postproc_script_args->append(src.postproc_script_args());
 
     _flags = src.flags();    
+    _priority = src.priority();
+    _min_elevation = src.min_elevation();
 
     free_private();
 
@@ -173,6 +179,8 @@ void TSatScript::zero(void)
     _postproc_script_args->clear();
 
     _flags = 0;
+    _priority = SS_DEFAULT_PRIORITY;
+    _min_elevation = 0;
 
     free_private();
 }
@@ -213,6 +221,8 @@ void TSatScript::readSettings(QSettings *reg, int modes)
 
     downlink(reg->value("Downlink", "").toString());
     flags(reg->value("Flags", 0).toInt());
+    priority(reg->value("Priority", SS_DEFAULT_PRIORITY).toInt());
+    min_elevation(reg->value("MinElevation", 0).toInt());
 
     reg->beginGroup("RX");
       rx_script(reg->value("Script", "").toString());
@@ -242,6 +252,8 @@ void TSatScript::writeSettings(QSettings *reg, int /*modes*/)
 
     reg->setValue("Downlink", _downlink);
     reg->setValue("Flags", _flags);
+    reg->setValue("Priority", _priority);
+    reg->setValue("MinElevation", _min_elevation);
 
     reg->beginGroup("RX");
       reg->setValue("Script", _rx_script);
@@ -35,6 +35,9 @@
 #define SS_ENABLE_DC                    4
 #define SS_SAT_ACTIVE                   8
 
+#define SS_DEFAULT_PRIORITY             1   // 1 ... SS_MAX_PRIORITY
+#define SS_MAX_PRIORITY                 10
+
 //---------------------------------------------------------------------------
 class QSettings;
 
@@ -59,6 +62,12 @@ public:
     QString downlink(void) const;
     void    downlink(const QString& dl) { _downlink = dl; }
 
+    // recording plan, see TPassScheduler
+    int  priority(void) const          { return _priority; }
+    void priority(int priority_)       { _priority = priority_; }
+    int  min_elevation(void) const     { return _min_elevation; }
+    void min_elevation(int elevation)  { _min_elevation = elevation; }
+
     bool         rx_srcrip_enable(void)                  { return flag(SS_ENABLE_REC_SCRIPT); }
     void         rx_srcrip_enable(bool enable)           { flag(SS_ENABLE_REC_SCRIPT, enable); }
     QString      rx_script(void) const                   { return _rx_script; }
@@ -115,6 +124,7 @@ private:
     QString     _rx_script, _postproc_script;
     QStringList *_rx_script_args, *_postproc_script_args;
     int         _flags;
+    int         _priority, _min_elevation;
 
     QString     _frames_filename, _baseband_filename;
     QStringList *constants, *commands;
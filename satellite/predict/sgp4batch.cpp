@@ -0,0 +1,732 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+#include "sgp4batch.h"
+#include "satcalc.h"
+#include "trace.h"
+
+//---------------------------------------------------------------------------
+// The kernel is written once over a lane type, double is one lane and the
+// C library sin and cos. The vector types hold SGP4_LANES doubles, their
+// sin and cos are the Cephes polynomials.
+#define SGP4_STATE  7 // x, y, z, vx, vy, vz, phase
+
+static inline double vsqrt(double a) { return sqrt(a); }
+static inline double vabs(double a) { return fabs(a); }
+static inline double vfloor(double a) { return floor(a); }
+static inline double vtrunc(double a) { return (double) ((int) a); }
+static inline double vlt(double a, double b) { return a < b ? 1.0:0.0; }
+static inline double vle(double a, double b) { return a <= b ? 1.0:0.0; }
+static inline double vor(double a, double b) { return a != 0.0 || b != 0.0 ? 1.0:0.0; }
+static inline double vselect(double m, double a, double b) { return m != 0.0 ? a:b; }
+static inline bool   vall(double m) { return m != 0.0; }
+static inline void   vstore(double *p, double a) { *p = a; }
+static inline void   vsincos(double a, double *s, double *c) { *s = sin(a); *c = cos(a); }
+
+template <class V> static inline V vload(const double *p);
+template <> inline double vload<double>(const double *p) { return *p; }
+
+#if defined(__AVX2__)
+#define SGP4_LANES  4
+
+struct vdouble
+{
+    __m256d v;
+
+    vdouble(void) {}
+    vdouble(double d) { v = _mm256_set1_pd(d); }
+    vdouble(__m256d v_) { v = v_; }
+};
+
+static inline vdouble operator + (vdouble a, vdouble b) { return _mm256_add_pd(a.v, b.v); }
+static inline vdouble operator - (vdouble a, vdouble b) { return _mm256_sub_pd(a.v, b.v); }
+static inline vdouble operator * (vdouble a, vdouble b) { return _mm256_mul_pd(a.v, b.v); }
+static inline vdouble operator / (vdouble a, vdouble b) { return _mm256_div_pd(a.v, b.v); }
+static inline vdouble operator - (vdouble a) { return _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)); }
+
+static inline vdouble vsqrt(vdouble a) { return _mm256_sqrt_pd(a.v); }
+static inline vdouble vabs(vdouble a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+static inline vdouble vfloor(vdouble a) { return _mm256_floor_pd(a.v); }
+static inline vdouble vtrunc(vdouble a) { return _mm256_round_pd(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+static inline vdouble vlt(vdouble a, vdouble b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+static inline vdouble vle(vdouble a, vdouble b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+static inline vdouble veq(vdouble a, vdouble b) { return _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ); }
+static inline vdouble vor(vdouble a, vdouble b) { return _mm256_or_pd(a.v, b.v); }
+static inline vdouble vselect(vdouble m, vdouble a, vdouble b) { return _mm256_blendv_pd(b.v, a.v, m.v); }
+static inline bool    vall(vdouble m) { return _mm256_movemask_pd(m.v) == 0x0f; }
+static inline void    vstore(double *p, vdouble a) { _mm256_storeu_pd(p, a.v); }
+
+template <> inline vdouble vload<vdouble>(const double *p) { return _mm256_loadu_pd(p); }
+
+#elif defined(__SSE2__)
+#define SGP4_LANES  2
+
+struct vdouble
+{
+    __m128d v;
+
+    vdouble(void) {}
+    vdouble(double d) { v = _mm_set1_pd(d); }
+    vdouble(__m128d v_) { v = v_; }
+};
+
+static inline vdouble operator + (vdouble a, vdouble b) { return _mm_add_pd(a.v, b.v); }
+static inline vdouble operator - (vdouble a, vdouble b) { return _mm_sub_pd(a.v, b.v); }
+static inline vdouble operator * (vdouble a, vdouble b) { return _mm_mul_pd(a.v, b.v); }
+static inline vdouble operator / (vdouble a, vdouble b) { return _mm_div_pd(a.v, b.v); }
+static inline vdouble operator - (vdouble a) { return _mm_xor_pd(a.v, _mm_set1_pd(-0.0)); }
+
+// |a| < 2^31
+static inline vdouble vtrunc(vdouble a) { return _mm_cvtepi32_pd(_mm_cvttpd_epi32(a.v)); }
+
+static inline vdouble vsqrt(vdouble a) { return _mm_sqrt_pd(a.v); }
+static inline vdouble vabs(vdouble a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+static inline vdouble vlt(vdouble a, vdouble b) { return _mm_cmplt_pd(a.v, b.v); }
+static inline vdouble vle(vdouble a, vdouble b) { return _mm_cmple_pd(a.v, b.v); }
+static inline vdouble veq(vdouble a, vdouble b) { return _mm_cmpeq_pd(a.v, b.v); }
+static inline vdouble vor(vdouble a, vdouble b) { return _mm_or_pd(a.v, b.v); }
+static inline vdouble vselect(vdouble m, vdouble a, vdouble b) { return _mm_or_pd(_mm_and_pd(m.v, a.v), _mm_andnot_pd(m.v, b.v)); }
+static inline bool    vall(vdouble m) { return _mm_movemask_pd(m.v) == 0x03; }
+static inline void    vstore(double *p, vdouble a) { _mm_storeu_pd(p, a.v); }
+
+static inline vdouble vfloor(vdouble a)
+{
+    vdouble t = vtrunc(a);
+
+    return t - vselect(vlt(a, t), 1.0, 0.0);
+}
+
+template <> inline vdouble vload<vdouble>(const double *p) { return _mm_loadu_pd(p); }
+
+#else
+#define SGP4_LANES  1
+
+typedef double vdouble;
+#endif
+
+#if SGP4_LANES > 1
+//---------------------------------------------------------------------------
+// Cephes sin.c, the argument is reduced to +-pi/4 in three parts so it is
+// exact up to about 1e9 radians
+static inline void vsincos(vdouble a, vdouble *s, vdouble *c)
+{
+    const double dp1 = 7.85398125648498535156E-1,
+                 dp2 = 3.77489470793079817668E-8,
+                 dp3 = 2.69515142907905952645E-15,
+                 fopi = 1.27323954473516268615; // 4/pi
+    vdouble x, y, j, z, zz, ps, pc, swap, sign;
+
+    x = vabs(a);
+
+    // the octant, odd ones move to the next even one
+    y = vfloor(x * fopi);
+    y = y + (y - vfloor(y * 0.5) * 2.0);
+    j = y - vfloor(y * 0.125) * 8.0;
+
+    z = ((x - y * dp1) - y * dp2) - y * dp3;
+    zz = z * z;
+
+    ps = z + z * zz * (((((1.58962301576546568060E-10 * zz - 2.50507477628578072866E-8) * zz
+                        + 2.75573136213857245213E-6) * zz - 1.98412698295895385996E-4) * zz
+                        + 8.33333333332211858878E-3) * zz - 1.66666666666666307295E-1);
+
+    pc = 1.0 - zz * 0.5 + zz * zz * (((((-1.13585365213876817300E-11 * zz + 2.08757008419747316778E-9) * zz
+                                     - 2.75573141792967388112E-7) * zz + 2.48015872888517045348E-5) * zz
+                                     - 1.38888888888730564116E-3) * zz + 4.16666666666665929218E-2);
+
+    // octants 2 and 6 swap the polynomials, 4 and 6 negate the sine,
+    // 2 and 4 the cosine
+    swap = vor(veq(j, 2.0), veq(j, 6.0));
+    sign = vselect(vlt(j, 3.0), 1.0, -1.0) * vselect(vlt(a, 0.0), -1.0, 1.0);
+
+    *s = vselect(swap, pc, ps) * sign;
+    *c = vselect(swap, ps, pc) * vselect(vor(veq(j, 2.0), veq(j, 4.0)), -1.0, 1.0);
+}
+#endif
+
+//---------------------------------------------------------------------------
+// TSat::FMod2p
+template <class V>
+static inline V vfmod2p(V x)
+{
+    x = x - vtrunc(x / twopi) * twopi;
+
+    return x + vselect(vlt(x, 0.0), twopi, 0.0);
+}
+
+//---------------------------------------------------------------------------
+// TSat::SGP4 after the initialisation, e is the element set and tsince the
+// time since its epoch in minutes. The terms the simple sets leave out are
+// zero, the result is the same. u is never needed, only its sine and cosine.
+template <class V>
+static void sgp4(const V *e, V tsince, V *state)
+{
+    V xmdf, omgadf, xnoddf, omega, xmp, tsq, xnode, tempa, tempe, templ, delm,
+      temp, tcube, tfour, a, ee, xl, beta, xn, axn, xll, aynl, xlt, ayn, capu,
+      sinepw, cosepw, epw, done, ecose, esine, elsq, pl, r, rdot, rfdot, betal,
+      cosu, sinu, sin2u, cos2u, rk, duk, xnodek, xinck, rdotk, rfdotk, sinuk,
+      cosuk, sinik, cosik, sinnok, cosnok, xmx, xmy, ux, uy, uz, vx, vy, vz,
+      temp1, temp2, temp3, temp4, temp5, temp6, s, c;
+    int i;
+
+    // secular gravity and atmospheric drag
+    xmdf   = e[SGP4_XMO] + e[SGP4_XMDOT] * tsince;
+    omgadf = e[SGP4_OMEGAO] + e[SGP4_OMGDOT] * tsince;
+    xnoddf = e[SGP4_XNODEO] + e[SGP4_XNODOT] * tsince;
+    tsq    = tsince * tsince;
+    xnode  = xnoddf + e[SGP4_XNODCF] * tsq;
+    tempa  = 1.0 - e[SGP4_C1] * tsince;
+    tempe  = e[SGP4_BSTAR] * e[SGP4_C4] * tsince;
+    templ  = e[SGP4_T2COF] * tsq;
+
+    vsincos(xmdf, &s, &c);
+    temp   = 1.0 + e[SGP4_ETA] * c;
+    delm   = e[SGP4_XMCOF] * (temp * temp * temp - e[SGP4_DELMO]);
+    temp   = e[SGP4_OMGCOF] * tsince + delm;
+    xmp    = xmdf + temp;
+    omega  = omgadf - temp;
+    tcube  = tsq * tsince;
+    tfour  = tsince * tcube;
+    tempa  = tempa - e[SGP4_D2] * tsq - e[SGP4_D3] * tcube - e[SGP4_D4] * tfour;
+    vsincos(xmp, &s, &c);
+    tempe  = tempe + e[SGP4_BSTAR] * e[SGP4_C5] * (s - e[SGP4_SINMO]);
+    templ  = templ + e[SGP4_T3COF] * tcube + tfour * (e[SGP4_T4COF] + tsince * e[SGP4_T5COF]);
+
+    a    = e[SGP4_AODP] * tempa * tempa;
+    ee   = e[SGP4_EO] - tempe;
+    xl   = xmp + omega + xnode + e[SGP4_XNODP] * templ;
+    beta = vsqrt(1.0 - ee * ee);
+    xn   = xke / (a * vsqrt(a));
+
+    // long period periodics
+    vsincos(omega, &s, &c);
+    axn  = ee * c;
+    temp = 1.0 / (a * beta * beta);
+    xll  = temp * e[SGP4_XLCOF] * axn;
+    aynl = temp * e[SGP4_AYCOF];
+    xlt  = xl + xll;
+    ayn  = ee * s + aynl;
+
+    // Kepler's equation, a lane that has converged keeps its values
+    capu  = vfmod2p(xlt - xnode);
+    temp2 = capu;
+    done  = 0.0;
+
+    for(i=0; i<=10; i++) {
+        vsincos(temp2, &sinepw, &cosepw);
+        temp3 = axn * sinepw;
+        temp4 = ayn * cosepw;
+        temp5 = axn * cosepw;
+        temp6 = ayn * sinepw;
+        epw   = (capu - temp4 + temp3 - temp2) / (1.0 - temp5 - temp6) + temp2;
+
+        done = vor(done, vle(vabs(epw - temp2), e6a));
+        if(vall(done))
+            break;
+
+        temp2 = vselect(done, temp2, epw);
+    }
+
+    // short period preliminary quantities
+    ecose = temp5 + temp6;
+    esine = temp3 - temp4;
+    elsq  = axn * axn + ayn * ayn;
+    temp  = 1.0 - elsq;
+    pl    = a * temp;
+    r     = a * (1.0 - ecose);
+    temp1 = 1.0 / r;
+    rdot  = xke * vsqrt(a) * esine * temp1;
+    rfdot = xke * vsqrt(pl) * temp1;
+    temp2 = a * temp1;
+    betal = vsqrt(temp);
+    temp3 = 1.0 / (1.0 + betal);
+    cosu  = temp2 * (cosepw - axn + ayn * esine * temp3);
+    sinu  = temp2 * (sinepw - ayn - axn * esine * temp3);
+    sin2u = 2.0 * sinu * cosu;
+    cos2u = 2.0 * cosu * cosu - 1.0;
+    temp  = 1.0 / pl;
+    temp1 = ck2 * temp;
+    temp2 = temp1 * temp;
+
+    // short periodics, uk = u + duk
+    rk     = r * (1.0 - 1.5 * temp2 * betal * e[SGP4_X3THM1]) + 0.5 * temp1 * e[SGP4_X1MTH2] * cos2u;
+    duk    = -0.25 * temp2 * e[SGP4_X7THM1] * sin2u;
+    xnodek = xnode + 1.5 * temp2 * e[SGP4_COSIO] * sin2u;
+    xinck  = e[SGP4_XINCL] + 1.5 * temp2 * e[SGP4_COSIO] * e[SGP4_SINIO] * cos2u;
+    rdotk  = rdot - xn * temp1 * e[SGP4_X1MTH2] * sin2u;
+    rfdotk = rfdot + xn * temp1 * (e[SGP4_X1MTH2] * cos2u + 1.5 * e[SGP4_X3THM1]);
+
+    // orientation vectors
+    vsincos(duk, &s, &c);
+    temp  = 1.0 / vsqrt(sinu * sinu + cosu * cosu);
+    sinuk = (sinu * c + cosu * s) * temp;
+    cosuk = (cosu * c - sinu * s) * temp;
+    vsincos(xinck, &sinik, &cosik);
+    vsincos(xnodek, &sinnok, &cosnok);
+    xmx   = -sinnok * cosik;
+    xmy   = cosnok * cosik;
+    ux    = xmx * sinuk + cosnok * cosuk;
+    uy    = xmy * sinuk + sinnok * cosuk;
+    uz    = sinik * sinuk;
+    vx    = xmx * cosuk - cosnok * sinuk;
+    vy    = xmy * cosuk - sinnok * sinuk;
+    vz    = sinik * cosuk;
+
+    // position and velocity in km and km/s, see TSat::Convert_Sat_State
+    temp = xkmper * xmnpda / secday;
+
+    state[0] = rk * ux * xkmper;
+    state[1] = rk * uy * xkmper;
+    state[2] = rk * uz * xkmper;
+    state[3] = (rdotk * ux + rfdotk * vx) * temp;
+    state[4] = (rdotk * uy + rfdotk * vy) * temp;
+    state[5] = (rdotk * uz + rfdotk * vz) * temp;
+
+    temp = xlt - xnode - omgadf + twopi;
+    state[6] = vfmod2p(temp + vselect(vlt(temp, 0.0), twopi, 0.0));
+}
+
+//---------------------------------------------------------------------------
+template <class V>
+static inline void store(TSGP4State *dst, int i, const V *state)
+{
+    vstore(dst->x + i, state[0]);
+    vstore(dst->y + i, state[1]);
+    vstore(dst->z + i, state[2]);
+    vstore(dst->vx + i, state[3]);
+    vstore(dst->vy + i, state[4]);
+    vstore(dst->vz + i, state[5]);
+    vstore(dst->phase + i, state[6]);
+}
+
+//---------------------------------------------------------------------------
+// sets i ... i + lanes - 1 at jul_utc
+template <class V>
+static inline void propagateSets(double * const *field, int i, double jul_utc, TSGP4State *dst)
+{
+    V e[SGP4_FIELDS], state[SGP4_STATE];
+    int f;
+
+    for(f=0; f<SGP4_FIELDS; f++)
+        e[f] = vload<V>(field[f] + i);
+
+    sgp4<V>(e, (V(jul_utc) - e[SGP4_EPOCH]) * xmnpda, state);
+    store<V>(dst, i, state);
+}
+
+//---------------------------------------------------------------------------
+// the set e at daynum[i] ... daynum[i + lanes - 1]
+template <class V>
+static inline void propagateTimes(const V *e, const double *daynum, int i, TSGP4State *dst)
+{
+    V state[SGP4_STATE];
+
+    sgp4<V>(e, (vload<V>(daynum + i) + 2444238.5 - e[SGP4_EPOCH]) * xmnpda, state);
+    store<V>(dst, i, state);
+}
+
+//---------------------------------------------------------------------------
+// the initialisation of TSat::SGP4 for an element set prepared by
+// select_ephemeris, f has SGP4_FIELDS entries
+static void init(const tle_t *tle, double jd_epoch, double *f)
+{
+    double a1, ao, betao, betao2, c1sq, c2, c3, coef, coef1, del1, delo,
+           eeta, eosq, etasq, perigee, pinvsq, psisq, qoms24, s4, temp,
+           temp1, temp2, temp3, theta2, theta4, tsi, a3ovk2, x1m5th, xhdot1;
+    double aodp, xnodp, cosio, sinio, eta, c1, x3thm1;
+
+    memset(f, 0, SGP4_FIELDS * sizeof(double));
+
+    f[SGP4_EPOCH]  = jd_epoch;
+    f[SGP4_XMO]    = tle->xmo;
+    f[SGP4_OMEGAO] = tle->omegao;
+    f[SGP4_XNODEO] = tle->xnodeo;
+    f[SGP4_XINCL]  = tle->xincl;
+    f[SGP4_EO]     = tle->eo;
+    f[SGP4_BSTAR]  = tle->bstar;
+
+    // original mean motion and semimajor axis
+    a1     = pow(xke/tle->xno, tothrd);
+    cosio  = cos(tle->xincl);
+    theta2 = cosio*cosio;
+    x3thm1 = 3*theta2-1.0;
+    eosq   = tle->eo*tle->eo;
+    betao2 = 1.0-eosq;
+    betao  = sqrt(betao2);
+    del1   = 1.5*ck2*x3thm1/(a1*a1*betao*betao2);
+    ao     = a1*(1.0-del1*(0.5*tothrd+del1*(1.0+134.0/81.0*del1)));
+    delo   = 1.5*ck2*x3thm1/(ao*ao*betao*betao2);
+    xnodp  = tle->xno/(1.0+delo);
+    aodp   = ao/(1.0-delo);
+
+    // perigees below 156 km alter s and qoms2t
+    s4      = s156;
+    qoms24  = qoms2t;
+    perigee = (aodp*(1.0-tle->eo)-ae)*xkmper;
+
+    if(perigee < 156.0) {
+        if(perigee <= 98.0)
+            s4 = 20;
+        else
+            s4 = perigee-78.0;
+
+        qoms24 = pow((120.0-s4)*ae/xkmper, 4.0);
+        s4     = s4/xkmper+ae;
+    }
+
+    pinvsq = 1.0/(aodp*aodp*betao2*betao2);
+    tsi    = 1.0/(aodp-s4);
+    eta    = aodp*tle->eo*tsi;
+    etasq  = eta*eta;
+    eeta   = tle->eo*eta;
+    psisq  = fabs(1-etasq);
+    coef   = qoms24*pow(tsi, 4.0);
+    coef1  = coef/pow(psisq, 3.5);
+    c2     = coef1*xnodp*(aodp*(1.0+1.5*etasq+eeta*(4.0+etasq))+0.75*ck2*tsi/psisq*x3thm1*(8.0+3.0*etasq*(8.0+etasq)));
+    c1     = tle->bstar*c2;
+    sinio  = sin(tle->xincl);
+    a3ovk2 = -xj3/ck2*pow(ae, 3.0);
+    c3     = coef*tsi*a3ovk2*xnodp*ae*sinio/tle->eo;
+
+    f[SGP4_AODP]   = aodp;
+    f[SGP4_XNODP]  = xnodp;
+    f[SGP4_COSIO]  = cosio;
+    f[SGP4_SINIO]  = sinio;
+    f[SGP4_ETA]    = eta;
+    f[SGP4_C1]     = c1;
+    f[SGP4_X3THM1] = x3thm1;
+    f[SGP4_X1MTH2] = 1.0-theta2;
+    f[SGP4_C4]     = 2.0*xnodp*coef1*aodp*betao2*(eta*(2.0+0.5*etasq)+tle->eo*(0.5+2.0*etasq)-2.0*ck2*tsi/(aodp*psisq)*(-3*x3thm1*(1-2*eeta+etasq*(1.5-0.5*eeta))+0.75*f[SGP4_X1MTH2]*(2.0*etasq-eeta*(1.0+etasq))*cos(2.0*tle->omegao)));
+
+    theta4 = theta2*theta2;
+    temp1  = 3.0*ck2*pinvsq*xnodp;
+    temp2  = temp1*ck2*pinvsq;
+    temp3  = 1.25*ck4*pinvsq*pinvsq*xnodp;
+    x1m5th = 1.0-5.0*theta2;
+    xhdot1 = -temp1*cosio;
+
+    f[SGP4_XMDOT]  = xnodp+0.5*temp1*betao*x3thm1+0.0625*temp2*betao*(13.0-78.0*theta2+137.0*theta4);
+    f[SGP4_OMGDOT] = -0.5*temp1*x1m5th+0.0625*temp2*(7.0-114.0*theta2+395.0*theta4)+temp3*(3.0-36.0*theta2+49.0*theta4);
+    f[SGP4_XNODOT] = xhdot1+(0.5*temp2*(4.0-19.0*theta2)+2.0*temp3*(3.0-7.0*theta2))*cosio;
+    f[SGP4_XNODCF] = 3.5*betao2*xhdot1*c1;
+    f[SGP4_T2COF]  = 1.5*c1;
+    f[SGP4_XLCOF]  = 0.125*a3ovk2*sinio*(3.0+5.0*cosio)/(1.0+cosio);
+    f[SGP4_AYCOF]  = 0.25*a3ovk2*sinio;
+    f[SGP4_X7THM1] = 7.0*theta2-1.0;
+
+    // perigee below 220 km, the equations are truncated to linear variation
+    // in sqrt a and quadratic variation in mean anomaly
+    if((aodp*(1.0-tle->eo)/ae) < (220.0/xkmper+ae))
+        return;
+
+    f[SGP4_C5]     = 2.0*coef1*aodp*betao2*(1.0+2.75*(etasq+eeta)+eeta*etasq);
+    f[SGP4_OMGCOF] = tle->bstar*c3*cos(tle->omegao);
+    f[SGP4_XMCOF]  = -tothrd*coef*tle->bstar*ae/eeta;
+    f[SGP4_DELMO]  = pow(1.0+eta*cos(tle->xmo), 3.0);
+    f[SGP4_SINMO]  = sin(tle->xmo);
+
+    c1sq = c1*c1;
+    f[SGP4_D2] = 4.0*aodp*tsi*c1sq;
+    temp = f[SGP4_D2]*tsi*c1/3.0;
+    f[SGP4_D3] = (17.0*aodp+s4)*temp;
+    f[SGP4_D4] = 0.5*temp*aodp*tsi*(221.0*aodp+31.0*s4)*c1;
+    f[SGP4_T3COF] = f[SGP4_D2]+2.0*c1sq;
+    f[SGP4_T4COF] = 0.25*(3.0*f[SGP4_D3]+c1*(12.0*f[SGP4_D2]+10.0*c1sq));
+    f[SGP4_T5COF] = 0.2*(3.0*f[SGP4_D4]+12.0*c1*f[SGP4_D3]+6.0*f[SGP4_D2]*f[SGP4_D2]+15.0*c1sq*(2.0*f[SGP4_D2]+c1sq));
+}
+
+//---------------------------------------------------------------------------
+// TSat::ThetaG_JD
+static double thetag(double jd)
+{
+    double ut, tu, gmst;
+    int i;
+
+    ut   = jd+0.5 - floor(jd+0.5);
+    jd   = jd-ut;
+    tu   = (jd-2451545.0)/36525;
+    gmst = 24110.54841+tu*(8640184.812866+tu*(0.093104-tu*6.2E-6));
+    gmst = gmst+secday*omega_E*ut;
+
+    i     = gmst/secday;
+    gmst -= i*secday;
+    if(gmst < 0.0)
+        gmst += secday;
+
+    return twopi*gmst/secday;
+}
+
+//---------------------------------------------------------------------------
+TSGP4State::TSGP4State(void)
+{
+    buffer = NULL;
+    size = 0;
+
+    clear();
+}
+
+//---------------------------------------------------------------------------
+TSGP4State::~TSGP4State(void)
+{
+    clear();
+}
+
+//---------------------------------------------------------------------------
+void TSGP4State::clear(void)
+{
+    if(buffer)
+        free(buffer);
+    buffer = NULL;
+
+    x = y = z = vx = vy = vz = phase = NULL;
+    size = 0;
+}
+
+//---------------------------------------------------------------------------
+bool TSGP4State::alloc(int size_)
+{
+    if(size_ <= size)
+        return size_ > 0;
+
+    clear();
+
+    buffer = (double *) malloc((size_t) size_ * SGP4_STATE * sizeof(double));
+    if(buffer == NULL) {
+        qDebug("Failed to allocate SGP4 state %d %s:%d", size_, __FILE__, __LINE__);
+        return false;
+    }
+
+    size = size_;
+
+    x     = buffer;
+    y     = x + size;
+    z     = y + size;
+    vx    = z + size;
+    vy    = vx + size;
+    vz    = vy + size;
+    phase = vz + size;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+TSGP4Batch::TSGP4Batch(void)
+{
+    buffer = NULL;
+    sets = capacity = 0;
+
+    memset(field, 0, sizeof(field));
+}
+
+//---------------------------------------------------------------------------
+TSGP4Batch::~TSGP4Batch(void)
+{
+    if(buffer)
+        free(buffer);
+}
+
+//---------------------------------------------------------------------------
+// the sets are dropped, the memory is kept
+void TSGP4Batch::clear(void)
+{
+    sets = 0;
+}
+
+//---------------------------------------------------------------------------
+bool TSGP4Batch::reserve(int capacity_)
+{
+    double *block;
+    int f;
+
+    if(capacity_ <= capacity)
+        return true;
+
+    capacity_ = capacity_ < 2 * capacity ? 2 * capacity:capacity_;
+
+    block = (double *) malloc((size_t) capacity_ * SGP4_FIELDS * sizeof(double));
+    if(block == NULL) {
+        qDebug("Failed to allocate SGP4 element sets %d %s:%d", capacity_, __FILE__, __LINE__);
+        return false;
+    }
+
+    for(f=0; f<SGP4_FIELDS; f++) {
+        if(sets)
+            memcpy(block + (size_t) f * capacity_, field[f], sets * sizeof(double));
+
+        field[f] = block + (size_t) f * capacity_;
+    }
+
+    if(buffer)
+        free(buffer);
+
+    buffer = block;
+    capacity = capacity_;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// returns the index of the set of sat, -1 if it is a deep space one
+int TSGP4Batch::add(TSat *sat)
+{
+    double f[SGP4_FIELDS], jd_epoch;
+    tle_t tle;
+    int i;
+
+    if(sat == NULL || sat->IsDeepSpace())
+        return -1;
+
+    if(!reserve(sets + 1))
+        return -1;
+
+    sat->GetElements(&tle, &jd_epoch);
+    init(&tle, jd_epoch, f);
+
+    for(i=0; i<SGP4_FIELDS; i++)
+        field[i][sets] = f[i];
+
+    return sets++;
+}
+
+//---------------------------------------------------------------------------
+// every set at daynum, state holds count() entries
+bool TSGP4Batch::propagate(double daynum, TSGP4State *state) const
+{
+    TRACE_SCOPE("TSGP4Batch::propagate");
+    double jul_utc = daynum + 2444238.5;
+    int i;
+
+    if(state == NULL || state->getSize() < sets)
+        return false;
+
+    for(i=0; i + SGP4_LANES <= sets; i += SGP4_LANES)
+        propagateSets<vdouble>(field, i, jul_utc, state);
+
+    for(; i<sets; i++)
+        propagateSets<double>(field, i, jul_utc, state);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// set at the n times of daynum, state holds n entries
+bool TSGP4Batch::propagate(int set, const double *daynum, int n, TSGP4State *state) const
+{
+    TRACE_SCOPE("TSGP4Batch::propagate");
+    vdouble ev[SGP4_FIELDS];
+    double e[SGP4_FIELDS];
+    int i;
+
+    if(set < 0 || set >= sets || daynum == NULL || state == NULL || state->getSize() < n)
+        return false;
+
+    for(i=0; i<SGP4_FIELDS; i++) {
+        e[i] = field[i][set];
+        ev[i] = e[i];
+    }
+
+    for(i=0; i + SGP4_LANES <= n; i += SGP4_LANES)
+        propagateTimes<vdouble>(ev, daynum, i, state);
+
+    for(; i<n; i++)
+        propagateTimes<double>(e, daynum, i, state);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// Azimuth and elevation (degrees) and range (km) of n states seen from
+// station (radians, km), see TSat::Calculate_Obs. The time of state i
+// is daynum[i * step], step is 0 if all are at one time. Any of azi, ele
+// and range may be NULL.
+void TSGP4Batch::look(const geodetic_t *station, const double *daynum, int step, const TSGP4State *state,
+                      int n, double *azi, double *ele, double *range)
+{
+    double sin_lat, cos_lat, sin_theta, cos_theta, c, achcp, oz, theta,
+           rx, ry, rz, rw, top_s, top_e, top_z, az;
+    int i;
+
+    sin_lat = sin(station->lat);
+    cos_lat = cos(station->lat);
+    c       = 1.0/sqrt(1+flat*(flat-2)*sin_lat*sin_lat);
+    achcp   = (xkmper*c+station->alt)*cos_lat;
+    oz      = (xkmper*(1.0-flat)*(1.0-flat)*c+station->alt)*sin_lat;
+
+    sin_theta = cos_theta = 0;
+
+    for(i=0; i<n; i++) {
+        if(i == 0 || step) {
+            theta = thetag(daynum[i * step] + 2444238.5) + station->lon;
+            theta = vfmod2p(theta);
+
+            sin_theta = sin(theta);
+            cos_theta = cos(theta);
+        }
+
+        rx = state->x[i] - achcp*cos_theta;
+        ry = state->y[i] - achcp*sin_theta;
+        rz = state->z[i] - oz;
+        rw = sqrt(rx*rx + ry*ry + rz*rz);
+
+        top_s = sin_lat*cos_theta*rx+sin_lat*sin_theta*ry-cos_lat*rz;
+        top_e = -sin_theta*rx+cos_theta*ry;
+        top_z = cos_lat*cos_theta*rx+cos_lat*sin_theta*ry+sin_lat*rz;
+
+        if(azi) {
+            az = atan(-top_e/top_s);
+
+            if(top_s > 0.0)
+                az = az+pi;
+            if(az < 0.0)
+                az = az+twopi;
+
+            azi[i] = az/deg2rad;
+        }
+
+        if(ele)
+            ele[i] = asin(top_z/rw)/deg2rad;
+
+        if(range)
+            range[i] = rw;
+    }
+}
+
+//---------------------------------------------------------------------------
+const char *TSGP4Batch::simd(void)
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "none";
+#endif
+}
@@ -0,0 +1,124 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef SGP4BATCH_H
+#define SGP4BATCH_H
+
+#include "Satellite.h"
+
+//---------------------------------------------------------------------------
+// the fields of an initialised SGP4 element set, see TSat::SGP4
+typedef enum
+{
+    SGP4_EPOCH,  // Julian date
+    SGP4_XMO,
+    SGP4_OMEGAO,
+    SGP4_XNODEO,
+    SGP4_XINCL,
+    SGP4_EO,
+    SGP4_BSTAR,
+    SGP4_AODP,
+    SGP4_XNODP,
+    SGP4_COSIO,
+    SGP4_SINIO,
+    SGP4_ETA,
+    SGP4_C1,
+    SGP4_C4,
+    SGP4_C5,
+    SGP4_D2,
+    SGP4_D3,
+    SGP4_D4,
+    SGP4_DELMO,
+    SGP4_SINMO,
+    SGP4_OMGCOF,
+    SGP4_XMCOF,
+    SGP4_XMDOT,
+    SGP4_OMGDOT,
+    SGP4_XNODOT,
+    SGP4_XNODCF,
+    SGP4_T2COF,
+    SGP4_T3COF,
+    SGP4_T4COF,
+    SGP4_T5COF,
+    SGP4_X1MTH2,
+    SGP4_X3THM1,
+    SGP4_X7THM1,
+    SGP4_XLCOF,
+    SGP4_AYCOF,
+
+    SGP4_FIELDS
+} SGP4_Field;
+
+//---------------------------------------------------------------------------
+// positions and velocities, one array per component
+class TSGP4State
+{
+public:
+    TSGP4State(void);
+    ~TSGP4State(void);
+
+    bool alloc(int size_);
+    void clear(void);
+    int  getSize(void) const { return size; }
+
+    double *x, *y, *z;     // ECI position, km
+    double *vx, *vy, *vz;  // ECI velocity, km/s
+    double *phase;         // radians
+
+private:
+    double *buffer;
+    int    size;
+};
+
+//---------------------------------------------------------------------------
+// SGP4 over a structure of arrays of element sets. The sets are
+// initialised once when added, propagating only reads them so one batch
+// may be shared by several threads. Several satellites at one time or
+// one satellite at several times are propagated as many at a time as
+// the SIMD unit holds (AVX2 4, SSE2 2).
+// Deep space satellites (SDP4) are not taken, TSat::Calc tracks them.
+class TSGP4Batch
+{
+public:
+    TSGP4Batch(void);
+    ~TSGP4Batch(void);
+
+    void clear(void);
+    int  add(TSat *sat);
+    int  count(void) const { return sets; }
+
+    bool propagate(double daynum, TSGP4State *state) const;
+    bool propagate(int set, const double *daynum, int n, TSGP4State *state) const;
+
+    static void look(const geodetic_t *station, const double *daynum, int step, const TSGP4State *state,
+                     int n, double *azi, double *ele, double *range);
+    static const char *simd(void);
+
+protected:
+    bool reserve(int capacity_);
+
+private:
+    double *buffer;
+    double *field[SGP4_FIELDS];
+    int    sets, capacity;
+};
+
+#endif // SGP4BATCH_H
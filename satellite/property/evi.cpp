@@ -100,29 +100,37 @@ TEVI& TEVI::operator = (TEVI& src)
 //---------------------------------------------------------------------------
 void TEVI::writeSettings(QSettings *reg)
 {
-#if 0 // todo
     reg->setValue("ID", _name);
     reg->setValue("LUT", _lut);
-    reg->setValue("Min-Value", _min_ndvi);
-    reg->setValue("Max-Value", _max_ndvi);
-    reg->setValue("Vis-Ch", _vis_ch);
+    reg->setValue("Min-Value", _min_evi);
+    reg->setValue("Max-Value", _max_evi);
     reg->setValue("NIR-Ch", _nir_ch);
+    reg->setValue("Red-Ch", _red_ch);
+    reg->setValue("Blue-Ch", _blue_ch);
+    reg->setValue("Gain", coef.g);
+    reg->setValue("C1", coef.c1);
+    reg->setValue("C2", coef.c2);
+    reg->setValue("L", coef.l);
+    reg->setValue("Soil", _soil_algorithm);
     reg->setValue("RGB-Name", _rgb_name);
-#endif
 }
 
 //---------------------------------------------------------------------------
 void TEVI::readSettings(QSettings *reg)
 {
-#if 0 // todo
     _name     = reg->value("ID", "Unknown").toString();
     _lut      = reg->value("LUT", "").toString();
-    _min_ndvi = reg->value("Min-Value", "-1").toDouble();
-    _max_ndvi = reg->value("Max-Value", "1").toDouble();
-    _vis_ch   = reg->value("Vis-Ch", "1").toInt();
+    _min_evi  = reg->value("Min-Value", "-1").toDouble();
+    _max_evi  = reg->value("Max-Value", "1").toDouble();
     _nir_ch   = reg->value("NIR-Ch", "2").toInt();
+    _red_ch   = reg->value("Red-Ch", "1").toInt();
+    _blue_ch  = reg->value("Blue-Ch", "3").toInt();
+    coef.g    = reg->value("Gain", "2.5").toDouble();
+    coef.c1   = reg->value("C1", "6.0").toDouble();
+    coef.c2   = reg->value("C2", "7.5").toDouble();
+    coef.l    = reg->value("L", "1.0").toDouble();
+    _soil_algorithm = reg->value("Soil", false).toBool();
     _rgb_name = reg->value("RGB-Name", "").toString();
-#endif
 }
 
 //---------------------------------------------------------------------------
@@ -189,7 +197,7 @@ int TEVI::lutIndex(double evi_value, int lut_width)
     double delta = _max_evi - _min_evi;
     int value;
 
-    value = (int) rint(width * (evi_value + delta/2.0) / delta);
+    value = (int) rint(width * (evi_value - _min_evi) / delta);
 
     return (int) ClipValue(value, width, 0);
 }
@@ -155,7 +155,7 @@ int TNDVI::lutIndex(double ndvi_value, int lut_width)
     double delta = _max_ndvi - _min_ndvi;
     int value;
 
-    value = (int) rint(width * (ndvi_value + delta/2.0) / delta);
+    value = (int) rint(width * (ndvi_value - _min_ndvi) / delta);
 
     return (int) ClipValue(value, width, 0);
 }
@@ -35,6 +35,7 @@ TSatProp::TSatProp(void)
     evilist = new PList;
 
     _decoderFlags = 0;
+    _syncErrors = 3;
 }
 
 //---------------------------------------------------------------------------
@@ -65,6 +66,7 @@ TSatProp& TSatProp::operator = (TSatProp& src)
         evilist->Add(new TEVI(*((TEVI *) src.evilist->ItemAt(i))));
 
     _decoderFlags = src.decoderFlags();
+    _syncErrors = src.syncErrors();
 
     return *this;
 }
@@ -173,6 +175,7 @@ void TSatProp::check(int max_ch)
 {
     TRGBConf *rc;
     TNDVI *vi;
+    TEVI *ev;
     int i;
 
     for(i=0; i<rgblist->Count; i++) {
@@ -185,8 +188,10 @@ void TSatProp::check(int max_ch)
         vi->check(max_ch);
     }
 
-    // todo: EVI
-
+    for(i=0; i<evilist->Count; i++) {
+        ev = (TEVI *) evilist->ItemAt(i);
+        ev->check(max_ch);
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -194,6 +199,7 @@ void TSatProp::readSettings(QSettings *reg)
 {
     TRGBConf *rc;
     TNDVI    *vi;
+    TEVI     *ev;
     QString  str;
     int      i;
 
@@ -201,6 +207,7 @@ void TSatProp::readSettings(QSettings *reg)
 
     str = reg->value("Flags", "0").toString();
     _decoderFlags = str.toUInt();
+    _syncErrors = reg->value("SyncErrors", 3).toInt();
 
     reg->endGroup(); // Decoder
 
@@ -252,7 +259,29 @@ void TSatProp::readSettings(QSettings *reg)
     reg->endGroup(); // NDVI-Conf
     delete vi;
 
-    // todo: EVI
+    ev = new TEVI;
+    i = 0;
+    reg->beginGroup("EVI-Conf");
+
+    while(true) {
+        str.sprintf("Conf-%d", i++);
+        reg->beginGroup(str);
+
+        if(!reg->contains("ID")) {
+            reg->endGroup();
+            break;
+        }
+
+        ev->readSettings(reg);
+
+        if(!get_evi(ev->name()))
+            evilist->Add(new TEVI(*ev));
+
+        reg->endGroup();
+    }
+
+    reg->endGroup(); // EVI-Conf
+    delete ev;
 }
 
 //---------------------------------------------------------------------------
@@ -260,12 +289,14 @@ void TSatProp::writeSettings(QSettings *reg)
 {
     TRGBConf *rc;
     TNDVI *vi;
+    TEVI *ev;
     QString str;
     int i;
 
     reg->beginGroup("Decoder");
 
     reg->setValue("Flags", decoderFlags());
+    reg->setValue("SyncErrors", syncErrors());
 
     reg->endGroup(); // Decoder
 
@@ -297,8 +328,20 @@ void TSatProp::writeSettings(QSettings *reg)
 
     reg->endGroup(); // NDVI-Conf
 
-    // todo: EVI
+    reg->beginGroup("EVI-Conf");
+
+    for(i=0; i<evilist->Count; i++) {
+        ev = (TEVI *) evilist->ItemAt(i);
+        str.sprintf("Conf-%d", i);
+
+        reg->beginGroup(str);
+
+        ev->writeSettings(reg);
+
+        reg->endGroup();
+    }
 
+    reg->endGroup(); // EVI-Conf
 }
 //---------------------------------------------------------------------------
 //
@@ -465,6 +508,18 @@ bool TSatProp::syncCheck(void)
     return flagState(&_decoderFlags, DF_SYNCCHECK);
 }
 
+//---------------------------------------------------------------------------
+void TSatProp::softSync(bool yes)
+{
+    flagState(&_decoderFlags, DF_SOFTSYNC, yes);
+}
+
+//---------------------------------------------------------------------------
+bool TSatProp::softSync(void)
+{
+    return flagState(&_decoderFlags, DF_SOFTSYNC);
+}
+
 //---------------------------------------------------------------------------
 void TSatProp::flagState(unsigned int *flag, unsigned int bitmap, bool on)
 {
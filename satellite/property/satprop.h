@@ -31,6 +31,7 @@
 #define DF_DERANDOMIZE  1
 #define DF_RSDECODE     2
 #define DF_SYNCCHECK    4
+#define DF_SOFTSYNC     8
 
 
 class QSettings;
@@ -73,6 +74,10 @@ public:
     bool rs_decode(void);
     void syncCheck(bool yes);
     bool syncCheck(void);
+    void softSync(bool yes);
+    bool softSync(void);
+    void syncErrors(int errors) { _syncErrors = errors; }
+    int  syncErrors(void) { return _syncErrors; }
 
     // general functions
     void check(int max_ch);
@@ -95,6 +100,7 @@ protected:
 
 private:
     unsigned int _decoderFlags;
+    int          _syncErrors; // CADU sync Hamming distance threshold
 
 };
 
@@ -156,6 +156,8 @@ void SatPropDialog::on_satlistWidget_itemClicked(QListWidgetItem* item)
     ui->derandCb->setChecked(selsat->sat_props->derandomize());
     ui->rsdecodeCb->setChecked(selsat->sat_props->rs_decode());
     ui->syncCheckCb->setChecked(selsat->sat_props->syncCheck());
+    ui->softSyncCb->setChecked(selsat->sat_props->softSync());
+    ui->syncErrorsSb->setValue(selsat->sat_props->syncErrors());
 }
 //---------------------------------------------------------------------------
 //
@@ -510,6 +512,8 @@ void SatPropDialog::on_applyDecoderBtn_clicked()
         sat->sat_props->derandomize(ui->derandCb->isChecked());
         sat->sat_props->rs_decode(ui->rsdecodeCb->isChecked());
         sat->sat_props->syncCheck(ui->syncCheckCb->isChecked());
+        sat->sat_props->softSync(ui->softSyncCb->isChecked());
+        sat->sat_props->syncErrors(ui->syncErrorsSb->value());
     }
 }
 
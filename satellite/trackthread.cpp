@@ -72,6 +72,10 @@ TrackThread::TrackThread(QObject *parent) : QThread(parent)
     connect(this, SIGNAL(setMoonLabelText(const QString &)),
             moonLabel, SLOT(setText(const QString &)));
 
+    // decoded while it is written, see MainWindow::followRecording
+    connect(this, SIGNAL(recordingStarted(const QString &)),
+            mw, SLOT(followRecording(const QString &)));
+
     prev_el = 0;
     prev_az = 0;
     speed_dt = QDateTime::currentDateTime();
@@ -300,6 +304,8 @@ void TrackThread::run()
                         rx_proc->start(proc_cmd);
                         sat->SavePassinfo();
                         rig_modes |= 256;
+
+                        emit(recordingStarted(sat->sat_scripts->frames_filename()));
                     }
                     else {
                         // make sure it wont be tested again until user corrects errors
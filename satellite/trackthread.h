@@ -57,6 +57,7 @@ signals:
     void setSunLabelText(const QString &cl);
     void setMoonLabelColor(const QString &cl);
     void setMoonLabelText(const QString &cl);
+    void recordingStarted(const QString &fileName);
 
 protected:
     void stopProcess(QProcess *proc);
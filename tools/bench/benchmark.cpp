@@ -0,0 +1,516 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFile>
+#include <QImage>
+#include <string.h>
+
+#include "benchmark.h"
+#include "block.h"
+#include "cadu.h"
+#include "hrptblock.h"
+#include "mn1hrptblock.h"
+#include "syncscanner.h"
+#include "rsdecoder.h"
+#include "unpack10.h"
+#include "linepool.h"
+
+//---------------------------------------------------------------------------
+#define BENCH_HRPT_LE   0
+#define BENCH_HRPT_BE   1
+#define BENCH_FY1HRPT   2
+#define BENCH_MN1HRPT   3
+#define BENCH_AHRPT     4
+
+static const struct {
+    const char *name;
+    Block_Type  type;
+    const char *ext;
+} BENCH_FORMAT[BENCH_FORMATS] =
+{
+    { "hrpt-le", HRPT_BlockType,    "raw"  },
+    { "hrpt-be", HRPT_BlockType,    "raw"  },
+    { "fy1hrpt", FY1HRPT_BlockType, "raw"  },
+    { "mn1hrpt", MN1HRPT_BlockType, "raw"  },
+    { "ahrpt",   AHRPT_BlockType,   "cadu" }
+};
+
+//---------------------------------------------------------------------------
+static double seconds(QElapsedTimer *timer)
+{
+    return timer->nsecsElapsed() / 1e9;
+}
+
+//---------------------------------------------------------------------------
+TBenchmark::TBenchmark(void)
+{
+    lines = 1000;
+    runs = 3;
+    keep = false;
+    softsync = false;
+}
+
+//---------------------------------------------------------------------------
+TBenchmark::~TBenchmark(void)
+{
+    if(!keep)
+        removeFiles();
+}
+
+//---------------------------------------------------------------------------
+bool TBenchmark::generate(void)
+{
+    QString str;
+    bool    rc;
+    int     i;
+
+    for(i=0; i<BENCH_FORMATS; i++) {
+        str.sprintf("/bench-%s.%s", BENCH_FORMAT[i].name, BENCH_FORMAT[i].ext);
+        files[i] = path + str;
+    }
+
+    rc = gen.hrpt(files[BENCH_HRPT_LE].toStdString().c_str(), lines, true) &&
+         gen.hrpt(files[BENCH_HRPT_BE].toStdString().c_str(), lines, false) &&
+         gen.fy1hrpt(files[BENCH_FY1HRPT].toStdString().c_str(), lines) &&
+         gen.mn1hrpt(files[BENCH_MN1HRPT].toStdString().c_str(), lines) &&
+         gen.ahrpt(files[BENCH_AHRPT].toStdString().c_str(), lines);
+
+    if(!rc)
+        fprintf(stderr, "Failed to write the recordings to %s\n", path.toStdString().c_str());
+
+    return rc;
+}
+
+//---------------------------------------------------------------------------
+void TBenchmark::removeSidecars(const QString &filename)
+{
+    QFileInfo fi(filename);
+
+    QFile::remove(fi.absolutePath() + "/" + fi.fileName() + ".idx");
+    QFile::remove(fi.absolutePath() + "/" + fi.fileName() + ".stats");
+}
+
+//---------------------------------------------------------------------------
+void TBenchmark::removeFiles(void)
+{
+    int i;
+
+    for(i=0; i<BENCH_FORMATS; i++) {
+        if(files[i].isEmpty())
+            continue;
+
+        removeSidecars(files[i]);
+        QFile::remove(files[i]);
+    }
+}
+
+//---------------------------------------------------------------------------
+void TBenchmark::add(const char *stage, const char *format, double mb, long lines_, double seconds)
+{
+    TBenchResult r;
+
+    memset(&r, 0, sizeof(TBenchResult));
+
+    strncpy(r.stage, stage, sizeof(r.stage) - 1);
+    strncpy(r.format, format, sizeof(r.format) - 1);
+    r.mb = mb;
+    r.lines = lines_;
+    r.seconds = seconds;
+
+    results.append(r);
+}
+
+//---------------------------------------------------------------------------
+const TBenchResult *TBenchmark::find(const QList<TBenchResult> &list, const char *stage, const char *format)
+{
+    int i;
+
+    for(i=0; i<list.count(); i++)
+        if(strcmp(list.at(i).stage, stage) == 0 && strcmp(list.at(i).format, format) == 0)
+            return &list.at(i);
+
+    return NULL;
+}
+
+//---------------------------------------------------------------------------
+// all registered patterns in one pass over the mapped recording, the way
+// the decoders count the frames
+void TBenchmark::syncSearch(void)
+{
+    QElapsedTimer timer;
+    TBlockReader  reader;
+    TSyncScanner  scanner;
+    double        t, best;
+    int           i, run;
+
+    for(i=0; i<BENCH_FORMATS; i++) {
+        if(!reader.open(files[i].toStdString().c_str()))
+            continue;
+
+        scanner.clear();
+
+        switch(i) {
+            case BENCH_MN1HRPT:
+                scanner.addPattern(CADU_SYNC, CADU_SYNC_SIZE);
+                scanner.addPattern(MN1_HRPT_SYNC2, MN1_HRPT_SYNC2_SIZE);
+            break;
+
+            case BENCH_AHRPT:
+                scanner.addPattern(CADU_SYNC, CADU_SYNC_SIZE);
+            break;
+
+            default:
+                scanner.addPattern16(HRPT_SYNC, HRPT_SYNC_SIZE, true);
+                scanner.addPattern16(HRPT_SYNC, HRPT_SYNC_SIZE, false);
+        }
+
+        best = 0;
+        for(run=0; run<runs; run++) {
+            scanner.clearMatches();
+
+            timer.start();
+            scanner.scan(&reader);
+            t = seconds(&timer);
+
+            best = run == 0 || t < best ? t:best;
+        }
+
+        add("sync search", BENCH_FORMAT[i].name, reader.size() / 1e6, lines, best);
+
+        reader.close();
+    }
+}
+
+//---------------------------------------------------------------------------
+// the AHRPT CADU payloads as received, derandomized and RS decoded one at
+// a time like TCADU::getpayload does
+void TBenchmark::cadus(void)
+{
+    QElapsedTimer timer;
+    TBlockReader  reader;
+    TCADU         cadu;
+    TRSDecoder    rs(4, true);
+    quint8        *raw, *derandomized, *work, *payload;
+    long          n, allocated, i;
+    double        t, best, mb;
+    int           run;
+
+    if(!reader.open(files[BENCH_AHRPT].toStdString().c_str()))
+        return;
+
+    allocated = (long) (reader.size() / (CADU_SYNC_SIZE + CADU_PACKET_SIZE)) + 1;
+
+    raw = (quint8 *) malloc((size_t) allocated * CADU_PACKET_SIZE);
+    derandomized = (quint8 *) malloc((size_t) allocated * CADU_PACKET_SIZE);
+    work = (quint8 *) malloc((size_t) allocated * CADU_PACKET_SIZE);
+
+    if(raw == NULL || derandomized == NULL || work == NULL) {
+        qDebug("Failed to allocate %ld CADUs %s:%d", allocated, __FILE__, __LINE__);
+
+        if(raw)
+            free(raw);
+        if(derandomized)
+            free(derandomized);
+        if(work)
+            free(work);
+
+        return;
+    }
+
+    // neither derandomized nor RS decoded by the TCADU
+    cadu.init(&reader, CADU_PACKET_SIZE);
+
+    n = 0;
+    while(n < allocated && cadu.findsync() && (payload = cadu.getpayload()) != NULL)
+        memcpy(raw + (size_t) (n++) * CADU_PACKET_SIZE, payload, CADU_PACKET_SIZE);
+
+    mb = n * CADU_PACKET_SIZE / 1e6;
+
+    best = 0;
+    for(run=0; run<runs; run++) {
+        timer.start();
+        for(i=0; i<n; i++)
+            TCADU::pn_xor(derandomized + i * CADU_PACKET_SIZE, raw + i * CADU_PACKET_SIZE, CADU_PACKET_SIZE);
+        t = seconds(&timer);
+
+        best = run == 0 || t < best ? t:best;
+    }
+
+    add("derandomize", BENCH_FORMAT[BENCH_AHRPT].name, mb, lines, best);
+
+    best = 0;
+    for(run=0; run<runs; run++) {
+        // the errors are corrected in place
+        memcpy(work, derandomized, (size_t) n * CADU_PACKET_SIZE);
+
+        timer.start();
+        for(i=0; i<n; i++)
+            rs.decode(work + i * CADU_PACKET_SIZE);
+        t = seconds(&timer);
+
+        best = run == 0 || t < best ? t:best;
+    }
+
+    add("reed solomon", BENCH_FORMAT[BENCH_AHRPT].name, mb, lines, best);
+
+    free(raw);
+    free(derandomized);
+    free(work);
+}
+
+//---------------------------------------------------------------------------
+// the AVHRR-HR image of the source packets to 16 bit words
+void TBenchmark::unpack(void)
+{
+    QElapsedTimer timer;
+    quint8        *packets;
+    quint16       *line;
+    double        t, best;
+    int           y, run;
+
+    packets = gen.ahrptPackets(lines);
+    line = (quint16 *) malloc(GEN_AHRPT_SAMPLES * sizeof(quint16));
+
+    if(packets == NULL || line == NULL) {
+        if(packets)
+            free(packets);
+        if(line)
+            free(line);
+
+        return;
+    }
+
+    best = 0;
+    for(run=0; run<runs; run++) {
+        timer.start();
+        for(y=0; y<lines; y++)
+            TUnpack10::unpack(line, packets + (size_t) y * GEN_AHRPT_PACKET_SIZE + GEN_AHRPT_IMAGE_START,
+                              GEN_AHRPT_PACKET_SIZE - GEN_AHRPT_IMAGE_START, GEN_AHRPT_SAMPLES, GEN_AHRPT_IMAGE_SHIFT);
+        t = seconds(&timer);
+
+        best = run == 0 || t < best ? t:best;
+    }
+
+    add("unpack", BENCH_FORMAT[BENCH_AHRPT].name,
+        (double) lines * (GEN_AHRPT_PACKET_SIZE - GEN_AHRPT_IMAGE_START) / 1e6, lines, best);
+
+    free(packets);
+    free(line);
+}
+
+//---------------------------------------------------------------------------
+// what the GUI does when a recording is opened: the counting pass, all
+// channels to the image store and a channel and an RGB image from it
+void TBenchmark::decoder(int format)
+{
+    QElapsedTimer timer;
+    TBlock        block;
+    QImage        *image;
+    const char    *name = BENCH_FORMAT[format].name;
+    double        t, best, mb;
+    int           run, type;
+    bool          rc = false;
+
+    block.satprop->zero();
+    block.satprop->add_defaults(1);
+
+    if(BENCH_FORMAT[format].type == AHRPT_BlockType) {
+        block.satprop->derandomize(true);
+        block.satprop->rs_decode(true);
+    }
+
+    block.satprop->softSync(softsync);
+
+    if(!block.setBlockType(BENCH_FORMAT[format].type))
+        return;
+
+    best = 0;
+    for(run=0; run<runs; run++) {
+        // or the next run reads the frame index
+        removeSidecars(files[format]);
+
+        timer.start();
+        rc = block.open(files[format].toStdString().c_str());
+        t = seconds(&timer);
+
+        if(!rc)
+            break;
+
+        best = run == 0 || t < best ? t:best;
+    }
+
+    if(!rc) {
+        fprintf(stderr, "No frames found in %s\n", files[format].toStdString().c_str());
+        block.close();
+
+        return;
+    }
+
+    block.checkSatProps();
+    mb = block.getReader()->size() / 1e6;
+
+    add("open", name, mb, block.getHeight(), best);
+
+    best = 0;
+    for(run=0; run<runs; run++) {
+        block.getStore()->setDecoded(false);
+
+        timer.start();
+        rc = block.decode();
+        t = seconds(&timer);
+
+        if(!rc)
+            break;
+
+        best = run == 0 || t < best ? t:best;
+    }
+
+    if(rc)
+        add("decode", name, mb, block.getHeight(), best);
+
+    image = new QImage(block.getWidth(), block.getHeight(), QImage::Format_RGB888);
+
+    // a channel, the first RGB image
+    for(type=0; rc && !image->isNull() && type<2 && type<block.getImageTypes().count(); type++) {
+        best = 0;
+        for(run=0; run<runs; run++) {
+            timer.start();
+            block.toImage(image, type, 1);
+            t = seconds(&timer);
+
+            best = run == 0 || t < best ? t:best;
+        }
+
+        add(type == 0 ? "compose channel":"compose rgb", name,
+            (double) image->bytesPerLine() * image->height() / 1e6, block.getHeight(), best);
+    }
+
+    delete image;
+
+    block.close();
+    removeSidecars(files[format]);
+}
+
+//---------------------------------------------------------------------------
+bool TBenchmark::run(void)
+{
+    int i;
+
+    results.clear();
+
+    if(!generate())
+        return false;
+
+    syncSearch();
+    cadus();
+    unpack();
+
+    for(i=0; i<BENCH_FORMATS; i++)
+        decoder(i);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void TBenchmark::print(FILE *fp)
+{
+    const TBenchResult *r, *b;
+    double mbs;
+    int    i;
+
+    fprintf(fp, "%d scan lines, best of %d runs, %d threads, sync %s, RS %s\n",
+            lines, runs, TLinePool::threads(), TSyncScanner::engine(), TRSDecoder::engine());
+    fprintf(fp, "%ld bit errors and %ld slips in the AHRPT recording\n\n",
+            gen.getBitErrors(), gen.getSlips());
+
+    fprintf(fp, "%-16s %-8s %9s %7s %9s %9s %10s", "stage", "format", "MB", "lines", "ms", "MB/s", "lines/s");
+    fprintf(fp, baseline.isEmpty() ? "\n":" %9s\n", "baseline");
+
+    for(i=0; i<results.count(); i++) {
+        r = &results.at(i);
+        mbs = r->seconds > 0 ? r->mb / r->seconds:0;
+
+        fprintf(fp, "%-16s %-8s %9.2f %7ld %9.2f %9.1f %10.0f",
+                r->stage, r->format, r->mb, r->lines, r->seconds * 1000.0,
+                mbs, r->seconds > 0 ? r->lines / r->seconds:0);
+
+        // change of the throughput
+        b = find(baseline, r->stage, r->format);
+        if(b != NULL && b->seconds > 0 && b->mb > 0)
+            fprintf(fp, " %+8.1f%%", (mbs / (b->mb / b->seconds) - 1.0) * 100.0);
+
+        fprintf(fp, "\n");
+    }
+}
+
+//---------------------------------------------------------------------------
+// stage,format,MB,lines,seconds for the -b option of another run
+bool TBenchmark::save(const char *filename)
+{
+    FILE *fp;
+    int  i;
+
+    fp = fopen(filename, "w");
+    if(fp == NULL) {
+        fprintf(stderr, "Failed to create file %s\n", filename);
+        return false;
+    }
+
+    fprintf(fp, "# stage,format,MB,lines,seconds\n");
+
+    for(i=0; i<results.count(); i++)
+        fprintf(fp, "%s,%s,%.6f,%ld,%.9f\n", results.at(i).stage, results.at(i).format,
+                results.at(i).mb, results.at(i).lines, results.at(i).seconds);
+
+    return fclose(fp) == 0;
+}
+
+//---------------------------------------------------------------------------
+bool TBenchmark::loadBaseline(const char *filename)
+{
+    TBenchResult r;
+    FILE *fp;
+    char buf[256];
+
+    baseline.clear();
+
+    fp = fopen(filename, "r");
+    if(fp == NULL) {
+        fprintf(stderr, "Failed to open file %s\n", filename);
+        return false;
+    }
+
+    while(fgets(buf, sizeof(buf), fp) != NULL) {
+        if(buf[0] == '#')
+            continue;
+
+        memset(&r, 0, sizeof(TBenchResult));
+
+        if(sscanf(buf, "%23[^,],%15[^,],%lf,%ld,%lf", r.stage, r.format, &r.mb, &r.lines, &r.seconds) == 5)
+            baseline.append(r);
+    }
+
+    fclose(fp);
+
+    return !baseline.isEmpty();
+}
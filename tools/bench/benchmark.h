@@ -0,0 +1,97 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QList>
+#include <stdio.h>
+
+#include "passgenerator.h"
+
+//---------------------------------------------------------------------------
+#define BENCH_FORMATS   5
+
+typedef struct TBenchResult_t
+{
+    char   stage[24];
+    char   format[16];
+    double mb;      // megabytes a run processed
+    long   lines;   // scan lines a run processed
+    double seconds; // fastest run
+} TBenchResult;
+
+//---------------------------------------------------------------------------
+// Decoder throughput, see poes-bench.pro.
+// Writes a synthetic recording of every format and times the stages of the
+// decoders on them: the sync search, derandomizing, Reed-Solomon and the
+// 10 bit unpacking of the AHRPT CADUs on their own, then TBlock::open
+// (counting pass), TBlock::decode (to the image store) and the compose of
+// a channel and an RGB image. Every stage is run a number of times and the
+// fastest run is reported, so page faults and a cold cache of the first
+// one don't count.
+class TBenchmark
+{
+public:
+    TBenchmark(void);
+    ~TBenchmark(void);
+
+    void setLines(int lines_) { lines = lines_ < 1 ? 1:lines_; }
+    void setRuns(int runs_) { runs = runs_ < 1 ? 1:runs_; }
+    void setPath(const QString &path_) { path = path_; }
+    void setKeepFiles(bool yes) { keep = yes; }
+    void setSoftSync(bool yes) { softsync = yes; }
+
+    TPassGenerator *getGenerator(void) { return &gen; }
+
+    bool run(void);
+
+    void print(FILE *fp);
+    bool save(const char *filename);
+    bool loadBaseline(const char *filename);
+
+protected:
+    bool generate(void);
+    void removeFiles(void);
+    void removeSidecars(const QString &filename);
+
+    void syncSearch(void);
+    void cadus(void);
+    void unpack(void);
+    void decoder(int format);
+
+    void add(const char *stage, const char *format, double mb, long lines_, double seconds);
+    const TBenchResult *find(const QList<TBenchResult> &list, const char *stage, const char *format);
+
+private:
+    TPassGenerator gen;
+
+    int     lines, runs;
+    QString path;
+    bool    keep, softsync;
+
+    QString files[BENCH_FORMATS];
+
+    QList<TBenchResult> results, baseline;
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,126 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+// poes-bench, decoder throughput on synthetic recordings:
+//
+//   poes-bench -l 2000 -o before.csv
+//   poes-bench -l 2000 -b before.csv
+//
+// The second run prints the change of every stage against the first one.
+//---------------------------------------------------------------------------
+#include <QCoreApplication>
+#include <QStringList>
+#include <QDir>
+#include <stdio.h>
+
+#include "benchmark.h"
+#include "version.h"
+
+//---------------------------------------------------------------------------
+static void usage(void)
+{
+    printf("%s %s, decoder throughput on synthetic recordings\n\n", "poes-bench", VER_FILEVERSION_STR);
+    printf("usage: poes-bench [options]\n\n");
+    printf("  -l lines   scan lines of every recording, default 1000\n");
+    printf("  -r runs    runs of every stage, the fastest is reported, default 3\n");
+    printf("  -e rate    bit error rate, eg. 1e-5, default 0\n");
+    printf("  -p frames  cut every n:th frame or CADU short (sync slip), default 0 = never\n");
+    printf("  -s seed    random seed of the scene and the errors, default 1\n");
+    printf("  -y         soft (bit slip tolerant) CADU sync\n");
+    printf("  -d path    where the recordings are written, default is the temp directory\n");
+    printf("  -k         keep the recordings\n");
+    printf("  -o file    save the results as csv\n");
+    printf("  -b file    compare with the results of a previous run\n");
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+    TBenchmark bench;
+    QString arg, value, output;
+    bool ok;
+    int i;
+
+    bench.setPath(QDir::tempPath());
+
+    for(i=1; i<args.count(); i++) {
+        arg = args.at(i);
+
+        if(arg == "-y")
+            bench.setSoftSync(true);
+        else if(arg == "-k")
+            bench.setKeepFiles(true);
+        else if(arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        }
+        else if(arg == "-l" || arg == "-r" || arg == "-e" || arg == "-p" ||
+                arg == "-s" || arg == "-d" || arg == "-o" || arg == "-b") {
+            if(++i >= args.count()) {
+                fprintf(stderr, "Missing value of %s\n", arg.toStdString().c_str());
+                return 2;
+            }
+
+            value = args.at(i);
+            ok = true;
+
+            if(arg == "-l")
+                bench.setLines(value.toInt(&ok));
+            else if(arg == "-r")
+                bench.setRuns(value.toInt(&ok));
+            else if(arg == "-e")
+                bench.getGenerator()->setBitErrorRate(value.toDouble(&ok));
+            else if(arg == "-p")
+                bench.getGenerator()->setSlipInterval(value.toInt(&ok));
+            else if(arg == "-s")
+                bench.getGenerator()->setSeed(value.toUInt(&ok));
+            else if(arg == "-d")
+                bench.setPath(value);
+            else if(arg == "-o")
+                output = value;
+            else if(!bench.loadBaseline(value.toStdString().c_str()))
+                return 2;
+
+            if(!ok) {
+                fprintf(stderr, "Invalid value of %s: %s\n", arg.toStdString().c_str(), value.toStdString().c_str());
+                return 2;
+            }
+        }
+        else {
+            fprintf(stderr, "Unknown option: %s\n", arg.toStdString().c_str());
+            usage();
+            return 2;
+        }
+    }
+
+    if(!bench.run())
+        return 1;
+
+    bench.print(stdout);
+
+    if(!output.isEmpty() && !bench.save(output.toStdString().c_str()))
+        return 1;
+
+    return 0;
+}
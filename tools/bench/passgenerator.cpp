@@ -0,0 +1,463 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "passgenerator.h"
+#include "cadu.h"
+#include "hrptblock.h"
+#include "mn1hrptblock.h"
+#include "rsdecoder.h"
+
+//---------------------------------------------------------------------------
+const int GEN_HRPT_FRAME_SIZE     = 11090; // words
+const int GEN_HRPT_IMAGE_START    = 750;
+const int GEN_HRPT_CHANNELS       = 5;
+
+const int GEN_FY1_FRAME_SIZE      = 22180; // words
+const int GEN_FY1_IMAGE_START     = 1600;
+const int GEN_FY1_CHANNELS        = 10;
+
+const int GEN_SCAN_WIDTH          = 2048;
+
+// Meteor M-N1 HRPT, see mn1hrptblock.cpp
+const int GEN_MN1_CADU_SIZE       = 256;   // bytes
+const int GEN_MN1_IMAGE_OFFSET    = 22;    // image bytes in a CADU
+const int GEN_MN1_IMAGE_SIZE      = 232;
+const int GEN_MN1_CADUS_PER_SCAN  = 50;
+const int GEN_MN1_SCAN_SIZE       = 11600;
+const int GEN_MN1_SCAN_HEADER     = 50;    // second sync and telemetry
+const int GEN_MN1_CHANNELS        = 6;
+const int GEN_MN1_SCAN_WIDTH      = 1540;
+
+// MetOp AHRPT, see ahrptblock.cpp and packetreassembler.cpp
+const int GEN_AHRPT_SCID          = 11;    // MetOp-A
+const int GEN_AHRPT_VCID          = 9;     // AVHRR-HR
+const int GEN_AHRPT_IDLE_VCID     = 63;
+const int GEN_AHRPT_APID          = 103;
+const int GEN_AHRPT_ZONE_START    = 10;    // M_PDU packet zone in the CADU payload
+const int GEN_AHRPT_ZONE_SIZE     = 882;
+const int GEN_AHRPT_IMAGE_BIT     = (GEN_AHRPT_IMAGE_START << 3) + GEN_AHRPT_IMAGE_SHIFT;
+const int GEN_AHRPT_CHANNELS      = 5;
+
+#define GEN_FHP_NONE    0x07ff // no packet starts in the zone
+#define GEN_FHP_IDLE    0x07fe
+
+//---------------------------------------------------------------------------
+TPassGenerator::TPassGenerator(void)
+{
+    fp = NULL;
+
+    seed = state = errorstate = 1;
+    ber = 0;
+    slip = 0;
+
+    rs = new TRSDecoder(4, true);
+
+    bytes = 0;
+    errorbit = -1;
+    frames = biterrors = slips = 0;
+}
+
+//---------------------------------------------------------------------------
+TPassGenerator::~TPassGenerator(void)
+{
+    close();
+
+    delete rs;
+}
+
+//---------------------------------------------------------------------------
+// xorshift32, fast and the same on every platform
+quint32 TPassGenerator::random(quint32 *state_)
+{
+    *state_ ^= *state_ << 13;
+    *state_ ^= *state_ >> 17;
+    *state_ ^= *state_ << 5;
+
+    return *state_;
+}
+
+//---------------------------------------------------------------------------
+// bits to the next bit error, the gaps of random errors are exponential
+qint64 TPassGenerator::nextError(void)
+{
+    double u;
+
+    if(ber <= 0)
+        return -1;
+
+    u = (random(&errorstate) + 1.0) / 4294967297.0;
+
+    return (qint64) (-log(u) / ber);
+}
+
+//---------------------------------------------------------------------------
+// 10 bit MSB first sample at bit of a zero filled buffer
+void TPassGenerator::put10(quint8 *dst, qint64 bit, quint16 value)
+{
+    quint32 w;
+
+    dst += bit >> 3;
+    w = (quint32) (value & 0x03ff) << (22 - (bit & 7));
+
+    dst[0] |= w >> 24;
+    dst[1] |= (w >> 16) & 0xff;
+    if(w & 0xff00)
+        dst[2] |= (w >> 8) & 0xff;
+}
+
+//---------------------------------------------------------------------------
+// the scene, a gradient with clouds and noise, channels differ by an offset
+quint16 TPassGenerator::sample(int channel, int x, int y)
+{
+    int v;
+
+    v = 200 + ((x * 5 + y * 3) & 0xff) + channel * 60;
+
+    if((((x >> 8) + (y >> 7)) & 1) == 0)
+        v += 300 - channel * 40;
+
+    v += random(&state) & 0x0f;
+
+    return (quint16) (v & 0x03ff);
+}
+
+//---------------------------------------------------------------------------
+bool TPassGenerator::create(const char *filename)
+{
+    close();
+
+    fp = fopen(filename, "wb");
+    if(fp == NULL) {
+        qDebug("Failed to create file %s %s:%d", filename, __FILE__, __LINE__);
+        return false;
+    }
+
+    state = seed;
+    errorstate = (seed * 2654435761u) | 1;
+
+    bytes = 0;
+    frames = biterrors = slips = 0;
+    errorbit = nextError();
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool TPassGenerator::close(void)
+{
+    bool rc;
+
+    if(fp == NULL)
+        return false;
+
+    rc = fclose(fp) == 0;
+    fp = NULL;
+
+    return rc;
+}
+
+//---------------------------------------------------------------------------
+// flips the bits of buf the error rate hits, buf is written at bytes
+void TPassGenerator::corrupt(quint8 *buf, size_t len)
+{
+    qint64 bit, end = (bytes + (qint64) len) << 3;
+
+    while(errorbit >= 0 && errorbit < end) {
+        bit = errorbit - (bytes << 3);
+
+        buf[bit >> 3] ^= 0x80 >> (bit & 7);
+        biterrors++;
+
+        errorbit += 1 + nextError();
+    }
+}
+
+//---------------------------------------------------------------------------
+// the length of the next frame or CADU, every slip interval one is cut short
+size_t TPassGenerator::slipped(size_t len)
+{
+    frames++;
+
+    if(slip <= 0 || len < 2 || (frames % slip) != 0)
+        return len;
+
+    slips++;
+
+    return 1 + random(&errorstate) % (len - 1);
+}
+
+//---------------------------------------------------------------------------
+// buf is corrupted in place
+bool TPassGenerator::write(quint8 *buf, size_t len)
+{
+    corrupt(buf, len);
+
+    if(fwrite(buf, 1, len, fp) != len) {
+        qDebug("Failed to write %d bytes %s:%d", (int) len, __FILE__, __LINE__);
+        return false;
+    }
+
+    bytes += len;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// NOAA HRPT and FY-1 frames of 10 bit words in 16 bit words
+bool TPassGenerator::poesFrames(const char *filename, int lines, bool little_endian,
+                                int frame_size, int image_start, int channels)
+{
+    quint16 *frame;
+    quint8  *buf;
+    int     y, x, ch, i;
+    bool    rc = true;
+
+    frame = (quint16 *) malloc(frame_size * sizeof(quint16));
+    buf = (quint8 *) malloc(frame_size * sizeof(quint16));
+
+    if(frame == NULL || buf == NULL) {
+        qDebug("Failed to allocate %d word frame %s:%d", frame_size, __FILE__, __LINE__);
+
+        if(frame)
+            free(frame);
+        if(buf)
+            free(buf);
+
+        return false;
+    }
+
+    if(!create(filename))
+        rc = false;
+
+    for(y=0; rc && y<lines; y++) {
+        memcpy(frame, HRPT_SYNC, sizeof(HRPT_SYNC));
+
+        // telemetry and fill, never looks like the sync
+        for(i=HRPT_SYNC_SIZE; i<frame_size; i++)
+            frame[i] = (quint16) ((i + y) & 0x03ff);
+
+        for(x=0; x<GEN_SCAN_WIDTH; x++)
+            for(ch=0; ch<channels; ch++)
+                frame[image_start + x * channels + ch] = sample(ch, x, y);
+
+        for(i=0; i<frame_size; i++) {
+            buf[(i << 1) + (little_endian ? 0:1)] = frame[i] & 0xff;
+            buf[(i << 1) + (little_endian ? 1:0)] = frame[i] >> 8;
+        }
+
+        rc = write(buf, slipped(frame_size * sizeof(quint16)));
+    }
+
+    free(frame);
+    free(buf);
+
+    return close() && rc;
+}
+
+//---------------------------------------------------------------------------
+bool TPassGenerator::hrpt(const char *filename, int lines, bool little_endian)
+{
+    return poesFrames(filename, lines, little_endian,
+                      GEN_HRPT_FRAME_SIZE, GEN_HRPT_IMAGE_START, GEN_HRPT_CHANNELS);
+}
+
+//---------------------------------------------------------------------------
+bool TPassGenerator::fy1hrpt(const char *filename, int lines, bool little_endian)
+{
+    return poesFrames(filename, lines, little_endian,
+                      GEN_FY1_FRAME_SIZE, GEN_FY1_IMAGE_START, GEN_FY1_CHANNELS);
+}
+
+//---------------------------------------------------------------------------
+// 50 CADUs per scan line, the second sync and the image are split over
+// bytes 22 ... 253 of them, every 5 bytes hold 4 samples of a channel
+bool TPassGenerator::mn1hrpt(const char *filename, int lines)
+{
+    quint8 scan[GEN_MN1_SCAN_SIZE + 2], cadu[GEN_MN1_CADU_SIZE];
+    int    y, g, ch, s, i;
+    qint64 bit;
+    bool   rc;
+
+    rc = create(filename);
+
+    for(y=0; rc && y<lines; y++) {
+        memset(scan, 0, sizeof(scan));
+        memcpy(scan, MN1_HRPT_SYNC2, MN1_HRPT_SYNC2_SIZE);
+
+        for(i=MN1_HRPT_SYNC2_SIZE; i<GEN_MN1_SCAN_HEADER; i++)
+            scan[i] = (quint8) (i + y);
+
+        for(g=0; g<GEN_MN1_SCAN_WIDTH / 4; g++)
+            for(ch=0; ch<GEN_MN1_CHANNELS; ch++) {
+                bit = (GEN_MN1_SCAN_HEADER + (g * GEN_MN1_CHANNELS + ch) * 5) << 3;
+
+                for(s=0; s<4; s++)
+                    put10(scan, bit + s * 10, sample(ch, (g << 2) + s, y));
+            }
+
+        for(i=0; rc && i<GEN_MN1_CADUS_PER_SCAN; i++) {
+            memset(cadu, 0, sizeof(cadu));
+            memcpy(cadu, CADU_SYNC, CADU_SYNC_SIZE);
+
+            cadu[4] = (quint8) (y >> 8);
+            cadu[5] = (quint8) y;
+            cadu[6] = (quint8) i;
+
+            memcpy(cadu + GEN_MN1_IMAGE_OFFSET, scan + i * GEN_MN1_IMAGE_SIZE, GEN_MN1_IMAGE_SIZE);
+
+            rc = write(cadu, slipped(GEN_MN1_CADU_SIZE));
+        }
+    }
+
+    return close() && rc;
+}
+
+//---------------------------------------------------------------------------
+// one AVHRR-HR scan line, CCSDS primary header, the secondary header and
+// the 5 channels interleaved from bit 6 of byte 88
+void TPassGenerator::ahrptPacket(quint8 *packet, int y)
+{
+    int len = GEN_AHRPT_PACKET_SIZE - 7, x, ch;
+
+    memset(packet, 0, GEN_AHRPT_PACKET_SIZE);
+
+    packet[0] = 0x08 | ((GEN_AHRPT_APID >> 8) & 0x07); // secondary header follows
+    packet[1] = GEN_AHRPT_APID & 0xff;
+    packet[2] = 0xc0 | ((y >> 8) & 0x3f);                // unsegmented
+    packet[3] = y & 0xff;
+    packet[4] = len >> 8;
+    packet[5] = len & 0xff;
+
+    // time code
+    packet[8] = (quint8) (y >> 16);
+    packet[9] = (quint8) (y >> 8);
+    packet[10] = (quint8) y;
+
+    for(x=0; x<GEN_SCAN_WIDTH; x++)
+        for(ch=0; ch<GEN_AHRPT_CHANNELS; ch++)
+            put10(packet, GEN_AHRPT_IMAGE_BIT + (qint64) (x * GEN_AHRPT_CHANNELS + ch) * 10, sample(ch, x, y));
+}
+
+//---------------------------------------------------------------------------
+quint8 *TPassGenerator::ahrptPackets(int lines)
+{
+    quint8 *packets;
+    int    y;
+
+    if(lines <= 0)
+        return NULL;
+
+    packets = (quint8 *) malloc((size_t) lines * GEN_AHRPT_PACKET_SIZE);
+    if(packets == NULL) {
+        qDebug("Failed to allocate %d source packets %s:%d", lines, __FILE__, __LINE__);
+        return NULL;
+    }
+
+    state = seed;
+
+    for(y=0; y<lines; y++)
+        ahrptPacket(packets + (size_t) y * GEN_AHRPT_PACKET_SIZE, y);
+
+    return packets;
+}
+
+//---------------------------------------------------------------------------
+// completes the VCDU header of payload, adds the RS parity, randomizes and
+// writes it after the attached sync marker
+bool TPassGenerator::writeCADU(quint8 *payload, int vcid, quint32 counter)
+{
+    quint8 cadu[CADU_SYNC_SIZE + CADU_PACKET_SIZE];
+
+    payload[0] = 0x40 | (GEN_AHRPT_SCID >> 2);
+    payload[1] = ((GEN_AHRPT_SCID & 3) << 6) | vcid;
+    payload[2] = (quint8) (counter >> 16);
+    payload[3] = (quint8) (counter >> 8);
+    payload[4] = (quint8) counter;
+    payload[5] = 0;
+    payload[6] = payload[7] = 0; // not encrypted
+
+    rs->encode(payload);
+
+    memcpy(cadu, CADU_SYNC, CADU_SYNC_SIZE);
+    TCADU::pn_xor(cadu + CADU_SYNC_SIZE, payload, CADU_PACKET_SIZE);
+
+    return write(cadu, slipped(sizeof(cadu)));
+}
+
+//---------------------------------------------------------------------------
+// one source packet per scan line in the M_PDU zones of VC 9 CADUs, every
+// GEN_AHRPT_IDLE_INTERVAL CADU is an idle frame
+bool TPassGenerator::ahrpt(const char *filename, int lines)
+{
+    quint8  packet[GEN_AHRPT_PACKET_SIZE], payload[CADU_PACKET_SIZE];
+    quint32 counter = 0, idle = 0;
+    int     y, pos, n, zone = 0, fhp = GEN_FHP_NONE;
+    bool    rc;
+
+    rc = create(filename);
+    memset(payload, 0, sizeof(payload));
+
+    for(y=0; rc && y<lines; y++) {
+        ahrptPacket(packet, y);
+
+        for(pos=0; rc && pos<GEN_AHRPT_PACKET_SIZE; ) {
+            if(pos == 0 && fhp == GEN_FHP_NONE)
+                fhp = zone;
+
+            n = GEN_AHRPT_PACKET_SIZE - pos;
+            if(n > GEN_AHRPT_ZONE_SIZE - zone)
+                n = GEN_AHRPT_ZONE_SIZE - zone;
+
+            memcpy(payload + GEN_AHRPT_ZONE_START + zone, packet + pos, n);
+            zone += n;
+            pos += n;
+
+            if(zone < GEN_AHRPT_ZONE_SIZE && y < lines - 1)
+                continue;
+
+            // zone full or the last packet written, the rest stays zero
+            payload[8] = (fhp >> 8) & 0x07;
+            payload[9] = fhp & 0xff;
+
+            rc = writeCADU(payload, GEN_AHRPT_VCID, counter++);
+
+            memset(payload, 0, sizeof(payload));
+            zone = 0;
+            fhp = GEN_FHP_NONE;
+
+            if(rc && (counter % (GEN_AHRPT_IDLE_INTERVAL - 1)) == 0) {
+                memset(payload + GEN_AHRPT_ZONE_START, 0x55, GEN_AHRPT_ZONE_SIZE);
+                payload[8] = (GEN_FHP_IDLE >> 8) & 0x07;
+                payload[9] = GEN_FHP_IDLE & 0xff;
+
+                rc = writeCADU(payload, GEN_AHRPT_IDLE_VCID, idle++);
+
+                memset(payload, 0, sizeof(payload));
+            }
+        }
+    }
+
+    return close() && rc;
+}
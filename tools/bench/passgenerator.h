@@ -0,0 +1,103 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef PASSGENERATOR_H
+#define PASSGENERATOR_H
+
+#include <QtGlobal>
+#include <stdio.h>
+
+//---------------------------------------------------------------------------
+#define GEN_AHRPT_PACKET_SIZE   12966 // bytes, AVHRR-HR source packet of one scan line
+#define GEN_AHRPT_IMAGE_START   88    // bytes, the image starts 6 bits into this one
+#define GEN_AHRPT_IMAGE_SHIFT   6
+#define GEN_AHRPT_SAMPLES       10240 // 5 channels x 2048
+#define GEN_AHRPT_IDLE_INTERVAL 8     // every 8th CADU is an idle (VC 63) frame
+
+class TRSDecoder;
+
+//---------------------------------------------------------------------------
+// Writes synthetic recordings in the formats the decoders read, see poes-bench.pro.
+// Every channel is the same smooth scene with a channel offset and some
+// noise, so the compose stage sees realistic histograms.
+// The scene and the errors only depend on the seed, two runs with the same
+// settings write identical files.
+//
+// Errors are added to what the receiver would have seen: bit errors at
+// the given rate over the whole stream (sync words, headers and RS parity
+// included) and every slip interval frames or CADUs one that is cut short
+// at a random length, the decoder has to find the sync of the next one.
+class TPassGenerator
+{
+public:
+    TPassGenerator(void);
+    ~TPassGenerator(void);
+
+    void setSeed(quint32 seed_) { seed = seed_ ? seed_:1; }
+    void setBitErrorRate(double ber_) { ber = ber_ < 0 ? 0:ber_; }
+    void setSlipInterval(int frames) { slip = frames < 0 ? 0:frames; }
+
+    // lines is the number of scan lines, false if the file can't be written
+    bool hrpt(const char *filename, int lines, bool little_endian = true);
+    bool fy1hrpt(const char *filename, int lines, bool little_endian = true);
+    bool mn1hrpt(const char *filename, int lines);
+    bool ahrpt(const char *filename, int lines);
+
+    // the AVHRR-HR image bytes of lines AHRPT source packets back to back,
+    // GEN_AHRPT_PACKET_SIZE bytes each, for the unpack stage
+    quint8 *ahrptPackets(int lines);
+
+    qint64 getBytes(void) { return bytes; }
+    long   getBitErrors(void) { return biterrors; }
+    long   getSlips(void) { return slips; }
+
+    quint16 sample(int channel, int x, int y);
+
+protected:
+    bool create(const char *filename);
+    bool close(void);
+    bool write(quint8 *buf, size_t len);
+    size_t  slipped(size_t len);
+    void    corrupt(quint8 *buf, size_t len);
+    static quint32 random(quint32 *state_);
+    qint64  nextError(void);
+
+    bool poesFrames(const char *filename, int lines, bool little_endian,
+                    int frame_size, int image_start, int channels);
+
+    void ahrptPacket(quint8 *packet, int y);
+    bool writeCADU(quint8 *payload, int vcid, quint32 counter);
+
+    static void put10(quint8 *dst, qint64 bit, quint16 value);
+
+private:
+    FILE   *fp;
+    quint32 seed, state, errorstate; // scene and error random numbers
+    double  ber;
+    int     slip;
+
+    TRSDecoder *rs;
+
+    qint64 bytes, errorbit;
+    long   frames, biterrors, slips;
+};
+
+#endif // PASSGENERATOR_H
@@ -27,6 +27,8 @@
 #include "cadusplitterdialog.h"
 #include "ui_cadusplitterdialog.h"
 #include "cadu.h"
+#include "blockreader.h"
+#include "packetreassembler.h"
 
 //---------------------------------------------------------------------------
 CADUSplitterDialog::CADUSplitterDialog(QWidget *parent) :
@@ -37,8 +39,8 @@ CADUSplitterDialog::CADUSplitterDialog(QWidget *parent) :
     setLayout(ui->mainLayout);
 
     cadu = new TCADU;
+    reader = new TBlockReader;
 
-    infp = NULL;
     outfp = NULL;
 }
 
@@ -49,6 +51,7 @@ CADUSplitterDialog::~CADUSplitterDialog()
 
     closeFiles();
     delete cadu;
+    delete reader;
 }
 
 //---------------------------------------------------------------------------
@@ -143,8 +146,7 @@ bool CADUSplitterDialog::openFiles(bool ahrpt)
        ui->infileEd->text() == outfile)
         return false;
 
-    infp = fopen(ui->infileEd->text().toStdString().c_str(), "rb");
-    if(!infp) {
+    if(!reader->open(ui->infileEd->text().toStdString().c_str())) {
         QMessageBox::critical(this, "Error: Failed to open file!", ui->infileEd->text());
         return false;
     }
@@ -161,9 +163,10 @@ bool CADUSplitterDialog::openFiles(bool ahrpt)
 
     cadu->reed_solomon(ui->rsdecodeCb->isChecked());
     cadu->derandomize(ui->derandomizeCb->isChecked());
+    cadu->soft_sync(ui->softSyncCb->isChecked());
     cadu->lrit_cadu(ahrpt ? false:true);
 
-    if(!cadu->init(infp, CADU_PACKET_SIZE, outfp)) {
+    if(!cadu->init(reader, CADU_PACKET_SIZE, outfp)) {
         closeFiles();
 
         QMessageBox::critical(this, "Error: Failed to initialize CCSDS class!", "Out of memory?");
@@ -176,15 +179,13 @@ bool CADUSplitterDialog::openFiles(bool ahrpt)
 //---------------------------------------------------------------------------
 void CADUSplitterDialog::closeFiles(void)
 {
-    if(infp)
-        fclose(infp);
+    reader->close();
 
     if(outfp)
         fclose(outfp);
 
     cadu->reset();
 
-    infp = NULL;
     outfp = NULL;
 }
 
@@ -203,119 +204,86 @@ void CADUSplitterDialog::on_genGOESdataBtn_clicked()
     if(!openFiles(false))
         return;
 
-    quint8  *vcdu, *m_pdu, *cp_pdu, *s_pdu;
-    quint8  *img_hdr;
-    quint8  vcid, sequenceflag;
-    quint16 apid, hdr_ptr, packet_length, hdr_len, sequence_count, all_hdr_len;
-    quint16 image_index, u16, bytes_read;
-    quint32 u32;
-    quint64 data_len, u64;
-
-    long    addr;
-    bool found;
+    TPacketReassembler  *vc_packets[STATS_MAX_VCID];
+    const TSourcePacket *packet;
+    const quint8 *data;
+    quint8  *s_pdu, *img_hdr;
+    quint8  vcid;
+    quint16 hdr_len, file_apid;
+    quint32 all_hdr_len;
+    quint64 data_len, bytes_written;
+    int     i, len, image_index;
 
     char txt[512];
-    FILE *txtfp = NULL;
+    FILE *txtfp = NULL, *lritfp = NULL;
 
     txtfp = fopen("/home/patrik/tmp/msg_frames-1.txt", "w");
 
-    image_index = 0;
-    found = false;
+    for(i=0; i<STATS_MAX_VCID; i++)
+        vc_packets[i] = NULL;
 
+    image_index = 0;
+    file_apid = 0;
+    data_len = bytes_written = 0;
 
     while(cadu->findsync()) {
-        vcdu = cadu->getpayload(); // VCDU (1020 bytes) without sync marker
-        if(!vcdu)
+        if(cadu->getpayload() == NULL) // VCDU (1020 bytes) without sync marker
             break;
 
         vcid = cadu->vcid();
         if(vcid == 63) // skip filler packets
             continue;
 
-#if 0
-        cadu->writepacket(true);
-        continue;
-#endif
-
-        addr = cadu->getpacketaddress();
-
-#if 0
-//        qDebug("\naddress: 0x%08x vcid: %d", (unsigned int) addr, (int) vcid);
-        if(addr < 0x017c4c00)
-            continue;
-#endif
-
-        m_pdu = cadu->get_mpdu();
-        if(m_pdu == NULL)
-            continue;
-
-        /*
-            M_PDU packet zone (CP_PDU) does not contain a header if
-            first header pointer is 2047 (0x07ff). It contains data from a
-            previous packet
-        */
+        // the M_PDUs of each virtual channel carry their own packets
+        if(vc_packets[vcid] == NULL)
+            vc_packets[vcid] = new TPacketReassembler;
 
-        if(!cadu->first_hdr_ptr(&hdr_ptr) || hdr_ptr == 0x07ff) {
-            hdr_ptr = 0;
-        }
-        // qDebug("header pointer: 0x%04x (%d)", hdr_ptr, (int)hdr_ptr);
-
-        cp_pdu = m_pdu + 0x02 + hdr_ptr;
-        sequenceflag = cadu->sequenceflag(cp_pdu);
-        sequence_count = ((cp_pdu[2] << 8) | cp_pdu[3]) & 0x3fff; // 14 bit
-        packet_length = (cp_pdu[4] << 8) | cp_pdu[5];
-        apid = cadu->apid(cp_pdu);
+        vc_packets[vcid]->push(cadu);
 
-#if 0
-        if(apid != 0) {
-            qDebug("\n->address: 0x%08x vcid: %d", (unsigned int) addr, (int) vcid);
-            qDebug("->apid: %d, header pointer: 0x%04x, sequence flag: %d, sequence count: %d, packet length: %d",
-                   (int) apid,
-                   hdr_ptr,
-                   (int) sequenceflag,
-                   (int) sequence_count,
-                   (int) packet_length);
-        }
-#endif
+        while((packet = vc_packets[vcid]->next()) != NULL) {
+            // CP_PDU data field, ends with a 2 byte CRC
+            data = packet->data + PACKET_PRIMARY_HDR_LEN;
+            len = packet->size - PACKET_PRIMARY_HDR_LEN - 2;
+            if(len <= 0)
+                continue;
 
-        if(apid == 0) {
-            // it is an MSGi application process id
+            if(packet->sequenceflag & 1) {
+                // first segment of a transport file, close previous file
+                if(lritfp)
+                    fclose(lritfp);
+                lritfp = NULL;
 
-            // close previous file
-            if(cadu->outfp)
-                fclose(cadu->outfp);
-            cadu->outfp = NULL;
-            bytes_read = 0;
+                // 10 byte TP_PDU header and the LRIT file primary header
+                if(len < 0x0a + 0x10)
+                    continue;
 
-            // read the primary header
-            s_pdu = cp_pdu + 0x06 + 0x0a;
-            hdr_len = (s_pdu[1] << 8) | s_pdu[2];
-            all_hdr_len = (s_pdu[4] << 24) | (s_pdu[5] << 16) | (s_pdu[6] << 8) | s_pdu[7];
+                s_pdu = (quint8 *) data + 0x0a;
+                hdr_len = (s_pdu[1] << 8) | s_pdu[2];
+                all_hdr_len = ((quint32) s_pdu[4] << 24) | (s_pdu[5] << 16) | (s_pdu[6] << 8) | s_pdu[7];
 
-            data_len = (quint64) ((s_pdu[8] << 56) | (s_pdu[9] << 48) | (s_pdu[10] << 40) | (s_pdu[11] << 32) |
-                       (s_pdu[12] << 24) | (s_pdu[13] << 16) | (s_pdu[14] << 8) | s_pdu[15]);
-            data_len >>= 3; // in bytes
+                data_len = 0;
+                for(i=8; i<16; i++)
+                    data_len = (data_len << 8) | s_pdu[i];
+                data_len >>= 3; // in bytes
 
-            if(hdr_len == 0 || all_hdr_len == 0 || data_len == 0 /*|| data_len > 8190*/)
-                continue;
+                if(hdr_len == 0 || all_hdr_len == 0 || data_len == 0)
+                    continue;
 
-            if(s_pdu[0] == 0x00 && s_pdu[3] == 0x00) {
-                if(hdr_len != 0x10) // primary header is 16 bytes
+                if(s_pdu[0] != 0x00 || s_pdu[3] != 0x00 || hdr_len != 0x10) // image file, 16 byte primary header
                     continue;
 
                 image_index++;
 
                 sprintf(txt, "============================================================");
                 print_debug(txt, txtfp);
-                sprintf(txt, "\nvcdu address: 0x%08x vcid: %d", (unsigned int) addr, (int) vcid);
+                sprintf(txt, "\nvcdu address: 0x%08x vcid: %d", (unsigned int) packet->address, (int) vcid);
                 print_debug(txt, txtfp);
 
-                sprintf(txt, "apid: %d, header pointer: 0x%04x, sequence flag: %d, sequence count: %d, packet length: %d, data length: %d",
-                        (int) apid,
-                        hdr_ptr,
-                        (int) sequenceflag,
-                        (int) sequence_count,
-                        (int) packet_length,
+                sprintf(txt, "apid: %d, sequence flag: %d, sequence count: %d, packet length: %d, data length: %d",
+                        (int) packet->apid,
+                        (int) packet->sequenceflag,
+                        (int) packet->sequence_count,
+                        (int) packet->size,
                         (int) data_len);
                 print_debug(txt, txtfp);
 
@@ -325,55 +293,50 @@ void CADUSplitterDialog::on_genGOESdataBtn_clicked()
                 // image file, set pointer at first secondary header
                 img_hdr = s_pdu + hdr_len;
                 lrit_secondary_header_decoder(img_hdr);
+                lrit_msg_header_decoder_debug(img_hdr, txtfp);
 
-                if(cadu->outfp) {
-                    // write this packet to the lrit file, starting from first secondary header until packet end
-                    // m_pdu packet is 884 bytes, primary header is 16 bytes
-
-                    u16 = 884 - hdr_ptr - 16;
-                    fwrite(s_pdu, 1, u16, cadu->outfp);
-
-                    // data starts at byte 8 from vcdu packet and is 884 bytes, m_pdu packet zone (cp_pdu)
-                    // vcdu hdr = 6 + m_pdu hdr = 2 -> 8 bytes
-                    // the last packet includes 2 byte crc
-                    // write to file until bytes_read < data_len
-                }
+                QString lritfile = QString("%1.%2").arg(ui->lritoutfileEd->text()).arg(image_index, 4, 10, QChar('0'));
+                lritfp = fopen(lritfile.toStdString().c_str(), "wb");
+                file_apid = packet->apid;
 
-                // debug
-                img_hdr = s_pdu + hdr_len;
-                lrit_msg_header_decoder_debug(img_hdr, txtfp);
+                // the LRIT file starts with the primary header
+                if(lritfp)
+                    fwrite(s_pdu, 1, len - 0x0a, lritfp);
+                bytes_written = len - 0x0a;
             }
-        } // end apid == 0
-        else if(cadu->outfp) {
-            // figure out how much to write
-            u64 = data_len - bytes_read;
-            if(u64 <= 884)
-                u16 = (quint16) (u64 - 2); // skip crc
-            else
-                u16 = 884;
+            else if(lritfp && packet->apid == file_apid) {
+                if(packet->missing) {
+                    sprintf(txt, "apid: %d, %d segments lost before sequence count %d",
+                            (int) packet->apid, packet->missing, (int) packet->sequence_count);
+                    print_debug(txt, txtfp);
+                }
 
-            fwrite(cp_pdu, 1, u16, cadu->outfp);
-            bytes_read += u16;
+                fwrite(data, 1, len, lritfp);
+                bytes_written += len;
 
-            sprintf(txt, "\nvcdu address: 0x%08x vcid: %d\npacket size: %d, total bytes written: %d of %d",
-                    (unsigned int) addr,
-                    (int) vcid,
-                    (int) u16,
-                    (int) bytes_read,
-                    (int) data_len);
-            print_debug(txt, txtfp);
-
-            if(bytes_read >= (data_len - 2)) { // crc skipped
-                fclose(cadu->outfp);
-                cadu->outfp = NULL;
+                sprintf(txt, "\nvcdu address: 0x%08x vcid: %d\npacket size: %d, total bytes written: %d of %d",
+                        (unsigned int) packet->address,
+                        (int) vcid,
+                        len,
+                        (int) bytes_written,
+                        (int) data_len);
+                print_debug(txt, txtfp);
             }
 
-
+            // last segment
+            if(lritfp && packet->apid == file_apid && (packet->sequenceflag & 2)) {
+                fclose(lritfp);
+                lritfp = NULL;
+            }
         }
-
-
     }
 
+    for(i=0; i<STATS_MAX_VCID; i++)
+        if(vc_packets[i])
+            delete vc_packets[i];
+
+    if(lritfp)
+        fclose(lritfp);
 
     if(txtfp)
         fclose(txtfp);
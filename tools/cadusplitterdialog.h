@@ -31,6 +31,7 @@ namespace Ui {
 }
 
 class TCADU;
+class TBlockReader;
 //---------------------------------------------------------------------------
 class CADUSplitterDialog : public QDialog
 {
@@ -43,7 +44,8 @@ public:
 private:
     Ui::CADUSplitterDialog *ui;
     TCADU *cadu;
-    FILE  *infp, *outfp;
+    TBlockReader *reader;
+    FILE  *outfp;
 
 protected:
     QString changePrefix(QString filename, bool ahrpt);
@@ -0,0 +1,291 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QSettings>
+#include <QImage>
+#include <stdio.h>
+
+#include "batchdecoder.h"
+#include "config.h"
+#include "colorscale.h"
+#include "plist.h"
+
+//---------------------------------------------------------------------------
+static const char *BLOCK_NAMES[NUM_SUPPORTED_BLOCKS] =
+{
+   "hrpt",
+   "fy1hrpt",
+   "ahrpt",
+   "mn1hrpt",
+   "fyahrpt",
+
+   "lrpt",
+   "mn1lrpt",
+   "lrit",
+   "lritjpeg"
+};
+
+//---------------------------------------------------------------------------
+TBatchDecoder::TBatchDecoder(void)
+{
+    block = new TBlock;
+
+    TColorScale::setPath(QCoreApplication::applicationDirPath() + "/" + PATH_LUT);
+
+    blocktype = HRPT_BlockType;
+    direction = BATCH_PASSINFO;
+    format = "png";
+
+    northbound = false;
+}
+
+//---------------------------------------------------------------------------
+TBatchDecoder::~TBatchDecoder(void)
+{
+    delete block;
+}
+
+//---------------------------------------------------------------------------
+// name is a block type number (0 ... NUM_SUPPORTED_BLOCKS - 1) or one of
+// BLOCK_NAMES, Undefined_BlockType if unknown
+Block_Type TBatchDecoder::blockType(const QString &name)
+{
+    bool ok;
+    int  i;
+
+    i = name.toInt(&ok);
+    if(ok)
+        return i >= 0 && i < NUM_SUPPORTED_BLOCKS ? (Block_Type) i:Undefined_BlockType;
+
+    for(i=0; i<NUM_SUPPORTED_BLOCKS; i++)
+        if(name.compare(BLOCK_NAMES[i], Qt::CaseInsensitive) == 0)
+            return (Block_Type) i;
+
+    return Undefined_BlockType;
+}
+
+//---------------------------------------------------------------------------
+// satellite name and direction from the passinfo file the tracker saved
+// next to the recording, see TSat::SavePassinfo
+bool TBatchDecoder::readPassinfo(const QString &filename)
+{
+    QFileInfo fi(filename);
+    QString   inifile = fi.absolutePath() + "/" + fi.completeBaseName() + ".ini";
+
+    satname.clear();
+    northbound = false;
+
+    fi.setFile(inifile);
+    if(!fi.exists())
+        return false;
+
+    QSettings reg(inifile, QSettings::IniFormat);
+
+    reg.beginGroup("TLE");
+       satname = reg.value("Name", "").toString();
+    reg.endGroup();
+
+    reg.beginGroup("PassInfo");
+       northbound = reg.value("Northbound", false).toBool();
+    reg.endGroup();
+
+    return !satname.isEmpty();
+}
+
+//---------------------------------------------------------------------------
+// decoder, RGB and NDVI settings of the satellite from the satellites.ini
+// the GUI writes, see MainWindow::writeSatelliteSettings
+bool TBatchDecoder::readProperties(const QString &name)
+{
+    QString ini, str;
+    int     i;
+
+    ini = satini;
+    if(ini.isEmpty()) {
+        ini = QCoreApplication::applicationDirPath() + "/" + PATH_CONF + "/" + FILE_SAT_INI;
+        if(!QFileInfo(ini).exists())
+            ini = QCoreApplication::applicationDirPath() + "/" + PATH_CONF + "/default-" + FILE_SAT_INI;
+    }
+
+    if(!QFileInfo(ini).exists())
+        return false;
+
+    QSettings reg(ini, QSettings::IniFormat);
+
+    for(i=1; ; i++) {
+        str.sprintf("Spacecraft_%d", i);
+
+        reg.beginGroup(str);
+
+        str = reg.value("Name", "").toString();
+        if(str.isEmpty()) {
+            reg.endGroup();
+            break;
+        }
+
+        if(str == name) {
+            block->satprop->readSettings(&reg);
+            reg.endGroup();
+
+            return true;
+        }
+
+        reg.endGroup();
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+// <output path>/<recording without its extension>-<product>.<format> for
+// every channel, RGB, NDVI and EVI setting, see TBlock::getImageTypes
+void TBatchDecoder::addProducts(const QString &filename)
+{
+    QFileInfo   fi(filename);
+    QStringList names;
+    QString     path, str;
+    int         i, ch;
+
+    files.clear();
+    types.clear();
+    channels.clear();
+
+    path = outpath.isEmpty() ? fi.absolutePath():outpath;
+    path += "/" + fi.completeBaseName() + "-";
+
+    if(block->getNumChannels() == 0) {
+        // rendered by the format itself, see TBlock::toImage
+        files.append(path + "image." + format);
+        types.append(0);
+        channels.append(1);
+
+        return;
+    }
+
+    for(ch=1; ch<=block->getNumChannels(); ch++) {
+        str.sprintf("ch%d.", ch);
+        files.append(path + str + format);
+        types.append(0);
+        channels.append(ch);
+    }
+
+    names = block->getImageTypes();
+    for(i=1; i<names.count(); i++) {
+        str = names.at(i).simplified().replace(' ', '-').replace('/', '-');
+
+        files.append(path + str + "." + format);
+        types.append(i);
+        channels.append(1);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool TBatchDecoder::save(QImage *image, const QString &filename)
+{
+    if(!image->save(filename, 0, 75)) {
+        fprintf(stderr, "Failed to save image: %s\n", filename.toStdString().c_str());
+        return false;
+    }
+
+    printf("%s\n", filename.toStdString().c_str());
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// renders and saves product y on a worker thread, see decode
+bool TBatchDecoder::decodeLine(int /*worker*/, int y)
+{
+    QImage image(block->getWidth(), block->getHeight(), QImage::Format_RGB888);
+
+    if(image.isNull()) {
+        fprintf(stderr, "Failed to create QImage %dx%d\n", block->getWidth(), block->getHeight());
+        return false;
+    }
+
+    if(!block->toImage(&image, types.at(y), channels.at(y)))
+        return false;
+
+    return save(&image, files.at(y));
+}
+
+//---------------------------------------------------------------------------
+bool TBatchDecoder::decode(const QString &filename)
+{
+    QImage *image;
+    long   saved;
+    bool   rc;
+
+    // the decoder options are needed by setBlockType
+    block->satprop->zero();
+
+    if(!readPassinfo(filename))
+        fprintf(stderr, "Warning: Couldn't read/find passinfo file (.ini) of %s\n", filename.toStdString().c_str());
+
+    if(satname.isEmpty() || !readProperties(satname))
+        block->satprop->add_defaults(1);
+
+    if(block->satprop->rgblist->Count == 0)
+        block->satprop->add_rgb_defaults();
+
+    if(!block->setBlockType(blocktype)) {
+        fprintf(stderr, "Unsupported type: %s %s\n",
+                block->getBlockTypeStr(blocktype).toStdString().c_str(),
+                filename.toStdString().c_str());
+
+        return false;
+    }
+
+    block->setNorthBound(direction == BATCH_PASSINFO ? northbound:direction == BATCH_NORTHBOUND);
+
+    if(!block->open(filename.toStdString().c_str())) {
+        fprintf(stderr, "No frames found in file %s\n", filename.toStdString().c_str());
+        block->close();
+
+        return false;
+    }
+
+    block->checkSatProps();
+    addProducts(filename);
+
+    if(block->getNumChannels() > 0) {
+        // all channels at once on all cores, the products from the image store
+        rc = block->decode();
+        if(rc) {
+            saved = TLinePool::run(this, files.count(), TLinePool::threads());
+            rc = saved == files.count();
+        }
+    }
+    else {
+        image = new QImage(block->getWidth(), block->getHeight(), QImage::Format_RGB888);
+
+        rc = !image->isNull() && block->toImage(image) && save(image, files.at(0));
+
+        delete image;
+    }
+
+    block->close();
+
+    return rc;
+}
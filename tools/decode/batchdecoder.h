@@ -0,0 +1,81 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+#ifndef BATCHDECODER_H
+#define BATCHDECODER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+#include "block.h"
+#include "linepool.h"
+
+//---------------------------------------------------------------------------
+#define BATCH_SOUTHBOUND    0
+#define BATCH_NORTHBOUND    1
+#define BATCH_PASSINFO      2 // direction from the passinfo file, southbound if unknown
+
+//---------------------------------------------------------------------------
+// Decodes recordings without the GUI, see poes-decode.pro.
+// A recording is decoded once on all cores, then every channel, RGB and
+// NDVI product configured for the satellite of its passinfo file (.ini)
+// is rendered and saved, one product per worker thread.
+class TBatchDecoder : public TLineJob
+{
+public:
+    TBatchDecoder(void);
+    ~TBatchDecoder(void);
+
+    void setBlockType(Block_Type type) { blocktype = type; }
+    void setDirection(int direction_) { direction = direction_; }
+    void setFormat(const QString &format_) { format = format_; }
+    void setOutputPath(const QString &path) { outpath = path; }
+    void setSatelliteIni(const QString &filename) { satini = filename; }
+
+    bool decode(const QString &filename);
+    bool decodeLine(int worker, int y);
+
+    static Block_Type blockType(const QString &name);
+
+protected:
+    bool readPassinfo(const QString &filename);
+    bool readProperties(const QString &name);
+    void addProducts(const QString &filename);
+    bool save(QImage *image, const QString &filename);
+
+private:
+    TBlock  *block;
+
+    Block_Type blocktype;
+    int     direction;
+    QString format, outpath, satini;
+
+    QString satname;
+    bool    northbound;
+
+    // products of the recording being decoded
+    QStringList files;
+    QList<int>  types, channels;
+};
+
+#endif // BATCHDECODER_H
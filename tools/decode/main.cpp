@@ -0,0 +1,127 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+// poes-decode, decodes recordings without the GUI, eg. as the post rx
+// script of the tracker:
+//
+//   poes-decode -t ahrpt -f tif -o /data/images /data/metop-a.cadu
+//
+// Every channel, RGB, NDVI and EVI product configured for the satellite of the
+// passinfo file is saved as <recording>-<product>.<format>.
+//---------------------------------------------------------------------------
+#include <QCoreApplication>
+#include <QStringList>
+#include <stdio.h>
+
+#if defined(HAVE_IMAGE_PLUGINS)
+# include <QtPlugin>
+
+  Q_IMPORT_PLUGIN(qtiff)
+#endif
+
+#include "batchdecoder.h"
+#include "version.h"
+#include "trace.h"
+
+//---------------------------------------------------------------------------
+static void usage(void)
+{
+    printf("%s %s, decodes recordings to images\n\n", "poes-decode", VER_FILEVERSION_STR);
+    printf("usage: poes-decode [options] recording [recording ...]\n\n");
+    printf("  -t type    hrpt (default), fy1hrpt, ahrpt, mn1hrpt, fyahrpt, mn1lrpt, lrit, lritjpeg\n");
+    printf("  -f format  png (default), tif or any other format Qt can write\n");
+    printf("  -o path    output directory, default is the directory of the recording\n");
+    printf("  -c file    satellites.ini with the RGB, NDVI and EVI settings, default is the one of POES-USRP\n");
+    printf("  -n         northbound pass\n");
+    printf("  -s         southbound pass, default is the direction of the passinfo file\n");
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+    QStringList recordings;
+    TBatchDecoder decoder;
+    Block_Type type;
+    QString arg;
+    int i, failed;
+
+    for(i=1; i<args.count(); i++) {
+        arg = args.at(i);
+
+        if(arg == "-n")
+            decoder.setDirection(BATCH_NORTHBOUND);
+        else if(arg == "-s")
+            decoder.setDirection(BATCH_SOUTHBOUND);
+        else if(arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        }
+        else if(arg == "-t" || arg == "-f" || arg == "-o" || arg == "-c") {
+            if(++i >= args.count()) {
+                fprintf(stderr, "Missing value of %s\n", arg.toStdString().c_str());
+                return 2;
+            }
+
+            if(arg == "-t") {
+                type = TBatchDecoder::blockType(args.at(i));
+                if(type == Undefined_BlockType) {
+                    fprintf(stderr, "Unknown type: %s\n", args.at(i).toStdString().c_str());
+                    return 2;
+                }
+
+                decoder.setBlockType(type);
+            }
+            else if(arg == "-f")
+                decoder.setFormat(args.at(i));
+            else if(arg == "-o")
+                decoder.setOutputPath(args.at(i));
+            else
+                decoder.setSatelliteIni(args.at(i));
+        }
+        else if(arg.startsWith("-")) {
+            fprintf(stderr, "Unknown option: %s\n", arg.toStdString().c_str());
+            usage();
+            return 2;
+        }
+        else
+            recordings.append(arg);
+    }
+
+    if(recordings.isEmpty()) {
+        usage();
+        return 2;
+    }
+
+    // one recording at a time, each is decoded and saved on all cores
+    TRACE_START();
+
+    failed = 0;
+    for(i=0; i<recordings.count(); i++)
+        if(!decoder.decode(recordings.at(i)))
+            failed++;
+
+    TRACE_STOP("poes-decode-trace.json");
+
+    return failed ? 1:0;
+}
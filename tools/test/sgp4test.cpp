@@ -0,0 +1,276 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+// poes-sgp4test, TSGP4Batch against TSat::Calc:
+//
+//   poes-sgp4test [tle file]
+//
+// Every near earth set is propagated at SGP4TEST_SAMPLES times with the
+// batch and with TSat::Calc, azimuth, elevation and range must agree.
+// Exits with 1 if they don't.
+//---------------------------------------------------------------------------
+#include <QElapsedTimer>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Satellite.h"
+#include "sgp4batch.h"
+#include "satcalc.h"
+#include "plist.h"
+#include "version.h"
+
+//---------------------------------------------------------------------------
+#define SGP4TEST_SAMPLES   20000
+#define SGP4TEST_DAYS      9.0
+#define SGP4TEST_ANGLE     1e-6  // degrees
+#define SGP4TEST_RANGE     1e-6  // km
+
+// without a tle file, the deep space one must be left out of the batch
+static const char *tles[] = {
+    "LEO 51",
+    "1 40000U 98067A   24001.51782528  .00000090  00000-0 -11606-4 0  2923",
+    "2 40000  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563531",
+    "SSO 99",
+    "1 40001U 98067A   24001.50000000  .00000090  00000-0  72752-4 0  2929",
+    "2 40001  99.1950 061.0512 0013700 200.1234 159.9321 14.12800000563536",
+    "SSO 98",
+    "1 40004U 98067A   23360.75000000  .00000090  00000-0  10000-3 0  2923",
+    "2 40004  98.5000 300.0000 0009000 010.0000 350.0000 14.30000000563533",
+    "LOW 65",
+    "1 40003U 98067A   24001.50000000  .00000090  00000-0  50000-3 0  2922",
+    "2 40003  65.0000 010.0000 0010000 045.0000 300.0000 16.20000000563535",
+    "HEO 63",
+    "1 40005U 98067A   24001.50000000  .00000090  00000-0  10000-3 0  2920",
+    "2 40005  63.4000 100.0000 7000000 270.0000 010.0000 02.00600000563532",
+    NULL
+};
+
+typedef struct {
+    double azi, ele, range;
+} difference_t;
+
+//---------------------------------------------------------------------------
+static double seconds(QElapsedTimer *timer)
+{
+    return timer->nsecsElapsed() / 1e9;
+}
+
+//---------------------------------------------------------------------------
+static void compare(TSat *sat, double azi, double ele, double range, difference_t *d)
+{
+    double da;
+
+    da = fabs(azi - sat->sat_azi);
+    if(da > 180.0)
+        da = 360.0 - da;
+
+    if(da > d->azi)
+        d->azi = da;
+    if(fabs(ele - sat->sat_ele) > d->ele)
+        d->ele = fabs(ele - sat->sat_ele);
+    if(fabs(range - sat->sat_range) > d->range)
+        d->range = fabs(range - sat->sat_range);
+}
+
+//---------------------------------------------------------------------------
+static bool addSat(PList *sats, char *name, char *line1, char *line2)
+{
+    TSat *sat = new TSat;
+
+    name[strcspn(name, "\r\n")] = '\0';
+    line1[strcspn(line1, "\r\n")] = '\0';
+    line2[strcspn(line2, "\r\n")] = '\0';
+
+    if(!sat->TLEKepCheck(name, line1, line2)) {
+        fprintf(stderr, "Invalid element set: %s\n", name);
+        delete sat;
+        return false;
+    }
+
+    sat->obs_geodetic.lat = 60.2*deg2rad;
+    sat->obs_geodetic.lon = 24.9*deg2rad;
+    sat->obs_geodetic.alt = 0.05;
+
+    sats->Add(sat);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+static bool readSats(PList *sats, const char *file)
+{
+    char  name[TLE_LINELEN+2], line1[TLE_LINELEN+2], line2[TLE_LINELEN+2];
+    FILE  *fp;
+    int   i;
+
+    if(file == NULL) {
+        for(i=0; tles[i] != NULL; i += 3) {
+            strcpy(name, tles[i]);
+            strcpy(line1, tles[i+1]);
+            strcpy(line2, tles[i+2]);
+
+            if(!addSat(sats, name, line1, line2))
+                return false;
+        }
+
+        return true;
+    }
+
+    if((fp = fopen(file, "r")) == NULL) {
+        fprintf(stderr, "Failed to open %s\n", file);
+        return false;
+    }
+
+    while(fgets(name, sizeof(name), fp) && fgets(line1, sizeof(line1), fp) && fgets(line2, sizeof(line2), fp))
+        if(!addSat(sats, name, line1, line2))
+            break;
+
+    fclose(fp);
+
+    return sats->Count > 0;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    PList          sats;
+    TSGP4Batch     batch;
+    TSGP4State     state;
+    TSat           *sat;
+    QElapsedTimer  timer;
+    difference_t   d;
+    tle_t          tle;
+    double         *t, *azi, *ele, *range, first, jd_epoch, calc, batched;
+    int            *set, i, j, n, sets;
+    bool           failed = false;
+
+    if(argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+        printf("%s %s, TSGP4Batch against TSat::Calc\n\n", "poes-sgp4test", VER_FILEVERSION_STR);
+        printf("usage: poes-sgp4test [tle file]\n");
+        return 2;
+    }
+
+    if(!readSats(&sats, argc == 2 ? argv[1]:NULL))
+        return 2;
+
+    n   = SGP4TEST_SAMPLES;
+    t   = (double *) malloc(4 * n * sizeof(double));
+    set = (int *) malloc(sats.Count * sizeof(int));
+    if(t == NULL || set == NULL || !state.alloc(n)) {
+        fprintf(stderr, "Failed to allocate %d samples\n", n);
+        return 1;
+    }
+
+    azi   = t + n;
+    ele   = azi + n;
+    range = ele + n;
+
+    // -1 for a deep space set, it has to stay on TSat::Calc
+    for(i=0, sets=0; i<sats.Count; i++) {
+        sat = (TSat *) sats.ItemAt(i);
+        set[i] = batch.add(sat);
+
+        if((set[i] < 0) != sat->IsDeepSpace()) {
+            printf("%-24s %s\n", sat->name, sat->IsDeepSpace() ? "deep space set was added":"near earth set was not added");
+            failed = true;
+        }
+        else if(set[i] >= 0)
+            sets++;
+    }
+
+    printf("%s, %d of %d sets near earth\n", TSGP4Batch::simd(), sets, sats.Count);
+
+    // one set at many times
+    for(i=0; i<sats.Count; i++) {
+        if(set[i] < 0)
+            continue;
+
+        sat = (TSat *) sats.ItemAt(i);
+        sat->GetElements(&tle, &jd_epoch);
+        first = floor(jd_epoch - 2444238.5) - 2.0;
+
+        for(j=0; j<n; j++)
+            t[j] = first + j*(SGP4TEST_DAYS/n);
+
+        timer.start();
+        batch.propagate(set[i], t, n, &state);
+        TSGP4Batch::look(&sat->obs_geodetic, t, 1, &state, n, azi, ele, range);
+        batched = seconds(&timer);
+
+        memset(&d, 0, sizeof(d));
+
+        timer.start();
+        for(j=0; j<n; j++) {
+            sat->daynum = t[j];
+            sat->Calc();
+
+            compare(sat, azi[j], ele[j], range[j], &d);
+        }
+        calc = seconds(&timer);
+
+        printf("%-24s azi %.2g ele %.2g deg range %.2g km, %.0f/%.0f ns\n", sat->name,
+               d.azi, d.ele, d.range, batched/n*1e9, calc/n*1e9);
+
+        if(d.azi > SGP4TEST_ANGLE || d.ele > SGP4TEST_ANGLE || d.range > SGP4TEST_RANGE)
+            failed = true;
+    }
+
+    // every set at one time
+    if(sets > 0) {
+        memset(&d, 0, sizeof(d));
+
+        for(j=0; j<100; j++) {
+            t[0] = t[n-1] - j*0.37;
+
+            batch.propagate(t[0], &state);
+            TSGP4Batch::look(&((TSat *) sats.ItemAt(0))->obs_geodetic, t, 0, &state, sets, azi, ele, range);
+
+            for(i=0; i<sats.Count; i++) {
+                if(set[i] < 0)
+                    continue;
+
+                sat = (TSat *) sats.ItemAt(i);
+                sat->daynum = t[0];
+                sat->Calc();
+
+                compare(sat, azi[set[i]], ele[set[i]], range[set[i]], &d);
+            }
+        }
+
+        printf("%-24s azi %.2g ele %.2g deg range %.2g km\n", "all sets at one time", d.azi, d.ele, d.range);
+
+        if(d.azi > SGP4TEST_ANGLE || d.ele > SGP4TEST_ANGLE || d.range > SGP4TEST_RANGE)
+            failed = true;
+    }
+
+    for(i=0; i<sats.Count; i++)
+        delete (TSat *) sats.ItemAt(i);
+
+    free(set);
+    free(t);
+
+    printf("%s\n", failed ? "FAILED":"passed");
+
+    return failed ? 1:0;
+}
@@ -0,0 +1,413 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#include <QThreadStorage>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QList>
+#include <string.h>
+#include <stdlib.h>
+
+#include "trace.h"
+
+#ifdef POES_TRACE
+
+#define TRACE_FIRST_EVENTS  4096
+
+//---------------------------------------------------------------------------
+// events and statistics of one thread
+class TTraceBuffer
+{
+public:
+    TTraceBuffer(int id_)
+    {
+        id = id_;
+        events = NULL;
+        allocated = 0;
+
+        reset();
+    }
+
+    void reset(void)
+    {
+        nevents = dropped = 0;
+        nstats = last = 0;
+    }
+
+    TTraceStat *stat(const char *name, bool timer);
+    bool        grow(void);
+
+    int          id;
+
+    TTraceEvent *events;
+    long         nevents, allocated, dropped;
+
+    TTraceStat   stats[TRACE_MAX_NAMES];
+    int          nstats, last;
+};
+
+// QThreadStorage deletes this when the thread exits, the buffer keeps its
+// events for the summary and goes to the free list. The next new thread
+// records to it, so short lived workers don't add a buffer each.
+class TTraceThread
+{
+public:
+    ~TTraceThread(void);
+
+    TTraceBuffer *buffer;
+};
+
+// before trace_thread, it is destroyed first
+static QList<TTraceBuffer *> trace_buffers;
+static QList<TTraceBuffer *> trace_free;
+static QMutex        trace_mutex;
+static QElapsedTimer trace_clock;
+
+static QThreadStorage<TTraceThread *> trace_thread;
+
+bool TTrace::started = false;
+
+//---------------------------------------------------------------------------
+TTraceThread::~TTraceThread(void)
+{
+    trace_mutex.lock();
+    trace_free.append(buffer);
+    trace_mutex.unlock();
+}
+
+//---------------------------------------------------------------------------
+// the same name is mostly hit several times in a row
+TTraceStat *TTraceBuffer::stat(const char *name, bool timer)
+{
+    TTraceStat *s;
+    int i;
+
+    if(last < nstats && stats[last].name == name)
+        return &stats[last];
+
+    for(i=0; i<nstats; i++)
+        if(stats[i].name == name) {
+            last = i;
+            return &stats[i];
+        }
+
+    if(nstats >= TRACE_MAX_NAMES)
+        return NULL;
+
+    s = &stats[nstats];
+    s->name = name;
+    s->timer = timer;
+    s->calls = 0;
+    s->total = s->max = 0;
+    s->min = -1;
+
+    last = nstats++;
+
+    return s;
+}
+
+//---------------------------------------------------------------------------
+bool TTraceBuffer::grow(void)
+{
+    TTraceEvent *e;
+    long n;
+
+    if(allocated >= TRACE_MAX_EVENTS)
+        return false;
+
+    n = allocated ? (allocated << 1):TRACE_FIRST_EVENTS;
+    if(n > TRACE_MAX_EVENTS)
+        n = TRACE_MAX_EVENTS;
+
+    e = (TTraceEvent *) realloc(events, n * sizeof(TTraceEvent));
+    if(e == NULL) {
+        qDebug("Failed to allocate %ld trace events %s:%d", n, __FILE__, __LINE__);
+        return false;
+    }
+
+    events = e;
+    allocated = n;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// the buffer of the calling thread, one of a thread that has exited or a
+// new one on its first event
+TTraceBuffer *TTrace::buffer(void)
+{
+    TTraceThread *t;
+    TTraceBuffer *b;
+
+    t = trace_thread.localData();
+    if(t != NULL)
+        return t->buffer;
+
+    trace_mutex.lock();
+
+    if(!trace_free.isEmpty())
+        b = trace_free.takeLast();
+    else {
+        b = new TTraceBuffer(trace_buffers.count());
+        trace_buffers.append(b);
+    }
+
+    trace_mutex.unlock();
+
+    t = new TTraceThread;
+    t->buffer = b;
+    trace_thread.setLocalData(t);
+
+    return b;
+}
+
+//---------------------------------------------------------------------------
+void TTrace::clear(void)
+{
+    int i;
+
+    trace_mutex.lock();
+
+    for(i=0; i<trace_buffers.count(); i++)
+        trace_buffers.at(i)->reset();
+
+    trace_mutex.unlock();
+}
+
+//---------------------------------------------------------------------------
+void TTrace::start(void)
+{
+    clear();
+
+    trace_clock.start();
+    started = true;
+}
+
+//---------------------------------------------------------------------------
+qint64 TTrace::now(void)
+{
+    return started ? trace_clock.nsecsElapsed():0;
+}
+
+//---------------------------------------------------------------------------
+void TTrace::add(const char *name, qint64 start_, qint64 duration)
+{
+    TTraceBuffer *b;
+    TTraceStat   *s;
+    TTraceEvent  *e;
+
+    if(!started)
+        return;
+
+    b = buffer();
+
+    s = b->stat(name, true);
+    if(s != NULL) {
+        s->calls++;
+        s->total += duration;
+
+        if(s->min < 0 || duration < s->min)
+            s->min = duration;
+        if(duration > s->max)
+            s->max = duration;
+    }
+
+    if(b->nevents >= b->allocated && !b->grow()) {
+        b->dropped++;
+        return;
+    }
+
+    e = &b->events[b->nevents++];
+    e->name = name;
+    e->start = start_;
+    e->duration = duration;
+}
+
+//---------------------------------------------------------------------------
+void TTrace::count(const char *name, qint64 n)
+{
+    TTraceStat *s;
+
+    if(!started)
+        return;
+
+    s = buffer()->stat(name, false);
+    if(s != NULL) {
+        s->calls++;
+        s->total += n;
+    }
+}
+
+//---------------------------------------------------------------------------
+typedef struct TTraceTotal_t
+{
+    TTraceStat stat;
+    int        threads;
+} TTraceTotal;
+
+static int compareTotal(const void *a, const void *b)
+{
+    qint64 ta = ((const TTraceTotal *) a)->stat.total, tb = ((const TTraceTotal *) b)->stat.total;
+
+    return ta < tb ? 1:(ta > tb ? -1:0);
+}
+
+//---------------------------------------------------------------------------
+// the statistics of all threads by name, the longest total time first
+void TTrace::summary(FILE *fp)
+{
+    TTraceTotal merged[TRACE_MAX_NAMES];
+    TTraceStat  *s, *m;
+    int         nmerged, i, j, k;
+    long        dropped = 0;
+    bool        timer;
+
+    nmerged = 0;
+
+    for(i=0; i<trace_buffers.count(); i++) {
+        dropped += trace_buffers.at(i)->dropped;
+
+        for(j=0; j<trace_buffers.at(i)->nstats; j++) {
+            s = &trace_buffers.at(i)->stats[j];
+
+            for(k=0; k<nmerged; k++)
+                if(merged[k].stat.timer == s->timer && strcmp(merged[k].stat.name, s->name) == 0)
+                    break;
+
+            if(k == nmerged) {
+                if(nmerged >= TRACE_MAX_NAMES)
+                    continue;
+
+                merged[nmerged].stat = *s;
+                merged[nmerged++].threads = 1;
+
+                continue;
+            }
+
+            m = &merged[k].stat;
+
+            m->calls += s->calls;
+            m->total += s->total;
+            if(s->min >= 0 && (m->min < 0 || s->min < m->min))
+                m->min = s->min;
+            if(s->max > m->max)
+                m->max = s->max;
+
+            merged[k].threads++;
+        }
+    }
+
+    qsort(merged, nmerged, sizeof(TTraceTotal), compareTotal);
+
+    for(k=0; k<2; k++) {
+        timer = k == 0;
+
+        if(timer)
+            fprintf(fp, "\n%-32s %7s %9s %11s %11s %11s %11s\n",
+                    "timer", "threads", "calls", "total ms", "mean us", "min us", "max us");
+        else
+            fprintf(fp, "\n%-32s %7s %9s %14s\n", "counter", "threads", "adds", "total");
+
+        for(i=0; i<nmerged; i++) {
+            s = &merged[i].stat;
+            if(s->timer != timer)
+                continue;
+
+            if(timer)
+                fprintf(fp, "%-32s %7d %9ld %11.3f %11.3f %11.3f %11.3f\n",
+                        s->name, merged[i].threads, s->calls,
+                        s->total / 1e6, (s->total / 1e3) / s->calls,
+                        s->min / 1e3, s->max / 1e3);
+            else
+                fprintf(fp, "%-32s %7d %9ld %14lld\n",
+                        s->name, merged[i].threads, s->calls, (long long) s->total);
+        }
+    }
+
+    if(dropped > 0)
+        fprintf(fp, "\n%ld events are not in the trace file, more than %d in a thread\n",
+                dropped, TRACE_MAX_EVENTS);
+}
+
+//---------------------------------------------------------------------------
+// complete ("X") events of every thread and the counter totals ("C") at
+// the end, times in us, see the Trace Event Format of the Chromium project
+bool TTrace::writeJson(const char *filename)
+{
+    TTraceBuffer *b;
+    TTraceEvent  *e;
+    FILE   *fp;
+    qint64 end = now();
+    long   n;
+    int    i, j;
+
+    fp = fopen(filename, "w");
+    if(fp == NULL) {
+        fprintf(stderr, "Failed to create file %s\n", filename);
+        return false;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"poes-usrp\"}}");
+
+    for(i=0; i<trace_buffers.count(); i++) {
+        b = trace_buffers.at(i);
+
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                b->id, b->id);
+
+        for(n=0; n<b->nevents; n++) {
+            e = &b->events[n];
+
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    e->name, b->id, e->start / 1e3, e->duration / 1e3);
+        }
+
+        for(j=0; j<b->nstats; j++)
+            if(!b->stats[j].timer)
+                fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"total\":%lld}}",
+                        b->stats[j].name, b->id, end / 1e3, (long long) b->stats[j].total);
+    }
+
+    fprintf(fp, "\n]}\n");
+
+    return fclose(fp) == 0;
+}
+
+//---------------------------------------------------------------------------
+void TTrace::stop(const char *filename)
+{
+    if(!started)
+        return;
+
+    trace_mutex.lock();
+
+    summary(stderr);
+
+    if(filename != NULL && writeJson(filename))
+        fprintf(stderr, "\nTrace events written to %s\n", filename);
+
+    trace_mutex.unlock();
+
+    started = false;
+}
+
+#endif // POES_TRACE
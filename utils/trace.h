@@ -0,0 +1,127 @@
+/*
+    POES-USRP, a software for recording and decoding POES high resolution weather satellite images.
+    Copyright (C) 2009-2012 Free Software Foundation, Inc.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Email: <postmaster@poes-weather.com>
+    Web: <http://www.poes-weather.com>
+*/
+//---------------------------------------------------------------------------
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QtGlobal>
+#include <stdio.h>
+
+//---------------------------------------------------------------------------
+// Hot path timers and counters, compiled in by building with
+// qmake CONFIG+=trace (defines POES_TRACE), the macros are empty otherwise.
+//
+//   TRACE_SCOPE("TCADU::getpayload");   times the rest of the block
+//   TRACE_COUNT("TCADU::rs_symbols", n); adds n to a counter
+//
+// Names are string literals, they are kept by pointer. Every thread
+// records to its own buffer, nothing is locked on the hot path. The
+// buffer of a thread that has exited is taken by the next new one, the
+// threads of the summary and the trace file are buffers.
+// TRACE_START starts the clock, nothing is recorded before it.
+// TRACE_STOP prints a summary table to stderr and writes the events as
+// Chrome trace event JSON (chrome://tracing or ui.perfetto.dev) to the
+// file, it must be called when the other threads are done.
+//---------------------------------------------------------------------------
+#define TRACE_MAX_EVENTS    (1 << 20) // per thread, only summed when full
+#define TRACE_MAX_NAMES     64        // timers and counters per thread
+
+#ifdef POES_TRACE
+
+#define TRACE_CONCAT2(a, b)     a##b
+#define TRACE_CONCAT(a, b)      TRACE_CONCAT2(a, b)
+
+#define TRACE_START()           TTrace::start()
+#define TRACE_STOP(filename)    TTrace::stop(filename)
+#define TRACE_SCOPE(name)       TTraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_COUNT(name, n)    TTrace::count(name, n)
+
+//---------------------------------------------------------------------------
+typedef struct TTraceEvent_t
+{
+    const char *name;
+    qint64     start, duration; // ns since TRACE_START
+} TTraceEvent;
+
+typedef struct TTraceStat_t
+{
+    const char *name;
+    bool       timer;
+    long       calls;
+    qint64     total, min, max; // ns of a timer, sum of a counter
+} TTraceStat;
+
+class TTraceBuffer;
+
+//---------------------------------------------------------------------------
+class TTrace
+{
+public:
+    static void   start(void);
+    static void   stop(const char *filename);
+    static bool   isStarted(void) { return started; }
+
+    static qint64 now(void);
+
+    static void   add(const char *name, qint64 start_, qint64 duration);
+    static void   count(const char *name, qint64 n);
+
+protected:
+    static TTraceBuffer *buffer(void);
+    static void clear(void);
+
+    static void summary(FILE *fp);
+    static bool writeJson(const char *filename);
+
+private:
+    static bool started;
+};
+
+//---------------------------------------------------------------------------
+class TTraceScope
+{
+public:
+    TTraceScope(const char *name_)
+    {
+        name = name_;
+        start = TTrace::now();
+    }
+
+    ~TTraceScope(void)
+    {
+        TTrace::add(name, start, TTrace::now() - start);
+    }
+
+private:
+    const char *name;
+    qint64     start;
+};
+
+#else
+
+#define TRACE_START()
+#define TRACE_STOP(filename)
+#define TRACE_SCOPE(name)
+#define TRACE_COUNT(name, n)
+
+#endif // POES_TRACE
+
+#endif // TRACE_H